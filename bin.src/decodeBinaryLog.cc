@@ -0,0 +1,135 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * \file decodeBinaryLog.cc
+ *
+ * \brief converts logs written by a BinaryFormatter to text.
+ *
+ * Usage: decodeBinaryLog [-f format] [file ...]
+ *
+ * Each file (or the standard input, if none, or if a file is "-") is 
+ * decoded and written to the standard output with the chosen formatter:
+ * brief, verbose, indented, prepended (the default), netlogger, json, or 
+ * pattern:PATTERN for a PatternFormatter with the given pattern.
+ */
+
+#include "lsst/pex/logging/BinaryLogReader.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/exceptions.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace std;
+using namespace lsst::pex::logging;
+
+namespace {
+
+    void usage(ostream& strm) {
+        strm << "Usage: decodeBinaryLog [-f format] [file ...]\n"
+             << "  format is one of brief, verbose, indented, prepended "
+             << "(the default),\n"
+             << "  netlogger, json, or pattern:PATTERN\n";
+    }
+
+    shared_ptr<LogFormatter> makeFormatter(const string& name) {
+        if (name == "brief") 
+            return shared_ptr<LogFormatter>(new BriefFormatter(false));
+        if (name == "verbose") 
+            return shared_ptr<LogFormatter>(new BriefFormatter(true));
+        if (name == "indented") 
+            return shared_ptr<LogFormatter>(new IndentedFormatter(true));
+        if (name == "prepended") 
+            return shared_ptr<LogFormatter>(new PrependedFormatter(true));
+        if (name == "netlogger") 
+            return shared_ptr<LogFormatter>(new NetLoggerFormatter());
+        if (name == "json") 
+            return shared_ptr<LogFormatter>(new JsonLinesFormatter());
+        if (name.compare(0, 8, "pattern:") == 0) 
+            return shared_ptr<LogFormatter>(
+                new PatternFormatter(name.substr(8)));
+        return shared_ptr<LogFormatter>();
+    }
+
+    void decode(istream& in, LogFormatter& formatter) {
+        BinaryLogReader reader(in);
+        while (shared_ptr<LogRecord> rec = reader.next()) 
+            formatter.write(&cout, *rec);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    string format("prepended");
+    int i = 1;
+    for(; i < argc && argv[i][0] == '-' && argv[i][1] != '\0'; ++i) {
+        if (strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+            format = argv[++i];
+        }
+        else if (strcmp(argv[i], "-h") == 0) {
+            usage(cout);
+            return 0;
+        }
+        else {
+            usage(cerr);
+            return 2;
+        }
+    }
+
+    shared_ptr<LogFormatter> formatter = makeFormatter(format);
+    if (! formatter) {
+        cerr << "decodeBinaryLog: unknown format: " << format << '\n';
+        usage(cerr);
+        return 2;
+    }
+
+    int status = 0;
+    if (i == argc) argv[--i] = const_cast<char*>("-");
+    for(; i < argc; ++i) {
+        try {
+            if (strcmp(argv[i], "-") == 0) {
+                decode(cin, *formatter);
+            }
+            else {
+                ifstream in(argv[i], ios::in | ios::binary);
+                if (! in) {
+                    cerr << "decodeBinaryLog: " << argv[i] 
+                         << ": unable to open\n";
+                    status = 1;
+                    continue;
+                }
+                decode(in, *formatter);
+            }
+        }
+        catch (lsst::pex::exceptions::Exception const& ex) {
+            cout.flush();
+            cerr << "decodeBinaryLog: " << argv[i] << ": " << ex.what() 
+                 << '\n';
+            status = 1;
+        }
+    }
+    cout.flush();
+    return status;
+}
@@ -0,0 +1,211 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file AsyncDestination.h
+ * @brief definition of the AsyncDestination class
+ */
+#ifndef LSST_PEX_ASYNCDESTINATION_H
+#define LSST_PEX_ASYNCDESTINATION_H
+
+#include "lsst/pex/logging/LogDestination.h"
+#include "lsst/pex/logging/AsyncWriter.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a LogDestination that hands records to another destination on a
+ * thread of its own, so that a slow destination does not hold up the
+ * others.
+ *
+ * A Log writes a record to each of its destinations in turn, so a
+ * destination that blocks (for example, a file on a slow network mount)
+ * delays every destination after it, whether the Log is synchronous or
+ * asynchronous (see AsyncWriter).  Wrapping that destination in an
+ * AsyncDestination lets write() return as soon as a copy of the record is
+ * queued; a worker thread belonging to the AsyncDestination writes the
+ * queued records to the wrapped destination in order, as many at a time
+ * as are waiting (see LogDestination::writeBatch()), and flushes it
+ * whenever it catches up.
+ *
+ * What happens when the queue is full is controlled by the same
+ * OverflowPolicy as an AsyncWriter; how often that happens and how many
+ * records were discarded as a result are counted for each
+ * AsyncDestination.  Records that are at least as important as a given
+ * level (by default, Log::WARN) bypass the queue: they are written to the
+ * wrapped destination at once by the calling thread, ahead of any records
+ * still queued, so that warnings and fatal errors are neither delayed nor
+ * dropped.
+ *
+ * Unlike other LogDestinations, this class is synchronized; several
+ * threads may write to it at once.  A record is queued only if it passes
+ * both this destination's threshold (initially that of the wrapped
+ * destination) and the wrapped destination's own.  flush() waits until
+ * the records queued before the call have been written, and the
+ * destructor writes out all that remain before stopping the worker
+ * thread.  The worker thread is not carried into a child process created
+ * with fork().
+ */
+class AsyncDestination : public LogDestination {
+public:
+
+    /**
+     * the importance at or above which records bypass the queue by
+     * default.  This is equal to Log::WARN.
+     */
+    static const int DEFAULT_BYPASS;
+
+    /**
+     * a bypass importance that makes every record go through the queue
+     */
+    static const int NO_BYPASS;
+
+    /**
+     * wrap a destination and start the worker thread
+     * @param destination  the destination to write records to
+     * @param capacity     the maximum number of records that may be
+     *                       waiting to be written
+     * @param policy       what to do when a record arrives and the queue
+     *                       is full
+     * @param bypass       records at least this important are written
+     *                       immediately rather than queued; NO_BYPASS
+     *                       queues every record.
+     */
+    explicit AsyncDestination(
+        const std::shared_ptr<LogDestination>& destination,
+        std::size_t capacity=AsyncWriter::DEFAULT_CAPACITY,
+        AsyncWriter::OverflowPolicy policy=AsyncWriter::BLOCK,
+        int bypass=DEFAULT_BYPASS);
+
+    /**
+     * write out all remaining records and stop the worker thread
+     */
+    virtual ~AsyncDestination();
+
+    /**
+     * queue a copy of a record to be written to the wrapped destination
+     * or, if it is important enough, write it immediately.
+     * @return  true if the record was queued or written; false if it
+     *          did not pass the thresholds or was discarded because the
+     *          queue was full.
+     */
+    virtual bool write(const LogRecord& rec);
+
+    /**
+     * queue or write a record as with write(const LogRecord&).  The
+     * wrapped destination renders the record itself.
+     */
+    virtual bool write(RenderedRecord& rec);
+
+    /**
+     * wait until all records queued prior to this call have been written
+     * and flush the wrapped destination.  This returns immediately when
+     * called from the worker thread itself.
+     */
+    virtual void flush();
+
+    /**
+     * return the destination that records are written to
+     */
+    const std::shared_ptr<LogDestination>& getDestination() const {
+        return _dest;
+    }
+
+    /**
+     * return the maximum number of records that may be waiting to be
+     * written
+     */
+    std::size_t getCapacity() const { return _capacity; }
+
+    /**
+     * return the policy applied when a record arrives and the queue is
+     * full
+     */
+    AsyncWriter::OverflowPolicy getOverflowPolicy() const { return _policy; }
+
+    /**
+     * return the importance at or above which records bypass the queue
+     */
+    int getBypassImportance() const { return _bypass; }
+
+    /**
+     * return the number of records that arrived while the queue was full,
+     * whether they then waited, were discarded, or had another record
+     * discarded to make room for them.
+     */
+    unsigned long long getOverflowCount() const;
+
+    /**
+     * return the number of records that have been discarded because the
+     * queue was full
+     */
+    unsigned long long getDropCount() const;
+
+    /**
+     * return the number of records that bypassed the queue
+     */
+    unsigned long long getBypassCount() const;
+
+    /**
+     * return the number of records currently waiting to be written
+     */
+    std::size_t getQueueLength() const;
+
+private:
+    AsyncDestination(const AsyncDestination&);
+    AsyncDestination& operator=(const AsyncDestination&);
+
+    bool _makeRoom(std::unique_lock<std::mutex>& lock, int importance);
+    void _run();
+
+    std::shared_ptr<LogDestination> _dest;
+    std::size_t _capacity;
+    AsyncWriter::OverflowPolicy _policy;
+    int _bypass;
+    std::deque<std::unique_ptr<LogRecord> > _queue;
+    unsigned long long _queued;         // records queued so far
+    unsigned long long _done;           // ...and since written or dropped
+    unsigned long long _overflows;
+    unsigned long long _dropped;
+    unsigned long long _bypassed;
+    bool _stopping;
+    mutable std::mutex _mutex;
+    std::mutex _destMutex;              // held while using _dest
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::condition_variable _written;
+    std::thread _thread;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_ASYNCDESTINATION_H
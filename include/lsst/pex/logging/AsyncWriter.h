@@ -0,0 +1,214 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file AsyncWriter.h
+ * @brief definition of the AsyncWriter class
+ */
+#ifndef LSST_PEX_ASYNCWRITER_H
+#define LSST_PEX_ASYNCWRITER_H
+
+#include "lsst/pex/logging/LogDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a background thread that writes log records to their
+ * destinations on behalf of the Logs that send them.
+ *
+ * When a Log is put into asynchronous mode (see Log::enableAsync()),
+ * Log::send() no longer formats and writes a record itself; instead, it
+ * hands a copy of the record and the Log's current destinations to an
+ * AsyncWriter.  This keeps the cost of formatting and I/O (for example,
+ * to a slow network-mounted file) off of the threads doing the real work.
+ *
+ * So that many threads may send at once without contending for a shared
+ * queue, each sending thread gets its own bounded, lock-free ring of
+ * records, created the first time the thread writes and given up when
+ * the thread exits.  A single dedicated thread drains the rings, merging
+ * their records by timestamp so that destinations receive them in time
+ * order.  Records from one thread are always written in the order they
+ * were accepted; a record that only becomes visible after later ones from
+ * other threads have been written (because its thread was preempted
+ * while sending it) may appear slightly out of time order.
+ *
+ * What happens when a thread's ring is full is controlled by an
+ * OverflowPolicy.  flush() blocks until all records accepted before the
+ * call have been written, and the destructor drains the rings before
+ * stopping the thread.  In a child process created with fork(), records
+ * queued before the fork are left to the parent to write, and a new
+ * writer thread is started when the child first writes.
+ */
+class AsyncWriter {
+public:
+
+    /**
+     * the list of destinations a record is to be written to
+     */
+    typedef std::list<std::shared_ptr<LogDestination> > DestinationList;
+
+    /**
+     * the choices of what to do when a record arrives and the queue is full
+     */
+    enum OverflowPolicy {
+        /**
+         * make the sending thread wait until there is room in the queue
+         */
+        BLOCK = 0,
+
+        /**
+         * discard the newly arriving record
+         */
+        DROP_NEWEST,
+
+        /**
+         * make room by discarding the oldest debugging record (i.e. one
+         * with an importance below Log::INFO) queued by the sending
+         * thread.  If there is none, a new debugging record is discarded,
+         * while any other record waits for room as with BLOCK.
+         */
+        DROP_DEBUG_FIRST
+    };
+
+    /**
+     * the default maximum number of records held for each sending thread
+     */
+    static const std::size_t DEFAULT_CAPACITY;
+
+    /**
+     * create a writer and start its thread
+     * @param capacity   the maximum number of records from each sending
+     *                      thread that may be waiting to be written.
+     * @param policy     what to do when a record arrives and the sending
+     *                      thread's queue is full.
+     */
+    explicit AsyncWriter(std::size_t capacity=DEFAULT_CAPACITY,
+                         OverflowPolicy policy=BLOCK);
+
+    /**
+     * write out all remaining records and stop the writer thread.  If a
+     * destination drops the last reference to this writer (e.g. by 
+     * calling Log::disableAsync()) while the writer thread is writing to
+     * it, the records still queued are discarded instead, and the thread
+     * stops once the destination returns.
+     */
+    virtual ~AsyncWriter();
+
+    /**
+     * queue a copy of a record to be written to the given destinations.
+     * @return bool   false if the record was discarded because the
+     *                  sending thread's queue was full.
+     */
+    bool write(const LogRecord& rec, const DestinationList& destinations);
+
+    /**
+     * wait until all records accepted prior to this call have been
+     * written to their destinations.  This returns immediately when
+     * called from the writer thread itself.
+     */
+    void flush();
+
+    /**
+     * return the maximum number of records from each sending thread that
+     * may be waiting to be written
+     */
+    std::size_t getCapacity() const { return _capacity; }
+
+    /**
+     * return the policy applied when a record arrives and the sending
+     * thread's queue is full
+     */
+    OverflowPolicy getOverflowPolicy() const { return _policy; }
+
+    /**
+     * return the number of records that have been discarded because a
+     * queue was full.
+     */
+    unsigned long long getDropCount() const;
+
+    /**
+     * return the number of records currently waiting to be written, summed
+     * over all sending threads
+     */
+    std::size_t getQueueLength() const;
+
+    /**
+     * flush all AsyncWriters that currently exist.  This is registered to
+     * run when the process exits normally so that queued records are not
+     * lost.
+     */
+    static void flushAll();
+
+private:
+    AsyncWriter(const AsyncWriter&);
+    AsyncWriter& operator=(const AsyncWriter&);
+
+    class Ring;
+    typedef std::vector<std::shared_ptr<Ring> > RingList;
+    typedef std::vector<std::shared_ptr<LogDestination> > DestinationSet;
+
+    Ring& _getRing(bool& exiting);
+    bool _makeRoom(Ring& ring, int importance);
+    bool _drain(const RingList& rings, DestinationSet& written);
+    bool _removeOrphans();
+    void _start();
+    void _run();
+    void _resetAfterFork();
+
+    static void _prepareFork();
+    static void _parentAfterFork();
+    static void _childAfterFork();
+
+    const unsigned long long _id;       // identifies this writer to threads
+    std::size_t _capacity;
+    std::size_t _ringSize;              // slots in each ring, a power of 2
+    OverflowPolicy _policy;
+    RingList _rings;
+    std::atomic<unsigned long long> _generation;    // changes with _rings
+    std::atomic<unsigned long long> _dropped;
+    std::atomic<int> _blocked;          // senders waiting for room
+    std::atomic<bool> _sleeping;        // the writer thread is waiting
+    std::atomic<bool> _restart;         // the thread is gone after a fork
+    bool _stopping;
+    mutable std::mutex _mutex;
+    std::condition_variable _notEmpty;
+    std::condition_variable _notFull;
+    std::condition_variable _written;
+    std::thread _thread;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_ASYNCWRITER_H
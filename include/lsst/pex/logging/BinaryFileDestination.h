@@ -0,0 +1,77 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryFileDestination.h
+ * @brief definition of the BinaryFileDestination class
+ */
+#ifndef LSST_PEX_BINARYFILEDESTINATION_H
+#define LSST_PEX_BINARYFILEDESTINATION_H
+
+#include "lsst/pex/logging/FileDestination.h"
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief  a FileDestination that writes records in the compact binary 
+ * form of the BinaryFormatter.
+ *
+ * The file can be converted to text later with BinaryLogReader or the 
+ * decodeBinaryLog program.  When messages are appended to an existing 
+ * file, a new header is written first, so the file remains readable as 
+ * a whole.
+ */
+class BinaryFileDestination : public FileDestination {
+public:
+
+    //@{
+    /**
+     * create a binary file destination.  If the file does not exist, it 
+     * will be created; otherwise, messages will be appended.
+     * @param filepath    the path to the log file to write messages to.
+     * @param threshold   the minimum volume level required to pass a message
+     *                       to the stream.  If not provided, it would be set
+     *                       to 0.  
+     * @param truncate    if True, overwrite the previous contents; otherwise,
+     *                       new messages will be appended to the file.
+     */
+    BinaryFileDestination(const boost::filesystem::path& filepath, 
+                          int threshold=threshold::PASS_ALL, 
+                          bool truncate=false);
+    BinaryFileDestination(const std::string& filepath, 
+                          int threshold=threshold::PASS_ALL, 
+                          bool truncate=false);
+    BinaryFileDestination(const char *filepath, 
+                          int threshold=threshold::PASS_ALL, 
+                          bool truncate=false);
+    //@}
+
+    virtual ~BinaryFileDestination();
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_BINARYFILEDESTINATION_H
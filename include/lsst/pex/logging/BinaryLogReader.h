@@ -0,0 +1,113 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryLogReader.h
+ * @brief definition of the BinaryLogReader class
+ */
+#ifndef LSST_PEX_BINARYLOGREADER_H
+#define LSST_PEX_BINARYLOGREADER_H
+
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/BinaryTrace.h"
+#include "lsst/daf/base/PropertySet.h"
+
+#include <istream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstddef>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a reader of the records written by a BinaryFormatter.
+ *
+ * Each call to next() decodes one record and recreates it as a LogRecord
+ * that can be handed to any LogFormatter, so that a binary log can be 
+ * rendered as text after the fact:
+ * @code
+ *   std::ifstream in("debug.blog", std::ios::binary);
+ *   BinaryLogReader reader(in);
+ *   PrependedFormatter fmtr;
+ *   while (std::shared_ptr<LogRecord> rec = reader.next()) 
+ *       fmtr.write(&std::cout, *rec);
+ * @endcode
+ * The recreated records have the original level, log name, TIMESTAMP, 
+ * comments and properties, with their original types.  Records that 
+ * shared a preamble share it again.  Every recreated record carries a 
+ * DATE property.  Messages recorded by BinaryTrace are formatted and 
+ * returned as records with a single comment, sent to their component at
+ * an importance of minus their verbosity.  Frames of kinds that this 
+ * reader does not know are skipped.
+ */
+class BinaryLogReader {
+public:
+
+    /**
+     * read records from a stream, which should be opened in binary mode
+     */
+    explicit BinaryLogReader(std::istream& strm);
+
+    /**
+     * read the next record
+     * @return  the record, or a null pointer if the end of the stream 
+     *            was reached.
+     * @throws lsst::pex::exceptions::IoError  if the stream does not hold
+     *            a binary log, ends in the middle of a record, or is 
+     *            otherwise corrupt.
+     */
+    std::shared_ptr<LogRecord> next();
+
+    /**
+     * return the number of records read so far
+     */
+    std::size_t getRecordCount() const { return _count; }
+
+private:
+    typedef std::shared_ptr<const lsst::daf::base::PropertySet> PreamblePtr;
+
+    BinaryLogReader(const BinaryLogReader&);
+    BinaryLogReader& operator=(const BinaryLogReader&);
+
+    bool _readFrame();
+    void _readHeader();
+    void _readTraceFormat();
+    std::shared_ptr<LogRecord> _readTraceEvent();
+
+    std::istream& _strm;
+    std::string _frame;
+    bool _started;
+    std::size_t _count;
+    std::vector<std::string> _names;
+    std::vector<PreamblePtr> _preambles;
+    std::unordered_map<unsigned long long, BinaryTrace::Format> _formats;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_BINARYLOGREADER_H
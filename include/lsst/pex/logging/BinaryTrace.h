@@ -0,0 +1,266 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryTrace.h
+ * @brief definition of the BinaryTrace and BinaryTraceSite classes and the
+ * LSST_BINARY_TRACE macro
+ */
+#ifndef LSST_PEX_BINARYTRACE_H
+#define LSST_PEX_BINARYTRACE_H
+
+#include "lsst/pex/logging/Trace.h"
+#include "lsst/pex/logging/FormatBuffer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <ostream>
+#include <string>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief the control of tracing in which messages are recorded in binary
+ * form and formatted later.
+ *
+ * Trace messages sent with LSST_BINARY_TRACE are not formatted when they
+ * are sent.  Each place in the code that sends them registers its 
+ * component name, verbosity, and format string once, getting an id for 
+ * them; after that, sending a message only copies the id, the time, and 
+ * the raw values of the arguments into a buffer that belongs to the 
+ * calling thread.  Nothing is locked or allocated, and no stream is 
+ * touched, so a message costs tens of nanoseconds.  Messages are later 
+ * drained from the threads' buffers, in time order, and either formatted 
+ * and sent to the default Log (as if they had been sent with Trace, but 
+ * with their original times) or, if an output stream is set with 
+ * setOutput(), written to it in the binary log format (see 
+ * BinaryFormatter) for formatting offline with BinaryLogReader or the 
+ * decodeBinaryLog program.
+ *
+ * Draining happens when flush() is called or periodically in a 
+ * background thread started with start().  If a thread's buffer fills 
+ * up before it is drained, further messages from that thread are dropped
+ * and counted (see getDropCount()).
+ *
+ * The format strings use the "{}" placeholders of FormatBuffer::format().
+ * Built-in numbers, characters, booleans and pointers are copied as they
+ * are; strings are copied, so they may change after the message is sent.
+ * A value of any other type is rendered with its output operator when the
+ * message is sent, which is much slower.
+ */
+class BinaryTrace {
+public:
+
+    /**
+     * the description of a place that sends messages
+     */
+    struct Format {
+        std::string name;        //!< the component messages are sent to
+        int verbosity;           //!< the verbosity of the messages
+        std::string file;        //!< the source file of the call
+        int line;                //!< the line of the call in the file
+        std::string format;      //!< the "{}"-style format string
+        std::string codes;       //!< the codes for the argument types
+    };
+
+    /**
+     * the codes for the types of the arguments as they are recorded.
+     * Each but STRING is followed by its value in 8 (or, for CHAR and 
+     * BOOL, 1) bytes in the byte order of the host; a STRING is a 4-byte 
+     * length followed by its characters.
+     */
+    enum ArgCode { 
+        SIGNED = 'q', UNSIGNED = 'Q', FLOAT = 'd', CHAR = 'c', BOOL = 'b', 
+        POINTER = 'p', STRING = 's'
+    };
+
+    /**
+     * the default size, in bytes, of each thread's buffer
+     */
+    static const std::size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    /**
+     * the default number of milliseconds between drains by the 
+     * background thread
+     */
+    static const unsigned int DEFAULT_INTERVAL = 100;
+
+    /**
+     * register a place that sends messages, returning the id that its 
+     * messages are recorded with.  Applications normally do not call 
+     * this directly.
+     */
+    static unsigned int registerFormat(const Format& format);
+
+    /**
+     * return the description of a place that sends messages, or null if 
+     * the id was not registered
+     */
+    static const Format *getFormat(unsigned int id);
+
+    /**
+     * format the message recorded for a place that sends messages
+     * @param out     the string to append the message to
+     * @param format  the description of the place that sent it
+     * @param args    the recorded argument values
+     * @param len     the number of bytes in args
+     * @return bool   false if the values do not match format.codes
+     */
+    static bool formatMessage(std::string& out, const Format& format,
+                              const char *args, std::size_t len);
+
+    /**
+     * set the stream that drained messages are written to in binary form.
+     * Messages already recorded are first drained to the previous 
+     * output.  A null pointer (the default) sends them to the default Log.
+     * The stream must not also be written to by a BinaryFormatter, as
+     * the two would define conflicting ids.
+     */
+    static void setOutput(const std::shared_ptr<std::ostream>& strm);
+
+    /**
+     * start a background thread that drains the threads' buffers every 
+     * interval milliseconds.  Nothing is done if it is already running.
+     */
+    static void start(unsigned int interval=DEFAULT_INTERVAL);
+
+    /**
+     * drain the buffers one last time and stop the background thread
+     */
+    static void stop();
+
+    /**
+     * return true if the background thread is running
+     */
+    static bool isRunning();
+
+    /**
+     * drain all the messages recorded so far
+     */
+    static void flush();
+
+    /**
+     * return the number of messages dropped because a buffer was full
+     */
+    static unsigned long long getDropCount();
+
+    /**
+     * set the size of the buffers of threads that have not yet sent a 
+     * message.  The size is rounded up to a power of 2.
+     */
+    static void setBufferSize(std::size_t bytes);
+
+    /**
+     * return the size of the buffers given to threads that have not yet 
+     * sent a message
+     */
+    static std::size_t getBufferSize();
+};
+
+/**
+ * @brief a single place in the code that sends messages via the 
+ * LSST_BINARY_TRACE macro.
+ *
+ * The component name, verbosity, and format string are registered with
+ * BinaryTrace the first time a message is recorded; they, and the types
+ * of the arguments, must be the same every time.  Applications normally 
+ * do not use this class directly.
+ */
+class BinaryTraceSite {
+public:
+
+    /**
+     * create a handle for a place that sends messages to a given component
+     */
+    BinaryTraceSite(const char *name, int verbosity, const char *file, 
+                    int line) 
+        : _site(name), _verbosity(verbosity), _file(file), _line(line), 
+          _id(0)
+    { }
+
+    /**
+     * return true if messages from this place will be recorded
+     */
+    bool isEnabled() const { return _site.isEnabled(_verbosity); }
+
+    /**
+     * record a message.  isEnabled() is assumed to have been checked.
+     * @param fmt    the "{}"-style format string
+     * @param args   the values to insert into it
+     */
+    template <class... Args>
+    void record(const char *fmt, const Args&... args) {
+        const FormatArg list[] = { FormatArg(args)..., FormatArg(0) };
+        _record(fmt, list, sizeof...(Args));
+    }
+
+private:
+    BinaryTraceSite(const BinaryTraceSite&);
+    BinaryTraceSite& operator=(const BinaryTraceSite&);
+
+    void _record(const char *fmt, const FormatArg *args, std::size_t nargs);
+    unsigned int _register(const char *fmt, const FormatArg *args, 
+                           std::size_t nargs);
+
+    const TraceSite _site;
+    const int _verbosity;
+    const char *_file;
+    const int _line;
+    std::atomic<unsigned int> _id;
+};
+
+/**
+ * \brief  record a trace message to a named component, to be formatted 
+ * later, if the verbosity is high enough.
+ *
+ * This is used like LSST_TRACE, but the format string takes "{}" 
+ * placeholders (see FormatBuffer::format()) and the message is formatted 
+ * only when it is drained (see BinaryTrace).  The arguments are not 
+ * evaluated unless the message is recorded.  The name, verbosity, and 
+ * format should be the same every time a particular use of the macro is 
+ * executed.
+ * \code
+ *     LSST_BINARY_TRACE("afw.math.convolve", 4, "kernel {} of {}", i, n);
+ * \endcode
+ */
+#if !LSST_NO_TRACE
+#define LSST_BINARY_TRACE(name, verbosity, ...)                              \
+    do {                                                                    \
+        if (LSST_MAX_TRACE < 0 || (verbosity) <= LSST_MAX_TRACE) {          \
+            static lsst::pex::logging::BinaryTraceSite                      \
+                lsstBinaryTraceSite_(name, verbosity, __FILE__, __LINE__);  \
+            if (lsstBinaryTraceSite_.isEnabled())                           \
+                lsstBinaryTraceSite_.record(__VA_ARGS__);                   \
+        }                                                                   \
+    } while (0)
+#else
+#define LSST_BINARY_TRACE(name, verbosity, ...) do { } while (0)
+#endif
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_BINARYTRACE_H
@@ -280,7 +280,7 @@ public:
             std::string msg("Starting ");
             msg += _funcName;
 
-            LogRecord rec(getThreshold(), _tracelev, getPreamble(), 
+            LogRecord rec(getThreshold(), _tracelev, _preamble, getName(),
                           willShowAll());
             rec.addComment(msg);
             rec.addProperty(STATUS, START);
@@ -307,7 +307,7 @@ public:
             std::string msg("Ending ");
             msg += _funcName;
 
-            LogRecord rec(getThreshold(), _tracelev, getPreamble(), 
+            LogRecord rec(getThreshold(), _tracelev, _preamble, getName(),
                           willShowAll());
             rec.addComment(msg);
             rec.addProperty(STATUS, END);
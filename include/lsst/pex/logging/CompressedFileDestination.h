@@ -0,0 +1,191 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file CompressedFileDestination.h
+ * @brief definition of the CompressedFileDestination class
+ */
+#ifndef LSST_PEX_COMPRESSEDFILEDESTINATION_H
+#define LSST_PEX_COMPRESSEDFILEDESTINATION_H
+
+#include "lsst/pex/logging/LogDestination.h"
+
+#include <boost/filesystem/path.hpp>
+#include <memory>
+#include <cstddef>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a LogDestination represented by a file that is compressed as it
+ * is written.
+ *
+ * Formatted records are copied into a block of memory; when the block is
+ * full, it is handed to a helper thread belonging to the destination to
+ * be compressed and written out, while records go on being copied into a
+ * second block.  Writing a record thus only waits if the helper thread
+ * has fallen a whole block behind.
+ *
+ * The file is written in the gzip format (which zcat and zless can read)
+ * or, if this package was built with LSST_PEX_LOGGING_HAVE_ZSTD defined
+ * and linked with libzstd, optionally in the zstd format.  When records
+ * are appended to an existing file, they are written as a new gzip member
+ * or zstd frame, which the usual tools read as a continuation of the
+ * file.
+ *
+ * Because each flush makes the compressor emit everything it has so far,
+ * the destination's FlushPolicy is set by default to flush only once a
+ * block's worth of records has been written (or when a record of at
+ * least Log::WARN importance is written).  A flush called for by the
+ * policy hands the records written so far to the helper thread without
+ * waiting for them to be compressed; if the helper is still busy with
+ * the previous block, they are handed over once it is free.  Only
+ * flush() and the destructor wait until everything written has reached
+ * the file.
+ *
+ * Like other LogDestinations, this class is not synchronized; it should
+ * be written to by one thread at a time (e.g. via an AsyncWriter).
+ */
+class CompressedFileDestination : public LogDestination {
+public:
+
+    /**
+     * the available compression formats
+     */
+    enum Codec {
+        /**
+         * the gzip format, via zlib's deflate
+         */
+        GZIP = 0,
+
+        /**
+         * the zstd format; only available if the package was built with
+         * LSST_PEX_LOGGING_HAVE_ZSTD defined
+         */
+        ZSTD
+    };
+
+    /**
+     * the level that selects each codec's default level of compression
+     */
+    static const int DEFAULT_LEVEL = -1;
+
+    /**
+     * the size of each block of uncompressed data by default
+     */
+    static const std::size_t DEFAULT_BLOCK_SIZE = 256*1024;
+
+    //@{
+    /**
+     * create a compressed file destination.  If the file does not exist,
+     * it will be created; otherwise, messages will be appended.
+     * A pex::exceptions::InvalidParameterError is thrown if the codec
+     * is not available.
+     * @param filepath    the path to the log file to write messages to.
+     * @param formatter   the LogFormatter to use to format the messages
+     * @param codec       the compression format
+     * @param level       the level of compression (1-9 for GZIP, 1-22 for
+     *                       ZSTD), or DEFAULT_LEVEL
+     * @param blockSize   the number of bytes of formatted records
+     *                       compressed at a time
+     * @param threshold   the minimum volume level required to pass a message
+     *                       to the stream.  If not provided, it would be set
+     *                       to 0.
+     * @param truncate    if True, overwrite the previous contents; otherwise,
+     *                       new messages will be appended to the file.
+     */
+    CompressedFileDestination(const boost::filesystem::path& filepath,
+                              const std::shared_ptr<LogFormatter>& formatter,
+                              Codec codec=GZIP, int level=DEFAULT_LEVEL,
+                              std::size_t blockSize=DEFAULT_BLOCK_SIZE,
+                              int threshold=threshold::PASS_ALL,
+                              bool truncate=false);
+    CompressedFileDestination(const std::string& filepath,
+                              const std::shared_ptr<LogFormatter>& formatter,
+                              Codec codec=GZIP, int level=DEFAULT_LEVEL,
+                              std::size_t blockSize=DEFAULT_BLOCK_SIZE,
+                              int threshold=threshold::PASS_ALL,
+                              bool truncate=false);
+    CompressedFileDestination(const char *filepath,
+                              const std::shared_ptr<LogFormatter>& formatter,
+                              Codec codec=GZIP, int level=DEFAULT_LEVEL,
+                              std::size_t blockSize=DEFAULT_BLOCK_SIZE,
+                              int threshold=threshold::PASS_ALL,
+                              bool truncate=false);
+    //@}
+
+    /**
+     * compress and write out everything written so far and close the file
+     */
+    virtual ~CompressedFileDestination();
+
+    /**
+     * return true if a codec is available in this build
+     */
+    static bool isSupported(Codec codec);
+
+    /**
+     * return the path to the log file
+     */
+    const boost::filesystem::path& getPath() const { return _path; }
+
+    /**
+     * return the compression format
+     */
+    Codec getCodec() const { return _codec; }
+
+    /**
+     * return the number of bytes of formatted records written so far
+     */
+    unsigned long long getBytesIn() const;
+
+    /**
+     * return the number of compressed bytes written to the file so far.
+     * This lags behind getBytesIn() until the destination is flushed.
+     */
+    unsigned long long getBytesOut() const;
+
+protected:
+    /**
+     * write a rendered record, handing the records to the helper thread
+     * when the FlushPolicy calls for a flush
+     */
+    virtual void _put(const LogRecord& rec, const std::string& text);
+
+private:
+    CompressedFileDestination(const CompressedFileDestination&);
+    CompressedFileDestination& operator=(const CompressedFileDestination&);
+
+    class CompressingBuffer;
+
+    boost::filesystem::path _path;
+    Codec _codec;
+    std::unique_ptr<CompressingBuffer> _buffer;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_COMPRESSEDFILEDESTINATION_H
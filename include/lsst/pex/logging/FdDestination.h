@@ -0,0 +1,137 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file FdDestination.h
+ * @brief definition of the FdDestination class
+ */
+#ifndef LSST_PEX_FDDESTINATION_H
+#define LSST_PEX_FDDESTINATION_H
+
+#include "lsst/pex/logging/LogDestination.h"
+
+#include <boost/filesystem/path.hpp>
+#include <memory>
+#include <string>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a LogDestination that writes to a file descriptor with writev(2)
+ * rather than through a file stream.
+ *
+ * Records written one at a time are collected in a buffer and written
+ * out when it is flushed according to the FlushPolicy, as with other
+ * destinations.  A sequence of records given to writeBatch() is rendered
+ * into separate buffers that are then handed to the kernel together with
+ * writev(2), up to IOV_MAX records per call, so that a backlog of many
+ * records (for example, one drained by an AsyncDestination) costs a few
+ * system calls rather than one per record.
+ *
+ * Like other LogDestinations, this class is not synchronized; it should
+ * be written to by one thread at a time (e.g. via an AsyncDestination).
+ */
+class FdDestination : public LogDestination {
+public:
+
+    /**
+     * create a destination that writes to an open file descriptor
+     * @param fd          the file descriptor to write messages to
+     * @param formatter   the LogFormatter to use to format the messages
+     * @param threshold   the minimum volume level required to pass a message
+     *                       to the stream.  If not provided, it would be set
+     *                       to 0.
+     * @param own         if true, the descriptor will be closed when this
+     *                       destination is deleted.
+     */
+    FdDestination(int fd, const std::shared_ptr<LogFormatter>& formatter,
+                  int threshold=threshold::PASS_ALL, bool own=false);
+
+    //@{
+    /**
+     * create a destination that writes to a file.  If the file does not
+     * exist, it will be created; otherwise, messages will be appended.
+     * A pex::exceptions::IoError is thrown if the file cannot be opened.
+     * @param filepath    the path to the log file to write messages to.
+     * @param formatter   the LogFormatter to use to format the messages
+     * @param threshold   the minimum volume level required to pass a message
+     *                       to the stream.  If not provided, it would be set
+     *                       to 0.
+     * @param truncate    if True, overwrite the previous contents; otherwise,
+     *                       new messages will be appended to the file.
+     */
+    FdDestination(const boost::filesystem::path& filepath,
+                  const std::shared_ptr<LogFormatter>& formatter,
+                  int threshold=threshold::PASS_ALL, bool truncate=false);
+    FdDestination(const std::string& filepath,
+                  const std::shared_ptr<LogFormatter>& formatter,
+                  int threshold=threshold::PASS_ALL, bool truncate=false);
+    FdDestination(const char *filepath,
+                  const std::shared_ptr<LogFormatter>& formatter,
+                  int threshold=threshold::PASS_ALL, bool truncate=false);
+    //@}
+
+    /**
+     * write out any buffered records and, if the descriptor is owned by
+     * this destination, close it
+     */
+    virtual ~FdDestination();
+
+    /**
+     * render the records that pass the threshold into separate buffers
+     * and write them out with as few calls to writev(2) as possible.  Any
+     * records buffered by earlier calls to write() are written out first.
+     * @param records   an array of pointers to the records to write
+     * @param count     the number of records in the array
+     * @return  the number of records written
+     */
+    virtual std::size_t writeBatch(const LogRecord* const* records,
+                                   std::size_t count);
+
+    /**
+     * return the file descriptor written to
+     */
+    int getFd() const { return _fd; }
+
+    /**
+     * return the number of calls to writev(2) made so far
+     */
+    unsigned long long getSyscallCount() const;
+
+private:
+    FdDestination(const FdDestination&);
+    FdDestination& operator=(const FdDestination&);
+
+    class FdBuffer;
+
+    int _fd;
+    bool _own;
+    std::unique_ptr<FdBuffer> _buffer;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_FDDESTINATION_H
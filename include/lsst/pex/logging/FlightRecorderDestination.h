@@ -0,0 +1,235 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file FlightRecorderDestination.h
+ * @brief definition of the FlightRecorderDestination class
+ */
+#ifndef LSST_PEX_FLIGHTRECORDERDESTINATION_H
+#define LSST_PEX_FLIGHTRECORDERDESTINATION_H
+
+#include "lsst/pex/logging/LogDestination.h"
+
+#include <boost/filesystem/path.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a LogDestination that keeps the most recent records in memory
+ * and writes them to a file only when something goes wrong.
+ *
+ * Rendered records are copied into a ring buffer allocated when the
+ * destination is created; once it holds the maximum number of records
+ * or bytes, the oldest records are dropped to make room.  The buffer is
+ * dumped, appending to the dump file, when:
+ * <ul>
+ *   <li> a record at or above the dump importance (Log::FATAL by
+ *        default) is written, e.g. by Log::fatal();
+ *   <li> dump() is called;
+ *   <li> the process receives SIGSEGV or SIGABRT after armSignals() has
+ *        been called.
+ * </ul>
+ * Each dump begins with a line starting with "###" giving its reason.
+ * Dumps other than those made from a signal handler empty the buffer, so
+ * that a later dump holds only what followed.
+ *
+ * The destination's threshold defaults to Log::DEBUG; to capture debug
+ * messages while other destinations report only at INFO, set the Log's
+ * threshold to DEBUG and give the other destinations a threshold of
+ * INFO.
+ *
+ * Like other LogDestinations, this class is not synchronized; it should
+ * be written to by one thread at a time.  The signal handler uses only
+ * async-signal-safe calls (open(2), write(2) and the like), and sees the
+ * buffer in a consistent state even if the signal interrupts a write on
+ * the same thread.
+ */
+class FlightRecorderDestination : public LogDestination {
+public:
+
+    /**
+     * the number of records kept by default
+     */
+    static const std::size_t DEFAULT_MAX_RECORDS;
+
+    /**
+     * the number of bytes of rendered records kept by default
+     */
+    static const std::size_t DEFAULT_MAX_BYTES;
+
+    /**
+     * the default threshold, Log::DEBUG
+     */
+    static const int DEFAULT_THRESHOLD;
+
+    //@{
+    /**
+     * create a flight recorder
+     * @param dumppath    the path to the file to append dumps to.  It is
+     *                       not created until the first dump.
+     * @param formatter   the LogFormatter to use to format the messages
+     * @param maxRecords  the most records to keep
+     * @param maxBytes    the most bytes of rendered records to keep.  A
+     *                       record longer than this keeps only its first
+     *                       maxBytes bytes.
+     * @param threshold   the minimum volume level required to pass a message
+     *                       to the buffer.
+     */
+    FlightRecorderDestination(const boost::filesystem::path& dumppath,
+                              const std::shared_ptr<LogFormatter>& formatter,
+                              std::size_t maxRecords=DEFAULT_MAX_RECORDS,
+                              std::size_t maxBytes=DEFAULT_MAX_BYTES,
+                              int threshold=DEFAULT_THRESHOLD);
+    FlightRecorderDestination(const std::string& dumppath,
+                              const std::shared_ptr<LogFormatter>& formatter,
+                              std::size_t maxRecords=DEFAULT_MAX_RECORDS,
+                              std::size_t maxBytes=DEFAULT_MAX_BYTES,
+                              int threshold=DEFAULT_THRESHOLD);
+    FlightRecorderDestination(const char *dumppath,
+                              const std::shared_ptr<LogFormatter>& formatter,
+                              std::size_t maxRecords=DEFAULT_MAX_RECORDS,
+                              std::size_t maxBytes=DEFAULT_MAX_BYTES,
+                              int threshold=DEFAULT_THRESHOLD);
+    //@}
+
+    /**
+     * delete this recorder, disarming the signal handlers if they were
+     * armed for it.  The buffer is not dumped.
+     */
+    virtual ~FlightRecorderDestination();
+
+    /**
+     * render a record into the buffer, dumping the buffer if the record
+     * is at or above the dump importance
+     * @return  true if the record was kept
+     */
+    virtual bool write(const LogRecord& rec);
+
+    /**
+     * copy a record into the buffer, using the text already rendered by
+     * an equivalent formatter if there is one, and dump the buffer if the
+     * record is at or above the dump importance
+     * @return  true if the record was kept
+     */
+    virtual bool write(RenderedRecord& rec);
+
+    /**
+     * append the contents of the buffer to the dump file and empty it
+     * @param reason   the reason for the dump, given in its first line
+     * @return  false if the dump file could not be opened or written to
+     */
+    bool dump(const std::string& reason="dump requested");
+
+    /**
+     * install handlers for SIGSEGV and SIGABRT that dump this recorder's
+     * buffer before passing the signal on to the handler that was in
+     * place before.  Only one recorder is armed at a time; arming another
+     * disarms this one.
+     */
+    void armSignals();
+
+    /**
+     * restore the signal handlers in place before armSignals() was
+     * called, if they are armed for this recorder
+     */
+    void disarmSignals();
+
+    /**
+     * return true if the signal handlers are armed for this recorder
+     */
+    bool isArmed() const;
+
+    /**
+     * return the importance at or above which a record triggers a dump
+     */
+    int getDumpImportance() const { return _dumpImportance; }
+
+    /**
+     * set the importance at or above which a record triggers a dump
+     */
+    void setDumpImportance(int importance) { _dumpImportance = importance; }
+
+    /**
+     * return the path to the file dumps are appended to
+     */
+    const std::string& getDumpPath() const { return _dumpPath; }
+
+    /**
+     * return the most records kept
+     */
+    std::size_t getMaxRecords() const { return _maxRecords; }
+
+    /**
+     * return the most bytes of rendered records kept
+     */
+    std::size_t getMaxBytes() const { return _maxBytes; }
+
+    /**
+     * return the number of records in the buffer
+     */
+    std::size_t getRecordCount() const { return _count; }
+
+    /**
+     * return the number of bytes of rendered records in the buffer
+     */
+    std::size_t getByteCount() const { return _tail - _head; }
+
+    /**
+     * return the number of dumps made, not counting those made from a
+     * signal handler
+     */
+    unsigned int getDumpCount() const { return _dumps; }
+
+private:
+    FlightRecorderDestination(const FlightRecorderDestination&);
+    FlightRecorderDestination& operator=(const FlightRecorderDestination&);
+
+    void _keep(const std::string& text);
+    bool _dumpTo(int fd, const char *reason) const;
+    static void _onSignal(int sig);
+
+    std::string _dumpPath;
+    std::size_t _maxRecords;
+    std::size_t _maxBytes;
+    int _dumpImportance;
+    unsigned int _dumps;
+    std::unique_ptr<char[]> _buf;                   // the rendered records
+    std::unique_ptr<unsigned long long[]> _ends;    // where each one ends
+    std::size_t _first;     // the index in _ends of the oldest record
+    std::size_t _count;     // the number of records kept
+
+    // the bytes kept, counted from the first byte ever kept; the signal
+    // handler relies on these being updated around each copy
+    std::atomic<unsigned long long> _head;
+    std::atomic<unsigned long long> _tail;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_FLIGHTRECORDERDESTINATION_H
@@ -0,0 +1,240 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file FormatBuffer.h
+ * @brief definition of the FormatBuffer and FormatArg classes
+ */
+#ifndef LSST_PEX_FORMATBUFFER_H
+#define LSST_PEX_FORMATBUFFER_H
+
+#include <string>
+#include <ostream>
+#include <cstdarg>
+#include <cstddef>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a type-erased reference to one argument of a message formatted
+ * with FormatBuffer::format().
+ *
+ * Built-in numbers, characters, booleans and strings are captured by
+ * value (or, for strings, by pointer) so that they can be rendered
+ * without going through a stream; any other type is rendered with its
+ * output operator (operator<<).  A FormatArg only refers to its
+ * argument, so it must not outlive the call it was created for.
+ * Applications normally do not create these directly.
+ */
+class FormatArg {
+public:
+    /**
+     * the kinds of values that are rendered directly
+     */
+    enum Kind { 
+        SIGNED, UNSIGNED, FLOAT, LONG_FLOAT, CHAR, BOOL, STRING, POINTER, OTHER
+    };
+
+    FormatArg(short val)              : _kind(SIGNED) { _v.i = val; }
+    FormatArg(int val)                : _kind(SIGNED) { _v.i = val; }
+    FormatArg(long val)               : _kind(SIGNED) { _v.i = val; }
+    FormatArg(long long val)          : _kind(SIGNED) { _v.i = val; }
+    FormatArg(unsigned short val)     : _kind(UNSIGNED) { _v.u = val; }
+    FormatArg(unsigned int val)       : _kind(UNSIGNED) { _v.u = val; }
+    FormatArg(unsigned long val)      : _kind(UNSIGNED) { _v.u = val; }
+    FormatArg(unsigned long long val) : _kind(UNSIGNED) { _v.u = val; }
+    FormatArg(float val)              : _kind(FLOAT) { _v.d = val; }
+    FormatArg(double val)             : _kind(FLOAT) { _v.d = val; }
+    FormatArg(long double val)        : _kind(LONG_FLOAT) { _v.f = val; }
+    FormatArg(char val)               : _kind(CHAR) { _v.c = val; }
+    FormatArg(signed char val)        : _kind(CHAR) { _v.c = val; }
+    FormatArg(unsigned char val)      : _kind(CHAR) { _v.c = val; }
+    FormatArg(bool val)               : _kind(BOOL) { _v.b = val; }
+    FormatArg(const void *val)        : _kind(POINTER) { _v.p = val; }
+    FormatArg(void *val)              : _kind(POINTER) { _v.p = val; }
+    FormatArg(const char *val) : _kind(STRING) { _setString(val); }
+    FormatArg(char *val)       : _kind(STRING) { _setString(val); }
+    FormatArg(const std::string& val) : _kind(STRING) {
+        _v.s.ptr = val.data();
+        _v.s.len = val.size();
+    }
+
+    /**
+     * capture a value of any other type, to be rendered via operator<<
+     */
+    template <class T>
+    FormatArg(const T& val) : _kind(OTHER) {
+        _v.o.ptr = &val;
+        _v.o.print = &_print<T>;
+    }
+
+    /**
+     * return the kind of value held
+     */
+    Kind getKind() const { return _kind; }
+
+private:
+    friend class FormatBuffer;
+    friend class BinaryTraceSite;
+
+    void _setString(const char *val);
+
+    template <class T>
+    static void _print(std::ostream& strm, const void *val) {
+        strm << *static_cast<const T*>(val);
+    }
+
+    Kind _kind;
+    union {
+        long long i;
+        unsigned long long u;
+        double d;
+        long double f;
+        char c;
+        bool b;
+        const void *p;
+        struct { const char *ptr; std::size_t len; } s;
+        struct {
+            const void *ptr;
+            void (*print)(std::ostream&, const void *);
+        } o;
+    } _v;
+};
+
+/**
+ * @brief a growable character buffer for formatting log messages that is
+ * reused by each thread.
+ *
+ * Creating a FormatBuffer borrows a buffer that belongs to the calling
+ * thread and that keeps its memory from one message to the next; thus,
+ * formatting a typical message does not allocate memory and never uses
+ * an amount of stack that depends on the message.  Messages are never
+ * truncated:  the buffer grows as needed.  If the thread's buffer is
+ * already in use (e.g. because rendering an argument itself formats a
+ * log message), a private buffer is used instead.  A FormatBuffer should
+ * only be used by the thread that created it.
+ *
+ * Two styles of formatting are supported.  printf() and vprintf() take
+ * printf-style format strings, rendering the message in a single pass
+ * unless the buffer must first grow.  format() takes a format string
+ * in which each "{}" is replaced by the next argument, rendered according
+ * to its type; no type letters are needed, and the arguments are checked
+ * by the compiler rather than trusted.  A placeholder may carry a
+ * printf-style specification after a colon, as in "{:.3f}", "{:>8}" or
+ * "{:08x}"; the specification's flags, width and precision are applied
+ * with the type's own conversion.  "{{" and "}}" produce literal braces.
+ * A placeholder without a corresponding argument is copied as is, and
+ * extra arguments are ignored.
+ */
+class FormatBuffer {
+public:
+
+    /**
+     * borrow the calling thread's buffer, emptied
+     */
+    FormatBuffer();
+
+    /**
+     * return the buffer to the calling thread
+     */
+    ~FormatBuffer();
+
+    /**
+     * return the formatted text
+     */
+    const std::string& str() const { return *_text; }
+
+    /**
+     * return the formatted text as a null-terminated string
+     */
+    const char *c_str() const { return _text->c_str(); }
+
+    /**
+     * return the number of characters formatted so far
+     */
+    std::size_t size() const { return _text->size(); }
+
+    /**
+     * discard the formatted text, keeping the memory for reuse
+     */
+    void clear() { _text->clear(); }
+
+    /**
+     * append text formatted from a printf-style format string.
+     */
+    void printf(const char *fmt, ...)
+#ifdef __GNUC__
+        __attribute__ ((format(printf, 2, 3)))
+#endif
+        ;
+
+    /**
+     * append text formatted from a printf-style format string and a
+     * variable argument list.  ap is left in an undefined state, as with
+     * vsnprintf().
+     */
+    void vprintf(const char *fmt, va_list ap);
+
+    /**
+     * append text formatted from a format string in which each "{}" is
+     * replaced by the next argument.
+     */
+    template <class... Args>
+    void format(const char *fmt, const Args&... args) {
+        const FormatArg list[] = { FormatArg(args)..., FormatArg(0) };
+        vformat(fmt, list, sizeof...(Args));
+    }
+
+    /**
+     * append text formatted from a "{}"-style format string and an array
+     * of arguments.
+     * @param fmt     the format string
+     * @param args    the arguments to insert
+     * @param nargs   the number of arguments in args
+     */
+    void vformat(const char *fmt, const FormatArg *args, std::size_t nargs);
+
+    /**
+     * append a single value, optionally formatted according to a
+     * printf-style specification (without the leading % and, optionally,
+     * without the conversion character).
+     */
+    void append(const FormatArg& arg, const char *spec=0, std::size_t len=0);
+
+private:
+    FormatBuffer(const FormatBuffer&);
+    FormatBuffer& operator=(const FormatBuffer&);
+
+    void _appendSpec(const FormatArg& arg, const char *spec, std::size_t len);
+
+    std::string *_text;
+    bool _borrowed;
+    std::string _own;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_FORMATBUFFER_H
@@ -0,0 +1,123 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file JsonString.h
+ * @brief definition of the JsonString class
+ */
+#ifndef LSST_PEX_JSONSTRING_H
+#define LSST_PEX_JSONSTRING_H
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief functions for writing text as JSON strings.
+ *
+ * A string is written in double quotes with '"', '\\' and the control 
+ * characters (below 0x20) escaped; all other bytes, including those of
+ * UTF-8 sequences, are copied as they are.  The text is scanned for 
+ * characters that need escaping many bytes at a time--32 with AVX2 where
+ * the processor supports it, 16 with SSE2, or 8 with portable word-wide
+ * operations otherwise--so that runs of ordinary text are copied in bulk.
+ */
+class JsonString {
+public:
+
+    /**
+     * the ways the text may be scanned
+     */
+    enum Scanner {
+        /**
+         * one byte at a time, for reference
+         */
+        BYTES = 0,
+
+        /**
+         * eight bytes at a time with ordinary integer operations
+         */
+        WORDS,
+
+        /**
+         * sixteen bytes at a time with SSE2 instructions
+         */
+        SSE2,
+
+        /**
+         * thirty-two bytes at a time with AVX2 instructions
+         */
+        AVX2
+    };
+
+    /**
+     * return the number of leading characters of a string that can be 
+     * copied without escaping, i.e. the position of the first that must 
+     * be escaped, or len if there are none.
+     */
+    static std::size_t scan(const char *text, std::size_t len);
+
+    /**
+     * write a string, in quotes and escaped, to a stream
+     */
+    static void write(std::ostream& strm, const char *text, std::size_t len);
+
+    /**
+     * write a string, in quotes and escaped, to a stream
+     */
+    static void write(std::ostream& strm, const std::string& text) {
+        write(strm, text.data(), text.size());
+    }
+
+    /**
+     * append a string, in quotes and escaped, to another string
+     */
+    static void append(std::string& out, const char *text, std::size_t len);
+
+    /**
+     * return the fastest scanner supported by the compiler and processor;
+     * this is the one scan() uses unless setScanner() chose another.
+     */
+    static Scanner bestScanner();
+
+    /**
+     * select the scanner used by scan(), for all threads.  A scanner that
+     * is not supported is replaced by the best that is.
+     * @return Scanner  the scanner that will be used
+     */
+    static Scanner setScanner(Scanner scanner);
+
+    /**
+     * return the scanner in use
+     */
+    static Scanner getScanner();
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_JSONSTRING_H
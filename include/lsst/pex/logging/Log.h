@@ -33,6 +33,8 @@
 #include "lsst/daf/base/PropertySet.h"
 #include "lsst/pex/logging/LogRecord.h"
 #include "lsst/pex/logging/LogDestination.h"
+#include "lsst/pex/logging/AsyncWriter.h"
+#include "lsst/pex/logging/FormatBuffer.h"
 #include "lsst/pex/logging/threshold/Memory.h"
 
 #include <vector>
@@ -277,11 +279,21 @@ public:
      * return the importance threshold for this log.  A message sent to this 
      * Log will not be recorded if the message importance is less than the 
      * threshold. 
+     *
+     * When this log inherits its threshold, the effective value is looked
+     * up once and cached until any threshold in the process is changed.
      */
     int getThreshold() const { 
-        return ((_threshold > INHERIT_THRESHOLD || _name.length() == 0) 
-                       ? _threshold
-                       : _thresholds->getThresholdFor(_name) );
+        if (_threshold > INHERIT_THRESHOLD || _name.length() == 0) 
+            return _threshold;
+
+        int out;
+        unsigned int generation = threshold::Memory::getGeneration();
+        if (! _cachedThreshold.get(generation, out)) {
+            out = _thresholds->getThresholdFor(_name);
+            _cachedThreshold.set(generation, out);
+        }
+        return out;
     }
 
     /**
@@ -376,6 +388,7 @@ public:
      * be stored in the preamble property under the key name "LABEL".
      */
     void addLabel(const std::string& val) {
+        _unsharePreamble();
         _preamble->add(LSST_LP_LABEL, val);
     }
 
@@ -540,7 +553,51 @@ public:
 #undef LEVELF
 
     /**
-     * send a fully formed LogRecord to the log destinations
+     * send a simple message formatted from a format string in which 
+     * each "{}" is replaced by the next argument, rendered according to 
+     * its type (see FormatBuffer).  As with format(), the formatting is 
+     * only done if the message will actually get recorded; the message 
+     * is rendered into a buffer reused by the calling thread.
+     * @code
+     *     log.logfmt(Log::INFO, "processed {} of {} ({:.1f}%)", i, n, pct);
+     * @endcode
+     * @param importance    how loud the message should be
+     * @param fmt          a "{}"-style format string
+     * @param args         the inputs to the formatting.
+     */
+    template <class... Args>
+    void logfmt(int importance, const char *fmt, const Args&... args) {
+        if (importance < getThreshold()) return;
+        FormatBuffer buf;
+        buf.format(fmt, args...);
+        log(importance, buf.str());
+    }
+
+    /** Define the following functions:
+
+     template <class... Args> void debugfmt(const char* fmt, const Args&...);
+     template <class... Args> void infofmt(const char* fmt, const Args&...);
+     template <class... Args> void warnfmt(const char* fmt, const Args&...);
+     template <class... Args> void fatalfmt(const char* fmt, const Args&...);
+
+     */
+#define LEVELF(fname, lev)                                     \
+    template <class... Args>                                   \
+    void fname(const char* fmt, const Args&... args) {         \
+        logfmt(lev, fmt, args...);                             \
+    }
+
+    LEVELF(debugfmt , DEBUG)
+    LEVELF(infofmt  , INFO )
+    LEVELF(warnfmt  , WARN )
+    LEVELF(fatalfmt , FATAL)
+
+#undef LEVELF
+
+    /**
+     * send a fully formed LogRecord to the log destinations.  The record
+     * is rendered only once for all destinations whose formatters are 
+     * equivalent (see LogFormatter::isEquivalent()).
      */
     void send(const LogRecord& record);
 
@@ -582,10 +639,60 @@ public:
         _destinations.push_back(destination);
     }
 
+    /**
+     * switch this log to asynchronous mode.  Records sent to this log 
+     * will be queued and written to the destinations by a background 
+     * thread (see AsyncWriter) rather than by the sending thread.  Like
+     * destinations, this mode will be inherited by all child Logs created
+     * from this log after a call to this function; previously created 
+     * logs are unaffected.  If this log is already asynchronous, its 
+     * current writer is flushed and replaced.
+     * @param capacity   the maximum number of records from each sending
+     *                      thread that may be waiting to be written.
+     * @param policy     what to do when a record is sent and the sending
+     *                      thread's queue is full.
+     */
+    void enableAsync(std::size_t capacity=AsyncWriter::DEFAULT_CAPACITY, 
+                     AsyncWriter::OverflowPolicy policy=AsyncWriter::BLOCK);
+
+    /**
+     * use a given AsyncWriter to write this log's records.  Several Log 
+     * hierarchies may share a single writer thread this way.  A null 
+     * pointer returns this log to synchronous mode.
+     */
+    void setAsyncWriter(const std::shared_ptr<AsyncWriter>& writer);
+
+    /**
+     * return this log to synchronous mode after writing out any records 
+     * still queued.  
+     */
+    void disableAsync() { setAsyncWriter(std::shared_ptr<AsyncWriter>()); }
+
+    /**
+     * return true if records sent to this log are written by a 
+     * background thread.
+     */
+    bool isAsync() const { return bool(_async); }
+
+    /**
+     * return the AsyncWriter used by this log or a null pointer if the 
+     * log is synchronous.
+     */
+    const std::shared_ptr<AsyncWriter>& getAsyncWriter() const { 
+        return _async; 
+    }
+
+    /**
+     * wait until all records sent to this log so far have been written to
+     * their destinations and flush the destinations' streams.
+     */
+    void flush();
+
     /** 
-     * return the current set of preamble properties
+     * return the current set of preamble properties, including the 
+     * log name ("LOG").  
      */
-    const lsst::daf::base::PropertySet& getPreamble() { return *_preamble; }
+    const lsst::daf::base::PropertySet& getPreamble();
 
     /**
      * Mark this Log as persistent in the Citizen framework.  This should
@@ -594,7 +701,7 @@ public:
      * global instance, the Citizen framework may complain about a leaked
      * PropertySet.
      */
-    void markPersistent() { _preamble->markPersistent(); }
+    void markPersistent();
 
     /**
      * obtain the default root Log instance.
@@ -672,13 +779,26 @@ protected:
      */
     void _format(int importance, const char* fmt, va_list ap);
 
+    /**
+     * make sure that this Log holds the only reference to its preamble 
+     * so that it may be changed.  The preamble is shared with copies 
+     * and children of this Log as well as with the LogRecords it 
+     * creates, so it must be copied before being altered if any of 
+     * them are still alive.  This should be called before any change 
+     * to the preamble.
+     */
+    void _unsharePreamble();
+
 private:
-    void completePreamble();
+    friend class LogRec;
 
     int _threshold;
+    threshold::CachedThreshold _cachedThreshold;
     std::shared_ptr<bool> _defShowAll;
     std::shared_ptr<bool> _myShowAll;
     std::string _name;
+    lsst::daf::base::PropertySet::Ptr _fullPreamble;
+    bool _persistent;
 
 protected: 
     /**
@@ -693,18 +813,28 @@ protected:
 
     /**
      * the list preamble data properties that are included with every 
-     * log record.
+     * log record, not including the log name.  This set is shared 
+     * (without copying) by this Log's copies and children and by the 
+     * records it creates; thus, it must not be altered without first 
+     * calling _unsharePreamble().
      */
     lsst::daf::base::PropertySet::Ptr _preamble;
+
+    /**
+     * the background writer used in asynchronous mode; null otherwise.
+     */
+    std::shared_ptr<AsyncWriter> _async;
 };
 
 template <class T>
 void Log::addPreambleProperty(const std::string& name, const T& val) {
+    _unsharePreamble();
     _preamble->add<T>(name, val);
 }
 
 template <class T>
 void Log::setPreambleProperty(const std::string& name, const T& val) {
+    _unsharePreamble();
     _preamble->set<T>(name, val);
 }
         
@@ -715,7 +845,7 @@ void Log::log(int importance, const std::string& message,
     int threshold = getThreshold();
     if (importance < threshold)
         return;
-    LogRecord rec(threshold, importance, *_preamble, willShowAll());
+    LogRecord rec(threshold, importance, _preamble, _name, willShowAll());
     rec.addComment(message);
     rec.addProperty(name, val);
     send(rec);
@@ -745,7 +875,8 @@ public:
      *                     threshold, the message will be recorded.
      */
     LogRec(Log& log, int importance) 
-        : LogRecord(log.getThreshold(), importance, log.getPreamble()), 
+        : LogRecord(log.getThreshold(), importance, log._preamble, 
+                    log.getName()), 
           _sent(false), _log(&log)
     { }
 
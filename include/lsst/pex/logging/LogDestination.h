@@ -36,6 +36,9 @@
 #include <string>
 #include <ostream>
 #include <memory>
+#include <cstddef>
+#include <utility>
+#include <vector>
 
 namespace lsst {
 namespace pex {
@@ -44,6 +47,178 @@ namespace logging {
 // forward declaration of LogRecord
 class LogRecord;
 
+/**
+ * @brief a rule for when a LogDestination flushes its output stream.
+ *
+ * A LogDestination hands each record to its stream in a single write; 
+ * the FlushPolicy decides when the stream is then flushed.  Flushing 
+ * after every record (the default) makes each record visible as soon as 
+ * it is written.  Flushing less often lets the stream collect several 
+ * records into one system call, which matters for busy or verbose logs; 
+ * records that are at least as important as a given level (by default, 
+ * Log::WARN) can still be made to flush immediately.  Records waiting in 
+ * a stream's buffer are also flushed by LogDestination::flush() and 
+ * Log::flush(), and when the stream is closed.
+ *
+ * The time limit is checked when a record is written; a destination that
+ * stops receiving records is not flushed on a timer.
+ */
+class FlushPolicy {
+public:
+
+    /**
+     * the importance at or above which records are flushed immediately 
+     * under the everyBytes() and everyMillis() policies by default.  This
+     * is equal to Log::WARN.
+     */
+    static const int DEFAULT_IMPORTANCE;
+
+    /**
+     * create a policy that flushes after every record
+     */
+    FlushPolicy() : _bytes(0), _millis(0), _importance(threshold::PASS_ALL) { }
+
+    /**
+     * return a policy that flushes after every record
+     */
+    static FlushPolicy everyRecord() { return FlushPolicy(); }
+
+    /**
+     * return a policy that flushes once a number of bytes have been 
+     * written since the last flush
+     * @param bytes       the number of bytes to let accumulate
+     * @param importance  records at least this important are flushed 
+     *                      immediately
+     */
+    static FlushPolicy everyBytes(std::size_t bytes, 
+                                  int importance=DEFAULT_IMPORTANCE) 
+    {
+        return FlushPolicy(bytes, 0, importance);
+    }
+
+    /**
+     * return a policy that flushes when a record is written at least 
+     * a given time after the last flush
+     * @param millis      the minimum time between flushes in milliseconds
+     * @param importance  records at least this important are flushed 
+     *                      immediately
+     */
+    static FlushPolicy everyMillis(long millis, 
+                                   int importance=DEFAULT_IMPORTANCE) 
+    {
+        return FlushPolicy(0, millis, importance);
+    }
+
+    /**
+     * return a policy that flushes once a number of bytes have been 
+     * written or a given time has passed since the last flush, whichever
+     * comes first.  A limit of zero is not applied.
+     * @param bytes       the number of bytes to let accumulate
+     * @param millis      the minimum time between flushes in milliseconds
+     * @param importance  records at least this important are flushed 
+     *                      immediately
+     */
+    static FlushPolicy limits(std::size_t bytes, long millis, 
+                              int importance=DEFAULT_IMPORTANCE) 
+    {
+        return FlushPolicy(bytes, millis, importance);
+    }
+
+    /**
+     * return the number of accumulated bytes that triggers a flush, or 
+     * zero if there is no such limit
+     */
+    std::size_t getBytes() const { return _bytes; }
+
+    /**
+     * return the time in milliseconds after which a flush is triggered, 
+     * or zero if there is no such limit
+     */
+    long getMillis() const { return _millis; }
+
+    /**
+     * return the importance at or above which every record is flushed
+     */
+    int getImportance() const { return _importance; }
+
+    /**
+     * return true if a stream should be flushed after writing a record.
+     * @param importance  the importance of the record just written
+     * @param pending     the number of bytes written since the last flush
+     * @param elapsed     the time since the last flush in nanoseconds
+     */
+    bool shouldFlush(int importance, std::size_t pending, 
+                     long long elapsed) const 
+    {
+        if (importance >= _importance) return true;
+        if (_bytes > 0 && pending >= _bytes) return true;
+        return (_millis > 0 && elapsed >= _millis * 1000000LL);
+    }
+
+    /**
+     * return true if shouldFlush() depends on the time of the last flush
+     */
+    bool isTimed() const { return _millis > 0; }
+
+private:
+    FlushPolicy(std::size_t bytes, long millis, int importance)
+        : _bytes(bytes), _millis(millis), _importance(importance) 
+    { 
+        // with no limits at all, there is nothing to wait for
+        if (_bytes == 0 && _millis == 0) _importance = threshold::PASS_ALL;
+    }
+
+    std::size_t _bytes;
+    long _millis;
+    int _importance;
+};
+
+/**
+ * @brief a log record together with the text it has been rendered into 
+ * by each of the formatters it has been written with.
+ *
+ * When a Log has several destinations, it hands each of them the same 
+ * RenderedRecord, so that destinations whose formatters are equivalent 
+ * (see LogFormatter::isEquivalent()) share a single rendering of the 
+ * record rather than each formatting it again.  Text once rendered is not
+ * changed.
+ */
+class RenderedRecord {
+public:
+
+    /**
+     * wrap a record that has not yet been rendered.  The record must 
+     * outlive this object.
+     */
+    explicit RenderedRecord(const LogRecord& rec) : _rec(rec), _texts() { }
+
+    /**
+     * return the record
+     */
+    const LogRecord& getRecord() const { return _rec; }
+
+    /**
+     * return the record as rendered by a formatter or one equivalent to 
+     * it, rendering it if this has not been done yet.  The text remains
+     * valid until the next call to this function.
+     */
+    const std::string& render(LogFormatter& formatter);
+
+    /**
+     * return the number of times the record has been rendered
+     */
+    std::size_t getRenderCount() const { return _texts.size(); }
+
+private:
+    RenderedRecord(const RenderedRecord&);
+    RenderedRecord& operator=(const RenderedRecord&);
+
+    typedef std::pair<LogFormatter*, std::string> Text;
+
+    const LogRecord& _rec;
+    std::vector<Text> _texts;
+};
+
 /**
  * @brief an encapsulation of a logging stream that will filter messages
  * based on their volume (importance) level.  
@@ -105,6 +280,14 @@ public:
      */
     void setThreshold(int threshold) { _threshold = threshold; }
 
+    /**
+     * return the formatter used to render records for this destination's
+     * stream
+     */
+    const std::shared_ptr<LogFormatter>& getFormatter() const { 
+        return _frmtr; 
+    }
+
     /**
      * record a given log record to this destinations output stream. The 
      * record will be sent to the stream attached to this class if (a)
@@ -112,15 +295,79 @@ public:
      * formatter, and (c) the importance level associated with the
      * record is equal to or greater than the threshold associated
      * with this destination. 
+     * Subclasses that hand records on elsewhere (such as 
+     * AsyncDestination) may override this.
+     * @return  true if the record was actually passed to the
+     *          associated stream. 
+     */
+    virtual bool write(const LogRecord& rec);
+
+    /**
+     * record a log record to this destination's output stream, using the
+     * text already rendered by an equivalent formatter if there is one.
+     * The conditions are those of write(const LogRecord&); subclasses 
+     * that override one of these should override both.
      * @return  true if the record was actually passed to the
      *          associated stream. 
      */
-    bool write(const LogRecord& rec);
+    virtual bool write(RenderedRecord& rec);
+
+    /**
+     * record a sequence of log records to this destination's output 
+     * stream, in order.  Each record is subject to the conditions of 
+     * write(const LogRecord&).  By default, the records are simply 
+     * written one at a time; subclasses may override this to hand the 
+     * whole sequence to the operating system at once (see FdDestination).
+     * @param records   an array of pointers to the records to write
+     * @param count     the number of records in the array
+     * @return  the number of records actually passed to the associated
+     *          stream
+     */
+    virtual std::size_t writeBatch(const LogRecord* const* records, 
+                                   std::size_t count);
+
+    /**
+     * flush the output stream if anything has been written to it since 
+     * it was last flushed
+     */
+    virtual void flush();
+
+    /**
+     * return the rule for when the output stream is flushed
+     */
+    const FlushPolicy& getFlushPolicy() const { return _flushPolicy; }
+
+    /**
+     * set the rule for when the output stream is flushed.  
+     */
+    void setFlushPolicy(const FlushPolicy& policy) { _flushPolicy = policy; }
+
+    /**
+     * return the number of bytes written to the stream since it was 
+     * last flushed
+     */
+    std::size_t getPendingBytes() const { return _pending; }
 
 protected:
+    /**
+     * render a record with this destination's formatter, appending it to
+     * a string
+     */
+    void _render(const LogRecord& rec, std::string& out);
+
+    /**
+     * write a rendered record to the stream and flush it according to 
+     * the FlushPolicy.  A subclass may override this to act before each 
+     * record reaches the stream.
+     */
+    virtual void _put(const LogRecord& rec, const std::string& text);
+
     int _threshold;   // the stream's threshold
     std::ostream *_strm;   // the output stream
     std::shared_ptr<LogFormatter> _frmtr;    // the formatter to use
+    FlushPolicy _flushPolicy;
+    std::size_t _pending;     // bytes written since the last flush
+    long long _lastFlush;     // time of the last flush
 };
 
 }}}     // end lsst::pex::logging
@@ -26,7 +26,8 @@
  * @file LogFormatter.h
  * @ingroup pex
  * @brief definitions of the LogFormatter.h abstract class and its 
- * implementing classes, BriefFormatter, NetLoggerFormatter
+ * implementing classes, BriefFormatter, NetLoggerFormatter, 
+ * PatternFormatter, JsonLinesFormatter, BinaryFormatter
  * @author Ray Plante
  */
 #ifndef LSST_PEX_LOGFORMATTER_H
@@ -34,6 +35,9 @@
 
 #include <string>
 #include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 #include <ostream>
 
 #include "lsst/daf/base/PropertySet.h"
@@ -83,13 +87,32 @@ public:
     LogFormatter& operator=(LogFormatter const& that) { return *this; }
 
     /**
-     * write out a log record to a stream
+     * write out a log record to a stream.  Implementations should end lines
+     * with '\n' rather than std::endl and leave flushing the stream to the 
+     * caller; a LogDestination renders each record into memory and 
+     * flushes its stream according to its FlushPolicy.
      * @param strm   pointer to the output stream to write the record to.  If 
      *                 the pointer is null, nothing is written.  
      * @param rec    the record to write
      */
     virtual void write(std::ostream *strm, LogRecord const& rec) = 0;
 
+    /**
+     * return true if this formatter renders every record exactly as 
+     * another one does, so that a record rendered by one can be written 
+     * in place of the other's (see RenderedRecord).  By default, a 
+     * formatter is only equivalent to itself.
+     */
+    virtual bool isEquivalent(LogFormatter const& that) const;
+
+    /**
+     * prepare to write to a new stream, as when a destination starts a 
+     * new file.  A formatter that writes something at the start of a 
+     * stream, or that remembers what it has written to it, should start 
+     * over.  By default, this does nothing.
+     */
+    virtual void startStream();
+
 };
 
 /**
@@ -148,6 +171,14 @@ public:
      */
     virtual void write(std::ostream *strm, LogRecord const& rec);
 
+    /**
+     * return true if the other formatter is of the same class and 
+     * verbosity as this one.  Subclasses other than IndentedFormatter 
+     * and PrependedFormatter are only equivalent to themselves unless 
+     * they override this.
+     */
+    virtual bool isEquivalent(LogFormatter const& that) const;
+
 private:
 
     bool _doAll;
@@ -228,6 +259,13 @@ public:
      */
     virtual void write(std::ostream *strm, LogRecord const& rec);
 
+    /**
+     * return true if the other formatter is of the same class and 
+     * uses the same value delimiter as this one.  A subclass is only 
+     * equivalent to itself unless it overrides this.
+     */
+    virtual bool isEquivalent(LogFormatter const& that) const;
+
     static const std::string defaultValDelim;
 
 private:
@@ -275,6 +313,283 @@ public:
     virtual void write(std::ostream *strm, LogRecord const& rec);
 };
 
+/**
+ * @brief a formatter that lays out records according to a pattern.
+ *
+ * The pattern is text in which the following directives are replaced 
+ * with parts of the record:
+ * @verbatim
+ *   %d         the date (DATE), as "2016-03-01T18:04:05.012345"
+ *   %n         the log name (LOG)
+ *   %l         the importance level (LEVEL), as a number
+ *   %L         the level as a word:  DEBUG, INFO, WARNING, or FATAL
+ *   %b         the label (LABEL), if any
+ *   %m         the message (COMMENT)
+ *   %v{NAME}   the value of the property NAME, if it exists
+ *   %p{A,B}    " A=value" for each value of each of the properties A, B, 
+ *                ... that exist
+ *   %%         a single %
+ * @endverbatim
+ * For example, "%d %L %n: %m%p{visit,ccd}" produces lines like 
+ * "2016-03-01T18:04:05.012345 INFO pipe.isr: done visit=85471 ccd=12".
+ * Any other use of % is copied as is.
+ * 
+ * A record produces one line for each of its messages; a pattern without
+ * %m produces one line per record.  The pattern is compiled once, when 
+ * the formatter is created, into a list of operations that write 
+ * directly to the output stream, so writing a record involves no parsing
+ * or building of intermediate strings.  The standard properties are read
+ * without exceptions, and directly from a compact record, as are the 
+ * properties named by %v and %p, which are looked up in its preamble and
+ * extra properties without assembling it.
+ */
+class PatternFormatter : public LogFormatter {
+public:
+
+    /**
+     * the pattern used by default, "%d %L %n: %m"
+     */
+    static const std::string DEFAULT_PATTERN;
+
+    /**
+     * create a formatter for a given pattern
+     * @param pattern   the pattern describing the layout of each line
+     */
+    explicit PatternFormatter(std::string const& pattern=DEFAULT_PATTERN);
+
+    PatternFormatter(PatternFormatter const& that)
+        : LogFormatter(that), _pattern(that._pattern), _ops(that._ops),
+          _perMessage(that._perMessage)
+    {}
+
+    virtual ~PatternFormatter();
+
+    PatternFormatter& operator=(PatternFormatter const& that) {
+        if (this == &that) return *this;
+
+        dynamic_cast<LogFormatter*>(this)->operator=(that);
+        _pattern = that._pattern;
+        _ops = that._ops;
+        _perMessage = that._perMessage;
+        return *this; 
+    }
+
+    /**
+     * return the pattern this formatter lays out records with
+     */
+    std::string const& getPattern() const { return _pattern; }
+
+    /**
+     * write out a log record to a stream
+     * @param strm   the output stream to write the record to
+     * @param rec    the record to write
+     */
+    virtual void write(std::ostream *strm, LogRecord const& rec);
+
+    /**
+     * return true if the other formatter is of the same class and 
+     * uses the same pattern as this one.  A subclass is only equivalent 
+     * to itself unless it overrides this.
+     */
+    virtual bool isEquivalent(LogFormatter const& that) const;
+
+private:
+    // one compiled operation:  write text, a part of the record, or the
+    // values of the named properties
+    struct Op {
+        enum Kind { TEXT, DATE, LOG, LEVEL, LEVEL_NAME, LABEL, MESSAGE, 
+                    VALUE, PROPERTIES };
+        Kind kind;
+        std::string text;
+        std::vector<std::string> names;
+    };
+
+    void _compile();
+
+    std::string _pattern;
+    std::vector<Op> _ops;
+    bool _perMessage;
+};
+
+/**
+ * @brief a formatter that writes each record as a JSON object on a line 
+ * of its own ("JSON lines").
+ *
+ * Each property of the record becomes a member of the object, named 
+ * after the property, with a value of the corresponding JSON type:
+ * strings and characters become strings; integers, floating-point 
+ * numbers and DateTimes (as nanoseconds) become numbers; and booleans 
+ * become true or false.  A property with several values becomes an 
+ * array; COMMENT is always an array, even when the record has only one
+ * comment, so that readers need not check its type.  The standard 
+ * properties come first, in the order DATE, LEVEL, LOG, COMMENT; for 
+ * example:
+ * @verbatim
+ * {"DATE":"2016-03-01T18:04:05.012345","LEVEL":0,"LOG":"pipe.isr","COMMENT":["done"],"visit":85471,"LABEL":"stage3"}
+ * @endverbatim
+ * Numbers are written exactly (see NumberFormat); as JSON cannot 
+ * represent infinities or NaNs, they are written as null.  Strings are
+ * escaped with JsonString.  Values of types that PropertyVisitor does not
+ * know are written as strings.
+ */
+class JsonLinesFormatter : public LogFormatter {
+public:
+
+    JsonLinesFormatter() : LogFormatter() {}
+
+    JsonLinesFormatter(JsonLinesFormatter const& that) : LogFormatter(that) {}
+
+    virtual ~JsonLinesFormatter();
+
+    JsonLinesFormatter& operator=(JsonLinesFormatter const& that) {
+        if (this == &that) return *this;
+
+        dynamic_cast<LogFormatter*>(this)->operator=(that);
+        return *this; 
+    }
+
+    /**
+     * write out a log record to a stream
+     * @param strm   the output stream to write the record to
+     * @param rec    the record to write
+     */
+    virtual void write(std::ostream *strm, LogRecord const& rec);
+
+    /**
+     * return true if the other formatter is of the same class as this 
+     * one.  A subclass is only equivalent to itself unless it overrides 
+     * this.
+     */
+    virtual bool isEquivalent(LogFormatter const& that) const;
+};
+
+/**
+ * @brief a formatter that writes records in a compact binary form for 
+ * later decoding with BinaryLogReader.
+ *
+ * Text formatting can dominate the cost of high-rate debug logging; this 
+ * formatter instead writes each record as a length-prefixed frame holding 
+ * its level, its TIMESTAMP as a 64-bit nanosecond count, its comments, and 
+ * its other properties as typed binary values.  Log names and property 
+ * names are interned:  the first frame that uses a name defines an id for 
+ * it, and later frames refer to the id.  The preamble shared by the 
+ * records of a Log (LogRecord::getPreamble()) is interned the same way, 
+ * so its properties are written once rather than with every record.  
+ * Properties of types other than the built-in numbers, strings, booleans 
+ * and DateTime are written as the text that PropertyVisitor renders for 
+ * them.
+ *
+ * The stream begins with a header frame; a new header (as when a file 
+ * written by an earlier BinaryFormatter is appended to) starts over with 
+ * no names defined.  All integers in a frame are unsigned LEB128 varints 
+ * (with zig-zag encoding for signed values) except for TIMESTAMP and 
+ * floating-point values, which are little-endian.  A frame is:
+ * @code
+ *   frame    := length kind payload     (length counts kind and payload)
+ *   header   := 'H' "LSSTBLOG" version
+ *   record   := 'R' flags level [timestamp] [logref] preref
+ *                   ncomments {string} {keyref type value}
+ *   logref, keyref := 2*id | 2*id+1 string     (odd: defines the next id)
+ *   preref   := 0 | 2*id+2 | 2*id+3 nvalues {keyref type value}
+ *   string   := length bytes
+ * @endcode
+ * A record's own values are not counted; they run to the end of its 
+ * frame.  Only the values defining a preamble are preceded by a count.
+ * BinaryTrace writes its messages in the same format, with two more kinds 
+ * of frames:
+ * @code
+ *   format   := 'F' id name verbosity file line format codes
+ *   event    := 'E' id timestamp args       (see BinaryTrace::ArgCode)
+ * @endcode
+ * Each writer keeps its own tables of ids, and a header frame clears a 
+ * reader's tables, so BinaryTrace and a BinaryFormatter must not write to 
+ * the same stream; give each a stream (or file) of its own.
+ *
+ * Because a BinaryFormatter remembers what it has written, an instance 
+ * must only be used with one stream at a time, and, like a LogDestination, 
+ * it is not synchronized.  A copy starts a new stream of its own, as does 
+ * an instance after startStream() (which a RotatingFileDestination calls 
+ * whenever it starts a new file).
+ */
+class BinaryFormatter : public LogFormatter {
+public:
+
+    /**
+     * the kinds of frames
+     */
+    enum Frame { 
+        HEADER = 'H', RECORD = 'R', TRACE_FORMAT = 'F', TRACE_EVENT = 'E'
+    };
+
+    /**
+     * the bits of a record's flags
+     */
+    enum Flag { HAS_TIMESTAMP = 1, HAS_DATE = 2, HAS_LOG = 4 };
+
+    /**
+     * the codes for the types of property values
+     */
+    enum ValueType {
+        BOOL = 'b', CHAR = 'c', SHORT = 's', INT = 'i', LONG = 'l', 
+        LONG_LONG = 'q', UNSIGNED_LONG_LONG = 'Q', FLOAT = 'f', DOUBLE = 'd',
+        STRING = 'S', DATETIME = 'T', TEXT = 'x'
+    };
+
+    /**
+     * the 8 characters that identify a header frame
+     */
+    static const char MAGIC[];
+
+    /**
+     * the version of the format written
+     */
+    static const int VERSION = 1;
+
+    /**
+     * the number of preambles remembered; the properties of records with 
+     * other preambles are written with each record.
+     */
+    static const std::size_t MAX_PREAMBLES = 64;
+
+    BinaryFormatter();
+
+    BinaryFormatter(BinaryFormatter const& that);
+
+    virtual ~BinaryFormatter();
+
+    BinaryFormatter& operator=(BinaryFormatter const& that) {
+        if (this == &that) return *this;
+
+        dynamic_cast<LogFormatter*>(this)->operator=(that);
+        _reset();
+        return *this; 
+    }
+
+    /**
+     * write out a log record to a stream
+     * @param strm   the output stream to write the record to
+     * @param rec    the record to write
+     */
+    virtual void write(std::ostream *strm, LogRecord const& rec);
+
+    /**
+     * forget the names and preambles written so far, so that the next 
+     * record starts with a header frame
+     */
+    virtual void startStream();
+
+private:
+    typedef std::shared_ptr<const lsst::daf::base::PropertySet> PreamblePtr;
+
+    void _reset();
+
+    bool _started;
+    std::string _frame;
+    std::unordered_map<std::string, unsigned long long> _names;
+    std::unordered_map<const lsst::daf::base::PropertySet*, 
+                       unsigned long long> _preambleIds;
+    std::vector<PreamblePtr> _preambles;
+};
 
 }}}     // end lsst::pex::logging
 
@@ -31,10 +31,15 @@
 #define LSST_PEX_LOGRECORD_H
 
 #include "lsst/daf/base/PropertySet.h"
+#include "lsst/pex/logging/PropertyVisitor.h"
 
 #include <memory>
+#include <boost/any.hpp>
+#include <boost/container/small_vector.hpp>
 #include <boost/format.hpp>
 #include <string>
+#include <typeinfo>
+#include <vector>
 #include <sys/time.h>
 
 #define LSST_LP_COMMENT     "COMMENT"
@@ -96,10 +101,27 @@ public:
  *
  * The purpose of this class is to collect data for inclusion in a message
  * to a Log.  
+ *
+ * To keep the cost of creating a record low, a record does not initially
+ * hold its data in a PropertySet.  Instead, the properties that every 
+ * record has--the importance level, the log name, the timestamp, and the 
+ * comments--are kept in fixed slots; the preamble is shared with (rather 
+ * than copied from) the Log that created the record; and any other 
+ * properties added to the record are kept in a short list.  A PropertySet 
+ * is only assembled from these pieces when one is asked for via data() 
+ * (or getProperties()).  This compact form is reflected by isCompact(); 
+ * while it is true, the getLogName(), getComments(), getTimestamp(), and 
+ * getPreamble() accessors provide a complete picture of the core 
+ * properties without requiring the PropertySet.  
  */
 class LogRecord {
 public:
 
+    /**
+     * the container type used to hold the comments in a record
+     */
+    typedef boost::container::small_vector<std::string, 1> CommentList;
+
     /**
      * Create a log record to be sent to a given log.  The current time is 
      * recorded and set as the DATE property.
@@ -124,7 +146,7 @@ public:
      *                     threshold, the message will be recorded.
      * @param preamble   an ordered set of properties that constitute the 
      *                     preamble of this message.  This should not include
-     *                     the current time.  
+     *                     the current time.  A copy of the preamble is made.
      * @param showAll    if true, prefer showing all properties when 
      *                     rendering this record.  The default is false.
      *                     (See willShowAll().)
@@ -132,14 +154,34 @@ public:
     LogRecord(int threshold, int importance, 
               const lsst::daf::base::PropertySet& preamble, bool showAll=false);
 
+    /**
+     * Create a log record to be sent to a given log, sharing the log's 
+     * preamble.  The current time is recorded and set as the DATE property.
+     * @param threshold  the importance threshold that determines if a message
+     *                     is printed.
+     * @param importance  the loudness of the record.  If this value is 
+     *                     greater than or equal to the given importance 
+     *                     threshold, the message will be recorded.
+     * @param preamble   an ordered set of properties that constitute the 
+     *                     preamble of this message.  This should not include
+     *                     the current time.  The set is not copied; thus, 
+     *                     the owner of the preamble must not alter it 
+     *                     while it is shared (i.e. it should copy-on-write).
+     *                     A null pointer is treated as an empty preamble.
+     * @param logName    the name of the log sending this record; this will 
+     *                     be reported as the LOG property.
+     * @param showAll    if true, prefer showing all properties when 
+     *                     rendering this record.  The default is false.
+     *                     (See willShowAll().)
+     */
+    LogRecord(int threshold, int importance, 
+              const std::shared_ptr<const lsst::daf::base::PropertySet>& preamble,
+              const std::string& logName, bool showAll=false);
+
     /**
      * create a copy of a record
      */
-    LogRecord(const LogRecord& that) 
-        : _send(that._send), _showAll(that._showAll), _vol(that._vol), _data()
-    { 
-        _data = that._data->deepCopy();
-    }   
+    LogRecord(const LogRecord& that);
 
     /**
      * delete this log record
@@ -149,13 +191,7 @@ public:
     /**
      * copy another record into this one.
      */
-    LogRecord& operator=(const LogRecord& that) {
-        _send = that._send; 
-        _showAll = that._showAll; 
-        _vol = that._vol; 
-        _data = that._data;
-        return *this;
-    }
+    LogRecord& operator=(const LogRecord& that);
 
     /**
      * add a string comment to this record.  The comment will get stored 
@@ -164,7 +200,14 @@ public:
      * the record is constructed (usually by a Log object).  
      */
     void addComment(const std::string& comment) {
-        if (_send) _data->add(LSST_LP_COMMENT, comment);
+        if (! _send) return;
+        if (_data) {
+            _data->add(LSST_LP_COMMENT, comment);
+        }
+        else {
+            _comments.push_back(comment);
+            _cache.reset();
+        }
     }
 
     /**
@@ -187,6 +230,14 @@ public:
     template <class T>
     void addProperty(const std::string& name, const T& val);
 
+    /**
+     * attach a named string to this record.  This version allows a 
+     * string literal to be passed as the value.  
+     */
+    void addProperty(const std::string& name, const char *val) {
+        addProperty(name, std::string(val));
+    }
+
     /**
      * add all of the properties found in the given PropertySet.  
      * This will make sure not to overwrite critical properties, 
@@ -217,21 +268,32 @@ public:
 
     /**
      * return the data properties that make up this log message.  
-     * This is a synonym for getProperties().
+     * This is a synonym for getProperties().  If this record is compact, 
+     * a PropertySet is assembled from its parts when first asked for; 
+     * the record remains compact.  
      */
-    const lsst::daf::base::PropertySet& data() const { return *_data; }
+    const lsst::daf::base::PropertySet& data() const {
+        if (_data) return *_data;
+        if (! _cache) _cache = _assemble();
+        return *_cache;
+    }
 
     /**
      * return the data properties that make up this log message.  
-     * This is a synonym for getProperties().
+     * This is a synonym for getProperties().  Because the caller may 
+     * alter the returned PropertySet, it becomes the definitive store of 
+     * this record's data, and the record is no longer compact.  
      */
-    lsst::daf::base::PropertySet& data() { return *_data; }
+    lsst::daf::base::PropertySet& data() {
+        if (! _data) _expand();
+        return *_data;
+    }
 
     /**
      * return the number available property parameter names (i.e. ones 
      * that return non-PropertySet values). 
      */
-    size_t countParamNames() {
+    size_t countParamNames() const {
         std::vector<std::string> names = data().paramNames(false);
         return names.size();
     }
@@ -275,6 +337,153 @@ public:
      */
     void setShowAll(bool yesno) {  _showAll = yesno;  }
 
+    /**
+     * return true if this record's data are still held in their compact 
+     * form.  When true, the level (getImportance()), LOG (getLogName()),
+     * COMMENT (getComments()), TIMESTAMP (getTimestamp()), and DATE 
+     * (getDate()) properties, as well as LABEL and any others from the 
+     * preamble (getPreamble()), can be read without assembling a 
+     * PropertySet; other properties added to the record are only 
+     * available via data().  When false, data() is the only reliable 
+     * source of the record's properties.
+     */
+    bool isCompact() const { return ! _data; }
+
+    /**
+     * return true if this record carries a LOG property taken from 
+     * its creator's name.  This is only meaningful if isCompact() is true.
+     */
+    bool hasLogName() const { return _hasLogName; }
+
+    /**
+     * return the name of the log that created this record.  This is only 
+     * meaningful if isCompact() and hasLogName() are true.
+     */
+    const std::string& getLogName() const { return _logName; }
+
+    /**
+     * return the comments attached to this record.  This is only 
+     * meaningful if isCompact() is true.
+     */
+    const CommentList& getComments() const { return _comments; }
+
+    /**
+     * return the preamble properties shared by this record, which may be 
+     * a null pointer.  This is only meaningful if isCompact() is true.
+     */
+    const std::shared_ptr<const lsst::daf::base::PropertySet>& getPreamble() const {
+        return _preamble;
+    }
+
+    /**
+     * return the time this record was created (or last stamped via
+     * setTimestamp()) as UTC nanoseconds since Jan 1, 1970.  This is only 
+     * meaningful if isCompact() is true.
+     */
+    long long getTimestamp() const { return _timestamp; }
+
+    /**
+     * return true if this record carries the TIMESTAMP property.  This is 
+     * only meaningful if isCompact() is true.
+     */
+    bool hasTimestamp() const { return _hasTimestamp; }
+
+    /**
+     * return true if this record carries the DATE property (see setDate()).
+     * This is only meaningful if isCompact() is true.
+     */
+    bool hasDate() const { return _hasDate; }
+
+    /**
+     * return the value of the DATE property, the formatted version of 
+     * getTimestamp().  This is only meaningful if isCompact() and 
+     * hasDate() are true.
+     */
+    std::string getDate() const { return formatDate(_timestamp); }
+
+    /**
+     * look up the value of a property without the risk of an exception.
+     * Use this instead of data().get<T>() when the property may be missing
+     * or have an unexpected type, as for optional ones like LABEL.  For a 
+     * compact record, this assembles the data (see data()); the 
+     * tryGet*() functions below do not.
+     * @param name    the name of the property
+     * @param value   set to the property's (last) value if it is found
+     * @return bool   true if the property exists and has type T; 
+     *                  otherwise, value is left unchanged.
+     */
+    template <class T>
+    bool tryGet(const std::string& name, T& value) const {
+        return tryGet(data(), name, value);
+    }
+
+    /**
+     * look up the value of a property in a PropertySet without the risk 
+     * of an exception.
+     * @param props   the properties to search
+     * @param name    the name of the property
+     * @param value   set to the property's (last) value if it is found
+     * @return bool   true if the property exists and has type T; 
+     *                  otherwise, value is left unchanged.
+     */
+    template <class T>
+    static bool tryGet(const lsst::daf::base::PropertySet& props, 
+                       const std::string& name, T& value)
+    {
+        if (! props.exists(name) || props.typeOf(name) != typeid(T)) 
+            return false;
+        value = props.get<T>(name);
+        return true;
+    }
+
+    /**
+     * look up the LEVEL property (an int) without the risk of an exception
+     * @return bool   true if it was found; otherwise value is unchanged.
+     */
+    bool tryGetLevel(int& value) const;
+
+    /**
+     * look up the LOG property (a string) without the risk of an exception
+     * @return bool   true if it was found; otherwise value is unchanged.
+     */
+    bool tryGetLogName(std::string& value) const;
+
+    /**
+     * look up the LABEL property (a string) without the risk of an 
+     * exception
+     * @return bool   true if it was found; otherwise value is unchanged.
+     */
+    bool tryGetLabel(std::string& value) const;
+
+    /**
+     * look up the DATE property (a string) without the risk of an 
+     * exception
+     * @return bool   true if it was found; otherwise value is unchanged.
+     */
+    bool tryGetDate(std::string& value) const;
+
+    /**
+     * look up all values of the COMMENT property without the risk of an 
+     * exception
+     * @return bool   true if it was found; otherwise value is unchanged.
+     */
+    bool tryGetComments(std::vector<std::string>& value) const;
+
+    /**
+     * hand each value of this record's properties, other than the standard
+     * ones kept in the fixed slots of a compact record (LOG, LEVEL, 
+     * COMMENT, TIMESTAMP, and DATE), to a visitor.  Unlike data(), this 
+     * does not assemble a compact record.  The index passed with each 
+     * value counts the values added together (e.g. in one call to 
+     * addProperty()) rather than all the values of the property.
+     * @param visitor       the visitor to hand the values to
+     * @param withPreamble  if false and this record is compact, the 
+     *                        properties of its preamble (getPreamble())
+     *                        are not visited.
+     */
+    void visitProperties(PropertyVisitor& visitor, 
+                         bool withPreamble=true) const;
+
     /**
      * set the TIMESTAMP property to the current time.  The value is stored as 
      * a lsst::daf::base::DateTime instance.  
@@ -285,6 +494,14 @@ public:
      */  
     void setTimestamp();
 
+    /**
+     * set the TIMESTAMP property to a given time, as when a record is 
+     * recreated from a copy written earlier.  If there is also a DATE 
+     * property, it will be updated as well.
+     * @param nsecs   the UTC time in nanosecs since Jan 1, 1970
+     */
+    void setTimestamp(long long nsecs);
+
     /**
      * set the DATE property to the current value of the TIMESTAMP property.
      * The value is a string representation of the TIMESTAMP property, 
@@ -301,19 +518,31 @@ public:
 
     /**
      * return the current UTC time in nanosecs since Jan 1, 1970.  This value
-     * is suitable for passing to a DateTime constructor.  
+     * is suitable for passing to a DateTime constructor.  The clock used 
+     * may be selected with Timestamp::setClock().
      */
     static long long utcnow();
 
+    /**
+     * format a UTC time given in nanosecs since Jan 1, 1970 the way it 
+     * appears in the DATE property (see Timestamp::format()).
+     */
+    static std::string formatDate(long long nsecs);
+
 protected: 
-    LogRecord() : _send(false), _vol(10), _data(new lsst::daf::base::PropertySet()) { }
+    LogRecord() 
+        : _send(false), _showAll(false), _vol(10), _hasLogName(false), 
+          _hasTimestamp(false), _hasDate(false), _timestamp(0), _logName(), 
+          _preamble(), _comments(), _extras(), _cache(), 
+          _data(new lsst::daf::base::PropertySet()) 
+    { }
 
     /**
      * initialize this record with the DATE and LEVEL properties
      */
     void _init() {
         if (_send) {
-            _data->set("LEVEL", _vol);
+            if (_data) _data->set(LSST_LP_LEVEL, _vol);
             setDate();
         }
     }
@@ -321,17 +550,90 @@ protected:
     bool _send;    // true if this record should be sent to the log
     bool _showAll; // true if there is preference to have all data displayed
     int _vol;      // the importance volume of this message
+
+private:
+    // a property added to a compact record, along with the functions that 
+    // know how to add it (with its proper type) to a PropertySet and how 
+    // to hand it to a PropertyVisitor
+    typedef void (*Adder)(lsst::daf::base::PropertySet&, const std::string&, 
+                          const boost::any&);
+    typedef void (*Visit)(const std::string&, const boost::any&, Adder,
+                          PropertyVisitor&);
+    struct Extra {
+        std::string name;
+        boost::any value;
+        Adder adder;
+        Visit visit;
+    };
+
+    template <class T>
+    static void _addValue(lsst::daf::base::PropertySet& set, 
+                          const std::string& name, const boost::any& value) 
+    {
+        set.add<T>(name, boost::any_cast<const T&>(value));
+    }
+
+    template <class T>
+    static void _visitValue(const std::string& name, const boost::any& value,
+                            Adder adder, PropertyVisitor& visitor)
+    {
+        PropertyValue::Writer writer = PropertyVisitor::getWriter(typeid(T));
+        if (writer) 
+            visitor.visit(name, PropertyValue(typeid(T), 
+                                    &boost::any_cast<const T&>(value), writer),
+                          0);
+        else 
+            _visitOther(name, value, adder, visitor);
+    }
+
+    static void _combineSet(lsst::daf::base::PropertySet& set, 
+                            const std::string& name, const boost::any& value);
+    static void _visitSet(const std::string& name, const boost::any& value,
+                          Adder adder, PropertyVisitor& visitor);
+    static void _visitOther(const std::string& name, const boost::any& value,
+                            Adder adder, PropertyVisitor& visitor);
+    static bool _isSlotName(const std::string& name);
+    static bool _isCoreName(const std::string& name);
+
+    lsst::daf::base::PropertySet::Ptr _assemble() const;
+    void _expand();
+
+    bool _hasLogName, _hasTimestamp, _hasDate;
+    long long _timestamp;
+    std::string _logName;
+    std::shared_ptr<const lsst::daf::base::PropertySet> _preamble;
+    CommentList _comments;
+    boost::container::small_vector<Extra, 2> _extras;
+    mutable lsst::daf::base::PropertySet::Ptr _cache;
+
+protected:
+    /**
+     * the definitive store of this record's data once it is no longer 
+     * compact; null while the record is compact.
+     */
     lsst::daf::base::PropertySet::Ptr _data;
 };
 
 template <class T>
 void LogRecord::addProperty(const RecordProperty<T>& property) {
-    if (_send) property.addTo(_data);
+    addProperty(property.name, property.value);
 }
 
 template <class T>
 void LogRecord::addProperty(const std::string& name, const T& val) {
-    if (_send) data().add(name, val);
+    if (! _send) return;
+    if (_data || _isCoreName(name)) {
+        data().add(name, val);
+    }
+    else {
+        Extra extra;
+        extra.name = name;
+        extra.value = val;
+        extra.adder = &LogRecord::_addValue<T>;
+        extra.visit = &LogRecord::_visitValue<T>;
+        _extras.push_back(extra);
+        _cache.reset();
+    }
 }
 
 
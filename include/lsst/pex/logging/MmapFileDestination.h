@@ -0,0 +1,194 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file MmapFileDestination.h
+ * @brief definition of the MmapFileDestination class
+ */
+#ifndef LSST_PEX_MMAPFILEDESTINATION_H
+#define LSST_PEX_MMAPFILEDESTINATION_H
+
+#include "lsst/pex/logging/LogDestination.h"
+
+#include <boost/filesystem/path.hpp>
+#include <atomic>
+#include <memory>
+#include <string>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a LogDestination represented by a file that records are copied
+ * into through a memory mapping.
+ *
+ * The file is extended (with posix_fallocate(3), which uses fallocate(2)
+ * where the file system supports it) and mapped into memory a chunk at a
+ * time; each rendered record is then copied straight into the mapping,
+ * skipping the copies made by a file stream and by write(2).  Unlike
+ * other LogDestinations, this class is synchronized: a writing thread
+ * claims the bytes for its record by atomically advancing the end of the
+ * log and then copies the record into them, so several threads may write
+ * at once without waiting for each other, except briefly when a new chunk
+ * has to be mapped.  Records appear in the file in the order in which
+ * their space was claimed.
+ *
+ * The disk space for a chunk is allocated before it is mapped, so a full
+ * file system makes write() return false (see getFailureCount()) rather
+ * than raising SIGBUS; the record is dropped and leaves no gap in the
+ * file.
+ *
+ * A record is visible to other processes reading the file as soon as it
+ * has been copied, so the FlushPolicy does not apply; flush() only asks
+ * the kernel to start writing the mapped pages back to disk.  Until the
+ * destination is deleted, the file extends with NUL bytes to the end of
+ * the last chunk; the destructor truncates it to the length of the
+ * records written.
+ *
+ * If the process dies without deleting the destination, the file is left
+ * with the trailing NUL bytes, and a record that was being copied at the
+ * time may be incomplete.  recover() (which is also applied when an
+ * existing file is opened for appending) trims such a file back to the
+ * end of its last complete line; a file that does not end in NUL bytes 
+ * is left untouched.  This assumes that records are lines of
+ * text, as written by all of the text formatters; this class should not
+ * be used with a BinaryFormatter.
+ */
+class MmapFileDestination : public LogDestination {
+public:
+
+    /**
+     * the number of bytes by which the file is extended and mapped at a
+     * time by default
+     */
+    static const std::size_t DEFAULT_CHUNK_SIZE;
+
+    //@{
+    /**
+     * create a memory-mapped file destination.  If the file does not
+     * exist, it will be created; otherwise, it is recovered (see
+     * recover()) and messages will be appended.  A
+     * pex::exceptions::IoError is thrown if the file cannot be opened.
+     * @param filepath    the path to the log file to write messages to.
+     * @param formatter   the LogFormatter to use to format the messages
+     * @param threshold   the minimum volume level required to pass a message
+     *                       to the stream.  If not provided, it would be set
+     *                       to 0.
+     * @param truncate    if True, overwrite the previous contents; otherwise,
+     *                       new messages will be appended to the file.
+     * @param chunkSize   the number of bytes by which to extend and map the
+     *                       file at a time, rounded up to a multiple of the
+     *                       page size
+     */
+    MmapFileDestination(const boost::filesystem::path& filepath,
+                        const std::shared_ptr<LogFormatter>& formatter,
+                        int threshold=threshold::PASS_ALL,
+                        bool truncate=false,
+                        std::size_t chunkSize=DEFAULT_CHUNK_SIZE);
+    MmapFileDestination(const std::string& filepath,
+                        const std::shared_ptr<LogFormatter>& formatter,
+                        int threshold=threshold::PASS_ALL,
+                        bool truncate=false,
+                        std::size_t chunkSize=DEFAULT_CHUNK_SIZE);
+    MmapFileDestination(const char *filepath,
+                        const std::shared_ptr<LogFormatter>& formatter,
+                        int threshold=threshold::PASS_ALL,
+                        bool truncate=false,
+                        std::size_t chunkSize=DEFAULT_CHUNK_SIZE);
+    //@}
+
+    /**
+     * unmap the file and truncate it to the length of the records written
+     */
+    virtual ~MmapFileDestination();
+
+    /**
+     * render a record and copy it into the file
+     * @return  true if the record was written; false if it did not pass
+     *            the threshold or the file could not be extended
+     */
+    virtual bool write(const LogRecord& rec);
+
+    /**
+     * copy a record into the file, using the text already rendered by an
+     * equivalent formatter if there is one
+     * @return  true if the record was written; false if it did not pass
+     *            the threshold or the file could not be extended
+     */
+    virtual bool write(RenderedRecord& rec);
+
+    /**
+     * ask the kernel to start writing the mapped pages back to disk
+     */
+    virtual void flush();
+
+    /**
+     * return the path to the log file
+     */
+    const boost::filesystem::path& getPath() const { return _path; }
+
+    /**
+     * return the number of bytes by which the file is extended at a time
+     */
+    std::size_t getChunkSize() const { return _chunkSize; }
+
+    /**
+     * return the length of the log, including any records that were in
+     * the file when it was opened
+     */
+    unsigned long long getSize() const { return _end.load(); }
+
+    /**
+     * return the number of records dropped because the file could not be
+     * extended to hold them
+     */
+    unsigned long long getFailureCount() const { return _failures.load(); }
+
+    /**
+     * trim a log file left behind by a process that did not delete its
+     * MmapFileDestination, i.e. one ending in NUL bytes, back to the end 
+     * of its last complete line.  Any other file is left untouched.
+     * @return  the number of bytes removed
+     */
+    static unsigned long long recover(const boost::filesystem::path& filepath);
+
+private:
+    MmapFileDestination(const MmapFileDestination&);
+    MmapFileDestination& operator=(const MmapFileDestination&);
+
+    class Mapping;
+
+    bool _append(const std::string& text);
+
+    boost::filesystem::path _path;
+    std::size_t _chunkSize;
+    std::atomic<unsigned long long> _end;   // the end of the claimed bytes
+    std::atomic<unsigned long long> _failures;
+    std::unique_ptr<Mapping> _mapping;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_MMAPFILEDESTINATION_H
@@ -0,0 +1,106 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file NumberFormat.h
+ * @brief definition of the NumberFormat class
+ */
+#ifndef LSST_PEX_NUMBERFORMAT_H
+#define LSST_PEX_NUMBERFORMAT_H
+
+#include <string>
+#include <ostream>
+#include <cstddef>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief functions for rendering numbers the same way regardless of the
+ * locale, as they are written for numeric properties of log records.
+ *
+ * Integers are written as plain decimal digits.  Floating-point numbers
+ * are written with the fewest significant digits that read back as 
+ * exactly the same value (e.g. "0.1", "15", "3.0000000000000004", 
+ * "1e+20"), in the style of printf's %g conversion but always with '.' as
+ * the decimal point; thus, a program that re-reads a log recovers the
+ * exact values that were logged.  Numbers are rendered into a caller's
+ * character array; no memory is allocated, and no stream formatting state
+ * or locale is consulted.
+ */
+class NumberFormat {
+public:
+
+    /**
+     * the most characters that any rendered number occupies
+     */
+    static const std::size_t MAX_LENGTH = 32;
+
+    //@{
+    /**
+     * write a number into a character array.  No terminating '\0' is
+     * added.
+     * @param val   the number to write
+     * @param out   the array to write into; it must have room for at
+     *                least MAX_LENGTH characters.
+     * @return char*  a pointer just past the last character written
+     */
+    static char *format(long long val, char *out);
+    static char *format(unsigned long long val, char *out);
+    static char *format(double val, char *out);
+    static char *format(float val, char *out);
+    static char *format(int val, char *out) { 
+        return format(static_cast<long long>(val), out); 
+    }
+    static char *format(long val, char *out) { 
+        return format(static_cast<long long>(val), out); 
+    }
+    static char *format(short val, char *out) { 
+        return format(static_cast<long long>(val), out); 
+    }
+    //@}
+
+    /**
+     * append a number to a string
+     */
+    template <class T>
+    static void append(T val, std::string& out) {
+        char buf[MAX_LENGTH];
+        out.append(buf, format(val, buf) - buf);
+    }
+
+    /**
+     * write a number to a stream, bypassing the stream's own formatting
+     */
+    template <class T>
+    static std::ostream& write(std::ostream& strm, T val) {
+        char buf[MAX_LENGTH];
+        return strm.write(buf, format(val, buf) - buf);
+    }
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_NUMBERFORMAT_H
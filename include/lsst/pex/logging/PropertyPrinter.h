@@ -38,6 +38,7 @@
 
 #include "lsst/daf/base/PropertySet.h"
 #include "lsst/daf/base/DateTime.h"
+#include "lsst/pex/logging/PropertyVisitor.h"
 #include "boost/any.hpp"
 
 namespace lsst {
@@ -172,7 +173,8 @@ public:
 
 template <class T>
 std::ostream& TmplPrinterIter<T>::write(std::ostream *strm) const { 
-    (*strm) << *(this->_it); 
+    const T& value = *(this->_it);
+    PropertyVisitor::writeValue<T>(*strm, &value);
     return *strm;
 }
 
@@ -357,6 +359,17 @@ public:
 PrinterList* makeBoolPrinter(const lsst::daf::base::PropertySet& prop, 
                              const std::string& name);
 
+/**
+ * @brief the factory function for printing a property of any type
+ * supported by PropertyVisitor.
+ *
+ * The values are rendered once, via PropertyVisitor, into strings that
+ * the returned list iterates over.  PrinterFactory uses this function for
+ * all of its default types.
+ */
+PrinterList* makeVisitedPrinter(const lsst::daf::base::PropertySet& prop, 
+                                const std::string& name);
+
 /**
  * @brief a factory used to create PrinterList instances to be used by 
  * a PropertyPrinter instance.   
@@ -446,7 +459,13 @@ private:
  * @endverbatim
  * Other types can be supported by passing the name of factory function 
  * that can create a printer instance to a PrinterFactory that will eventually 
- * be used with a PropertyPrinter (see PrinterFactory for details.  
+ * be used with a PropertyPrinter (see PrinterFactory for details.  Types 
+ * added to PropertyVisitor are also printed when the factory does not 
+ * support them.
+ *
+ * PropertyPrinter creates its iterators on the heap and copies the values
+ * it prints; applications that print many properties, like the 
+ * LogFormatters, should use PropertyVisitor instead.  
  */
 class PropertyPrinter {
 public:
@@ -0,0 +1,255 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PropertyVisitor.h
+ * @brief definition of the PropertyVisitor and PropertyValue classes
+ */
+#ifndef LSST_PEX_PROPERTYVISITOR_H
+#define LSST_PEX_PROPERTYVISITOR_H
+
+#include <string>
+#include <ostream>
+#include <typeinfo>
+#include <vector>
+#include <cstddef>
+
+#include "lsst/daf/base/PropertySet.h"
+#include "lsst/pex/logging/NumberFormat.h"
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a reference to a single value of a property, as handed to a
+ * PropertyVisitor.
+ *
+ * A PropertyValue only refers to its value; it is valid only for the
+ * duration of the PropertyVisitor::visit() call that receives it.
+ */
+class PropertyValue {
+public:
+
+    /**
+     * the type of a function that writes a value of a particular type,
+     * given as a pointer, to a stream
+     */
+    typedef void (*Writer)(std::ostream&, const void *);
+
+    /**
+     * wrap a value
+     * @param type    the type of the value
+     * @param value   a pointer to the value
+     * @param writer  the function that writes the value to a stream
+     */
+    PropertyValue(const std::type_info& type, const void *value,
+                  Writer writer)
+        : _type(&type), _value(value), _writer(writer)
+    { }
+
+    /**
+     * return the type of the value
+     */
+    const std::type_info& getType() const { return *_type; }
+
+    /**
+     * return a pointer to the value if it has type T or null otherwise
+     */
+    template <class T>
+    const T *get() const {
+        return (*_type == typeid(T)) ? static_cast<const T*>(_value) : 0;
+    }
+
+    /**
+     * write the value to a stream the way a PropertyPrinter would
+     */
+    std::ostream& write(std::ostream& strm) const {
+        (*_writer)(strm, _value);
+        return strm;
+    }
+
+private:
+    const std::type_info *_type;
+    const void *_value;
+    Writer _writer;
+};
+
+/**
+ * @brief a receiver of the values of the properties in a PropertySet.
+ *
+ * This is an alternative to the PropertyPrinter for applications, like
+ * the LogFormatters, that must print every value of every property of
+ * many PropertySets.  Rather than creating iterators, one implements
+ * visit(), and the static visitValues() and visitAll() functions call it
+ * once for each value.  The type of each property is looked up once in
+ * a table indexed by type, and the value is passed by reference to a
+ * copy on the stack; no iterators or lists are created on the heap, and
+ * a property with a single value is never copied into a vector.
+ * @code
+ *   class Printer : public PropertyVisitor {
+ *   public:
+ *       virtual void visit(const std::string& name,
+ *                          const PropertyValue& value, std::size_t) {
+ *           std::cout << name << ": ";
+ *           value.write(std::cout) << '\n';
+ *       }
+ *   };
+ *   Printer printer;
+ *   PropertyVisitor::visitAll(ps, printer);
+ * @endcode
+ *
+ * The same types supported by default by PropertyPrinter are supported
+ * here; others may be added with addType().  A value of a type that was
+ * only added to PropertyPrinter::defaultPrinterFactory is visited as the
+ * string that PropertyPrinter would print (created the slow way); a
+ * value of any other type is visited as the string "<unprintable>".
+ */
+class PropertyVisitor {
+public:
+    virtual ~PropertyVisitor();
+
+    /**
+     * receive one value of a property
+     * @param name    the name of the property
+     * @param value   the value
+     * @param index   the position of the value among those of the property
+     */
+    virtual void visit(const std::string& name, const PropertyValue& value,
+                       std::size_t index) = 0;
+
+    /**
+     * visit each of the values of one property in turn.
+     * @param props    the properties to look in
+     * @param name     the name of the property.  A
+     *                   pex::exceptions::NotFoundError is thrown if
+     *                   it does not exist.
+     * @param visitor  the visitor to hand the values to
+     */
+    static void visitValues(const lsst::daf::base::PropertySet& props,
+                            const std::string& name,
+                            PropertyVisitor& visitor);
+
+    /**
+     * visit each of the values of all the properties in a PropertySet,
+     * in the order given by PropertySet::paramNames().
+     * @param props    the properties to visit
+     * @param visitor  the visitor to hand the values to
+     * @param topLevelOnly  passed to PropertySet::paramNames()
+     */
+    static void visitAll(const lsst::daf::base::PropertySet& props,
+                         PropertyVisitor& visitor, bool topLevelOnly=false);
+
+    /**
+     * return true if values of a type can be visited as themselves
+     * rather than as "<unprintable>"
+     */
+    static bool isSupported(const std::type_info& type);
+
+    /**
+     * return the function that writes values of a type, or null if the
+     * type is not supported (see isSupported()).
+     */
+    static PropertyValue::Writer getWriter(const std::type_info& type);
+
+    /**
+     * write a value of type T to a stream with operator<<, or, for the
+     * built-in integer and floating-point types, with NumberFormat
+     */
+    template <class T>
+    static void writeValue(std::ostream& strm, const void *value) {
+        strm << *static_cast<const T*>(value);
+    }
+
+    /**
+     * add support for a type to the table of supported types, or change
+     * how it is written.  The table is shared by all threads; types
+     * should be added before any are visited.
+     * @param writer   the function that writes a value of type T
+     */
+    template <class T>
+    static void addType(PropertyValue::Writer writer=&writeValue<T>) {
+        _addType(typeid(T), &_walk<T>, writer);
+    }
+
+private:
+    typedef void (*Walker)(const lsst::daf::base::PropertySet&,
+                           const std::string&, PropertyVisitor&,
+                           PropertyValue::Writer);
+
+    static void _addType(const std::type_info& type, Walker walker,
+                         PropertyValue::Writer writer);
+    static void _loadDefaults();
+
+    template <class T>
+    static void _walk(const lsst::daf::base::PropertySet& props,
+                      const std::string& name, PropertyVisitor& visitor,
+                      PropertyValue::Writer writer);
+};
+
+//@cond
+#define LSST_PV_NUMBER(T)                                                   \
+template <>                                                                 \
+inline void PropertyVisitor::writeValue<T>(std::ostream& strm,              \
+                                           const void *value)               \
+{                                                                           \
+    NumberFormat::write(strm, *static_cast<const T*>(value));               \
+}
+
+LSST_PV_NUMBER(short)
+LSST_PV_NUMBER(int)
+LSST_PV_NUMBER(long)
+LSST_PV_NUMBER(long long)
+LSST_PV_NUMBER(unsigned long long)
+LSST_PV_NUMBER(float)
+LSST_PV_NUMBER(double)
+
+#undef LSST_PV_NUMBER
+//@endcond
+
+/*
+ * visit the values of a property of type T.  A single value is fetched
+ * with get() so that no vector is built.
+ */
+template <class T>
+void PropertyVisitor::_walk(const lsst::daf::base::PropertySet& props,
+                            const std::string& name,
+                            PropertyVisitor& visitor,
+                            PropertyValue::Writer writer)
+{
+    if (props.valueCount(name) <= 1) {
+        const T value = props.get<T>(name);
+        visitor.visit(name, PropertyValue(typeid(T), &value, writer), 0);
+        return;
+    }
+    const std::vector<T> values = props.getArray<T>(name);
+    for(std::size_t i=0; i < values.size(); ++i) {
+        const T& value = values[i];
+        visitor.visit(name, PropertyValue(typeid(T), &value, writer), i);
+    }
+}
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_PROPERTYVISITOR_H
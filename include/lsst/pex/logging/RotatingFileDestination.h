@@ -0,0 +1,260 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file RotatingFileDestination.h
+ * @brief definition of the RotatingFileDestination and RotationPolicy
+ * classes
+ */
+#ifndef LSST_PEX_ROTATINGFILEDESTINATION_H
+#define LSST_PEX_ROTATINGFILEDESTINATION_H
+
+#include "lsst/pex/logging/LogDestination.h"
+
+#include <boost/filesystem/path.hpp>
+#include <memory>
+#include <cstddef>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief a rule for when a RotatingFileDestination starts a new file and
+ * what it does with the old ones.
+ *
+ * A file may be rotated before a record would take it past a given size
+ * (a single record larger than that still gets a file of its own), once
+ * the wall clock passes a multiple of a given interval (counted in UTC
+ * from Jan 1, 1970, so that an interval of 86400 seconds rotates at each
+ * midnight UTC), or on whichever of these comes first.  The limits are
+ * checked when a record is written; a record is never split between two
+ * files.
+ */
+class RotationPolicy {
+public:
+
+    /**
+     * the number of old files kept by default
+     */
+    static const unsigned int DEFAULT_KEEP = 5;
+
+    /**
+     * create a policy that never rotates
+     */
+    RotationPolicy()
+        : _bytes(0), _seconds(0), _keep(DEFAULT_KEEP), _compress(false)
+    { }
+
+    /**
+     * return a policy that rotates a file before a record would make it
+     * larger than a number of bytes
+     * @param bytes     the largest size a file may grow to
+     * @param keep      the number of old files to keep
+     * @param compress  if true, gzip old files in the background
+     */
+    static RotationPolicy bySize(unsigned long long bytes,
+                                 unsigned int keep=DEFAULT_KEEP,
+                                 bool compress=false)
+    {
+        return RotationPolicy(bytes, 0, keep, compress);
+    }
+
+    /**
+     * return a policy that rotates a file when the wall clock passes a
+     * multiple of an interval
+     * @param seconds   the interval between rotations in seconds
+     * @param keep      the number of old files to keep
+     * @param compress  if true, gzip old files in the background
+     */
+    static RotationPolicy byInterval(long seconds,
+                                     unsigned int keep=DEFAULT_KEEP,
+                                     bool compress=false)
+    {
+        return RotationPolicy(0, seconds, keep, compress);
+    }
+
+    /**
+     * return a policy that rotates a file on reaching a size or at the
+     * end of an interval, whichever comes first.  A limit of zero is not
+     * applied.
+     * @param bytes     the largest size a file may grow to
+     * @param seconds   the interval between rotations in seconds
+     * @param keep      the number of old files to keep
+     * @param compress  if true, gzip old files in the background
+     */
+    static RotationPolicy limits(unsigned long long bytes, long seconds,
+                                 unsigned int keep=DEFAULT_KEEP,
+                                 bool compress=false)
+    {
+        return RotationPolicy(bytes, seconds, keep, compress);
+    }
+
+    /**
+     * return the largest size a file may grow to, or zero if there is
+     * no such limit
+     */
+    unsigned long long getBytes() const { return _bytes; }
+
+    /**
+     * return the interval between rotations in seconds, or zero if there
+     * is no such limit
+     */
+    long getSeconds() const { return _seconds; }
+
+    /**
+     * return the number of old files that are kept
+     */
+    unsigned int getKeep() const { return _keep; }
+
+    /**
+     * return true if old files are compressed
+     */
+    bool isCompressed() const { return _compress; }
+
+private:
+    RotationPolicy(unsigned long long bytes, long seconds, unsigned int keep,
+                   bool compress)
+        : _bytes(bytes), _seconds(seconds > 0 ? seconds : 0), _keep(keep),
+          _compress(compress)
+    { }
+
+    unsigned long long _bytes;
+    long _seconds;
+    unsigned int _keep;
+    bool _compress;
+};
+
+/**
+ * @brief a LogDestination represented by a file that is replaced by a
+ * new one as it grows or ages.
+ *
+ * When a file is rotated according to the RotationPolicy, it is renamed
+ * with the suffix ".1" (or ".1.gz" when compressed), the previously
+ * rotated files are shifted along to ".2", ".3", and so on, and the
+ * oldest beyond the number to keep is removed.  A new, empty file is then
+ * opened under the original name before the next record is written, so
+ * no record is lost or split across files.  The formatter is told that a
+ * new stream has begun (see LogFormatter::startStream()) and the record
+ * rendered again, so each file written with a BinaryFormatter starts
+ * with its own header and name definitions.  If the file cannot be
+ * renamed, it is kept and appended to.
+ *
+ * Compressing the old files with gzip is done on a background thread
+ * belonging to the destination, so that writing a record never waits
+ * for it; until it is done, the rotated file is held under a temporary
+ * name (the file's name with ".rotated-" and a number appended), and the
+ * files already compressed are only shifted along once it has been.  A
+ * file that cannot be compressed is left under that name and tried 
+ * again, ahead of the later ones, at the next rotation.  The destructor 
+ * waits for any compression still under way.
+ *
+ * Like other LogDestinations, this class is not synchronized; it should
+ * be written to by one thread at a time (e.g. via an AsyncWriter).
+ */
+class RotatingFileDestination : public LogDestination {
+public:
+
+    //@{
+    /**
+     * create a rotating file destination.  If the file exists, messages
+     * will be appended to it.
+     * @param filepath    the path to the log file to write messages to.
+     * @param formatter   the LogFormatter to use to format the messages
+     * @param policy      the rule for when to rotate the file
+     * @param threshold   the minimum volume level required to pass a message
+     *                       to the stream.  If not provided, it would be set
+     *                       to 0.
+     */
+    RotatingFileDestination(const boost::filesystem::path& filepath,
+                            const std::shared_ptr<LogFormatter>& formatter,
+                            const RotationPolicy& policy,
+                            int threshold=threshold::PASS_ALL);
+    RotatingFileDestination(const std::string& filepath,
+                            const std::shared_ptr<LogFormatter>& formatter,
+                            const RotationPolicy& policy,
+                            int threshold=threshold::PASS_ALL);
+    RotatingFileDestination(const char *filepath,
+                            const std::shared_ptr<LogFormatter>& formatter,
+                            const RotationPolicy& policy,
+                            int threshold=threshold::PASS_ALL);
+    //@}
+
+    /**
+     * close the file, waiting for any compression still under way
+     */
+    virtual ~RotatingFileDestination();
+
+    /**
+     * return the path to the current log file
+     */
+    const boost::filesystem::path& getPath() const;
+
+    /**
+     * return the rule for when the file is rotated
+     */
+    const RotationPolicy& getRotationPolicy() const;
+
+    /**
+     * return the number of bytes in the current file
+     */
+    unsigned long long getSize() const;
+
+    /**
+     * rotate the file now, regardless of the policy, and tell the
+     * formatter that a new stream has begun
+     */
+    void rotate();
+
+    /**
+     * close the file and open it again by name, appending to it, and
+     * tell the formatter that a new stream has begun.  This lets an
+     * external tool such as logrotate move the file aside; the
+     * destination keeps writing to the moved file until this is called.
+     */
+    void reopen();
+
+    /**
+     * wait until compressing every rotated file has been tried
+     */
+    void waitForCompression();
+
+protected:
+    /**
+     * rotate the file first if the policy calls for it, rendering the
+     * record again for the new file
+     */
+    virtual void _put(const LogRecord& rec, const std::string& text);
+
+private:
+    RotatingFileDestination(const RotatingFileDestination&);
+    RotatingFileDestination& operator=(const RotatingFileDestination&);
+
+    class RotatingBuffer;
+    std::unique_ptr<RotatingBuffer> _buffer;
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_ROTATINGFILEDESTINATION_H
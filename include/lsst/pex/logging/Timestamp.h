@@ -0,0 +1,125 @@
+// -*- lsst-c++ -*-
+
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file Timestamp.h
+ * @brief definition of the Timestamp class
+ */
+#ifndef LSST_PEX_TIMESTAMP_H
+#define LSST_PEX_TIMESTAMP_H
+
+#include <string>
+#include <cstddef>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+/**
+ * @brief functions for reading the clock and formatting the times at
+ * which log records are created.
+ *
+ * Times are handled as UTC nanoseconds since Jan 1, 1970, the form
+ * accepted by lsst::daf::base::DateTime.  They are formatted the way
+ * they appear in a record's DATE property, as an ISO-8601 date and time
+ * with microseconds, e.g. "2016-03-01T18:04:05.012345".
+ *
+ * Formatting is cheap when done repeatedly:  each thread remembers the
+ * date-and-time prefix ("2016-03-01T18:04:05.") of the last second it
+ * formatted, so the calendar conversion is only done once per second;
+ * otherwise, only the fractional digits must be written.
+ */
+class Timestamp {
+public:
+
+    /**
+     * the clocks that may be used to time records
+     */
+    enum Clock {
+        /**
+         * the real-time clock at its full resolution
+         */
+        PRECISE = 0,
+
+        /**
+         * a cheaper real-time clock that is only updated every few
+         * milliseconds (where supported; otherwise, PRECISE is used)
+         */
+        COARSE
+    };
+
+    /**
+     * the number of characters in a formatted time
+     */
+    static const std::size_t LENGTH = 26;
+
+    /**
+     * return the current UTC time in nanosecs since Jan 1, 1970, read
+     * from the clock selected with setClock().
+     */
+    static long long now();
+
+    /**
+     * select the clock used by now() for all threads
+     */
+    static void setClock(Clock clock);
+
+    /**
+     * return the clock used by now()
+     */
+    static Clock getClock();
+
+    /**
+     * write a time into a character array.  Exactly LENGTH characters
+     * are written; no terminating '\0' is added.
+     * @param nsecs   the UTC time in nanosecs since Jan 1, 1970
+     * @param out     the array to write into; it must have room for at
+     *                  least LENGTH characters.
+     * @return char*  a pointer just past the last character written
+     */
+    static char *format(long long nsecs, char *out);
+
+    /**
+     * append a formatted time to a string
+     * @param nsecs   the UTC time in nanosecs since Jan 1, 1970
+     * @param out     the string to append to
+     */
+    static void append(long long nsecs, std::string& out) {
+        char buf[LENGTH];
+        out.append(buf, format(nsecs, buf) - buf);
+    }
+
+    /**
+     * return a formatted time
+     * @param nsecs   the UTC time in nanosecs since Jan 1, 1970
+     */
+    static std::string format(long long nsecs) {
+        char buf[LENGTH];
+        return std::string(buf, format(nsecs, buf) - buf);
+    }
+};
+
+}}}     // end lsst::pex::logging
+
+#endif  // LSST_PEX_TIMESTAMP_H
@@ -55,7 +55,7 @@ namespace logging {
 #endif
 
 #if !defined(LSST_MAX_TRACE)
-#  define LSST_MAX_TRACE -1  //!< Maximum level to trace (only works for TTrace)
+#  define LSST_MAX_TRACE -1  //!< Maximum level to trace (TTrace, LSST_TRACE)
 #endif
 
 /**
@@ -108,18 +108,14 @@ public:
           ) 
     {
         if (-1*verbosity >= Log::getDefaultLog().getThresholdFor(name)) {
+            FormatBuffer msg;
             va_list ap;
             va_start(ap, fmt);
-            const int len = vsnprintf(NULL, 0, fmt.c_str(), ap) + 1; // "+ 1" for the '\0'
-            va_end(ap);
-
-            char msg[len];
-            va_start(ap, fmt);
-            (void)vsnprintf(msg, len, fmt.c_str(), ap);
+            msg.vprintf(fmt.c_str(), ap);
             va_end(ap);
             
             Debug out(name);
-            out.debug(verbosity, msg);
+            out.debug(verbosity, msg.str());
         }
     }
 
@@ -189,25 +185,118 @@ public:
     }
 };
 
+/**
+ * \brief  a handle on a single place in the code where trace messages are 
+ * sent via the LSST_TRACE macro.
+ *
+ * A TraceSite remembers the threshold in effect for its component name 
+ * so that deciding whether a message should be printed does not require 
+ * looking the name up in the default Log each time.  The remembered value
+ * is tagged with the threshold generation (see threshold::Memory) and is 
+ * looked up again only after some threshold has changed or the default 
+ * Log has been replaced.  Applications normally do not use this class 
+ * directly.
+ */
+class TraceSite {
+public:
+
+    /**
+     * create a handle for trace messages sent to a given component
+     */
+    explicit TraceSite(const std::string& name) : _name(name), _cache() { }
+
+    /**
+     * return the name of the component messages are sent to
+     */
+    const std::string& getName() const { return _name; }
+
+    /**
+     * return true if messages with the given verbosity will be printed
+     */
+    bool isEnabled(int verbosity) const {
+        unsigned int generation = threshold::Memory::getGeneration();
+        int thresh;
+        if (! _cache.get(generation, thresh)) {
+            thresh = Log::getDefaultLog().getThresholdFor(_name);
+            _cache.set(generation, thresh);
+        }
+        return -1*verbosity >= thresh;
+    }
+
+    /**
+     * print a message (formatted printf-style) to this component.  The 
+     * verbosity is assumed to have been checked with isEnabled().
+     */
+    void trace(int verbosity, const char *fmt, ...) const {
+        va_list ap;
+        va_start(ap, fmt);
+        Debug(_name).debug(verbosity, fmt, ap);
+        va_end(ap);
+    }
+
+    /**
+     * print a message to this component.  The verbosity is assumed to have 
+     * been checked with isEnabled().
+     */
+    void trace(int verbosity, const std::string& msg) const {
+        Debug(_name).debug(verbosity, msg);
+    }
+
+    /**
+     * print a message to this component.  The verbosity is assumed to have 
+     * been checked with isEnabled().
+     */
+    void trace(int verbosity, const boost::format& msg) const {
+        Debug(_name).debug(verbosity, msg.str());
+    }
+
+private:
+    const std::string _name;
+    threshold::CachedThreshold _cache;
+};
+
+/**
+ * \brief  print a trace message to a named component if the verbosity is 
+ * high enough.
+ *
+ * This is equivalent to Trace(name, verbosity, ...), but each use of the 
+ * macro keeps a TraceSite that remembers the component's threshold; thus,
+ * a message that will not be printed costs only a comparison against 
+ * the remembered value.  The message arguments are not evaluated unless 
+ * the message is printed.  The name should be the same every time a 
+ * particular use of the macro is executed, as only the first one is used.
+ * A message more verbose than LSST_MAX_TRACE (if set) is compiled out.
+ * \code
+ *     LSST_TRACE("afw.math.convolve", 4, "kernel %d of %d", i, n);
+ * \endcode
+ */
+#if !LSST_NO_TRACE
+#define LSST_TRACE(name, verbosity, ...)                                     \
+    do {                                                                    \
+        if (LSST_MAX_TRACE < 0 || (verbosity) <= LSST_MAX_TRACE) {          \
+            static const lsst::pex::logging::TraceSite                      \
+                lsstTraceSite_(name);                                       \
+            if (lsstTraceSite_.isEnabled(verbosity))                        \
+                lsstTraceSite_.trace(verbosity, __VA_ARGS__);               \
+        }                                                                   \
+    } while (0)
+#else
+#define LSST_TRACE(name, verbosity, ...) do { } while (0)
+#endif
+
 template<int VERBOSITY>
 void TTrace(const char *name,           //!< Name of component
             const char *fmt,            //!< Message to write as a printf format
             ...
            ) {
     if (LSST_MAX_TRACE < 0 || VERBOSITY <= LSST_MAX_TRACE) {
+        FormatBuffer msg;
         va_list ap;
-
-        // first determine the length of the message
-        va_start(ap, fmt);
-        const int len = vsnprintf(NULL, 0, fmt, ap) + 1; // "+ 1" for the '\0'
-        va_end(ap);
-
-        char msg[len];
         va_start(ap, fmt);
-        (void)vsnprintf(msg, len, fmt, ap);
+        msg.vprintf(fmt, ap);
         va_end(ap);
 
-        Trace(name, VERBOSITY, msg);
+        Trace(name, VERBOSITY, msg.c_str());
     }
 }
 
@@ -217,10 +306,13 @@ void TTrace(const std::string name,      //!< Name of component
             ...
            ) {
     if (LSST_MAX_TRACE < 0 || VERBOSITY <= LSST_MAX_TRACE) {
+        FormatBuffer msg;
         va_list ap;
         va_start(ap, fmt);
-        Trace(name, VERBOSITY, fmt, ap);
+        msg.vprintf(fmt.c_str(), ap);
         va_end(ap);
+
+        Trace(name, VERBOSITY, msg.c_str());
     }
 }
 
@@ -32,8 +32,12 @@
 
 #include <string>
 #include <map>
+#include <deque>
+#include <vector>
 #include <ostream>
 #include <memory>
+#include <atomic>
+#include <mutex>
 #include <boost/tokenizer.hpp>
 
 #include "lsst/pex/logging/threshold/enum.h"
@@ -55,6 +59,9 @@ typedef boost::tokenizer<boost::char_separator<char> > tokenizer;
  * descendant.  If any threshold is set to the special value INHERIT,
  * the effective value should be taken to be the threshold of its nearest
  * ancestor.
+ *
+ * @deprecated  Memory no longer uses this class to store its thresholds;
+ * it is retained only for existing users.  
  */
 class Family {
 public:
@@ -161,12 +168,99 @@ private:
     ChildMap *_children;
 };
 
+/**
+ * @brief a cached copy of an effective threshold value, tagged with the 
+ * Memory generation that it was resolved under.
+ *
+ * Every change to the thresholds stored in any Memory instance advances a
+ * process-wide generation counter (see Memory::getGeneration()).  A cached
+ * value is only considered valid while the generation it was stored with 
+ * is still current; thus, checking the cache costs a pair of atomic loads 
+ * and a comparison.  The generation and value are packed into a single 
+ * atomic word so that a cache may be shared safely between threads.  
+ */
+class CachedThreshold {
+public:
+
+    /**
+     * create an empty cache
+     */
+    CachedThreshold() : _packed(0) { }
+
+    /**
+     * create an empty cache.  Cached values are never copied as they 
+     * belong to the object that resolved them.
+     */
+    CachedThreshold(const CachedThreshold&) : _packed(0) { }
+
+    /**
+     * empty this cache.  Cached values are never copied.
+     */
+    CachedThreshold& operator=(const CachedThreshold&) {
+        invalidate();
+        return *this;
+    }
+
+    /**
+     * retrieve the cached threshold.  
+     * @param generation  the current Memory generation
+     * @param threshold   set to the cached value if it is still valid
+     * @return bool       true if the cached value was resolved under the 
+     *                      given generation.
+     */
+    bool get(unsigned int generation, int& threshold) const {
+        unsigned long long packed = _packed.load(std::memory_order_relaxed);
+        if (static_cast<unsigned int>(packed >> 32) != generation) 
+            return false;
+        threshold = static_cast<int>(static_cast<unsigned int>(packed));
+        return true;
+    }
+
+    /**
+     * save a threshold value resolved under a given generation.  The 
+     * generation should be read (via Memory::getGeneration()) \e before
+     * the threshold is resolved.
+     */
+    void set(unsigned int generation, int threshold) const {
+        unsigned long long packed = generation;
+        packed = (packed << 32) | static_cast<unsigned int>(threshold);
+        _packed.store(packed, std::memory_order_relaxed);
+    }
+
+    /**
+     * forget the cached value
+     */
+    void invalidate() { _packed.store(0, std::memory_order_relaxed); }
+
+private:
+    mutable std::atomic<unsigned long long> _packed;
+};
+
 /**
  * a container for keeping track of the threshold data for a family of Logs.
- * The actually mappings of log names to remembered threshold values is 
- * stored internally (privately) as a Family instance.  One Memory instance 
- * shared by all the Log instances in a Log hierarchy, created first by the 
- * root log and passed (by shared pointer) to child logs as they are created.
+ * One Memory instance shared by all the Log instances in a Log hierarchy, 
+ * created first by the root log and passed (by shared pointer) to child 
+ * logs as they are created.
+ *
+ * The names are stored internally as a tree with one node per field of 
+ * a hierarchical name; however, rather than having each node keep a map 
+ * of its children, all of the nodes are indexed in a single open-addressing
+ * hash table keyed on the parent node and the field name.  This allows
+ * getThresholdFor() to resolve a name in a single pass over its characters 
+ * without splitting it into strings, so that lookups require no memory 
+ * allocation.  As with boost::char_separator, empty fields (e.g. from 
+ * consecutive delimiters) are ignored.
+ *
+ * A Memory may be used from multiple threads.  Lookups take no locks: the
+ * hash table is published through an atomic pointer, its slots and the 
+ * threshold values are atomic, and nodes are never changed (other than 
+ * their thresholds) or freed once published.  When the table must grow, a 
+ * new one is built and published in its place.  Changes are serialized 
+ * with a mutex.  Tables that have been replaced are kept until the Memory 
+ * is destroyed so that a lookup in progress can always finish safely.  
+ * Forgetting names (see forgetAllNames()) resets their thresholds in place 
+ * rather than discarding their nodes, so a name that is set again reuses 
+ * its node.
  */
 class Memory {
 public:
@@ -176,41 +270,73 @@ public:
     /**
      * return the threshold value associated with a given name
      */
-    int getThresholdFor(const std::string& name) {
-        if (name.length() == 0) return getRootThreshold();
-        tokenizer fields(name, _sep);
-        return _tree.getThresholdFor(fields.begin(), fields.end());
+    int getThresholdFor(const std::string& name) const {
+        return getThresholdFor(name.data(), name.length());
     }
 
+    /**
+     * return the threshold value associated with a given name
+     * @param name     the characters of the name; this need not be 
+     *                   null-terminated.
+     * @param length   the number of characters in the name
+     */
+    int getThresholdFor(const char *name, std::size_t length) const;
+
     /**
      * set the threshold value associated with a given name
      */
-    void setThresholdFor(const std::string& name, int threshold) {
-        if (name.length() == 0) {
-            setRootThreshold(threshold);
-        }
-        else {
-            tokenizer fields(name, _sep);
-            _tree.setThresholdFor(fields.begin(), fields.end(), threshold);
-        }
-    }
+    void setThresholdFor(const std::string& name, int threshold);
+
+    /**
+     * reset the threshold value associated with a given name so that it 
+     * inherits from its nearest ancestor.
+     */
+    void resetThresholdFor(const std::string& name);
 
     /**
      * return the default threshold value associated with the root
      * of the hierarchy.
      */
-    int getRootThreshold() { return _tree.getThreshold(); }
+    int getRootThreshold() const { 
+        return _root.thresh.load(std::memory_order_relaxed); 
+    }
 
     /**
      * return the default threshold value associated with the root
      * of the hierarchy.
      */
-    void setRootThreshold(int threshold) { _tree.setThreshold(threshold); }
+    void setRootThreshold(int threshold);
+
+    /**
+     * reset the memory so that every name inherits the root threshold
+     */
+    void forgetAllNames();
+
+    /**
+     * return the number of names (including each ancestor of a name set 
+     * explicitly) currently remembered, not counting the root.  Names 
+     * are remembered from when they are set until forgetAllNames() is 
+     * called.
+     */
+    std::size_t countNames() const;
+
+    /**
+     * return the current threshold generation.  This value changes every 
+     * time a threshold is set or reset in any Memory instance; a threshold
+     * value resolved under one generation (see CachedThreshold) remains 
+     * valid for as long as this function returns the same value.
+     */
+    static unsigned int getGeneration() {
+        return _generation.load(std::memory_order_acquire);
+    }
 
     /**
-     * reset the memory
+     * advance the threshold generation, invalidating every CachedThreshold.
+     * This should be called when cached thresholds may have become stale 
+     * for a reason other than a change to a Memory, such as when the 
+     * default Log is replaced.
      */
-    void forgetAllNames() { _tree.deleteDescendants(); }
+    static void advanceGeneration() { _advanceGeneration(); }
 
     /**
      * print the thresholds stored in this Memory that are not set to INHERIT.
@@ -219,8 +345,62 @@ public:
 
 
 private:
-    Family _tree;
-    boost::char_separator<char> _sep;
+    Memory(const Memory&);
+    Memory& operator=(const Memory&);
+
+    // one field of a hierarchical name
+    struct Node {
+        Node(const char *name, std::size_t length, const Node *up, 
+             std::size_t key) 
+            : field(name, length), parent(up), hash(key), thresh(INHERIT),
+              remembered(true)
+        { }
+
+        const std::string field;
+        const Node *parent;
+        const std::size_t hash;
+        std::atomic<int> thresh;
+        bool remembered;        // false once forgotten; guarded by the mutex
+    };
+
+    // the hash table of nodes
+    struct Index {
+        explicit Index(std::size_t size);
+
+        std::size_t mask;
+        std::size_t count;
+        std::unique_ptr<std::atomic<const Node*>[]> slots;
+    };
+
+    static void _advanceGeneration() {
+        // skip zero, which marks an empty CachedThreshold
+        if (_generation.fetch_add(1, std::memory_order_acq_rel) + 1 == 0)
+            _generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    bool _nextField(const char*& pos, const char *end, 
+                    const char*& field) const;
+    static const Node *_findChild(const Index& index, const Node *parent, 
+                                  std::size_t hash, const char *field, 
+                                  std::size_t length);
+    Node *_findNode(const std::string& name, bool create);
+    void _insert(const Node *node);
+    void _publish(Index *index);
+    void _printChildren(std::ostream& out, 
+                        const std::multimap<const Node*, const Node*>& tree,
+                        const Node *parent, const std::string& prefix) const;
+
+    static std::size_t _hash(const Node *parent, const char *field, 
+                             std::size_t length);
+
+    Node _root;
+    std::deque<Node> _nodes;
+    std::vector<std::unique_ptr<Index> > _indexes;
+    std::atomic<const Index*> _index;
+    std::size_t _remembered;
+    mutable std::mutex _mutex;
+    bool _isDelim[256];
+    static std::atomic<unsigned int> _generation;
 };
 
 }}}} // end lsst::pex::logging::threshold
@@ -24,6 +24,8 @@
 
 #include "lsst/pex/logging/Log.h"
 #include "lsst/pex/logging/FileDestination.h"
+#include "lsst/pex/logging/BinaryFileDestination.h"
+#include "lsst/pex/logging/LogFormatter.h"
 
 namespace py = pybind11;
 using namespace pybind11::literals;
@@ -37,6 +39,12 @@ PYBIND11_MODULE(log, mod) {
 
     py::class_<Log, std::shared_ptr<Log>> cls(mod, "Log");
 
+    py::enum_<AsyncWriter::OverflowPolicy>(cls, "OverflowPolicy")
+            .value("BLOCK", AsyncWriter::BLOCK)
+            .value("DROP_NEWEST", AsyncWriter::DROP_NEWEST)
+            .value("DROP_DEBUG_FIRST", AsyncWriter::DROP_DEBUG_FIRST)
+            .export_values();
+
     cls.def_readonly_static("DEBUG", &Log::DEBUG);
     cls.def_readonly_static("INFO", &Log::INFO);
     cls.def_readonly_static("WARN", &Log::WARN);
@@ -64,12 +72,28 @@ PYBIND11_MODULE(log, mod) {
     cls.def("send", &Log::send);
     cls.def("addDestination",
             [](Log &l, const std::string &filepath, bool verbose = false,
-               int threshold = lsst::pex::logging::threshold::PASS_ALL) {
-                std::shared_ptr<lsst::pex::logging::LogDestination> fdest(
-                        new lsst::pex::logging::FileDestination(filepath, verbose, threshold));
+               int threshold = lsst::pex::logging::threshold::PASS_ALL,
+               const std::string &format = "text") {
+                std::shared_ptr<lsst::pex::logging::LogDestination> fdest;
+                if (format == "json") {
+                    std::shared_ptr<LogFormatter> fmtr(new JsonLinesFormatter());
+                    fdest.reset(new lsst::pex::logging::FileDestination(filepath, fmtr, threshold));
+                } else if (format == "binary") {
+                    fdest.reset(new lsst::pex::logging::BinaryFileDestination(filepath, threshold));
+                } else if (format == "text") {
+                    fdest.reset(new lsst::pex::logging::FileDestination(filepath, verbose, threshold));
+                } else {
+                    throw py::value_error("unsupported log format: " + format);
+                }
                 l.addDestination(fdest);
             },
-            "filepath"_a, "verbose"_a = false, "threshold"_a = lsst::pex::logging::threshold::PASS_ALL);
+            "filepath"_a, "verbose"_a = false, "threshold"_a = lsst::pex::logging::threshold::PASS_ALL,
+            "format"_a = "text");
+    cls.def("enableAsync", &Log::enableAsync, "capacity"_a = AsyncWriter::DEFAULT_CAPACITY,
+            "policy"_a = AsyncWriter::BLOCK);
+    cls.def("disableAsync", &Log::disableAsync);
+    cls.def("isAsync", &Log::isAsync);
+    cls.def("flush", &Log::flush);
     cls.def("markPersistent", &Log::markPersistent);
     cls.def_static("getDefaultLog", &Log::getDefaultLog);
     cls.def_static("closeDefaultLog", &Log::closeDefaultLog);
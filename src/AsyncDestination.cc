@@ -0,0 +1,227 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file AsyncDestination.cc
+ */
+#include "lsst/pex/logging/AsyncDestination.h"
+#include "lsst/pex/logging/Log.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+using std::shared_ptr;
+using std::unique_ptr;
+using std::mutex;
+using std::lock_guard;
+using std::unique_lock;
+
+namespace {
+
+    // the most queued records handed to the destination at once
+    const std::size_t MAX_BATCH = 1024;
+}
+
+const int AsyncDestination::DEFAULT_BYPASS = Log::WARN;
+const int AsyncDestination::NO_BYPASS = std::numeric_limits<int>::max();
+
+AsyncDestination::AsyncDestination(
+    const shared_ptr<LogDestination>& destination, std::size_t capacity,
+    AsyncWriter::OverflowPolicy policy, int bypass)
+    : LogDestination(0, shared_ptr<LogFormatter>(),
+                     destination->getThreshold()),
+      _dest(destination), _capacity(capacity > 0 ? capacity : 1),
+      _policy(policy), _bypass(bypass), _queue(), _queued(0), _done(0),
+      _overflows(0), _dropped(0), _bypassed(0), _stopping(false), _mutex(),
+      _destMutex(), _notEmpty(), _notFull(), _written(), _thread()
+{
+    _thread = std::thread(&AsyncDestination::_run, this);
+}
+
+/*
+ * write out all remaining records and stop the worker thread
+ */
+AsyncDestination::~AsyncDestination() {
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _notEmpty.notify_one();
+    _notFull.notify_all();
+    if (_thread.joinable()) _thread.join();
+    try {
+        _dest->flush();
+    }
+    catch (...) { }
+}
+
+/*
+ * queue a copy of a record or, if it is important enough, write it now
+ */
+bool AsyncDestination::write(const LogRecord& rec) {
+    int importance = rec.getImportance();
+    if (importance < _threshold || importance < _dest->getThreshold())
+        return false;
+
+    // a formatter of the wrapped destination is itself logging
+    if (_thread.get_id() == std::this_thread::get_id())
+        return _dest->write(rec);
+
+    if (importance >= _bypass) {
+        {
+            lock_guard<mutex> lock(_mutex);
+            ++_bypassed;
+        }
+        lock_guard<mutex> lock(_destMutex);
+        return _dest->write(rec);
+    }
+
+    unique_ptr<LogRecord> copy(new LogRecord(rec));
+    unique_lock<mutex> lock(_mutex);
+    if (! _makeRoom(lock, importance)) {
+        ++_dropped;
+        return false;
+    }
+    _queue.push_back(std::move(copy));
+    ++_queued;
+    lock.unlock();
+    _notEmpty.notify_one();
+    return true;
+}
+
+bool AsyncDestination::write(RenderedRecord& rec) {
+    return write(rec.getRecord());
+}
+
+/*
+ * make room in the queue according to the overflow policy.  The lock
+ * must be held.
+ * @return bool   false if the new record should be discarded
+ */
+bool AsyncDestination::_makeRoom(unique_lock<mutex>& lock, int importance) {
+    if (_queue.size() < _capacity) return true;
+    ++_overflows;
+    while (_queue.size() >= _capacity) {
+        if (_stopping || _policy == AsyncWriter::DROP_NEWEST) return false;
+        if (_policy == AsyncWriter::DROP_DEBUG_FIRST) {
+            auto debug = std::find_if(_queue.begin(), _queue.end(),
+                [](const unique_ptr<LogRecord>& r) {
+                    return r->getImportance() < Log::INFO;
+                });
+            if (debug != _queue.end()) {
+                _queue.erase(debug);
+                ++_dropped;
+                ++_done;
+                _written.notify_all();
+                return true;
+            }
+            if (importance < Log::INFO) return false;
+        }
+        _notFull.wait(lock);
+    }
+    return true;
+}
+
+/*
+ * wait until all records queued prior to this call have been written
+ * and flush the wrapped destination
+ */
+void AsyncDestination::flush() {
+    if (_thread.get_id() == std::this_thread::get_id()) return;
+    {
+        unique_lock<mutex> lock(_mutex);
+        unsigned long long end = _queued;
+        while (_done < end) _written.wait(lock);
+    }
+    lock_guard<mutex> lock(_destMutex);
+    _dest->flush();
+}
+
+unsigned long long AsyncDestination::getOverflowCount() const {
+    lock_guard<mutex> lock(_mutex);
+    return _overflows;
+}
+
+unsigned long long AsyncDestination::getDropCount() const {
+    lock_guard<mutex> lock(_mutex);
+    return _dropped;
+}
+
+unsigned long long AsyncDestination::getBypassCount() const {
+    lock_guard<mutex> lock(_mutex);
+    return _bypassed;
+}
+
+std::size_t AsyncDestination::getQueueLength() const {
+    lock_guard<mutex> lock(_mutex);
+    return _queue.size();
+}
+
+/*
+ * the body of the worker thread
+ */
+void AsyncDestination::_run() {
+    std::vector<unique_ptr<LogRecord> > batch;
+    std::vector<const LogRecord*> records;
+    unique_lock<mutex> lock(_mutex);
+    while (true) {
+        while (_queue.empty() && ! _stopping) _notEmpty.wait(lock);
+        if (_queue.empty()) break;
+        std::size_t count = std::min(_queue.size(), MAX_BATCH);
+        for(std::size_t i=0; i < count; ++i) {
+            batch.push_back(std::move(_queue.front()));
+            _queue.pop_front();
+            records.push_back(batch.back().get());
+        }
+        bool idle = _queue.empty();
+        lock.unlock();
+        _notFull.notify_all();
+
+        {
+            lock_guard<mutex> destLock(_destMutex);
+            try {
+                _dest->writeBatch(&records[0], count);
+
+                // nothing more is waiting, so push out what the
+                // destination has buffered
+                if (idle) _dest->flush();
+            }
+            catch (...) { }
+        }
+        batch.clear();
+        records.clear();
+
+        lock.lock();
+        _done += count;
+        _written.notify_all();
+    }
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
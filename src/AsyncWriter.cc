@@ -0,0 +1,599 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file AsyncWriter.cc
+ */
+#include "lsst/pex/logging/AsyncWriter.h"
+#include "lsst/pex/logging/Log.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <new>
+#include <queue>
+#include <set>
+#include <pthread.h>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+using std::shared_ptr;
+using std::mutex;
+using std::unique_lock;
+using std::lock_guard;
+
+namespace {
+
+    // the writers currently alive; these are flushed when the process
+    // exits.  The registry is never destroyed so that it remains usable
+    // from atexit handlers.
+    struct WriterRegistry {
+        mutex lock;
+        std::set<AsyncWriter*> writers;
+    };
+
+    WriterRegistry& registry() {
+        static WriterRegistry *reg = 0;
+        static std::once_flag once;
+        std::call_once(once, []() {
+            reg = new WriterRegistry();
+            std::atexit(&AsyncWriter::flushAll);
+        });
+        return *reg;
+    }
+
+    std::atomic<unsigned long long> nextWriterId(1);
+
+    // set on a writer thread whose AsyncWriter was destroyed by a 
+    // destination it was writing to; the thread must then return without
+    // touching the writer again
+    thread_local bool writerGone = false;
+
+    std::size_t powerOf2(std::size_t atLeast) {
+        std::size_t size = 1;
+        while (size < atLeast) size <<= 1;
+        return size;
+    }
+}
+
+/*
+ * the records queued by one sending thread.  Only that thread adds
+ * records (at the tail), and only the writer thread removes them (at the
+ * head).  Under DROP_DEBUG_FIRST, the sending thread may also cancel a
+ * queued record, which the writer thread then skips; cancelled records
+ * still take up a slot until they are skipped, so rings for that policy
+ * have twice as many slots as the capacity.
+ */
+class AsyncWriter::Ring {
+public:
+    enum SlotState { EMPTY = 0, READY, CANCELLED };
+
+    struct Slot {
+        Slot() : time(0), importance(0), state(EMPTY), rec(), dests() { }
+        long long time;
+        int importance;
+        std::atomic<int> state;
+        shared_ptr<LogRecord> rec;
+        DestinationList dests;
+    };
+
+    Ring(std::size_t size, std::thread::id owner) 
+        : owner(owner), tail(0), cancelled(0), head(0), skipped(0), done(0),
+          orphaned(false), closed(false), _slots(new Slot[size]), 
+          _mask(size - 1)
+    { }
+
+    Slot& slot(unsigned long long index) { return _slots[index & _mask]; }
+
+    // the number of records queued and not cancelled.  Reading head 
+    // before skipped means this can only overestimate.
+    unsigned long long queued() const {
+        unsigned long long h = head.load(std::memory_order_acquire);
+        unsigned long long s = skipped.load(std::memory_order_acquire);
+        return tail.load(std::memory_order_relaxed) - h - 
+               (cancelled.load(std::memory_order_relaxed) - s);
+    }
+
+    bool hasRoom(std::size_t capacity) const {
+        return queued() < capacity && 
+               tail.load(std::memory_order_relaxed) - 
+               head.load(std::memory_order_acquire) <= _mask;
+    }
+
+    bool isEmpty() const {
+        return head.load(std::memory_order_relaxed) == 
+               tail.load(std::memory_order_acquire);
+    }
+
+    // cancel the oldest queued debugging record; called by the owner
+    bool cancelDebug() {
+        unsigned long long end = tail.load(std::memory_order_relaxed);
+        for(unsigned long long i = head.load(std::memory_order_acquire);
+            i < end; ++i) 
+        {
+            Slot& s = slot(i);
+            int ready = READY;
+            if (s.importance < Log::INFO &&
+                s.state.compare_exchange_strong(ready, CANCELLED))
+            {
+                cancelled.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    const std::thread::id owner;
+
+    // written by the sending thread
+    std::atomic<unsigned long long> tail;
+    std::atomic<unsigned long long> cancelled;
+    char padding[64];          // keeps the two sides on separate cache lines
+
+    // written by the writer thread
+    std::atomic<unsigned long long> head;
+    std::atomic<unsigned long long> skipped;
+    std::atomic<unsigned long long> done;     // records written or skipped
+
+    std::atomic<bool> orphaned;     // the sending thread has exited
+    std::atomic<bool> closed;       // the writer has been destroyed
+
+private:
+    std::unique_ptr<Slot[]> _slots;
+    const std::size_t _mask;
+};
+
+const std::size_t AsyncWriter::DEFAULT_CAPACITY = 8192;
+
+AsyncWriter::AsyncWriter(std::size_t capacity, OverflowPolicy policy)
+    : _id(nextWriterId++), _capacity(capacity > 0 ? capacity : 1), 
+      _ringSize(0), _policy(policy), _rings(), _generation(0), _dropped(0), 
+      _blocked(0), _sleeping(false), _restart(false), _stopping(false),
+      _mutex(), _notEmpty(), _notFull(), _written(), _thread()
+{
+    _ringSize = powerOf2((_policy == DROP_DEBUG_FIRST) ? 2*_capacity 
+                                                        : _capacity);
+    _thread = std::thread(&AsyncWriter::_run, this);
+
+    static std::once_flag forkHandlers;
+    std::call_once(forkHandlers, []() {
+        pthread_atfork(&AsyncWriter::_prepareFork, 
+                       &AsyncWriter::_parentAfterFork,
+                       &AsyncWriter::_childAfterFork);
+    });
+
+    WriterRegistry& reg = registry();
+    lock_guard<mutex> lock(reg.lock);
+    reg.writers.insert(this);
+}
+
+/*
+ * write out all remaining records and stop the writer thread.  When this
+ * is called from the writer thread itself (by a destination that drops 
+ * the last reference to this writer), the thread cannot be waited for; 
+ * it is detached and told to return as soon as the destination does, and
+ * the records still queued are discarded.
+ */
+AsyncWriter::~AsyncWriter() {
+    {
+        WriterRegistry& reg = registry();
+        lock_guard<mutex> lock(reg.lock);
+        reg.writers.erase(this);
+    }
+    {
+        lock_guard<mutex> lock(_mutex);
+        _stopping = true;
+    }
+    _notEmpty.notify_all();
+    _notFull.notify_all();
+    if (_thread.joinable()) {
+        if (_thread.get_id() == std::this_thread::get_id()) {
+            writerGone = true;
+            _thread.detach();
+        }
+        else 
+            _thread.join();
+    }
+
+    // let the sending threads forget their rings
+    lock_guard<mutex> lock(_mutex);
+    for(auto const& ring : _rings) 
+        ring->closed.store(true, std::memory_order_release);
+}
+
+/*
+ * return the calling thread's ring, creating it on first use.  A thread
+ * that writes while exiting, after its rings have been given up, gets a
+ * new ring each time, which it must give up itself (exiting is set).
+ */
+AsyncWriter::Ring& AsyncWriter::_getRing(bool& exiting) {
+    static thread_local bool gone = false;
+
+    // each thread's rings, which are given up when it exits
+    struct RingCache {
+        RingCache() : rings() { }
+        ~RingCache() {
+            for(auto const& entry : rings) 
+                entry.second->orphaned.store(true, std::memory_order_release);
+            gone = true;
+        }
+        std::vector<std::pair<unsigned long long, shared_ptr<Ring> > > rings;
+    };
+    static thread_local RingCache cache;
+
+    exiting = gone;
+    if (! gone) {
+        for(auto const& entry : cache.rings) 
+            if (entry.first == _id) return *entry.second;
+
+        // forget rings of writers that have been destroyed
+        auto dead = [](const std::pair<unsigned long long, 
+                                       shared_ptr<Ring> >& entry) {
+            return entry.second->closed.load(std::memory_order_acquire);
+        };
+        cache.rings.erase(std::remove_if(cache.rings.begin(), 
+                                         cache.rings.end(), dead),
+                          cache.rings.end());
+    }
+
+    shared_ptr<Ring> ring(new Ring(_ringSize, std::this_thread::get_id()));
+    {
+        lock_guard<mutex> lock(_mutex);
+        _rings.push_back(ring);
+        _generation.fetch_add(1, std::memory_order_release);
+    }
+    if (! gone) cache.rings.push_back(std::make_pair(_id, ring));
+    return *ring;
+}
+
+/*
+ * wait for or make room in a sending thread's ring according to the 
+ * overflow policy.
+ * @return bool   false if the incoming record should be dropped
+ */
+bool AsyncWriter::_makeRoom(Ring& ring, int importance) {
+    while (! ring.hasRoom(_capacity)) {
+        if (_policy == DROP_NEWEST) 
+            return false;
+
+        if (_policy == DROP_DEBUG_FIRST) {
+            if (ring.queued() >= _capacity && ring.cancelDebug()) {
+                ++_dropped;
+                continue;
+            }
+            if (importance < Log::INFO) 
+                return false;
+        }
+
+        unique_lock<mutex> lock(_mutex);
+        if (_stopping) return false;
+        _blocked.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (! ring.hasRoom(_capacity)) _notFull.wait(lock);
+        _blocked.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+/*
+ * queue a copy of a record to be written to the given destinations.
+ */
+bool AsyncWriter::write(const LogRecord& rec, 
+                        const DestinationList& destinations) 
+{
+    if (destinations.empty()) return true;
+    if (_restart.load(std::memory_order_relaxed)) _start();
+
+    bool exiting = false;
+    Ring& ring = _getRing(exiting);
+    if (! _makeRoom(ring, rec.getImportance())) {
+        ++_dropped;
+        if (exiting) ring.orphaned.store(true, std::memory_order_release);
+        return false;
+    }
+
+    unsigned long long tail = ring.tail.load(std::memory_order_relaxed);
+    Ring::Slot& slot = ring.slot(tail);
+    slot.time = (rec.isCompact() && rec.hasTimestamp()) 
+                    ? rec.getTimestamp() : LogRecord::utcnow();
+    slot.importance = rec.getImportance();
+    slot.rec.reset(new LogRecord(rec));
+    slot.dests = destinations;
+    slot.state.store(Ring::READY, std::memory_order_relaxed);
+    ring.tail.store(tail + 1, std::memory_order_release);
+    if (exiting) ring.orphaned.store(true, std::memory_order_release);
+
+    // wake the writer thread if it is waiting (see _run())
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_sleeping.load(std::memory_order_relaxed)) {
+        lock_guard<mutex> lock(_mutex);
+        _notEmpty.notify_one();
+    }
+    return true;
+}
+
+/*
+ * wait until all records accepted prior to this call have been written
+ */
+void AsyncWriter::flush() {
+    if (_thread.get_id() == std::this_thread::get_id()) return;
+    if (_restart.load(std::memory_order_relaxed)) _start();
+
+    unique_lock<mutex> lock(_mutex);
+    RingList rings(_rings);
+    std::vector<unsigned long long> ends;
+    for(auto const& ring : rings) 
+        ends.push_back(ring->tail.load(std::memory_order_acquire));
+
+    std::size_t i = 0;
+    while (i < rings.size()) {
+        if (rings[i]->done.load(std::memory_order_acquire) >= ends[i]) 
+            ++i;
+        else
+            _written.wait(lock);
+    }
+}
+
+unsigned long long AsyncWriter::getDropCount() const {
+    return _dropped.load();
+}
+
+std::size_t AsyncWriter::getQueueLength() const {
+    lock_guard<mutex> lock(_mutex);
+    std::size_t length = 0;
+    for(auto const& ring : _rings) 
+        length += ring->queued();
+    return length;
+}
+
+void AsyncWriter::flushAll() {
+    WriterRegistry& reg = registry();
+    lock_guard<mutex> lock(reg.lock);
+    std::set<AsyncWriter*>::iterator it;
+    for(it = reg.writers.begin(); it != reg.writers.end(); ++it) 
+        (*it)->flush();
+}
+
+/*
+ * start a new writer thread in a child process
+ */
+void AsyncWriter::_start() {
+    lock_guard<mutex> lock(_mutex);
+    if (! _restart.load(std::memory_order_relaxed)) return;
+    _thread = std::thread(&AsyncWriter::_run, this);
+    _restart.store(false, std::memory_order_relaxed);
+}
+
+/*
+ * write the records that are waiting in the rings, merged into time 
+ * order.  Records queued after this starts are left for the next call.
+ * @param rings    the rings to drain
+ * @param written  the destinations written to are added to this
+ * @return bool    true if any records were taken from the rings
+ */
+bool AsyncWriter::_drain(const RingList& rings, DestinationSet& written) {
+    // the time of the next record in each ring, by ring
+    typedef std::pair<long long, std::size_t> Next;
+    std::priority_queue<Next, std::vector<Next>, std::greater<Next> > next;
+    std::vector<unsigned long long> ends(rings.size());
+    for(std::size_t i=0; i < rings.size(); ++i) {
+        Ring& ring = *rings[i];
+        ends[i] = ring.tail.load(std::memory_order_acquire);
+        unsigned long long head = ring.head.load(std::memory_order_relaxed);
+        if (head < ends[i]) next.push(Next(ring.slot(head).time, i));
+    }
+    if (next.empty()) return false;
+
+    while (! next.empty() && ! writerGone) {
+        std::size_t i = next.top().second;
+        next.pop();
+        Ring& ring = *rings[i];
+        unsigned long long head = ring.head.load(std::memory_order_relaxed);
+        Ring::Slot& slot = ring.slot(head);
+
+        // take the record out so that its slot is free while it is written
+        shared_ptr<LogRecord> rec;
+        DestinationList dests;
+        int ready = Ring::READY;
+        bool cancelled = 
+            ! slot.state.compare_exchange_strong(ready, Ring::EMPTY);
+        rec.swap(slot.rec);
+        dests.swap(slot.dests);
+        if (cancelled) {
+            slot.state.store(Ring::EMPTY, std::memory_order_relaxed);
+            ring.skipped.store(ring.skipped.load(std::memory_order_relaxed)+1,
+                               std::memory_order_release);
+        }
+        ring.head.store(head + 1, std::memory_order_release);
+        if (head + 1 < ends[i]) next.push(Next(ring.slot(head + 1).time, i));
+
+        // wake senders waiting for room (see _makeRoom()) once their 
+        // rings are half empty or this pass is over
+        if (ends[i] - head - 1 == _capacity/2 || next.empty()) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (_blocked.load(std::memory_order_relaxed) > 0) {
+                lock_guard<mutex> lock(_mutex);
+                _notFull.notify_all();
+            }
+        }
+
+        if (cancelled) continue;
+        RenderedRecord rendered(*rec);
+        DestinationList::iterator di;
+        for(di = dests.begin(); di != dests.end(); ++di) {
+            try {
+                if (dests.size() == 1) 
+                    (*di)->write(*rec);
+                else
+                    (*di)->write(rendered);
+            }
+            catch (...) { }
+            if (writerGone) return true;
+            if (std::find(written.begin(), written.end(), *di) == 
+                written.end()) 
+              written.push_back(*di);
+        }
+    }
+    return true;
+}
+
+/*
+ * forget the rings of threads that have exited once they are empty.  The
+ * lock must be held.
+ * @return bool   true if any were forgotten
+ */
+bool AsyncWriter::_removeOrphans() {
+    std::size_t count = _rings.size();
+    auto gone = [](const shared_ptr<Ring>& ring) {
+        return ring->orphaned.load(std::memory_order_acquire) && 
+               ring->isEmpty();
+    };
+    _rings.erase(std::remove_if(_rings.begin(), _rings.end(), gone), 
+                 _rings.end());
+    if (_rings.size() == count) return false;
+    _generation.fetch_add(1, std::memory_order_release);
+    return true;
+}
+
+/*
+ * the body of the writer thread.  After any call into a destination, 
+ * writerGone is checked before this writer is touched again, as the 
+ * destination may have destroyed it.
+ */
+void AsyncWriter::_run() {
+    RingList rings;
+    unsigned long long seen = 0;
+    DestinationSet written;
+    auto pending = [&rings]() {
+        for(auto const& ring : rings) 
+            if (! ring->isEmpty()) return true;
+        return false;
+    };
+
+    while (true) {
+        if (_generation.load(std::memory_order_acquire) != seen) {
+            lock_guard<mutex> lock(_mutex);
+            rings = _rings;
+            seen = _generation.load(std::memory_order_relaxed);
+        }
+
+        _drain(rings, written);
+        if (writerGone) return;
+
+        // nothing more may be coming soon, so push out what the 
+        // destinations have buffered
+        // (one with nothing buffered, such as an AsyncDestination, which
+        // flushes itself, is skipped so that this thread never waits on it)
+        if (! pending()) {
+            for(auto const& dest : written) {
+                try {
+                    if (dest->getPendingBytes() > 0) dest->flush();
+                }
+                catch (...) { }
+                if (writerGone) return;
+            }
+            written.clear();
+        }
+        for(auto const& ring : rings) 
+            ring->done.store(ring->head.load(std::memory_order_relaxed),
+                             std::memory_order_release);
+
+        unique_lock<mutex> lock(_mutex);
+        _written.notify_all();
+        if (pending() || _generation.load(std::memory_order_relaxed) != seen
+            || _removeOrphans()) 
+          continue;
+        if (_stopping) break;
+
+        // a sender that publishes a record after the fence will see that
+        // this thread is sleeping and wake it
+        _sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (! pending() && ! _stopping &&
+            _generation.load(std::memory_order_relaxed) == seen)
+          _notEmpty.wait(lock);
+        _sleeping.store(false, std::memory_order_relaxed);
+    }
+    _written.notify_all();
+}
+
+/*
+ * hold every writer's lock across fork() so that the child gets them in
+ * a consistent state
+ */
+void AsyncWriter::_prepareFork() {
+    WriterRegistry& reg = registry();
+    reg.lock.lock();
+    for(auto writer : reg.writers) writer->_mutex.lock();
+}
+
+void AsyncWriter::_parentAfterFork() {
+    WriterRegistry& reg = registry();
+    for(auto writer : reg.writers) writer->_mutex.unlock();
+    reg.lock.unlock();
+}
+
+void AsyncWriter::_childAfterFork() {
+    WriterRegistry& reg = registry();
+    for(auto writer : reg.writers) {
+        writer->_resetAfterFork();
+        writer->_mutex.unlock();
+    }
+    reg.lock.unlock();
+}
+
+/*
+ * recover in a child process, in which only the thread that called fork()
+ * survives.  The records queued before the fork are the parent's to
+ * write, so they are discarded here, as are the other threads' rings.  
+ * The lock is held.
+ */
+void AsyncWriter::_resetAfterFork() {
+    RingList kept;
+    for(auto const& ring : _rings) {
+        if (ring->owner != std::this_thread::get_id()) continue;
+        unsigned long long tail = ring->tail.load(std::memory_order_relaxed);
+        ring->skipped.store(ring->cancelled.load(std::memory_order_relaxed));
+        ring->head.store(tail);
+        ring->done.store(tail);
+        kept.push_back(ring);
+    }
+    _rings.swap(kept);
+    _generation.fetch_add(1, std::memory_order_release);
+    _blocked.store(0);
+    _sleeping.store(false);
+
+    // the condition variables may record waiters that no longer exist
+    new (&_notEmpty) std::condition_variable();
+    new (&_notFull) std::condition_variable();
+    new (&_written) std::condition_variable();
+
+    // the writer thread does not exist here; it is restarted when needed
+    if (_thread.joinable()) _thread.detach();
+    _restart.store(! _stopping, std::memory_order_relaxed);
+}
+
+//@endcond
+}}} // end lsst::pex::logging
@@ -0,0 +1,53 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryFileDestination.cc
+ */
+#include "lsst/pex/logging/BinaryFileDestination.h"
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+BinaryFileDestination::BinaryFileDestination(
+    const boost::filesystem::path& filepath, int threshold, bool truncate)
+    : FileDestination(filepath, 
+                      std::shared_ptr<LogFormatter>(new BinaryFormatter()),
+                      threshold, truncate)
+{ }
+BinaryFileDestination::BinaryFileDestination(const std::string& filepath, 
+                                             int threshold, bool truncate)
+    : FileDestination(filepath, 
+                      std::shared_ptr<LogFormatter>(new BinaryFormatter()),
+                      threshold, truncate)
+{ }
+BinaryFileDestination::BinaryFileDestination(const char *filepath, 
+                                             int threshold, bool truncate)
+    : FileDestination(filepath, 
+                      std::shared_ptr<LogFormatter>(new BinaryFormatter()),
+                      threshold, truncate)
+{ }
+
+BinaryFileDestination::~BinaryFileDestination() { }
+
+}}} // end lsst::pex::logging
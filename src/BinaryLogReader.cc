@@ -0,0 +1,371 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryLogReader.cc
+ */
+#include "lsst/pex/logging/BinaryLogReader.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/daf/base/DateTime.h"
+#include "lsst/pex/exceptions.h"
+
+#include <cstdint>
+#include <cstring>
+
+using std::string;
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+using lsst::daf::base::PropertySet;
+using lsst::daf::base::DateTime;
+namespace pexExcept = lsst::pex::exceptions;
+
+namespace {
+
+    // the longest frame accepted; anything longer is taken as corruption
+    const unsigned long long MAX_FRAME_LENGTH = 1ULL << 30;
+
+    void corrupt(char const *why) {
+        throw LSST_EXCEPT(pexExcept::IoError, 
+                          string("Corrupt binary log: ") + why);
+    }
+
+    /*
+     * reads the parts of a frame in turn
+     */
+    class FrameReader {
+    public:
+        FrameReader(string const& frame, std::vector<string>& names) 
+            : _p(frame.data()), _end(frame.data() + frame.size()), 
+              _names(names) 
+        { }
+
+        bool atEnd() const { return _p == _end; }
+
+        std::size_t remaining() const { return _end - _p; }
+
+        int getByte() {
+            _need(1);
+            return static_cast<unsigned char>(*_p++);
+        }
+
+        unsigned long long getVarint() {
+            unsigned long long val = 0;
+            for(int shift=0; shift < 64; shift += 7) {
+                int byte = getByte();
+                val |= static_cast<unsigned long long>(byte & 0x7f) << shift;
+                if (! (byte & 0x80)) return val;
+            }
+            corrupt("integer too long");
+            return val;
+        }
+
+        long long getSigned() {
+            unsigned long long val = getVarint();
+            return static_cast<long long>((val >> 1) ^ (~(val & 1) + 1));
+        }
+
+        unsigned long long getFixed(int nbytes) {
+            _need(nbytes);
+            unsigned long long val = 0;
+            for(int i=0; i < nbytes; ++i) 
+                val |= static_cast<unsigned long long>(
+                           static_cast<unsigned char>(*_p++)) << (8*i);
+            return val;
+        }
+
+        string getString() {
+            unsigned long long len = getVarint();
+            _need(len);
+            string out(_p, len);
+            _p += len;
+            return out;
+        }
+
+        // read a reference to a name, learning it if it is defined here
+        string const& getName() {
+            unsigned long long val = getVarint();
+            unsigned long long id = val >> 1;
+            if (val & 1) {
+                if (id != _names.size()) corrupt("name defined out of order");
+                _names.push_back(getString());
+            }
+            else if (id >= _names.size()) {
+                corrupt("reference to an undefined name");
+            }
+            return _names[id];
+        }
+
+        // read a named, typed value and add it to target
+        template <class Target>
+        void getValue(Target& target);
+
+    private:
+        void _need(unsigned long long n) {
+            if (static_cast<unsigned long long>(_end - _p) < n) 
+                corrupt("frame ends early");
+        }
+
+        char const *_p;
+        char const *_end;
+        std::vector<string>& _names;
+    };
+
+    template <class Target>
+    void FrameReader::getValue(Target& target) {
+        const string name = getName();
+        switch (getByte()) {
+        case BinaryFormatter::BOOL:
+            target.add(name, getByte() != 0);
+            break;
+        case BinaryFormatter::CHAR:
+            target.add(name, static_cast<char>(getByte()));
+            break;
+        case BinaryFormatter::SHORT:
+            target.add(name, static_cast<short>(getSigned()));
+            break;
+        case BinaryFormatter::INT:
+            target.add(name, static_cast<int>(getSigned()));
+            break;
+        case BinaryFormatter::LONG:
+            target.add(name, static_cast<long>(getSigned()));
+            break;
+        case BinaryFormatter::LONG_LONG:
+            target.add(name, getSigned());
+            break;
+        case BinaryFormatter::UNSIGNED_LONG_LONG:
+            target.add(name, getVarint());
+            break;
+        case BinaryFormatter::FLOAT: {
+            uint32_t bits = static_cast<uint32_t>(getFixed(4));
+            float val;
+            std::memcpy(&val, &bits, sizeof(val));
+            target.add(name, val);
+            break;
+        }
+        case BinaryFormatter::DOUBLE: {
+            unsigned long long bits = getFixed(8);
+            double val;
+            std::memcpy(&val, &bits, sizeof(val));
+            target.add(name, val);
+            break;
+        }
+        case BinaryFormatter::STRING:
+        case BinaryFormatter::TEXT:
+            target.add(name, getString());
+            break;
+        case BinaryFormatter::DATETIME:
+            target.add(name, DateTime(static_cast<long long>(getFixed(8)),
+                                      DateTime::UTC));
+            break;
+        default:
+            corrupt("unknown value type");
+        }
+    }
+
+    // adds decoded values to a preamble
+    struct SetTarget {
+        PropertySet& set;
+
+        template <class T>
+        void add(string const& name, T const& value) {
+            set.add<T>(name, value);
+        }
+    };
+
+    // adds decoded values to a record
+    struct RecordTarget {
+        LogRecord& rec;
+
+        template <class T>
+        void add(string const& name, T const& value) {
+            rec.addProperty<T>(name, value);
+        }
+    };
+}
+
+BinaryLogReader::BinaryLogReader(std::istream& strm) 
+    : _strm(strm), _frame(), _started(false), _count(0), _names(), 
+      _preambles(), _formats()
+{ }
+
+std::shared_ptr<LogRecord> BinaryLogReader::next() {
+    while (_readFrame()) {
+        if (_frame.empty()) corrupt("empty frame");
+        int kind = static_cast<unsigned char>(_frame[0]);
+        if (kind == BinaryFormatter::HEADER) {
+            _readHeader();
+            continue;
+        }
+        if (! _started) corrupt("not a binary log");
+        if (kind == BinaryFormatter::TRACE_FORMAT) {
+            _readTraceFormat();
+            continue;
+        }
+        if (kind == BinaryFormatter::TRACE_EVENT) {
+            ++_count;
+            return _readTraceEvent();
+        }
+        if (kind != BinaryFormatter::RECORD) continue;
+
+        FrameReader in(_frame, _names);
+        in.getByte();
+        int flags = in.getByte();
+        int level = static_cast<int>(in.getSigned());
+        long long timestamp = 0;
+        if (flags & BinaryFormatter::HAS_TIMESTAMP) 
+            timestamp = static_cast<long long>(in.getFixed(8));
+        string logName;
+        if (flags & BinaryFormatter::HAS_LOG) 
+            logName = in.getName();
+
+        PreamblePtr preamble;
+        unsigned long long ref = in.getVarint();
+        if (ref > 0) {
+            if (ref < 2) corrupt("bad preamble reference");
+            unsigned long long id = (ref - 2) >> 1;
+            if (ref & 1) {
+                if (id != _preambles.size()) 
+                    corrupt("preamble defined out of order");
+                PropertySet::Ptr props(new PropertySet());
+                SetTarget target = { *props };
+                for (unsigned long long n = in.getVarint(); n > 0; --n) 
+                    in.getValue(target);
+                _preambles.push_back(props);
+            }
+            else if (id >= _preambles.size()) {
+                corrupt("reference to an undefined preamble");
+            }
+            preamble = _preambles[id];
+        }
+
+        std::shared_ptr<LogRecord> rec;
+        if (flags & BinaryFormatter::HAS_LOG) 
+            rec.reset(new LogRecord(level, level, preamble, logName));
+        else if (preamble) 
+            rec.reset(new LogRecord(level, level, *preamble));
+        else 
+            rec.reset(new LogRecord(level, level));
+        if (flags & BinaryFormatter::HAS_TIMESTAMP) 
+            rec->setTimestamp(timestamp);
+
+        for (unsigned long long n = in.getVarint(); n > 0; --n) 
+            rec->addComment(in.getString());
+        RecordTarget target = { *rec };
+        while (! in.atEnd()) 
+            in.getValue(target);
+
+        ++_count;
+        return rec;
+    }
+    return std::shared_ptr<LogRecord>();
+}
+
+/*
+ * read the next frame into _frame, returning false at the end of the stream
+ */
+bool BinaryLogReader::_readFrame() {
+    unsigned long long len = 0;
+    for(int shift=0; ; shift += 7) {
+        std::istream::int_type c = _strm.get();
+        if (c == std::istream::traits_type::eof()) {
+            if (shift == 0) return false;
+            corrupt("stream ends within a frame");
+        }
+        if (shift >= 63) corrupt("frame length too long");
+        len |= static_cast<unsigned long long>(c & 0x7f) << shift;
+        if (! (c & 0x80)) break;
+    }
+    if (len > MAX_FRAME_LENGTH) corrupt("frame length too long");
+
+    _frame.resize(len);
+    _strm.read(&_frame[0], len);
+    if (static_cast<unsigned long long>(_strm.gcount()) != len) 
+        corrupt("stream ends within a frame");
+    return true;
+}
+
+/*
+ * start over on reading a header frame
+ */
+void BinaryLogReader::_readHeader() {
+    if (_frame.size() < 9 || 
+        std::memcmp(_frame.data() + 1, BinaryFormatter::MAGIC, 8) != 0) 
+        corrupt("not a binary log");
+    string rest = _frame.substr(9);
+    FrameReader in(rest, _names);
+    if (in.getVarint() > static_cast<unsigned long long>(BinaryFormatter::VERSION))
+        corrupt("written in an unsupported version of the format");
+    _names.clear();
+    _preambles.clear();
+    _formats.clear();
+    _started = true;
+}
+
+/*
+ * learn the description of a place that sent BinaryTrace messages
+ */
+void BinaryLogReader::_readTraceFormat() {
+    FrameReader in(_frame, _names);
+    in.getByte();
+    unsigned long long id = in.getVarint();
+    BinaryTrace::Format format;
+    format.name = in.getString();
+    format.verbosity = static_cast<int>(in.getSigned());
+    format.file = in.getString();
+    format.line = static_cast<int>(in.getVarint());
+    format.format = in.getString();
+    format.codes = in.getString();
+    _formats[id] = format;
+}
+
+/*
+ * recreate a BinaryTrace message as a record
+ */
+std::shared_ptr<LogRecord> BinaryLogReader::_readTraceEvent() {
+    FrameReader in(_frame, _names);
+    in.getByte();
+    auto fi = _formats.find(in.getVarint());
+    if (fi == _formats.end()) corrupt("reference to an undefined format");
+    long long timestamp = static_cast<long long>(in.getFixed(8));
+    BinaryTrace::Format const& format = fi->second;
+
+    string msg;
+    std::size_t used = _frame.size() - in.remaining();
+    if (! BinaryTrace::formatMessage(msg, format, _frame.data() + used,
+                                     in.remaining()))
+        corrupt("message does not match its format");
+
+    int level = -1*format.verbosity;
+    std::shared_ptr<LogRecord> rec(new LogRecord(level, level, PreamblePtr(),
+                                                 format.name));
+    rec->setTimestamp(timestamp);
+    rec->addComment(msg);
+    return rec;
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
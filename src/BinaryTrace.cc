@@ -0,0 +1,613 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file BinaryTrace.cc
+ */
+#include "lsst/pex/logging/BinaryTrace.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/Timestamp.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+
+namespace {
+
+    // the header of each message in a thread's buffer
+    struct EntryHeader {
+        uint32_t id;       // the format id, or 0 for padding
+        uint32_t size;     // the bytes used by the message, without padding
+        long long time;
+    };
+
+    const std::size_t HEADER_SIZE = sizeof(EntryHeader);
+
+    // messages start on 8-byte boundaries
+    std::size_t padded(std::size_t size) { 
+        return (size + 7) & ~static_cast<std::size_t>(7); 
+    }
+
+    /*
+     * a ring of messages written by one thread and read by the one that
+     * drains it.  A message that would not fit before the end of the ring
+     * is preceded by padding (a header with an id of 0) to the end.
+     */
+    class TraceBuffer {
+    public:
+        explicit TraceBuffer(std::size_t capacity) 
+            : _data(new char[capacity]), _capacity(capacity), _pending(0),
+              _head(0), _tail(0), _orphaned(false)
+        { }
+
+        // return room for a message of size bytes, or null if it is full
+        char *reserve(std::size_t size) {
+            std::size_t need = padded(size);
+            unsigned long long head = _head.load(std::memory_order_relaxed);
+            unsigned long long tail = _tail.load(std::memory_order_acquire);
+            std::size_t offset = head & (_capacity - 1);
+            std::size_t skip = (need <= _capacity - offset) 
+                                   ? 0 : _capacity - offset;
+            if (head + skip + need - tail > _capacity) return 0;
+            if (skip > 0) {
+                uint32_t pad[2] = { 0, static_cast<uint32_t>(skip) };
+                std::memcpy(_data.get() + offset, pad, sizeof(pad));
+            }
+            _pending = skip + need;
+            return _data.get() + ((head + skip) & (_capacity - 1));
+        }
+
+        // make the message written into the room reserved available
+        void commit() {
+            _head.store(_head.load(std::memory_order_relaxed) + _pending,
+                        std::memory_order_release);
+        }
+
+        // hand each message to handler(header, args, len) and free it
+        template <class Handler>
+        void drain(Handler& handler) {
+            unsigned long long tail = _tail.load(std::memory_order_relaxed);
+            unsigned long long head = _head.load(std::memory_order_acquire);
+            while (tail < head) {
+                char const *msg = _data.get() + (tail & (_capacity - 1));
+                EntryHeader header;
+                std::memcpy(&header, msg, 2*sizeof(uint32_t));
+                if (header.id != 0) {
+                    std::memcpy(&header, msg, HEADER_SIZE);
+                    handler(header, msg + HEADER_SIZE, 
+                            header.size - HEADER_SIZE);
+                }
+                tail += padded(header.size);
+            }
+            _tail.store(tail, std::memory_order_release);
+        }
+
+        bool isEmpty() const {
+            return _tail.load(std::memory_order_acquire) == 
+                   _head.load(std::memory_order_acquire);
+        }
+
+        // the owning thread has exited
+        void orphan() { _orphaned.store(true, std::memory_order_release); }
+        bool isOrphaned() const { 
+            return _orphaned.load(std::memory_order_acquire); 
+        }
+
+    private:
+        std::unique_ptr<char[]> _data;
+        const std::size_t _capacity;
+        std::size_t _pending;
+        std::atomic<unsigned long long> _head;
+        std::atomic<unsigned long long> _tail;
+        std::atomic<bool> _orphaned;
+    };
+
+    /*
+     * everything shared by the threads that trace and the one that drains
+     */
+    struct State {
+        State() 
+            : formatsMutex(), formats(), buffersMutex(), buffers(), drops(0),
+              bufferSize(BinaryTrace::DEFAULT_BUFFER_SIZE), drainMutex(), 
+              output(), written(), threadMutex(), wake(), thread(), 
+              stopping(false)
+        { }
+
+        std::mutex formatsMutex;
+        std::deque<BinaryTrace::Format> formats;   // formats[id-1]
+
+        std::mutex buffersMutex;
+        std::vector<std::shared_ptr<TraceBuffer> > buffers;
+        std::atomic<unsigned long long> drops;
+        std::atomic<std::size_t> bufferSize;
+
+        // held while draining; guards output and written
+        std::mutex drainMutex;
+        std::shared_ptr<std::ostream> output;
+        std::unordered_set<unsigned int> written;   // formats in output
+
+        std::mutex threadMutex;
+        std::condition_variable wake;
+        std::thread thread;
+        bool stopping;
+    };
+
+    // never destroyed, so that threads may trace until the very end
+    State& state() {
+        static State *shared = new State();
+        return *shared;
+    }
+
+    // gives a thread's buffer up when the thread exits
+    struct LocalBuffer {
+        LocalBuffer() : buffer() { }
+        ~LocalBuffer() { if (buffer) buffer->orphan(); }
+        std::shared_ptr<TraceBuffer> buffer;
+    };
+
+    thread_local TraceBuffer *localBuffer = 0;
+    thread_local LocalBuffer localOwner;
+
+    TraceBuffer& getLocalBuffer() {
+        if (localBuffer == 0) {
+            State& s = state();
+            localOwner.buffer.reset(new TraceBuffer(s.bufferSize.load()));
+            std::lock_guard<std::mutex> lock(s.buffersMutex);
+            s.buffers.push_back(localOwner.buffer);
+            localBuffer = localOwner.buffer.get();
+        }
+        return *localBuffer;
+    }
+
+    void putString(char *&out, char const *data, std::size_t len) {
+        uint32_t n = static_cast<uint32_t>(len);
+        std::memcpy(out, &n, sizeof(n));
+        std::memcpy(out + sizeof(n), data, len);
+        out += sizeof(n) + len;
+    }
+
+    void put8(char *&out, void const *value) {
+        std::memcpy(out, value, 8);
+        out += 8;
+    }
+
+    // a drained message
+    struct Event {
+        long long time;
+        unsigned int id;
+        std::string args;
+    };
+
+    bool earlier(Event const& a, Event const& b) { return a.time < b.time; }
+
+    struct EventCollector {
+        std::vector<Event>& events;
+
+        void operator()(EntryHeader const& header, char const *args, 
+                        std::size_t len) 
+        {
+            Event event = { header.time, header.id, std::string(args, len) };
+            events.push_back(event);
+        }
+    };
+
+    void putVarint(std::string& out, unsigned long long val) {
+        while (val >= 0x80) {
+            out.push_back(static_cast<char>((val & 0x7f) | 0x80));
+            val >>= 7;
+        }
+        out.push_back(static_cast<char>(val));
+    }
+
+    void putSigned(std::string& out, long long val) {
+        putVarint(out, (static_cast<unsigned long long>(val) << 1) ^ 
+                       static_cast<unsigned long long>(val >> 63));
+    }
+
+    void putString(std::string& out, std::string const& val) {
+        putVarint(out, val.size());
+        out.append(val);
+    }
+
+    void writeFrame(std::ostream& strm, std::string const& frame) {
+        std::string length;
+        putVarint(length, frame.size());
+        strm.write(length.data(), length.size());
+        strm.write(frame.data(), frame.size());
+    }
+
+    // write messages in the binary log format; the drain lock is held
+    void writeEvents(State& s, std::vector<Event> const& events) {
+        std::ostream& strm = *s.output;
+        std::string frame;
+        for (auto const& event : events) {
+            BinaryTrace::Format const *format = 
+                BinaryTrace::getFormat(event.id);
+            if (format == 0) continue;
+            if (s.written.insert(event.id).second) {
+                frame.clear();
+                frame.push_back(BinaryFormatter::TRACE_FORMAT);
+                putVarint(frame, event.id);
+                putString(frame, format->name);
+                putSigned(frame, format->verbosity);
+                putString(frame, format->file);
+                putVarint(frame, format->line);
+                putString(frame, format->format);
+                putString(frame, format->codes);
+                writeFrame(strm, frame);
+            }
+            frame.clear();
+            frame.push_back(BinaryFormatter::TRACE_EVENT);
+            putVarint(frame, event.id);
+            for(int i=0; i < 8; ++i) 
+                frame.push_back(static_cast<char>(
+                    static_cast<unsigned long long>(event.time) >> (8*i)));
+            frame.append(event.args);
+            writeFrame(strm, frame);
+        }
+        strm.flush();
+    }
+
+    // format messages and send them to the default Log
+    void sendEvents(std::vector<Event> const& events) {
+        std::unordered_map<unsigned int, std::shared_ptr<Log> > logs;
+        std::string msg;
+        for (auto const& event : events) {
+            BinaryTrace::Format const *format = 
+                BinaryTrace::getFormat(event.id);
+            if (format == 0) continue;
+            std::shared_ptr<Log>& log = logs[event.id];
+            if (! log) 
+                log.reset(new Log(Log::getDefaultLog(), format->name));
+            msg.clear();
+            if (! BinaryTrace::formatMessage(msg, *format, event.args.data(),
+                                             event.args.size()))
+                msg = format->format;
+            LogRec rec(*log, -1*format->verbosity);
+            rec.addComment(msg);
+            rec.setTimestamp(event.time);
+            rec << LogRec::endr;
+        }
+    }
+
+    // drain every buffer; the drain lock is held
+    void drainAll(State& s) {
+        std::vector<std::shared_ptr<TraceBuffer> > buffers;
+        {
+            std::lock_guard<std::mutex> lock(s.buffersMutex);
+            buffers = s.buffers;
+        }
+
+        std::vector<Event> events;
+        EventCollector collector = { events };
+        for (auto const& buffer : buffers) 
+            buffer->drain(collector);
+
+        {
+            // forget the buffers of threads that have exited
+            std::lock_guard<std::mutex> lock(s.buffersMutex);
+            for (std::size_t i = 0; i < s.buffers.size(); ) {
+                if (s.buffers[i]->isOrphaned() && s.buffers[i]->isEmpty()) {
+                    s.buffers[i] = s.buffers.back();
+                    s.buffers.pop_back();
+                }
+                else {
+                    ++i;
+                }
+            }
+        }
+
+        if (events.empty()) return;
+        std::stable_sort(events.begin(), events.end(), &earlier);
+        if (s.output) 
+            writeEvents(s, events);
+        else 
+            sendEvents(events);
+    }
+
+    void run(unsigned int interval) {
+        State& s = state();
+        std::unique_lock<std::mutex> lock(s.threadMutex);
+        while (! s.stopping) {
+            s.wake.wait_for(lock, std::chrono::milliseconds(interval));
+            if (s.stopping) break;
+            lock.unlock();
+            BinaryTrace::flush();
+            lock.lock();
+        }
+    }
+
+    // stops the background thread when the program exits
+    struct Stopper {
+        ~Stopper() { BinaryTrace::stop(); }
+    };
+}
+
+const std::size_t BinaryTrace::DEFAULT_BUFFER_SIZE;
+const unsigned int BinaryTrace::DEFAULT_INTERVAL;
+
+unsigned int BinaryTrace::registerFormat(const Format& format) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.formatsMutex);
+    s.formats.push_back(format);
+    return static_cast<unsigned int>(s.formats.size());
+}
+
+const BinaryTrace::Format *BinaryTrace::getFormat(unsigned int id) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.formatsMutex);
+    if (id == 0 || id > s.formats.size()) return 0;
+    return &s.formats[id-1];
+}
+
+bool BinaryTrace::formatMessage(std::string& out, const Format& format,
+                                const char *args, std::size_t len)
+{
+    std::vector<FormatArg> list;
+    std::vector<std::string> strings;
+    list.reserve(format.codes.size());
+    strings.reserve(format.codes.size());
+    const char *end = args + len;
+
+    for (char code : format.codes) {
+        std::size_t need = (code == CHAR || code == BOOL) ? 1 
+                         : (code == STRING) ? sizeof(uint32_t) : 8;
+        if (static_cast<std::size_t>(end - args) < need) return false;
+        switch (code) {
+        case SIGNED: {
+            long long val;
+            std::memcpy(&val, args, 8);
+            list.push_back(FormatArg(val));
+            break;
+        }
+        case UNSIGNED: {
+            unsigned long long val;
+            std::memcpy(&val, args, 8);
+            list.push_back(FormatArg(val));
+            break;
+        }
+        case FLOAT: {
+            double val;
+            std::memcpy(&val, args, 8);
+            list.push_back(FormatArg(val));
+            break;
+        }
+        case POINTER: {
+            uint64_t val;
+            std::memcpy(&val, args, 8);
+            list.push_back(FormatArg(reinterpret_cast<const void*>(
+                                         static_cast<uintptr_t>(val))));
+            break;
+        }
+        case CHAR:
+            list.push_back(FormatArg(*args));
+            break;
+        case BOOL:
+            list.push_back(FormatArg(*args != 0));
+            break;
+        case STRING: {
+            uint32_t n;
+            std::memcpy(&n, args, sizeof(n));
+            if (static_cast<std::size_t>(end - args) < need + n) return false;
+            strings.push_back(std::string(args + need, n));
+            list.push_back(FormatArg(strings.back()));
+            need += n;
+            break;
+        }
+        default:
+            return false;
+        }
+        args += need;
+    }
+
+    FormatBuffer msg;
+    msg.vformat(format.format.c_str(), list.data(), list.size());
+    out.append(msg.str());
+    return true;
+}
+
+void BinaryTrace::setOutput(const std::shared_ptr<std::ostream>& strm) {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.drainMutex);
+    drainAll(s);
+    s.output = strm;
+    s.written.clear();
+    if (strm) {
+        std::string frame;
+        frame.push_back(BinaryFormatter::HEADER);
+        frame.append(BinaryFormatter::MAGIC, 8);
+        putVarint(frame, BinaryFormatter::VERSION);
+        writeFrame(*strm, frame);
+    }
+}
+
+void BinaryTrace::start(unsigned int interval) {
+    static Stopper stopper;
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.threadMutex);
+    if (s.thread.joinable()) return;
+    s.stopping = false;
+    s.thread = std::thread(&run, interval);
+}
+
+void BinaryTrace::stop() {
+    State& s = state();
+    {
+        std::lock_guard<std::mutex> lock(s.threadMutex);
+        if (! s.thread.joinable()) return;
+        s.stopping = true;
+    }
+    s.wake.notify_all();
+    s.thread.join();
+    flush();
+}
+
+bool BinaryTrace::isRunning() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.threadMutex);
+    return s.thread.joinable();
+}
+
+void BinaryTrace::flush() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.drainMutex);
+    drainAll(s);
+}
+
+unsigned long long BinaryTrace::getDropCount() {
+    return state().drops.load(std::memory_order_relaxed);
+}
+
+void BinaryTrace::setBufferSize(std::size_t bytes) {
+    std::size_t size = 64;
+    while (size < bytes) size <<= 1;
+    state().bufferSize.store(size);
+}
+
+std::size_t BinaryTrace::getBufferSize() {
+    return state().bufferSize.load();
+}
+
+/*
+ * register this site the first time it records a message
+ */
+unsigned int BinaryTraceSite::_register(const char *fmt, 
+                                        const FormatArg *args, 
+                                        std::size_t nargs) 
+{
+    BinaryTrace::Format format;
+    format.name = _site.getName();
+    format.verbosity = _verbosity;
+    format.file = (_file) ? _file : "";
+    format.line = _line;
+    format.format = (fmt) ? fmt : "";
+    for (std::size_t i = 0; i < nargs; ++i) {
+        switch (args[i].getKind()) {
+        case FormatArg::SIGNED:     format.codes += BinaryTrace::SIGNED;   break;
+        case FormatArg::UNSIGNED:   format.codes += BinaryTrace::UNSIGNED; break;
+        case FormatArg::FLOAT:
+        case FormatArg::LONG_FLOAT: format.codes += BinaryTrace::FLOAT;    break;
+        case FormatArg::CHAR:       format.codes += BinaryTrace::CHAR;     break;
+        case FormatArg::BOOL:       format.codes += BinaryTrace::BOOL;     break;
+        case FormatArg::POINTER:    format.codes += BinaryTrace::POINTER;  break;
+        default:                    format.codes += BinaryTrace::STRING;
+        }
+    }
+
+    // if another thread got here first, its registration is used
+    unsigned int id = BinaryTrace::registerFormat(format);
+    unsigned int expected = 0;
+    if (! _id.compare_exchange_strong(expected, id)) id = expected;
+    return id;
+}
+
+void BinaryTraceSite::_record(const char *fmt, const FormatArg *args, 
+                              std::size_t nargs)
+{
+    unsigned int id = _id.load(std::memory_order_acquire);
+    if (id == 0) id = _register(fmt, args, nargs);
+
+    // values of other types are rendered now
+    std::vector<std::string> rendered;
+    std::size_t size = HEADER_SIZE;
+    for (std::size_t i = 0; i < nargs; ++i) {
+        switch (args[i]._kind) {
+        case FormatArg::CHAR:
+        case FormatArg::BOOL:
+            size += 1;
+            break;
+        case FormatArg::STRING:
+            size += sizeof(uint32_t) + args[i]._v.s.len;
+            break;
+        case FormatArg::OTHER: {
+            if (rendered.empty()) rendered.resize(nargs);
+            std::ostringstream strm;
+            (*args[i]._v.o.print)(strm, args[i]._v.o.ptr);
+            rendered[i] = strm.str();
+            size += sizeof(uint32_t) + rendered[i].size();
+            break;
+        }
+        default:
+            size += 8;
+        }
+    }
+
+    TraceBuffer& buffer = getLocalBuffer();
+    char *out = (size <= UINT32_MAX) ? buffer.reserve(size) : 0;
+    if (out == 0) {
+        state().drops.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    EntryHeader header = { id, static_cast<uint32_t>(size), Timestamp::now() };
+    std::memcpy(out, &header, HEADER_SIZE);
+    out += HEADER_SIZE;
+    for (std::size_t i = 0; i < nargs; ++i) {
+        FormatArg const& arg = args[i];
+        switch (arg._kind) {
+        case FormatArg::SIGNED:   put8(out, &arg._v.i);  break;
+        case FormatArg::UNSIGNED: put8(out, &arg._v.u);  break;
+        case FormatArg::FLOAT:    put8(out, &arg._v.d);  break;
+        case FormatArg::LONG_FLOAT: {
+            double val = static_cast<double>(arg._v.f);
+            put8(out, &val);
+            break;
+        }
+        case FormatArg::POINTER: {
+            uint64_t val = reinterpret_cast<uintptr_t>(arg._v.p);
+            put8(out, &val);
+            break;
+        }
+        case FormatArg::CHAR:
+            *out++ = arg._v.c;
+            break;
+        case FormatArg::BOOL:
+            *out++ = (arg._v.b) ? 1 : 0;
+            break;
+        case FormatArg::STRING:
+            putString(out, arg._v.s.ptr, arg._v.s.len);
+            break;
+        default:
+            putString(out, rendered[i].data(), rendered[i].size());
+        }
+    }
+    buffer.commit();
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
@@ -0,0 +1,397 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file CompressedFileDestination.cc
+ */
+#include "lsst/pex/logging/CompressedFileDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Timestamp.h"
+#include "lsst/pex/exceptions.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#ifdef LSST_PEX_LOGGING_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+namespace fs = boost::filesystem;
+namespace pexExcept = lsst::pex::exceptions;
+
+namespace {
+
+    /*
+     * a compressor of a stream of blocks
+     */
+    class Encoder {
+    public:
+        enum Mode { CONTINUE, FLUSH, FINISH };
+
+        virtual ~Encoder() { }
+
+        // compress a block, appending the output to out.  FLUSH makes
+        // everything so far decodable; FINISH ends the stream.
+        virtual void encode(const char *data, std::size_t len, Mode mode,
+                            std::string& out) = 0;
+    };
+
+    class GzipEncoder : public Encoder {
+    public:
+        explicit GzipEncoder(int level) {
+            std::memset(&_z, 0, sizeof(_z));
+            if (level < 0) level = Z_DEFAULT_COMPRESSION;
+            // a window of 15 bits plus 16 asks for a gzip header
+            if (deflateInit2(&_z, level, Z_DEFLATED, 15 + 16, 8,
+                             Z_DEFAULT_STRATEGY) != Z_OK)
+                throw LSST_EXCEPT(pexExcept::InvalidParameterError,
+                                  "Unable to start gzip compression");
+        }
+
+        virtual ~GzipEncoder() { deflateEnd(&_z); }
+
+        virtual void encode(const char *data, std::size_t len, Mode mode,
+                            std::string& out)
+        {
+            int flush = (mode == FINISH) ? Z_FINISH
+                      : (mode == FLUSH)  ? Z_SYNC_FLUSH : Z_NO_FLUSH;
+            _z.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+            _z.avail_in = static_cast<uInt>(len);
+            char buf[64*1024];
+            while (true) {
+                _z.next_out = reinterpret_cast<Bytef*>(buf);
+                _z.avail_out = sizeof(buf);
+                int rc = deflate(&_z, flush);
+                if (rc == Z_STREAM_ERROR)
+                    throw LSST_EXCEPT(pexExcept::IoError,
+                                      "gzip compression failed");
+                out.append(buf, sizeof(buf) - _z.avail_out);
+                if (rc == Z_STREAM_END) break;
+                if (_z.avail_out > 0 && mode != FINISH) break;
+            }
+        }
+
+    private:
+        z_stream _z;
+    };
+
+#ifdef LSST_PEX_LOGGING_HAVE_ZSTD
+    class ZstdEncoder : public Encoder {
+    public:
+        explicit ZstdEncoder(int level)
+            : _ctx(ZSTD_createCCtx()), _buf(ZSTD_CStreamOutSize())
+        {
+            if (_ctx == 0)
+                throw LSST_EXCEPT(pexExcept::InvalidParameterError,
+                                  "Unable to start zstd compression");
+            if (level < 0) level = ZSTD_CLEVEL_DEFAULT;
+            ZSTD_CCtx_setParameter(_ctx, ZSTD_c_compressionLevel, level);
+        }
+
+        virtual ~ZstdEncoder() { ZSTD_freeCCtx(_ctx); }
+
+        virtual void encode(const char *data, std::size_t len, Mode mode,
+                            std::string& out)
+        {
+            ZSTD_EndDirective end = (mode == FINISH) ? ZSTD_e_end
+                                  : (mode == FLUSH)  ? ZSTD_e_flush
+                                                     : ZSTD_e_continue;
+            ZSTD_inBuffer in = { data, len, 0 };
+            bool done = false;
+            while (! done) {
+                ZSTD_outBuffer chunk = { &_buf[0], _buf.size(), 0 };
+                std::size_t left = ZSTD_compressStream2(_ctx, &chunk, &in,
+                                                        end);
+                if (ZSTD_isError(left))
+                    throw LSST_EXCEPT(pexExcept::IoError,
+                                      std::string("zstd compression failed: ")
+                                      + ZSTD_getErrorName(left));
+                out.append(&_buf[0], chunk.pos);
+                done = (end == ZSTD_e_continue) ? (in.pos == in.size)
+                                                : (left == 0);
+            }
+        }
+
+    private:
+        ZSTD_CCtx *_ctx;
+        std::vector<char> _buf;
+    };
+#endif
+
+    Encoder *makeEncoder(CompressedFileDestination::Codec codec, int level) {
+        switch (codec) {
+        case CompressedFileDestination::GZIP:
+            return new GzipEncoder(level);
+#ifdef LSST_PEX_LOGGING_HAVE_ZSTD
+        case CompressedFileDestination::ZSTD:
+            return new ZstdEncoder(level);
+#endif
+        default:
+            throw LSST_EXCEPT(pexExcept::InvalidParameterError,
+                              "Compression format not available in this "
+                              "build");
+        }
+    }
+}
+
+const int CompressedFileDestination::DEFAULT_LEVEL;
+const std::size_t CompressedFileDestination::DEFAULT_BLOCK_SIZE;
+
+/*
+ * the stream buffer behind a CompressedFileDestination.  Its put area is
+ * one of two blocks; when that fills up, the block is handed to the
+ * helper thread and the other one takes its place.  sync() waits for
+ * everything to reach the file, while post() only starts a flush.
+ */
+class CompressedFileDestination::CompressingBuffer : public std::streambuf {
+public:
+    CompressingBuffer(const fs::path& path, Codec codec, int level,
+                      std::size_t blockSize, bool truncate)
+        : _encoder(makeEncoder(codec, level)),
+          _file(path.string().c_str(),
+                std::ios::binary | (truncate ? std::ios::trunc
+                                             : std::ios::app)),
+          _current(0), _in(0), _out(0), _compressed(), _mutex(), _ready(),
+          _idle(), _job(0), _jobLength(0), _jobMode(Encoder::CONTINUE),
+          _busy(false), _failed(false), _stopping(false), _flushDue(false),
+          _thread()
+    {
+        for(int i=0; i < 2; ++i)
+            _blocks[i].resize(blockSize > 0 ? blockSize : 1);
+        setp(&_blocks[0][0], &_blocks[0][0] + _blocks[0].size());
+        _thread = std::thread(&CompressingBuffer::_run, this);
+    }
+
+    ~CompressingBuffer() {
+        _handOff(Encoder::FINISH);
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (_busy) _idle.wait(lock);
+            _stopping = true;
+        }
+        _ready.notify_one();
+        _thread.join();
+    }
+
+    unsigned long long getBytesIn() const { return _in + (pptr() - pbase()); }
+    unsigned long long getBytesOut() const { return _out.load(); }
+
+    /*
+     * hand the current block to the helper thread to be compressed and
+     * flushed, without waiting for it.  If the helper is still busy with
+     * the previous block, the flush is left due, to be made by the next
+     * hand-off or call to post().
+     * @return  true if the block was handed off
+     */
+    bool post() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_busy) {
+                _flushDue = true;
+                return false;
+            }
+        }
+        _handOff(Encoder::FLUSH);
+        return true;
+    }
+
+    /*
+     * return true if a flush started by post() is still waiting for the
+     * helper thread
+     */
+    bool isFlushDue() const { return _flushDue; }
+
+protected:
+    virtual int_type overflow(int_type c) {
+        _handOff(Encoder::CONTINUE);
+        if (! traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    virtual int sync() {
+        _handOff(Encoder::FLUSH);
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (_busy) _idle.wait(lock);
+        return _failed ? -1 : 0;
+    }
+
+private:
+    // give the current block to the helper thread and switch to the other
+    void _handOff(Encoder::Mode mode) {
+        if (_flushDue && mode == Encoder::CONTINUE) mode = Encoder::FLUSH;
+        _flushDue = false;
+        std::size_t length = pptr() - pbase();
+        if (length == 0 && mode == Encoder::CONTINUE) return;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            while (_busy) _idle.wait(lock);
+            _job = pbase();
+            _jobLength = length;
+            _jobMode = mode;
+            _busy = true;
+        }
+        _ready.notify_one();
+        _in += length;
+        _current = 1 - _current;
+        std::vector<char>& block = _blocks[_current];
+        setp(&block[0], &block[0] + block.size());
+    }
+
+    // the body of the helper thread
+    void _run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            while (! _busy && ! _stopping) _ready.wait(lock);
+            if (! _busy) break;
+            lock.unlock();
+
+            _compressed.clear();
+            bool failed = false;
+            try {
+                _encoder->encode(_job, _jobLength, _jobMode, _compressed);
+                _file.write(_compressed.data(), _compressed.size());
+                if (_jobMode != Encoder::CONTINUE) _file.flush();
+                failed = ! _file;
+            }
+            catch (...) {
+                failed = true;
+            }
+            _out += _compressed.size();
+
+            lock.lock();
+            if (failed) _failed = true;
+            _busy = false;
+            _idle.notify_all();
+        }
+    }
+
+    std::unique_ptr<Encoder> _encoder;
+    std::ofstream _file;
+    std::vector<char> _blocks[2];
+    int _current;                       // the block being filled
+    unsigned long long _in;
+    std::atomic<unsigned long long> _out;
+    std::string _compressed;            // used by the helper thread
+
+    std::mutex _mutex;
+    std::condition_variable _ready;
+    std::condition_variable _idle;
+    const char *_job;                   // the block being compressed
+    std::size_t _jobLength;
+    Encoder::Mode _jobMode;
+    bool _busy;                         // the helper thread has a block
+    bool _failed;
+    bool _stopping;
+    bool _flushDue;                     // used by the writing thread only
+    std::thread _thread;
+};
+
+CompressedFileDestination::CompressedFileDestination(
+    const fs::path& filepath, const std::shared_ptr<LogFormatter>& formatter,
+    Codec codec, int level, std::size_t blockSize, int threshold,
+    bool truncate)
+    : LogDestination(0, formatter, threshold), _path(filepath),
+      _codec(codec),
+      _buffer(new CompressingBuffer(filepath, codec, level, blockSize,
+                                    truncate))
+{
+    _strm = new std::ostream(_buffer.get());
+    setFlushPolicy(FlushPolicy::everyBytes(blockSize));
+}
+CompressedFileDestination::CompressedFileDestination(
+    const std::string& filepath,
+    const std::shared_ptr<LogFormatter>& formatter,
+    Codec codec, int level, std::size_t blockSize, int threshold,
+    bool truncate)
+    : CompressedFileDestination(fs::path(filepath), formatter, codec, level,
+                                blockSize, threshold, truncate)
+{ }
+CompressedFileDestination::CompressedFileDestination(
+    const char *filepath, const std::shared_ptr<LogFormatter>& formatter,
+    Codec codec, int level, std::size_t blockSize, int threshold,
+    bool truncate)
+    : CompressedFileDestination(fs::path(filepath), formatter, codec, level,
+                                blockSize, threshold, truncate)
+{ }
+
+CompressedFileDestination::~CompressedFileDestination() {
+    delete _strm;
+    _strm = 0;
+    _buffer.reset();
+}
+
+/*
+ * write a rendered record to the stream.  A flush called for by the
+ * FlushPolicy only hands the records to the helper thread; it is flush()
+ * that waits for them to reach the file.  The bytes stay pending until
+ * the helper takes them, so that they are flushed later if it is busy.
+ */
+void CompressedFileDestination::_put(const LogRecord& rec,
+                                     const std::string& text)
+{
+    _strm->write(text.data(), text.size());
+    _pending += text.size();
+
+    long long elapsed = 0;
+    if (_flushPolicy.isTimed()) elapsed = Timestamp::now() - _lastFlush;
+    if ((_buffer->isFlushDue() ||
+         _flushPolicy.shouldFlush(rec.getImportance(), _pending, elapsed)) &&
+        _buffer->post())
+    {
+        _pending = 0;
+        if (_flushPolicy.isTimed()) _lastFlush = Timestamp::now();
+    }
+}
+
+bool CompressedFileDestination::isSupported(Codec codec) {
+#ifdef LSST_PEX_LOGGING_HAVE_ZSTD
+    if (codec == ZSTD) return true;
+#endif
+    return codec == GZIP;
+}
+
+unsigned long long CompressedFileDestination::getBytesIn() const {
+    return _buffer->getBytesIn();
+}
+
+unsigned long long CompressedFileDestination::getBytesOut() const {
+    return _buffer->getBytesOut();
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
@@ -84,6 +84,8 @@ void DualLog::_init(const string& filename, int filethresh) {
 }
 
 DualLog::~DualLog() { 
+    // records still queued for the file must be written before it closes
+    flush();
     fstrm->close();
     delete fstrm;
 }
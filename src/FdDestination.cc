@@ -0,0 +1,242 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file FdDestination.cc
+ */
+#include "lsst/pex/logging/FdDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/exceptions.h"
+
+#include <cerrno>
+#include <cstring>
+#include <streambuf>
+#include <vector>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+namespace fs = boost::filesystem;
+namespace pexExcept = lsst::pex::exceptions;
+
+namespace {
+
+    // the most buffers handed to one call to writev()
+#ifdef IOV_MAX
+    const std::size_t IOV_LIMIT = IOV_MAX;
+#else
+    const std::size_t IOV_LIMIT = 1024;
+#endif
+
+    // the size of the buffer collecting records written one at a time
+    const std::size_t BUFFER_SIZE = 64*1024;
+
+    int openLog(const fs::path& path, bool truncate) {
+        int flags = O_WRONLY | O_CREAT | O_APPEND | (truncate ? O_TRUNC : 0);
+        int fd = ::open(path.string().c_str(), flags, 0644);
+        if (fd < 0)
+            throw LSST_EXCEPT(pexExcept::IoError,
+                              "Unable to open log file " + path.string() +
+                              ": " + std::strerror(errno));
+        return fd;
+    }
+}
+
+/*
+ * the stream buffer behind an FdDestination, which also holds the
+ * buffers of a batch of records
+ */
+class FdDestination::FdBuffer : public std::streambuf {
+public:
+    explicit FdBuffer(int fd)
+        : texts(), iov(), _fd(fd), _buf(BUFFER_SIZE), _syscalls(0)
+    {
+        setp(&_buf[0], &_buf[0] + _buf.size());
+    }
+
+    /*
+     * write out a set of buffers with as few calls to writev() as
+     * possible, bypassing the stream buffer
+     * @return bool   false if the descriptor could not be written to
+     */
+    bool gather(struct iovec *vec, std::size_t n) {
+        while (n > 0) {
+            ssize_t put = ::writev(_fd, vec, static_cast<int>(n));
+            ++_syscalls;
+            if (put < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+
+            // skip over what was written
+            std::size_t done = static_cast<std::size_t>(put);
+            while (n > 0 && done >= vec->iov_len) {
+                done -= vec->iov_len;
+                ++vec;
+                --n;
+            }
+            if (n > 0) {
+                vec->iov_base = static_cast<char*>(vec->iov_base) + done;
+                vec->iov_len -= done;
+            }
+        }
+        return true;
+    }
+
+    unsigned long long getSyscallCount() const { return _syscalls; }
+
+    std::vector<std::string> texts;     // the rendered records of a batch
+    std::vector<struct iovec> iov;
+
+protected:
+    virtual int_type overflow(int_type c) {
+        if (! _drain()) return traits_type::eof();
+        if (! traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    virtual std::streamsize xsputn(const char *s, std::streamsize n) {
+        std::size_t len = static_cast<std::size_t>(n);
+        if (len > static_cast<std::size_t>(epptr() - pptr())) {
+            if (! _drain()) return 0;
+            if (len >= _buf.size()) {
+                struct iovec vec = { const_cast<char*>(s), len };
+                return gather(&vec, 1) ? n : 0;
+            }
+        }
+        std::memcpy(pptr(), s, len);
+        pbump(static_cast<int>(len));
+        return n;
+    }
+
+    virtual int sync() { return _drain() ? 0 : -1; }
+
+private:
+    bool _drain() {
+        std::size_t len = pptr() - pbase();
+        if (len == 0) return true;
+        struct iovec vec = { pbase(), len };
+        bool ok = gather(&vec, 1);
+        setp(&_buf[0], &_buf[0] + _buf.size());
+        return ok;
+    }
+
+    int _fd;
+    std::vector<char> _buf;
+    unsigned long long _syscalls;
+};
+
+FdDestination::FdDestination(int fd,
+                             const std::shared_ptr<LogFormatter>& formatter,
+                             int threshold, bool own)
+    : LogDestination(0, formatter, threshold), _fd(fd), _own(own),
+      _buffer(new FdBuffer(fd))
+{
+    _strm = new std::ostream(_buffer.get());
+}
+FdDestination::FdDestination(const fs::path& filepath,
+                             const std::shared_ptr<LogFormatter>& formatter,
+                             int threshold, bool truncate)
+    : FdDestination(openLog(filepath, truncate), formatter, threshold, true)
+{ }
+FdDestination::FdDestination(const std::string& filepath,
+                             const std::shared_ptr<LogFormatter>& formatter,
+                             int threshold, bool truncate)
+    : FdDestination(fs::path(filepath), formatter, threshold, truncate)
+{ }
+FdDestination::FdDestination(const char *filepath,
+                             const std::shared_ptr<LogFormatter>& formatter,
+                             int threshold, bool truncate)
+    : FdDestination(fs::path(filepath), formatter, threshold, truncate)
+{ }
+
+FdDestination::~FdDestination() {
+    try {
+        _strm->flush();
+    }
+    catch (...) { }
+    delete _strm;
+    _strm = 0;
+    _buffer.reset();
+    if (_own) ::close(_fd);
+}
+
+/*
+ * render the records that pass the threshold into separate buffers and
+ * write them out with as few calls to writev() as possible
+ */
+std::size_t FdDestination::writeBatch(const LogRecord* const* records,
+                                      std::size_t count)
+{
+    if (_frmtr.get() == 0) return 0;
+
+    // records written one at a time go first
+    flush();
+
+    std::vector<std::string>& texts = _buffer->texts;
+    std::vector<struct iovec>& iov = _buffer->iov;
+    std::size_t written = 0;
+    std::size_t i = 0;
+    while (i < count) {
+        std::size_t used = 0;
+        for(; i < count && used < IOV_LIMIT; ++i) {
+            const LogRecord& rec = *records[i];
+            if (rec.getImportance() < _threshold) continue;
+            if (texts.size() <= used) texts.push_back(std::string());
+            std::string& text = texts[used];
+            text.clear();
+            _render(rec, text);
+            ++used;
+        }
+        if (used == 0) break;
+
+        // the texts are not touched again until they have been written
+        iov.resize(used);
+        for(std::size_t j=0; j < used; ++j) {
+            iov[j].iov_base = &texts[j][0];
+            iov[j].iov_len = texts[j].size();
+        }
+        if (! _buffer->gather(&iov[0], used)) {
+            _strm->setstate(std::ios::badbit);
+            break;
+        }
+        written += used;
+    }
+    return written;
+}
+
+unsigned long long FdDestination::getSyscallCount() const {
+    return _buffer->getSyscallCount();
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
@@ -0,0 +1,312 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file FlightRecorderDestination.cc
+ */
+#include "lsst/pex/logging/FlightRecorderDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+namespace fs = boost::filesystem;
+
+const std::size_t FlightRecorderDestination::DEFAULT_MAX_RECORDS = 10000;
+const std::size_t FlightRecorderDestination::DEFAULT_MAX_BYTES = 1024*1024;
+const int FlightRecorderDestination::DEFAULT_THRESHOLD = Log::DEBUG;
+
+namespace {
+
+    // a buffer grown beyond this is released rather than kept
+    const std::size_t MAX_KEPT = 64*1024;
+
+    // the string each thread renders records into
+    struct Scratch {
+        Scratch() : text(), busy(false) { text.reserve(1024); }
+
+        std::string text;
+        bool busy;
+    };
+
+    thread_local Scratch scratch;
+
+    // the signals that trigger a dump, and the handlers they had before
+    const int CRASH_SIGNALS[] = { SIGSEGV, SIGABRT };
+    const char *CRASH_REASONS[] = { "caught SIGSEGV", "caught SIGABRT" };
+    const int NSIGNALS = 2;
+    struct sigaction previous[NSIGNALS];
+
+    // the recorder the signal handlers dump, if any
+    std::atomic<FlightRecorderDestination*> armed(0);
+
+    std::mutex armMutex;        // held while installing or restoring handlers
+    bool installed = false;
+
+    // the following are safe to call from a signal handler
+
+    std::size_t length(const char *s) {
+        std::size_t n = 0;
+        while (s[n] != '\0') ++n;
+        return n;
+    }
+
+    bool writeAll(int fd, const char *data, std::size_t len) {
+        while (len > 0) {
+            ssize_t put = ::write(fd, data, len);
+            if (put < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += put;
+            len -= static_cast<std::size_t>(put);
+        }
+        return true;
+    }
+}
+
+FlightRecorderDestination::FlightRecorderDestination(
+    const fs::path& dumppath, const std::shared_ptr<LogFormatter>& formatter,
+    std::size_t maxRecords, std::size_t maxBytes, int threshold)
+    : LogDestination(0, formatter, threshold), _dumpPath(dumppath.string()),
+      _maxRecords(std::max<std::size_t>(maxRecords, 1)),
+      _maxBytes(std::max<std::size_t>(maxBytes, 1)),
+      _dumpImportance(Log::FATAL), _dumps(0),
+      _buf(new char[_maxBytes]), _ends(new unsigned long long[_maxRecords]),
+      _first(0), _count(0), _head(0), _tail(0)
+{
+    // touch the buffer now so that the first pass through it costs no
+    // more than later ones
+    std::memset(_buf.get(), 0, _maxBytes);
+}
+FlightRecorderDestination::FlightRecorderDestination(
+    const std::string& dumppath,
+    const std::shared_ptr<LogFormatter>& formatter,
+    std::size_t maxRecords, std::size_t maxBytes, int threshold)
+    : FlightRecorderDestination(fs::path(dumppath), formatter, maxRecords,
+                                maxBytes, threshold)
+{ }
+FlightRecorderDestination::FlightRecorderDestination(
+    const char *dumppath, const std::shared_ptr<LogFormatter>& formatter,
+    std::size_t maxRecords, std::size_t maxBytes, int threshold)
+    : FlightRecorderDestination(fs::path(dumppath), formatter, maxRecords,
+                                maxBytes, threshold)
+{ }
+
+FlightRecorderDestination::~FlightRecorderDestination() {
+    disarmSignals();
+}
+
+/*
+ * render a record into the buffer, dumping the buffer if the record is
+ * important enough
+ */
+bool FlightRecorderDestination::write(const LogRecord& rec) {
+    if (_frmtr.get() == 0 || rec.getImportance() < _threshold)
+        return false;
+
+    Scratch& s = scratch;
+    if (s.busy) {
+        // a formatter is itself logging; render this one separately
+        std::string text;
+        _render(rec, text);
+        _keep(text);
+    }
+    else {
+        s.busy = true;
+        s.text.clear();
+        try {
+            _render(rec, s.text);
+            _keep(s.text);
+        }
+        catch (...) {
+            s.busy = false;
+            throw;
+        }
+        s.busy = false;
+        if (s.text.capacity() > MAX_KEPT) std::string().swap(s.text);
+    }
+
+    if (rec.getImportance() >= _dumpImportance) {
+        std::ostringstream reason;
+        reason << "record of importance " << rec.getImportance();
+        dump(reason.str());
+    }
+    return true;
+}
+
+/*
+ * copy a record into the buffer, using the text already rendered by an
+ * equivalent formatter if there is one
+ */
+bool FlightRecorderDestination::write(RenderedRecord& rec) {
+    const LogRecord& record = rec.getRecord();
+    if (_frmtr.get() == 0 || record.getImportance() < _threshold)
+        return false;
+
+    _keep(rec.render(*_frmtr));
+
+    if (record.getImportance() >= _dumpImportance) {
+        std::ostringstream reason;
+        reason << "record of importance " << record.getImportance();
+        dump(reason.str());
+    }
+    return true;
+}
+
+/*
+ * append the contents of the buffer to the dump file and empty it
+ */
+bool FlightRecorderDestination::dump(const std::string& reason) {
+    int fd = ::open(_dumpPath.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+    bool ok = _dumpTo(fd, reason.c_str());
+    if (::close(fd) != 0) ok = false;
+    ++_dumps;
+
+    _first = 0;
+    _count = 0;
+    _head.store(_tail.load(std::memory_order_relaxed),
+                std::memory_order_release);
+    return ok;
+}
+
+void FlightRecorderDestination::armSignals() {
+    std::lock_guard<std::mutex> lock(armMutex);
+    armed.store(this);
+    if (installed) return;
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = &FlightRecorderDestination::_onSignal;
+    sigemptyset(&action.sa_mask);
+    for(int i=0; i < NSIGNALS; ++i)
+        ::sigaction(CRASH_SIGNALS[i], &action, &previous[i]);
+    installed = true;
+}
+
+void FlightRecorderDestination::disarmSignals() {
+    std::lock_guard<std::mutex> lock(armMutex);
+    if (armed.load() != this) return;
+    armed.store(0);
+    if (! installed) return;
+
+    for(int i=0; i < NSIGNALS; ++i)
+        ::sigaction(CRASH_SIGNALS[i], &previous[i], 0);
+    installed = false;
+}
+
+bool FlightRecorderDestination::isArmed() const {
+    return armed.load() == this;
+}
+
+/*
+ * copy a rendered record to the end of the buffer, first dropping as
+ * many of the oldest records as it takes to make room.  The start of the
+ * kept bytes is moved before anything is overwritten and the end only
+ * after the copy, so that a signal handler always sees whole records.
+ */
+void FlightRecorderDestination::_keep(const std::string& text) {
+    std::size_t len = std::min(text.size(), _maxBytes);
+    unsigned long long head = _head.load(std::memory_order_relaxed);
+    unsigned long long tail = _tail.load(std::memory_order_relaxed);
+    while (_count > 0 &&
+           (_count == _maxRecords || tail + len - head > _maxBytes))
+    {
+        head = _ends[_first];
+        _first = (_first + 1) % _maxRecords;
+        --_count;
+    }
+    _head.store(head, std::memory_order_release);
+
+    std::size_t start = tail % _maxBytes;
+    std::size_t first = std::min(len, _maxBytes - start);
+    std::memcpy(&_buf[start], text.data(), first);
+    std::memcpy(&_buf[0], text.data() + first, len - first);
+
+    tail += len;
+    _ends[(_first + _count) % _maxRecords] = tail;
+    ++_count;
+    _tail.store(tail, std::memory_order_release);
+}
+
+/*
+ * write out the contents of the buffer, headed by the reason for the
+ * dump, using only async-signal-safe calls
+ */
+bool FlightRecorderDestination::_dumpTo(int fd, const char *reason) const {
+    unsigned long long head = _head.load(std::memory_order_acquire);
+    unsigned long long tail = _tail.load(std::memory_order_acquire);
+    if (tail - head > _maxBytes) head = tail - _maxBytes;
+
+    static const char HEADER[] = "### flight recorder dump: ";
+    bool ok = writeAll(fd, HEADER, sizeof(HEADER) - 1) &&
+              writeAll(fd, reason, length(reason)) &&
+              writeAll(fd, "\n", 1);
+
+    std::size_t len = static_cast<std::size_t>(tail - head);
+    std::size_t start = head % _maxBytes;
+    std::size_t first = std::min(len, _maxBytes - start);
+    return ok && writeAll(fd, &_buf[start], first) &&
+           writeAll(fd, &_buf[0], len - first);
+}
+
+/*
+ * dump the armed recorder, then pass the signal on to the handler that
+ * was in place before
+ */
+void FlightRecorderDestination::_onSignal(int sig) {
+    int saved = errno;
+    int i = 0;
+    while (i < NSIGNALS - 1 && CRASH_SIGNALS[i] != sig) ++i;
+
+    // taking the recorder keeps a second crash from dumping it again
+    FlightRecorderDestination *rec = armed.exchange(0);
+    if (rec != 0) {
+        int fd = ::open(rec->_dumpPath.c_str(),
+                        O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (fd >= 0) {
+            rec->_dumpTo(fd, CRASH_REASONS[i]);
+            ::close(fd);
+        }
+    }
+
+    ::sigaction(sig, &previous[i], 0);
+    errno = saved;
+    ::raise(sig);
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
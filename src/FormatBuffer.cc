@@ -0,0 +1,304 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file FormatBuffer.cc
+ */
+#include "lsst/pex/logging/FormatBuffer.h"
+#include "lsst/pex/logging/NumberFormat.h"
+
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+
+namespace {
+
+    // the buffer each thread reuses and whether it is currently lent out
+    struct ThreadBuffer {
+        ThreadBuffer() : busy(false) { text.reserve(INITIAL_SIZE); }
+
+        // room for most messages without growing
+        static const std::size_t INITIAL_SIZE = 256;
+
+        // the space on the stack that printf-style formatting is offered
+        // in one pass; longer messages are rendered twice
+        static const std::size_t PRINTF_ROOM = 512;
+
+        // a buffer grown beyond this is released rather than kept
+        static const std::size_t MAX_KEPT = 64*1024;
+
+        std::string text;
+        bool busy;
+    };
+
+    thread_local ThreadBuffer threadBuffer;
+
+    bool isFlag(char c) {
+        return c == '-' || c == '+' || c == ' ' || c == '#' || c == '0';
+    }
+}
+
+void FormatArg::_setString(const char *val) {
+    if (val == 0) val = "(null)";
+    _v.s.ptr = val;
+    _v.s.len = std::strlen(val);
+}
+
+FormatBuffer::FormatBuffer() : _text(0), _borrowed(false), _own() {
+    ThreadBuffer& tb = threadBuffer;
+    if (tb.busy) {
+        _text = &_own;
+    }
+    else {
+        tb.busy = true;
+        _borrowed = true;
+        _text = &tb.text;
+        _text->clear();
+    }
+}
+
+FormatBuffer::~FormatBuffer() {
+    if (_borrowed) {
+        ThreadBuffer& tb = threadBuffer;
+        if (tb.text.capacity() > ThreadBuffer::MAX_KEPT) {
+            std::string().swap(tb.text);
+            tb.text.reserve(ThreadBuffer::INITIAL_SIZE);
+        }
+        tb.busy = false;
+    }
+}
+
+void FormatBuffer::printf(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    vprintf(fmt, ap);
+    va_end(ap);
+}
+
+/*
+ * the text is rendered on the stack and appended, so that the buffer is 
+ * only ever resized to the length of the text.  Only if it does not fit 
+ * is the buffer grown by that length and the text rendered again, 
+ * directly into it.
+ */
+void FormatBuffer::vprintf(const char *fmt, va_list ap) {
+    va_list aq;
+    va_copy(aq, ap);
+
+    char room[ThreadBuffer::PRINTF_ROOM];
+    int len = vsnprintf(room, sizeof(room), fmt, ap);
+    if (len < 0) {
+        // an invalid format; leave the buffer as it was
+    }
+    else if (std::size_t(len) < sizeof(room)) {
+        _text->append(room, len);
+    }
+    else {
+        // the string always has room for a terminating '\0' past its size
+        std::size_t start = _text->size();
+        _text->resize(start + len);
+        vsnprintf(&(*_text)[start], len + 1, fmt, aq);
+    }
+    va_end(aq);
+}
+
+void FormatBuffer::vformat(const char *fmt, const FormatArg *args,
+                           std::size_t nargs)
+{
+    std::size_t next = 0;
+    const char *lit = fmt;     // start of pending literal text
+    const char *p = fmt;
+    while (*p != '\0') {
+        if (*p != '{' && *p != '}') {
+            ++p;
+            continue;
+        }
+
+        // doubled braces produce a single literal one
+        if (p[1] == *p) {
+            _text->append(lit, p - lit + 1);
+            p += 2;
+            lit = p;
+            continue;
+        }
+        if (*p == '}') {
+            ++p;
+            continue;
+        }
+
+        // a placeholder: "{}" or "{:spec}"
+        const char *close = std::strchr(p, '}');
+        if (close == 0) break;
+        const char *spec = p + 1;
+        if (*spec == ':') ++spec;
+        else if (spec != close) {
+            // not a placeholder we understand; leave it as text
+            p = close + 1;
+            continue;
+        }
+        if (next >= nargs) {
+            p = close + 1;
+            continue;
+        }
+
+        _text->append(lit, p - lit);
+        append(args[next++], spec, close - spec);
+        p = close + 1;
+        lit = p;
+    }
+    _text->append(lit, p + std::strlen(p) - lit);
+}
+
+void FormatBuffer::append(const FormatArg& arg, const char *spec,
+                          std::size_t len)
+{
+    if (len > 0) {
+        _appendSpec(arg, spec, len);
+        return;
+    }
+
+    char digits[NumberFormat::MAX_LENGTH];  // also enough for %g
+    switch (arg._kind) {
+      case FormatArg::SIGNED:
+        _text->append(digits, NumberFormat::format(arg._v.i, digits) - digits);
+        break;
+      case FormatArg::UNSIGNED:
+        _text->append(digits, NumberFormat::format(arg._v.u, digits) - digits);
+        break;
+      case FormatArg::FLOAT:
+        _text->append(digits, std::snprintf(digits, sizeof(digits), "%g", 
+                                            arg._v.d));
+        break;
+      case FormatArg::LONG_FLOAT:
+        _text->append(digits, std::snprintf(digits, sizeof(digits), "%Lg", 
+                                            arg._v.f));
+        break;
+      case FormatArg::CHAR:
+        _text->push_back(arg._v.c);
+        break;
+      case FormatArg::BOOL:
+        _text->append(arg._v.b ? "true" : "false");
+        break;
+      case FormatArg::STRING:
+        _text->append(arg._v.s.ptr, arg._v.s.len);
+        break;
+      case FormatArg::POINTER:
+        printf("%p", arg._v.p);
+        break;
+      case FormatArg::OTHER: {
+        std::ostringstream strm;
+        (*arg._v.o.print)(strm, arg._v.o.ptr);
+        _text->append(strm.str());
+        break;
+      }
+    }
+}
+
+/*
+ * render a value according to a printf-style specification by building
+ * a printf conversion with the length modifier appropriate to its type.
+ * Python-style alignment (<, >) is translated into the printf - flag.
+ */
+void FormatBuffer::_appendSpec(const FormatArg& arg, const char *spec,
+                               std::size_t len)
+{
+    std::string conv("%");
+    const char *p = spec, *end = spec + len;
+    if (p < end && (*p == '<' || *p == '>')) {
+        if (*p == '<') conv += '-';
+        ++p;
+    }
+    while (p < end && isFlag(*p)) conv += *p++;
+    while (p < end && (std::isdigit(static_cast<unsigned char>(*p)) || *p == '.')) conv += *p++;
+    char type = (p < end) ? *p : '\0';
+
+    switch (arg._kind) {
+      case FormatArg::SIGNED:
+      case FormatArg::UNSIGNED: {
+        if (type == '\0' || std::strchr("diuoxXc", type) == 0)
+            type = (arg._kind == FormatArg::SIGNED) ? 'd' : 'u';
+        if (type == 'c') {
+            conv += 'c';
+            printf(conv.c_str(), int(arg._v.i));
+        }
+        else {
+            conv += "ll";
+            conv += type;
+            if (arg._kind == FormatArg::SIGNED) 
+                printf(conv.c_str(), arg._v.i);
+            else 
+                printf(conv.c_str(), arg._v.u);
+        }
+        break;
+      }
+      case FormatArg::FLOAT:
+      case FormatArg::LONG_FLOAT:
+        if (type == '\0' || std::strchr("eEfFgGaA", type) == 0) type = 'g';
+        if (arg._kind == FormatArg::FLOAT) {
+            conv += type;
+            printf(conv.c_str(), arg._v.d);
+        }
+        else {
+            conv += 'L';
+            conv += type;
+            printf(conv.c_str(), arg._v.f);
+        }
+        break;
+      case FormatArg::CHAR:
+        if (type == '\0' || std::strchr("diuoxX", type) == 0) type = 'c';
+        conv += type;
+        printf(conv.c_str(), int(arg._v.c));
+        break;
+      case FormatArg::POINTER:
+        conv += 'p';
+        printf(conv.c_str(), arg._v.p);
+        break;
+      case FormatArg::BOOL:
+      case FormatArg::STRING:
+      case FormatArg::OTHER: {
+        std::string val;
+        if (arg._kind == FormatArg::STRING)
+            val.assign(arg._v.s.ptr, arg._v.s.len);
+        else if (arg._kind == FormatArg::BOOL)
+            val = arg._v.b ? "true" : "false";
+        else {
+            std::ostringstream strm;
+            (*arg._v.o.print)(strm, arg._v.o.ptr);
+            val = strm.str();
+        }
+        conv += 's';
+        printf(conv.c_str(), val.c_str());
+        break;
+      }
+    }
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
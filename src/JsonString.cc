@@ -0,0 +1,248 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file JsonString.cc
+ */
+#include "lsst/pex/logging/JsonString.h"
+
+#include <atomic>
+#include <cstring>
+#include <stdint.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// AVX2 code is compiled for the processors that may have it and used 
+// only where the processor reports it
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define LSST_PEX_HAVE_AVX2 1
+#endif
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+
+namespace {
+
+    inline bool needsEscape(unsigned char c) {
+        return c < 0x20 || c == '"' || c == '\\';
+    }
+
+    std::size_t scanBytes(const char *text, std::size_t i, std::size_t len) {
+        while (i < len && ! needsEscape(text[i])) ++i;
+        return i;
+    }
+
+    /*
+     * each step flags a word if any of its bytes is below 0x20 or equal
+     * to '"' or '\\'; a flag can only be raised in error above a byte 
+     * that truly matches, so the bytes of a flagged word are then checked
+     * one at a time.
+     */
+    std::size_t scanWords(const char *text, std::size_t len) {
+        const uint64_t ones = 0x0101010101010101ULL;
+        const uint64_t highs = 0x8080808080808080ULL;
+        std::size_t i = 0;
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, text + i, 8);
+            uint64_t quote = w ^ (ones * '"');
+            uint64_t slash = w ^ (ones * '\\');
+            uint64_t hits = ((w - ones * 0x20) & ~w) | 
+                            ((quote - ones) & ~quote) | 
+                            ((slash - ones) & ~slash);
+            if (hits & highs) break;
+        }
+        return scanBytes(text, i, len);
+    }
+
+#ifdef __SSE2__
+    std::size_t scanSSE2(const char *text, std::size_t len) {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i slash = _mm_set1_epi8('\\');
+        const __m128i ctrl = _mm_set1_epi8(0x1f);
+        std::size_t i = 0;
+        for (; i + 16 <= len; i += 16) {
+            __m128i v = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(text + i));
+            __m128i hits = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(v, quote), 
+                             _mm_cmpeq_epi8(v, slash)),
+                _mm_cmpeq_epi8(_mm_max_epu8(v, ctrl), ctrl));
+            int mask = _mm_movemask_epi8(hits);
+            if (mask != 0) return i + __builtin_ctz(mask);
+        }
+        return scanBytes(text, i, len);
+    }
+#endif
+
+#ifdef LSST_PEX_HAVE_AVX2
+    __attribute__((target("avx2")))
+    std::size_t scanAVX2(const char *text, std::size_t len) {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i slash = _mm256_set1_epi8('\\');
+        const __m256i ctrl = _mm256_set1_epi8(0x1f);
+        std::size_t i = 0;
+        for (; i + 32 <= len; i += 32) {
+            __m256i v = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(text + i));
+            __m256i hits = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), 
+                                _mm256_cmpeq_epi8(v, slash)),
+                _mm256_cmpeq_epi8(_mm256_max_epu8(v, ctrl), ctrl));
+            unsigned mask = 
+                static_cast<unsigned>(_mm256_movemask_epi8(hits));
+            if (mask != 0) return i + __builtin_ctz(mask);
+        }
+        return scanBytes(text, i, len);
+    }
+#endif
+
+    bool supported(JsonString::Scanner scanner) {
+        switch (scanner) {
+          case JsonString::BYTES:
+          case JsonString::WORDS:
+            return true;
+          case JsonString::SSE2:
+#ifdef __SSE2__
+            return true;
+#else
+            return false;
+#endif
+          case JsonString::AVX2:
+#ifdef LSST_PEX_HAVE_AVX2
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        }
+        return false;
+    }
+
+    JsonString::Scanner findBest() {
+        if (supported(JsonString::AVX2)) return JsonString::AVX2;
+        if (supported(JsonString::SSE2)) return JsonString::SSE2;
+        return JsonString::WORDS;
+    }
+
+    std::atomic<int> scannerInUse(findBest());
+
+    const char hexDigits[] = "0123456789abcdef";
+
+    /*
+     * the escape sequence for a character that needs one, written into
+     * buf; returns its length
+     */
+    std::size_t escape(unsigned char c, char *buf) {
+        buf[0] = '\\';
+        switch (c) {
+          case '"':   buf[1] = '"';   return 2;
+          case '\\':  buf[1] = '\\';  return 2;
+          case '\n':  buf[1] = 'n';   return 2;
+          case '\r':  buf[1] = 'r';   return 2;
+          case '\t':  buf[1] = 't';   return 2;
+          case '\b':  buf[1] = 'b';   return 2;
+          case '\f':  buf[1] = 'f';   return 2;
+        }
+        std::memcpy(buf + 1, "u00", 3);
+        buf[4] = hexDigits[c >> 4];
+        buf[5] = hexDigits[c & 0xf];
+        return 6;
+    }
+
+    /*
+     * copy the text in runs between the characters that must be escaped
+     */
+    template <class Sink>
+    void writeEscaped(Sink& sink, const char *text, std::size_t len) {
+        char esc[6];
+        sink.put('"');
+        while (len > 0) {
+            std::size_t run = JsonString::scan(text, len);
+            sink.write(text, run);
+            if (run == len) break;
+            sink.write(esc, escape(text[run], esc));
+            text += run + 1;
+            len -= run + 1;
+        }
+        sink.put('"');
+    }
+
+    // lets writeEscaped() append to a string
+    struct StringSink {
+        explicit StringSink(std::string& str) : out(str) { }
+        void put(char c) { out.push_back(c); }
+        void write(const char *text, std::size_t len) { out.append(text, len); }
+        std::string& out;
+    };
+}
+
+std::size_t JsonString::scan(const char *text, std::size_t len) {
+    switch (scannerInUse.load(std::memory_order_relaxed)) {
+#ifdef LSST_PEX_HAVE_AVX2
+      case AVX2:
+        return scanAVX2(text, len);
+#endif
+#ifdef __SSE2__
+      case SSE2:
+        return scanSSE2(text, len);
+#endif
+      case WORDS:
+        return scanWords(text, len);
+      default:
+        return scanBytes(text, 0, len);
+    }
+}
+
+void JsonString::write(std::ostream& strm, const char *text, std::size_t len) 
+{
+    writeEscaped(strm, text, len);
+}
+
+void JsonString::append(std::string& out, const char *text, std::size_t len)
+{
+    StringSink sink(out);
+    writeEscaped(sink, text, len);
+}
+
+JsonString::Scanner JsonString::bestScanner() {
+    return findBest();
+}
+
+JsonString::Scanner JsonString::setScanner(Scanner scanner) {
+    if (! supported(scanner)) scanner = findBest();
+    scannerInUse.store(scanner, std::memory_order_relaxed);
+    return scanner;
+}
+
+JsonString::Scanner JsonString::getScanner() {
+    return static_cast<Scanner>(scannerInUse.load(std::memory_order_relaxed));
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
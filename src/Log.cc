@@ -30,6 +30,7 @@
 
 #include "lsst/pex/logging/Log.h"
 #include "lsst/pex/logging/ScreenLog.h"
+#include "lsst/pex/logging/AsyncDestination.h"
 
 #include <memory>
 
@@ -95,14 +96,15 @@ const int Log::INHERIT_THRESHOLD = threshold::INHERIT;
  *                    (the default) denotes a root log.
  */
 Log::Log(const int threshold, const string& name) 
-    : _threshold(threshold), _defShowAll(new bool(false)), _myShowAll(), 
-      _name(name), _thresholds(new threshold::Memory(Log::_sep)), 
-      _destinations(), _preamble(new PropertySet())
+    : _threshold(threshold), _cachedThreshold(), 
+      _defShowAll(new bool(false)), _myShowAll(), 
+      _name(name), _fullPreamble(), _persistent(false), 
+      _thresholds(new threshold::Memory(Log::_sep)), 
+      _destinations(), _preamble(new PropertySet()), _async()
 {
     _thresholds->setRootThreshold(threshold);
     if (name.length() > 0) _thresholds->setThresholdFor(name, threshold);
     _myShowAll = _defShowAll;
-    completePreamble();
 }
 
 /*
@@ -128,23 +130,28 @@ Log::Log(const int threshold, const string& name)
 Log::Log(const list<shared_ptr<LogDestination> > &destinations, 
          const PropertySet &preamble,
          const string &name, const int threshold, bool defaultShowAll)
-    : _threshold(threshold), _defShowAll(new bool(defaultShowAll)), 
-      _myShowAll(), _name(name), _thresholds(new threshold::Memory(Log::_sep)),
-      _destinations(destinations), _preamble(preamble.deepCopy())
+    : _threshold(threshold), _cachedThreshold(), 
+      _defShowAll(new bool(defaultShowAll)), _myShowAll(), _name(name), 
+      _fullPreamble(), _persistent(false), 
+      _thresholds(new threshold::Memory(Log::_sep)),
+      _destinations(destinations), _preamble(preamble.deepCopy()), _async()
 {  
     _thresholds->setRootThreshold(threshold);
     if (name.length() > 0) _thresholds->setThresholdFor(name, threshold);
-    completePreamble();
+
+    // the log name is supplied to each record separately
+    if (_preamble->exists(LSST_LP_LOG)) _preamble->remove(LSST_LP_LOG);
 }
 
 /*
  * create a copy
  */
 Log::Log(const Log& that) 
-    : _threshold(that._threshold), _defShowAll(that._defShowAll), 
-      _myShowAll(that._myShowAll), _name(that._name), 
+    : _threshold(that._threshold), _cachedThreshold(), 
+      _defShowAll(that._defShowAll), _myShowAll(that._myShowAll), 
+      _name(that._name), _fullPreamble(), _persistent(false), 
       _thresholds(that._thresholds), _destinations(that._destinations), 
-      _preamble(that._preamble->deepCopy())
+      _preamble(that._preamble), _async(that._async)
 { }
 
 /* 
@@ -157,17 +164,48 @@ Log::~Log() { }
  */
 Log& Log::operator=(const Log& that) {
     _threshold = that._threshold; 
+    _cachedThreshold.invalidate();
     _defShowAll = that._defShowAll;
     _myShowAll = that._myShowAll;
     _name = that._name;
     _thresholds = that._thresholds;
     _destinations = that._destinations;
-    _preamble = that._preamble->deepCopy();
+    _preamble = that._preamble;
+    _fullPreamble.reset();
+    _async = that._async;
     return *this;
 }
 
-void Log::completePreamble() {
-    _preamble->set<string>("LOG", _name);
+/*
+ * return the current set of preamble properties, including the log name
+ */
+const PropertySet& Log::getPreamble() {
+    if (! _fullPreamble) {
+        _fullPreamble = _preamble->deepCopy();
+        _fullPreamble->set<string>(LSST_LP_LOG, _name);
+        if (_persistent) _fullPreamble->markPersistent();
+    }
+    return *_fullPreamble;
+}
+
+/*
+ * Mark this Log as persistent in the Citizen framework.
+ */
+void Log::markPersistent() { 
+    _persistent = true;
+    _preamble->markPersistent(); 
+    if (_fullPreamble) _fullPreamble->markPersistent();
+}
+
+/*
+ * make sure that this Log holds the only reference to its preamble
+ */
+void Log::_unsharePreamble() {
+    _fullPreamble.reset();
+    if (! _preamble.unique()) {
+        _preamble = _preamble->deepCopy();
+        if (_persistent) _preamble->markPersistent();
+    }
 }
 
 /*
@@ -183,18 +221,17 @@ void Log::completePreamble() {
  *                          it will be set to the threshold of the parent.  
  */
 Log::Log(const Log& parent, const string& childName, int threshold)
-    : _threshold(threshold), _defShowAll(parent._defShowAll), 
-      _myShowAll(), _name(parent.getName()), _thresholds(parent._thresholds), 
+    : _threshold(threshold), _cachedThreshold(), 
+      _defShowAll(parent._defShowAll), _myShowAll(), _name(parent.getName()), 
+      _fullPreamble(), _persistent(false), _thresholds(parent._thresholds), 
       _destinations(parent._destinations), 
-      _preamble(parent._preamble->deepCopy())  
+      _preamble(parent._preamble), _async(parent._async)
 { 
     if (_name.length() > 0) _name += _sep;
     _name += childName;
 
     if (_threshold > INHERIT_THRESHOLD) 
         _thresholds->setThresholdFor(_name, _threshold);
-
-    completePreamble();
 }
 
 /*
@@ -215,6 +252,10 @@ void Log::setThresholdFor(const string& name, int threshold) {
 }
 
 int Log::getThresholdFor(const string& name) const {
+    // a root log (e.g. the default log used by Trace) can look the name 
+    // up directly
+    if (_name.length() == 0) return _thresholds->getThresholdFor(name);
+
     string fullname(getName());
     if (_name.length() > 0) fullname += _sep;
     return _thresholds->getThresholdFor(fullname+name);
@@ -264,7 +305,7 @@ void Log::log(int importance, const string& message,
     int threshold = getThreshold();
     if (importance < threshold)
         return;
-    LogRecord rec(threshold, importance, *_preamble, willShowAll());
+    LogRecord rec(threshold, importance, _preamble, _name, willShowAll());
     rec.addComment(message);
     rec.addProperties(properties);
     send(rec);
@@ -279,7 +320,7 @@ void Log::log(int importance, const string& message) {
     int threshold = getThreshold();
     if (importance < threshold)
         return;
-    LogRecord rec(threshold, importance, *_preamble, willShowAll());
+    LogRecord rec(threshold, importance, _preamble, _name, willShowAll());
     rec.addComment(message);
     send(rec);
 }
@@ -302,16 +343,9 @@ void Log::format(int importance, const char *fmt, ...) {
 }
 
 void Log::_format(int importance, const char* fmt, va_list ap) {
-	va_list aq;
-	va_copy(aq, ap);
-	// find out how long the formatted string will be
-    const int len = vsnprintf(NULL, 0, fmt, ap) + 1; // "+ 1" for the '\0'
-    va_end(ap);
-	// allocate a string of the appropriate length
-    char msg[len];
-    (void)vsnprintf(msg, len, fmt, aq);
-    va_end(aq);
-    log(importance, msg);
+    FormatBuffer msg;
+    msg.vprintf(fmt, ap);
+    log(importance, msg.str());
 }
 
 /*
@@ -319,12 +353,11 @@ void Log::_format(int importance, const char* fmt, va_list ap) {
  * not check the Log threshold; it assumes this has already been done.
  */
 void Log::_send(int threshold, int importance, const char *fmt, va_list ap) {
-    const int len = strlen(fmt) + 100;  // guess the length
-    char message[len];
-    vsnprintf(message, len, fmt, ap);
+    FormatBuffer message;
+    message.vprintf(fmt, ap);
 
-    LogRecord rec(threshold, importance, *_preamble, willShowAll());
-    rec.addComment(message);
+    LogRecord rec(threshold, importance, _preamble, _name, willShowAll());
+    rec.addComment(message.str());
     send(rec);
 }
 
@@ -335,9 +368,20 @@ void Log::_send(int threshold, int importance, const char *fmt, va_list ap) {
 void Log::send(const LogRecord& record) {
     if (record.getImportance() < getThreshold()) 
         return;
+    if (_async) {
+        _async->write(record, _destinations);
+        return;
+    }
+    if (_destinations.size() == 1) {
+        _destinations.front()->write(record);
+        return;
+    }
+
+    // destinations with equivalent formatters share one rendering
+    RenderedRecord rendered(record);
     list<shared_ptr<LogDestination> >::iterator i;
     for(i = _destinations.begin(); i != _destinations.end(); i++) {
-        (*i)->write(record);
+        (*i)->write(rendered);
     }
 }
 
@@ -377,6 +421,38 @@ void Log::addDestination(ostream& destination, int threshold,
     addDestination(dest);
 }
 
+/*
+ * switch this log to asynchronous mode.  
+ */
+void Log::enableAsync(std::size_t capacity, AsyncWriter::OverflowPolicy policy) {
+    setAsyncWriter(shared_ptr<AsyncWriter>(new AsyncWriter(capacity, policy)));
+}
+
+/*
+ * use a given AsyncWriter to write this log's records.
+ */
+void Log::setAsyncWriter(const shared_ptr<AsyncWriter>& writer) {
+    if (_async) _async->flush();
+    _async = writer;
+}
+
+/*
+ * wait until all records sent to this log so far have been written and
+ * flush the destinations' streams.  An AsyncWriter flushes the 
+ * destinations itself whenever it runs out of records to write, except
+ * for AsyncDestinations, which are waited on here.
+ */
+void Log::flush() {
+    if (_async) _async->flush();
+    list<shared_ptr<LogDestination> >::iterator i;
+    for(i = _destinations.begin(); i != _destinations.end(); i++) {
+        // only an AsyncDestination may be flushed while the writer thread
+        // could be using it
+        if (! _async || dynamic_cast<AsyncDestination*>(i->get()) != 0)
+            (*i)->flush();
+    }
+}
+
 Log& Log::getDefaultLog() {
     if (defaultLog == 0) {
         Log::setDefaultLog(new ScreenLog());
@@ -391,6 +467,10 @@ void Log::setDefaultLog(Log *deflog) {
     if (defaultLog != 0) {
         defaultLog->markPersistent();
     }
+
+    // thresholds cached from the old default log (e.g. by TraceSite) 
+    // no longer apply
+    threshold::Memory::advanceGeneration();
 }
 
 void Log::createDefaultLog(const list<shared_ptr<LogDestination> >& dests, 
@@ -400,7 +480,10 @@ void Log::createDefaultLog(const list<shared_ptr<LogDestination> >& dests,
     Log::setDefaultLog(new Log(dests, preamble, name, threshold));
 }
 
-void Log::closeDefaultLog()  {  setDefaultLog(0);  }
+void Log::closeDefaultLog()  {  
+    if (defaultLog != 0) defaultLog->flush();
+    setDefaultLog(0);  
+}
 
 Log *Log::defaultLog = 0;
 const string Log::_sep(".");
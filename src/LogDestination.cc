@@ -26,8 +26,12 @@
  */
 #include "lsst/pex/logging/LogDestination.h"
 #include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/Timestamp.h"
 
 #include <memory>
+#include <sstream>
+#include <streambuf>
 #include <boost/any.hpp>
 
 using namespace std;
@@ -39,6 +43,111 @@ namespace logging {
 //@cond
 using std::shared_ptr;
 
+namespace {
+
+    // a stream buffer that appends to a string, keeping the string's 
+    // memory from one record to the next
+    class StringAppender : public std::streambuf {
+    public:
+        explicit StringAppender(std::string& text) : _text(&text) { }
+
+        void setTarget(std::string& text) { _text = &text; }
+
+    protected:
+        virtual int_type overflow(int_type c) {
+            if (! traits_type::eq_int_type(c, traits_type::eof()))
+                _text->push_back(traits_type::to_char_type(c));
+            return traits_type::not_eof(c);
+        }
+
+        virtual std::streamsize xsputn(const char *s, std::streamsize n) {
+            _text->append(s, n);
+            return n;
+        }
+
+    private:
+        std::string *_text;
+    };
+
+    // the stream each thread renders records into before they are 
+    // handed to a destination's stream
+    struct RecordBuffer {
+        RecordBuffer() : text(), buf(text), strm(&buf), busy(false) { 
+            text.reserve(1024);
+        }
+
+        std::string text;
+        StringAppender buf;
+        std::ostream strm;
+        bool busy;
+    };
+
+    thread_local RecordBuffer recordBuffer;
+
+    // a buffer grown beyond this is released rather than kept
+    const std::size_t MAX_KEPT = 64*1024;
+
+    // room for a typical record, made before rendering one for sharing
+    const std::size_t RENDER_RESERVE = 256;
+
+    // render a record with a formatter, appending it to a string
+    void renderRecord(LogFormatter& formatter, const LogRecord& rec, 
+                      std::string& out) 
+    {
+        RecordBuffer& rb = recordBuffer;
+        if (rb.busy) {
+            // a formatter is itself logging; render this one separately
+            std::ostringstream strm;
+            formatter.write(&strm, rec);
+            out += strm.str();
+            return;
+        }
+
+        rb.busy = true;
+        rb.buf.setTarget(out);
+        rb.strm.clear();
+        rb.strm.flags(std::ios_base::dec | std::ios_base::skipws);
+        rb.strm.precision(6);
+        rb.strm.width(0);
+        rb.strm.fill(' ');
+        try {
+            formatter.write(&rb.strm, rec);
+        }
+        catch (...) {
+            rb.buf.setTarget(rb.text);
+            rb.busy = false;
+            throw;
+        }
+        rb.buf.setTarget(rb.text);
+        rb.busy = false;
+    }
+}
+
+/*
+ * return the record as rendered by a formatter or one equivalent to it,
+ * rendering it if this has not been done yet
+ */
+const std::string& RenderedRecord::render(LogFormatter& formatter) {
+    std::vector<Text>::iterator i;
+    for(i = _texts.begin(); i != _texts.end(); ++i) {
+        if (i->first == &formatter || formatter.isEquivalent(*i->first))
+            return i->second;
+    }
+
+    _texts.push_back(Text(&formatter, std::string()));
+    _texts.back().second.reserve(RENDER_RESERVE);
+    try {
+        renderRecord(formatter, _rec, _texts.back().second);
+    }
+    catch (...) {
+        _texts.pop_back();
+        throw;
+    }
+    return _texts.back().second;
+}
+
+const int FlushPolicy::DEFAULT_IMPORTANCE = Log::WARN;
+
 /*
  * @brief create a destination with a threshold.  
  * @param strm       the output stream to send messages to.  If the pointer
@@ -52,14 +161,17 @@ using std::shared_ptr;
 LogDestination::LogDestination(ostream *strm, 
                                const shared_ptr<LogFormatter>& formatter,
                                int threshold) 
-    : _threshold(threshold), _strm(strm), _frmtr(formatter)
+    : _threshold(threshold), _strm(strm), _frmtr(formatter), 
+      _flushPolicy(), _pending(0), _lastFlush(Timestamp::now())
 { }
 
 /*
  * create a copy
  */
 LogDestination::LogDestination(const LogDestination& that)
-    : _threshold(that._threshold), _strm(that._strm), _frmtr(that._frmtr)
+    : _threshold(that._threshold), _strm(that._strm), _frmtr(that._frmtr),
+      _flushPolicy(that._flushPolicy), _pending(0), 
+      _lastFlush(Timestamp::now())
 { }
 
 /*
@@ -74,6 +186,7 @@ LogDestination& LogDestination::operator=(const LogDestination& that) {
     _threshold = that._threshold;
     _strm = that._strm; 
     _frmtr = that._frmtr;
+    _flushPolicy = that._flushPolicy;
     return *this;
 }
 
@@ -88,13 +201,86 @@ LogDestination& LogDestination::operator=(const LogDestination& that) {
  *          associated stream. 
  */
 bool LogDestination::write(const LogRecord& rec) {
-    if (_strm != 0 && _frmtr.get() != 0 && 
-        rec.getImportance() >= _threshold)
-    {
-        _frmtr->write(_strm, rec);
-        return true;
+    if (_strm == 0 || _frmtr.get() == 0 || rec.getImportance() < _threshold)
+        return false;
+
+    // render the whole record in memory so that it reaches the stream in 
+    // a single write
+    RecordBuffer& rb = recordBuffer;
+    if (rb.busy) {
+        // a formatter is itself logging; render this one separately
+        std::string text;
+        renderRecord(*_frmtr, rec, text);
+        _put(rec, text);
+    }
+    else {
+        rb.text.clear();
+        renderRecord(*_frmtr, rec, rb.text);
+        _put(rec, rb.text);
+        if (rb.text.capacity() > MAX_KEPT) std::string().swap(rb.text);
     }
-    return false;
+    return true;
+}
+
+/*
+ * record a log record to this destination's output stream, using the
+ * text already rendered by an equivalent formatter if there is one
+ */
+bool LogDestination::write(RenderedRecord& rec) {
+    const LogRecord& record = rec.getRecord();
+    if (_strm == 0 || _frmtr.get() == 0 || 
+        record.getImportance() < _threshold)
+      return false;
+
+    _put(record, rec.render(*_frmtr));
+    return true;
+}
+
+/*
+ * record a sequence of log records to this destination's output stream,
+ * one at a time
+ */
+std::size_t LogDestination::writeBatch(const LogRecord* const* records, 
+                                       std::size_t count) 
+{
+    std::size_t written = 0;
+    for(std::size_t i=0; i < count; ++i) {
+        if (write(*records[i])) ++written;
+    }
+    return written;
+}
+
+/*
+ * render a record with this destination's formatter, appending it to a 
+ * string
+ */
+void LogDestination::_render(const LogRecord& rec, std::string& out) {
+    renderRecord(*_frmtr, rec, out);
+}
+
+/*
+ * write a rendered record to the stream and flush it according to the 
+ * FlushPolicy
+ */
+void LogDestination::_put(const LogRecord& rec, const std::string& text) {
+    _strm->write(text.data(), text.size());
+    _pending += text.size();
+
+    long long elapsed = 0;
+    if (_flushPolicy.isTimed()) elapsed = Timestamp::now() - _lastFlush;
+    if (_flushPolicy.shouldFlush(rec.getImportance(), _pending, elapsed)) 
+        flush();
+}
+
+/*
+ * flush the output stream if anything has been written to it since 
+ * it was last flushed
+ */
+void LogDestination::flush() {
+    if (_pending == 0 || _strm == 0) return;
+    _strm->flush();
+    _pending = 0;
+    if (_flushPolicy.isTimed()) _lastFlush = Timestamp::now();
 }
 
 //@endcond
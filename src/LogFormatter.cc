@@ -30,14 +30,22 @@
 #include "lsst/pex/logging/LogFormatter.h"
 #include "lsst/pex/logging/LogRecord.h"
 #include "lsst/pex/logging/Log.h"
-#include "lsst/pex/logging/PropertyPrinter.h"
+#include "lsst/pex/logging/PropertyVisitor.h"
+#include "lsst/pex/logging/Timestamp.h"
+#include "lsst/pex/logging/NumberFormat.h"
+#include "lsst/pex/logging/JsonString.h"
+#include "lsst/daf/base/DateTime.h"
 #include "lsst/pex/exceptions.h"
 #include "lsst/daf/base/PropertySet.h"
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <memory>
 #include <boost/any.hpp>
 #include <string>
 #include <sstream>
+#include <typeinfo>
 
 using std::string;
 
@@ -46,7 +54,535 @@ namespace pex {
 namespace logging {
 
 namespace dafBase = lsst::daf::base;
-namespace pexExcept = lsst::pex::exceptions;
+
+//@cond
+namespace {
+
+    /*
+     * the level, log name, and comments of a record, which are all that
+     * the brief formats need.  These are read directly from a compact 
+     * record and from its PropertySet otherwise.
+     */
+    class CoreProps {
+    public:
+        explicit CoreProps(LogRecord const& rec);
+
+        int level;
+        string const *log;
+        string const *commentsBegin;
+        string const *commentsEnd;
+
+    private:
+        string _log;
+        std::vector<string> _comments;
+    };
+
+    CoreProps::CoreProps(LogRecord const& rec) 
+        : level(0), log(&_log), commentsBegin(0), commentsEnd(0), 
+          _log(), _comments()
+    {
+        if (rec.isCompact()) {
+            level = rec.getImportance();
+            if (rec.hasLogName()) log = &rec.getLogName();
+            LogRecord::CommentList const& comments = rec.getComments();
+            commentsBegin = comments.data();
+            commentsEnd = commentsBegin + comments.size();
+            return;
+        }
+
+        // a missing property is common and cheap to detect; a 
+        // mis-typed one is rare and only then is existence checked
+        rec.tryGetLevel(level);
+        if (! rec.tryGetLogName(_log) && rec.data().exists(LSST_LP_LOG))
+            _log = "mis-specified_log_name";
+        if (! rec.tryGetComments(_comments) && 
+            rec.data().exists(LSST_LP_COMMENT)) 
+            _comments.push_back("(mis-specified_comment)");
+        commentsBegin = _comments.data();
+        commentsEnd = commentsBegin + _comments.size();
+    }
+
+    /*
+     * writes each value of a property on its own line, as 
+     * "<indent>  name: value"
+     */
+    class PropertyLines : public PropertyVisitor {
+    public:
+        PropertyLines(std::ostream& strm, string const& indent) 
+            : _strm(strm), _indent(indent) { }
+
+        virtual void visit(string const& name, PropertyValue const& value,
+                           std::size_t) 
+        {
+            _strm << _indent << "  " << name << ": ";
+            value.write(_strm) << '\n';
+        }
+
+        void writeAll(dafBase::PropertySet const& props, bool skipLabel) {
+            std::vector<std::string> names = props.paramNames(false);
+            for (auto const& name : names) {
+                if (name == LSST_LP_COMMENT || name == LSST_LP_LOG || 
+                    (skipLabel && name == LSST_LP_LABEL)) 
+                    continue;
+                visitValues(props, name, *this);
+            }
+        }
+
+    private:
+        std::ostream& _strm;
+        string const& _indent;
+    };
+
+    const string noIndent;
+
+    /*
+     * writes each value of a property on its own line in the NetLogger 
+     * format, "<type> name<midfix>value"
+     */
+    class NetLoggerLines : public PropertyVisitor {
+    public:
+        NetLoggerLines(std::ostream& strm, char tp, string const& midfix) 
+            : wrote(false), _strm(strm), _tp(tp), _midfix(midfix) { }
+
+        virtual void visit(string const& name, PropertyValue const& value,
+                           std::size_t) 
+        {
+            _strm << _tp << " " << name << _midfix;
+            value.write(_strm) << '\n';
+            wrote = true;
+        }
+
+        bool wrote;
+
+    private:
+        std::ostream& _strm;
+        char _tp;
+        string const& _midfix;
+    };
+
+    /*
+     * writes the values of a property, separated by commas
+     */
+    class ValueWriter : public PropertyVisitor {
+    public:
+        explicit ValueWriter(std::ostream& strm) : _strm(strm) { }
+
+        virtual void visit(string const&, PropertyValue const& value,
+                           std::size_t index) 
+        {
+            if (index > 0) _strm << ',';
+            value.write(_strm);
+        }
+
+    private:
+        std::ostream& _strm;
+    };
+
+    /*
+     * writes each value of a property as " name=value"
+     */
+    class PairWriter : public PropertyVisitor {
+    public:
+        explicit PairWriter(std::ostream& strm) : _strm(strm) { }
+
+        virtual void visit(string const& name, PropertyValue const& value,
+                           std::size_t) 
+        {
+            _strm << ' ' << name << '=';
+            value.write(_strm);
+        }
+
+    private:
+        std::ostream& _strm;
+    };
+
+    /*
+     * writes the values of a property as JSON:  a single value as is, and
+     * several as an array
+     */
+    class JsonValues : public PropertyVisitor {
+    public:
+        JsonValues(std::ostream& strm, bool array) 
+            : _strm(strm), _array(array), _visited(0) { }
+
+        virtual void visit(string const&, PropertyValue const& value,
+                           std::size_t);
+
+        // end the values written so far
+        void finish() {
+            if (_visited == 0) 
+                _strm << (_array ? "[]" : "null");
+            else if (_array)
+                _strm << ']';
+        }
+
+        // start on the values of another property
+        void restart(bool array) {
+            _array = array;
+            _visited = 0;
+        }
+
+    private:
+        std::ostream& _strm;
+        bool _array;
+        std::size_t _visited;
+    };
+
+    template <class T>
+    bool writeFinite(std::ostream& strm, PropertyValue const& value) {
+        T const *val = value.get<T>();
+        if (val == 0) return false;
+        if (std::isfinite(*val)) 
+            NumberFormat::write(strm, *val);
+        else 
+            strm << "null";
+        return true;
+    }
+
+    void JsonValues::visit(string const&, PropertyValue const& value,
+                           std::size_t) 
+    {
+        if (_array) _strm << ((_visited == 0) ? '[' : ',');
+        ++_visited;
+
+        std::type_info const& type = value.getType();
+        if (string const *str = value.get<string>()) {
+            JsonString::write(_strm, *str);
+        }
+        else if (bool const *flag = value.get<bool>()) {
+            _strm << ((*flag) ? "true" : "false");
+        }
+        else if (type == typeid(int) || type == typeid(long) || 
+                 type == typeid(long long) || type == typeid(short) || 
+                 type == typeid(unsigned long long) || 
+                 type == typeid(dafBase::DateTime)) 
+        {
+            value.write(_strm);
+        }
+        else if (! writeFinite<double>(_strm, value) && 
+                 ! writeFinite<float>(_strm, value))
+        {
+            // characters and anything else
+            std::ostringstream text;
+            value.write(text);
+            JsonString::write(_strm, text.str());
+        }
+    }
+
+    /*
+     * counts the values of each property visited, in the order the 
+     * properties are first seen, noting whether any property's values 
+     * are not all visited together
+     */
+    class PropertyCounter : public PropertyVisitor {
+    public:
+        PropertyCounter() : counts(), together(true) { }
+
+        virtual void visit(string const& name, PropertyValue const&,
+                           std::size_t) 
+        {
+            if (! counts.empty() && counts.back().first == name) {
+                ++counts.back().second;
+                return;
+            }
+            for (auto const& count : counts) {
+                if (count.first == name) together = false;
+            }
+            counts.push_back(std::make_pair(name, std::size_t(1)));
+        }
+
+        std::vector<std::pair<string, std::size_t> > counts;
+        bool together;
+    };
+
+    /*
+     * writes each property visited as a JSON member, given the counts of 
+     * the values of properties whose values are visited together
+     */
+    class JsonProperties : public PropertyVisitor {
+    public:
+        JsonProperties(std::ostream& strm, PropertyCounter const& counter)
+            : _strm(strm), _counts(counter.counts), _next(0), 
+              _values(strm, false) 
+        { }
+
+        virtual void visit(string const& name, PropertyValue const& value,
+                           std::size_t index) 
+        {
+            if (_next == 0 || _counts[_next-1].first != name) {
+                if (_next > 0) _values.finish();
+                _strm << ',';
+                JsonString::write(_strm, name);
+                _strm << ':';
+                _values.restart(_counts[_next++].second > 1);
+            }
+            _values.visit(name, value, index);
+        }
+
+        // end the last property
+        void finish() {
+            if (_next > 0) _values.finish();
+        }
+
+    private:
+        std::ostream& _strm;
+        std::vector<std::pair<string, std::size_t> > const& _counts;
+        std::size_t _next;
+        JsonValues _values;
+    };
+
+    /*
+     * passes on to another visitor the values of one property only, 
+     * numbering them across all the additions made to it
+     */
+    class NamedValues : public PropertyVisitor {
+    public:
+        NamedValues(string const& name, PropertyVisitor& visitor)
+            : _name(name), _visitor(visitor), _count(0) { }
+
+        virtual void visit(string const& name, PropertyValue const& value,
+                           std::size_t) 
+        {
+            if (name == _name) _visitor.visit(name, value, _count++);
+        }
+
+    private:
+        string const& _name;
+        PropertyVisitor& _visitor;
+        std::size_t _count;
+    };
+
+    template <class T>
+    void visitSlot(PropertyVisitor& visitor, string const& name, 
+                   T const& value, std::size_t index) 
+    {
+        PropertyValue::Writer writer = PropertyVisitor::getWriter(typeid(T));
+        if (writer != 0) 
+            visitor.visit(name, PropertyValue(typeid(T), &value, writer), 
+                          index);
+    }
+
+    /*
+     * hand a visitor the values of one property of a record.  Those of a
+     * compact record are taken from its slots, its preamble, and its 
+     * extra properties without assembling it.
+     */
+    void visitNamed(LogRecord const& rec, CoreProps const& core, 
+                    string const& name, PropertyVisitor& visitor)
+    {
+        if (! rec.isCompact()) {
+            dafBase::PropertySet const& props = rec.data();
+            if (props.exists(name)) 
+                PropertyVisitor::visitValues(props, name, visitor);
+            return;
+        }
+
+        if (name == LSST_LP_LOG) {
+            if (rec.hasLogName()) visitSlot(visitor, name, *core.log, 0);
+        }
+        else if (name == LSST_LP_LEVEL) {
+            visitSlot(visitor, name, core.level, 0);
+        }
+        else if (name == LSST_LP_COMMENT) {
+            std::size_t i = 0;
+            for (string const *c = core.commentsBegin; c != core.commentsEnd;
+                 ++c)
+              visitSlot(visitor, name, *c, i++);
+        }
+        else if (name == LSST_LP_TIMESTAMP) {
+            if (rec.hasTimestamp()) {
+                dafBase::DateTime ts(rec.getTimestamp(), 
+                                     dafBase::DateTime::UTC);
+                visitSlot(visitor, name, ts, 0);
+            }
+        }
+        else if (name == LSST_LP_DATE) {
+            if (rec.hasDate()) visitSlot(visitor, name, rec.getDate(), 0);
+        }
+        else {
+            NamedValues named(name, visitor);
+            dafBase::PropertySet const *preamble = rec.getPreamble().get();
+            if (preamble != 0 && preamble->exists(name)) 
+                PropertyVisitor::visitValues(*preamble, name, named);
+            rec.visitProperties(named, false);
+        }
+    }
+
+    /*
+     * return the name of a level
+     */
+    char const *levelName(int level) {
+        if (level >= Log::FATAL) return "FATAL";
+        if (level >= Log::WARN) return "WARNING";
+        if (level < Log::INFO) return "DEBUG";
+        return "INFO";
+    }
+
+    /*
+     * return the string that separates the log name from a comment 
+     * for a given level
+     */
+    char const *levelString(int level) {
+        if (level >= Log::FATAL) return " FATAL: ";
+        if (level >= Log::WARN) return " WARNING: ";
+        if (level < Log::INFO) return " DEBUG: ";
+        return ": ";
+    }
+
+    /*
+     * return true if a property's value is one that a BinaryFormatter 
+     * writes in a record's fixed fields
+     */
+    bool isSlotName(string const& name) {
+        return (name == LSST_LP_COMMENT || name == LSST_LP_LOG || 
+                name == LSST_LP_LEVEL || name == LSST_LP_TIMESTAMP || 
+                name == LSST_LP_DATE);
+    }
+
+    /*
+     * appends the parts of a BinaryFormatter frame to a string.  As a 
+     * visitor, it appends each value as a named, typed property.
+     */
+    class FrameWriter : public PropertyVisitor {
+    public:
+        typedef std::unordered_map<string, unsigned long long> NameTable;
+
+        FrameWriter(string& out, NameTable& names) 
+            : count(0), _out(out), _names(names) { }
+
+        void putByte(int val) { _out.push_back(static_cast<char>(val)); }
+
+        void putVarint(unsigned long long val) {
+            while (val >= 0x80) {
+                _out.push_back(static_cast<char>((val & 0x7f) | 0x80));
+                val >>= 7;
+            }
+            _out.push_back(static_cast<char>(val));
+        }
+
+        void putSigned(long long val) {
+            putVarint((static_cast<unsigned long long>(val) << 1) ^ 
+                      static_cast<unsigned long long>(val >> 63));
+        }
+
+        void putFixed(unsigned long long val, int nbytes) {
+            for(int i=0; i < nbytes; ++i, val >>= 8) 
+                _out.push_back(static_cast<char>(val & 0xff));
+        }
+
+        void putString(string const& val) {
+            putVarint(val.size());
+            _out.append(val);
+        }
+
+        // write a reference to a name, defining it if it is new
+        void putName(string const& name) {
+            NameTable::const_iterator it = _names.find(name);
+            if (it != _names.end()) {
+                putVarint(it->second << 1);
+                return;
+            }
+            unsigned long long id = _names.size();
+            _names[name] = id;
+            putVarint((id << 1) | 1);
+            putString(name);
+        }
+
+        virtual void visit(string const& name, PropertyValue const& value,
+                           std::size_t);
+
+        std::size_t count;   // the number of values visited
+
+    private:
+        string& _out;
+        NameTable& _names;
+    };
+
+    // write a frame preceded by its length
+    void writeFrame(std::ostream& strm, string const& frame) {
+        char length[10];
+        std::size_t n = 0, len = frame.size();
+        while (len >= 0x80) {
+            length[n++] = static_cast<char>((len & 0x7f) | 0x80);
+            len >>= 7;
+        }
+        length[n++] = static_cast<char>(len);
+        strm.write(length, n);
+        strm.write(frame.data(), frame.size());
+    }
+
+    void FrameWriter::visit(string const& name, PropertyValue const& value,
+                            std::size_t) 
+    {
+        ++count;
+        putName(name);
+        if (string const *v = value.get<string>()) {
+            putByte(BinaryFormatter::STRING);
+            putString(*v);
+        }
+        else if (int const *v = value.get<int>()) {
+            putByte(BinaryFormatter::INT);
+            putSigned(*v);
+        }
+        else if (double const *v = value.get<double>()) {
+            unsigned long long bits;
+            std::memcpy(&bits, v, sizeof(bits));
+            putByte(BinaryFormatter::DOUBLE);
+            putFixed(bits, 8);
+        }
+        else if (long const *v = value.get<long>()) {
+            putByte(BinaryFormatter::LONG);
+            putSigned(*v);
+        }
+        else if (long long const *v = value.get<long long>()) {
+            putByte(BinaryFormatter::LONG_LONG);
+            putSigned(*v);
+        }
+        else if (bool const *v = value.get<bool>()) {
+            putByte(BinaryFormatter::BOOL);
+            putByte(*v ? 1 : 0);
+        }
+        else if (float const *v = value.get<float>()) {
+            uint32_t bits;
+            std::memcpy(&bits, v, sizeof(bits));
+            putByte(BinaryFormatter::FLOAT);
+            putFixed(bits, 4);
+        }
+        else if (dafBase::DateTime const *v = value.get<dafBase::DateTime>()) {
+            putByte(BinaryFormatter::DATETIME);
+            putFixed(static_cast<unsigned long long>(v->nsecs()), 8);
+        }
+        else if (short const *v = value.get<short>()) {
+            putByte(BinaryFormatter::SHORT);
+            putSigned(*v);
+        }
+        else if (unsigned long long const *v = 
+                     value.get<unsigned long long>()) 
+        {
+            putByte(BinaryFormatter::UNSIGNED_LONG_LONG);
+            putVarint(*v);
+        }
+        else if (char const *v = value.get<char>()) {
+            putByte(BinaryFormatter::CHAR);
+            putByte(*v);
+        }
+        else if (signed char const *v = value.get<signed char>()) {
+            putByte(BinaryFormatter::CHAR);
+            putByte(*v);
+        }
+        else if (unsigned char const *v = value.get<unsigned char>()) {
+            putByte(BinaryFormatter::CHAR);
+            putByte(*v);
+        }
+        else {
+            std::ostringstream text;
+            value.write(text);
+            putByte(BinaryFormatter::TEXT);
+            putString(text.str());
+        }
+    }
+}
+//@endcond
 
 ///////////////////////////////////////////////////////////
 //  LogFormatter
@@ -54,59 +590,57 @@ namespace pexExcept = lsst::pex::exceptions;
 
 LogFormatter::~LogFormatter() {}
 
+/*
+ * return true if this formatter renders every record exactly as another 
+ * one does.  By default, a formatter is only equivalent to itself.
+ */
+bool LogFormatter::isEquivalent(LogFormatter const& that) const {
+    return this == &that;
+}
+
+/*
+ * prepare to write to a new stream.  By default, this does nothing.
+ */
+void LogFormatter::startStream() { }
+
 ///////////////////////////////////////////////////////////
 //  BriefFormatter
 ///////////////////////////////////////////////////////////
 
 BriefFormatter::~BriefFormatter() {}
 
+/*
+ * return true if the other formatter is of the same class and verbosity
+ * as this one.  This also serves IndentedFormatter and PrependedFormatter,
+ * which add no state; a subclass of any other kind is only equivalent to
+ * itself, as it may render records differently.
+ */
+bool BriefFormatter::isEquivalent(LogFormatter const& that) const {
+    if (this == &that) return true;
+    std::type_info const& type = typeid(*this);
+    if (type != typeid(BriefFormatter) && type != typeid(IndentedFormatter) &&
+        type != typeid(PrependedFormatter))
+      return false;
+    return typeid(that) == type && 
+           static_cast<BriefFormatter const&>(that)._doAll == _doAll;
+}
+
 /*
  * write out a log record to a stream
  * @param strm   the output stream to write the record to
  * @param rec    the record to write
  */
 void BriefFormatter::write(std::ostream *strm, LogRecord const& rec) {
-    string log;
-    int level=0;
-    string levstr(": ");
-    std::vector<std::string> comments;
-
-    try {
-        level = rec.data().get<int>(LSST_LP_LEVEL);
-        if (level >= Log::FATAL) levstr = " FATAL: ";
-        else if (level >= Log::WARN) levstr = " WARNING: ";
-        else if (level < Log::INFO) levstr = " DEBUG: ";
-    } catch (pexExcept::TypeError const & ex) {
-    } catch (pexExcept::NotFoundError const & ex) {}
-
-    try { 
-        log = rec.data().get<string>(LSST_LP_LOG);
-    } catch (pexExcept::TypeError const & ex) {
-        log = "mis-specified_log_name";
-    } catch (pexExcept::NotFoundError const & ex) {}
-
-    try {
-        comments = rec.data().getArray<string>(LSST_LP_COMMENT);
-    } catch (pexExcept::TypeError const & ex) {
-        comments.push_back("(mis-specified_comment)");
-    } catch (pexExcept::NotFoundError const & ex) {}
-
-    for (auto const& vi : comments) {
-        (*strm) << log << levstr << vi << std::endl;
+    CoreProps core(rec);
+    char const *levstr = levelString(core.level);
+
+    for (string const *vi = core.commentsBegin; vi != core.commentsEnd; ++vi) {
+        (*strm) << *core.log << levstr << *vi << '\n';
     }
 
     if (isVerbose() || rec.willShowAll()) {
-        std::vector<std::string> names = rec.data().paramNames(false);
-        for (auto const& vi : names) {
-            if (vi == LSST_LP_COMMENT || vi == LSST_LP_LOG) continue;
-
-            PropertyPrinter pp(rec.data(), vi);
-            for (PropertyPrinter::iterator pi=pp.begin(); pi.notAtEnd(); ++pi) {
-                (*strm) << "  " << vi << ": ";
-                pi.write(strm) << std::endl;
-            }
-        }
-        (*strm)  << std::endl;
+        PropertyLines(*strm, noIndent).writeAll(rec.data(), false);
+        (*strm) << '\n';
     }
 }
 
@@ -122,56 +656,19 @@ IndentedFormatter::~IndentedFormatter() {}
  * @param rec    the record to write
  */
 void IndentedFormatter::write(std::ostream *strm, LogRecord const& rec) {
-    string log;
-    int level=0;
-    string levstr(": ");
-    std::vector<std::string> comments;
-
-    try {
-        level = rec.data().get<int>(LSST_LP_LEVEL);
-        if (level >= Log::FATAL) levstr = " FATAL: ";
-        else if (level >= Log::WARN) levstr = " WARNING: ";
-        else if (level < Log::INFO) levstr = " DEBUG: ";
-    } catch (pexExcept::TypeError const & ex) {
-    } catch (pexExcept::NotFoundError const & ex) {}
+    CoreProps core(rec);
+    char const *levstr = levelString(core.level);
 
-    try { 
-        log = rec.data().get<string>(LSST_LP_LOG);
-    } catch (pexExcept::TypeError const & ex) {
-        log = "mis-specified_log_name";
-    } catch (pexExcept::NotFoundError const & ex) {}
+    // indent the message
+    string indent((core.level < 0) ? -core.level : 0, ' ');
 
-    try {
-        comments = rec.data().getArray<string>(LSST_LP_COMMENT);
-    } catch (pexExcept::TypeError const & ex) {
-        comments.push_back("(mis-specified_comment)");
-    } catch (pexExcept::NotFoundError const & ex) {}
-
-    std::ostringstream indentstr;
-    if (level < 0) {
-        // indent the message
-        for (int i=level; i < 0; ++i) {
-            indentstr << ' ';
-        }
-    }
-    string indent(indentstr.str());
-
-    for (auto const& vi : comments) {
-        (*strm) << indent << log << levstr << vi << std::endl;
+    for (string const *vi = core.commentsBegin; vi != core.commentsEnd; ++vi) {
+        (*strm) << indent << *core.log << levstr << *vi << '\n';
     }
 
     if (isVerbose() || rec.willShowAll()) {
-        std::vector<std::string> names = rec.data().paramNames(false);
-        for (auto const& vi : names) {
-            if (vi == LSST_LP_COMMENT || vi == LSST_LP_LOG) continue;
-
-            PropertyPrinter pp(rec.data(), vi);
-            for (PropertyPrinter::iterator pi=pp.begin(); pi.notAtEnd(); ++pi) {
-                (*strm) << indent << "  " << vi << ": ";
-                pi.write(strm) << std::endl;
-            }
-        }
-        (*strm)  << std::endl;
+        PropertyLines(*strm, indent).writeAll(rec.data(), false);
+        (*strm) << '\n';
     }
 }
 
@@ -190,6 +687,18 @@ NetLoggerFormatter::NetLoggerFormatter(string const& valueDelim)
 
 NetLoggerFormatter::~NetLoggerFormatter() {}
 
+/*
+ * return true if the other formatter is a NetLoggerFormatter using the 
+ * same value delimiter as this one.  A subclass is only equivalent to 
+ * itself.
+ */
+bool NetLoggerFormatter::isEquivalent(LogFormatter const& that) const {
+    if (this == &that) return true;
+    return typeid(*this) == typeid(NetLoggerFormatter) &&
+           typeid(that) == typeid(NetLoggerFormatter) && 
+           static_cast<NetLoggerFormatter const&>(that)._midfix == _midfix;
+}
+
 #define LSST_TL_ADD(T, C) _tplookup[typeid(T).name()] = C
 
 void NetLoggerFormatter::loadTypeLookup() {
@@ -222,9 +731,7 @@ NetLoggerFormatter& NetLoggerFormatter::operator=(NetLoggerFormatter const& that
  * @param rec    the record to write
  */
 void NetLoggerFormatter::write(std::ostream *strm, LogRecord const& rec) {
-    string newl("\n");
     bool wrote = false;
-    std::vector<std::string> comments;
 
     std::vector<std::string> names = rec.data().paramNames(false);
     for (auto const& vi : names) {
@@ -235,15 +742,12 @@ void NetLoggerFormatter::write(std::ostream *strm, LogRecord const& rec) {
             tp = '?';
         
 
-        PropertyPrinter pp(rec.data(), vi);
-        for (PropertyPrinter::iterator pi=pp.begin(); pi.notAtEnd(); ++pi) {
-            (*strm) << tp << " " << vi << _midfix;
-            pi.write(strm) << newl;
-            if (!wrote) wrote = true;
-        }
+        NetLoggerLines lines(*strm, tp, _midfix);
+        PropertyVisitor::visitValues(rec.data(), vi, lines);
+        if (lines.wrote) wrote = true;
     }
 
-    if (wrote) (*strm) << std::endl;
+    if (wrote) (*strm) << '\n';
 }
 
 ///////////////////////////////////////////////////////////
@@ -258,63 +762,444 @@ PrependedFormatter::~PrependedFormatter() {}
  * @param rec    the record to write
  */
 void PrependedFormatter::write(std::ostream *strm, LogRecord const& rec) {
+    CoreProps core(rec);
+    char const *levstr = levelString(core.level);
+
+    // the date comes from the record's creation time when it is compact
     string date;
-    try {
-        date = rec.data().get<string>(LSST_LP_DATE) + ": ";
-    } catch (...) {
+    if (rec.isCompact() && rec.hasDate()) {
+        Timestamp::append(rec.getTimestamp(), date);
+        date += ": ";
+    }
+    else if (! rec.isCompact() && rec.tryGetDate(date)) {
+        date += ": ";
+    }
+    else {
         date = "(failed to get timestamp): ";
     }
 
-    int level = 0;
-    string levstr(": ");
-    try {
-        level = rec.data().get<int>(LSST_LP_LEVEL);
-        if (level >= Log::FATAL) levstr = " FATAL: ";
-        else if (level >= Log::WARN) levstr = " WARNING: ";
-        else if (level < Log::INFO) levstr = " DEBUG: ";
-    } catch (pexExcept::TypeError const & ex) {
-    } catch (pexExcept::NotFoundError const & ex) {}
-
-    string log;
-    try {
-        log = rec.data().get<string>(LSST_LP_LOG);
-    } catch (pexExcept::TypeError const & ex) {
-        log = "mis-specified_log_name";
-    } catch (pexExcept::NotFoundError const & ex) {}
-
-    std::vector<std::string> comments;
-    try {
-        comments = rec.data().getArray<string>(LSST_LP_COMMENT);
-    } catch (pexExcept::TypeError const & ex) {
-        comments.push_back("(mis-specified_comment)");
-    } catch (pexExcept::NotFoundError const & ex) {}
-
+    // most records have no label
     string label;
-    try {
-        label = rec.data().get<string>(LSST_LP_LABEL);
-    } catch (pexExcept::TypeError const & ex) {
-        label = "mis-specified_label";
-    } catch (pexExcept::NotFoundError const & ex) {}
+    if (! rec.tryGetLabel(label)) {
+        dafBase::PropertySet const *labelSrc = 
+            rec.isCompact() ? rec.getPreamble().get() : &rec.data();
+        if (labelSrc && labelSrc->exists(LSST_LP_LABEL))
+            label = "mis-specified_label";
+    }
 
-    for (auto const& vi : comments) {
-        (*strm) << date << label << ": " << log << levstr << vi << std::endl;
+    for (string const *vi = core.commentsBegin; vi != core.commentsEnd; ++vi) {
+        (*strm) << date << label << ": " << *core.log << levstr << *vi 
+                << '\n';
     }
 
     if (isVerbose() || rec.willShowAll()) {
-        std::vector<std::string> names = rec.data().paramNames(false);
-        for (auto const& vi : names) {
-            if (vi == LSST_LP_COMMENT || vi == LSST_LP_LOG || vi == LSST_LP_LABEL) continue;
-
-            PropertyPrinter pp(rec.data(), vi);
-            for (PropertyPrinter::iterator pi=pp.begin(); pi.notAtEnd(); ++pi) {
-                (*strm) << "  " << vi << ": ";
-                pi.write(strm) << std::endl;
+        PropertyLines(*strm, noIndent).writeAll(rec.data(), true);
+        (*strm) << '\n';
+    }
+}
+
+///////////////////////////////////////////////////////////
+//  PatternFormatter
+///////////////////////////////////////////////////////////
+
+const string PatternFormatter::DEFAULT_PATTERN("%d %L %n: %m");
+
+PatternFormatter::PatternFormatter(string const& pattern)
+    : LogFormatter(), _pattern(pattern), _ops(), _perMessage(false)
+{
+    _compile();
+}
+
+PatternFormatter::~PatternFormatter() {}
+
+/*
+ * return true if the other formatter is a PatternFormatter using the 
+ * same pattern as this one.  A subclass is only equivalent to itself.
+ */
+bool PatternFormatter::isEquivalent(LogFormatter const& that) const {
+    if (this == &that) return true;
+    return typeid(*this) == typeid(PatternFormatter) &&
+           typeid(that) == typeid(PatternFormatter) && 
+           static_cast<PatternFormatter const&>(that)._pattern == _pattern;
+}
+
+/*
+ * parse the pattern into operations, merging runs of literal text into 
+ * single TEXT operations
+ */
+void PatternFormatter::_compile() {
+    _ops.clear();
+    _perMessage = false;
+
+    string text;
+    string::size_type i = 0;
+    while (i < _pattern.size()) {
+        char c = _pattern[i++];
+        if (c != '%' || i >= _pattern.size()) {
+            text += c;
+            continue;
+        }
+
+        Op op;
+        char d = _pattern[i++];
+        switch (d) {
+          case 'd':  op.kind = Op::DATE;        break;
+          case 'n':  op.kind = Op::LOG;         break;
+          case 'l':  op.kind = Op::LEVEL;       break;
+          case 'L':  op.kind = Op::LEVEL_NAME;  break;
+          case 'b':  op.kind = Op::LABEL;       break;
+          case 'm':  op.kind = Op::MESSAGE;     break;
+          case 'v':
+          case 'p': {
+            string::size_type close = _pattern.find('}', i);
+            if (i >= _pattern.size() || _pattern[i] != '{' || 
+                close == string::npos) 
+            {
+                // not a directive we understand; leave it as text
+                text += c;
+                text += d;
+                continue;
             }
+            op.kind = (d == 'v') ? Op::VALUE : Op::PROPERTIES;
+            string::size_type start = i + 1;
+            while (start <= close) {
+                string::size_type end = _pattern.find(',', start);
+                if (end == string::npos || end > close) end = close;
+                string::size_type first = 
+                    _pattern.find_first_not_of(' ', start);
+                string::size_type last = 
+                    _pattern.find_last_not_of(' ', end - 1);
+                if (first < end && last != string::npos && last >= first)
+                    op.names.push_back(_pattern.substr(first, 
+                                                       last - first + 1));
+                start = end + 1;
+            }
+            i = close + 1;
+            break;
+          }
+          case '%':  
+            text += '%';  
+            continue;
+          default:
+            text += c;
+            text += d;
+            continue;
+        }
+
+        if (! text.empty()) {
+            Op lit;
+            lit.kind = Op::TEXT;
+            lit.text.swap(text);
+            _ops.push_back(lit);
         }
-        (*strm) << std::endl;
+        if (op.kind == Op::MESSAGE) _perMessage = true;
+        _ops.push_back(op);
+    }
+    if (! text.empty()) {
+        Op lit;
+        lit.kind = Op::TEXT;
+        lit.text.swap(text);
+        _ops.push_back(lit);
     }
 }
 
+/*
+ * write out a log record to a stream
+ * @param strm   the output stream to write the record to
+ * @param rec    the record to write
+ */
+void PatternFormatter::write(std::ostream *strm, LogRecord const& rec) {
+    if (strm == 0) return;
+    CoreProps core(rec);
+    if (_perMessage && core.commentsBegin == core.commentsEnd) return;
+
+    // the date and label are only looked up if needed, and only once
+    bool compactDate = rec.isCompact() && rec.hasDate();
+    bool dateFetched = false, labelFetched = false;
+    string date, label;
+    char stamp[Timestamp::LENGTH];
+
+    string const *msg = core.commentsBegin;
+    do {
+        for (auto const& op : _ops) {
+            switch (op.kind) {
+              case Op::TEXT:
+                strm->write(op.text.data(), op.text.size());
+                break;
+              case Op::DATE:
+                if (compactDate) {
+                    strm->write(stamp, 
+                                Timestamp::format(rec.getTimestamp(), stamp)
+                                - stamp);
+                    break;
+                }
+                if (! dateFetched) {
+                    if (! rec.isCompact()) rec.tryGetDate(date);
+                    dateFetched = true;
+                }
+                (*strm) << date;
+                break;
+              case Op::LOG:
+                (*strm) << *core.log;
+                break;
+              case Op::LEVEL:
+                NumberFormat::write(*strm, core.level);
+                break;
+              case Op::LEVEL_NAME:
+                (*strm) << levelName(core.level);
+                break;
+              case Op::LABEL:
+                if (! labelFetched) {
+                    rec.tryGetLabel(label);
+                    labelFetched = true;
+                }
+                (*strm) << label;
+                break;
+              case Op::MESSAGE:
+                (*strm) << *msg;
+                break;
+              case Op::VALUE: 
+              case Op::PROPERTIES: {
+                ValueWriter values(*strm);
+                PairWriter pairs(*strm);
+                for (auto const& name : op.names) {
+                    if (op.kind == Op::VALUE) 
+                        visitNamed(rec, core, name, values);
+                    else
+                        visitNamed(rec, core, name, pairs);
+                }
+                break;
+              }
+            }
+        }
+        (*strm) << '\n';
+    } while (_perMessage && ++msg != core.commentsEnd);
+}
+
+///////////////////////////////////////////////////////////
+//  JsonLinesFormatter
+///////////////////////////////////////////////////////////
+
+JsonLinesFormatter::~JsonLinesFormatter() {}
+
+/*
+ * return true if the other formatter is a JsonLinesFormatter.  A subclass
+ * is only equivalent to itself.
+ */
+bool JsonLinesFormatter::isEquivalent(LogFormatter const& that) const {
+    return this == &that || 
+           (typeid(*this) == typeid(JsonLinesFormatter) &&
+            typeid(that) == typeid(JsonLinesFormatter));
+}
+
+/*
+ * write out a log record to a stream
+ * @param strm   the output stream to write the record to
+ * @param rec    the record to write
+ */
+void JsonLinesFormatter::write(std::ostream *strm, LogRecord const& rec) {
+    if (strm == 0) return;
+    CoreProps core(rec);
+
+    (*strm) << '{';
+    if (rec.isCompact() && rec.hasDate()) {
+        char stamp[Timestamp::LENGTH];
+        (*strm) << "\"" LSST_LP_DATE "\":\"";
+        strm->write(stamp, Timestamp::format(rec.getTimestamp(), stamp) - stamp);
+        (*strm) << "\",";
+    }
+    else {
+        string date;
+        if (! rec.isCompact() && rec.tryGetDate(date)) {
+            (*strm) << "\"" LSST_LP_DATE "\":";
+            JsonString::write(*strm, date);
+            (*strm) << ',';
+        }
+    }
+
+    (*strm) << "\"" LSST_LP_LEVEL "\":";
+    NumberFormat::write(*strm, core.level);
+    (*strm) << ",\"" LSST_LP_LOG "\":";
+    JsonString::write(*strm, *core.log);
+
+    if (core.commentsBegin != core.commentsEnd) {
+        (*strm) << ",\"" LSST_LP_COMMENT "\":[";
+        for (string const *vi = core.commentsBegin; vi != core.commentsEnd; 
+             ++vi) 
+        {
+            if (vi != core.commentsBegin) (*strm) << ',';
+            JsonString::write(*strm, *vi);
+        }
+        (*strm) << ']';
+    }
+
+    // a compact record's properties are visited where they are kept, 
+    // unless a property's values are scattered among them
+    if (rec.isCompact()) {
+        PropertyCounter counter;
+        rec.visitProperties(counter, true);
+        if (counter.together) {
+            if (rec.hasTimestamp()) {
+                // as a DateTime TIMESTAMP would be written
+                dafBase::DateTime ts(rec.getTimestamp(), 
+                                     dafBase::DateTime::UTC);
+                (*strm) << ",\"" LSST_LP_TIMESTAMP "\":";
+                NumberFormat::write(*strm, ts.nsecs());
+            }
+            JsonProperties props(*strm, counter);
+            rec.visitProperties(props, true);
+            props.finish();
+            (*strm) << "}\n";
+            return;
+        }
+    }
+
+    dafBase::PropertySet const& props = rec.data();
+    std::vector<std::string> names = props.paramNames(false);
+    for (auto const& name : names) {
+        if (name == LSST_LP_DATE || name == LSST_LP_LEVEL || 
+            name == LSST_LP_LOG || name == LSST_LP_COMMENT) 
+            continue;
+        (*strm) << ',';
+        JsonString::write(*strm, name);
+        (*strm) << ':';
+        JsonValues values(*strm, props.valueCount(name) > 1);
+        PropertyVisitor::visitValues(props, name, values);
+        values.finish();
+    }
+    (*strm) << "}\n";
+}
+
+///////////////////////////////////////////////////////////
+//  BinaryFormatter
+///////////////////////////////////////////////////////////
+
+const char BinaryFormatter::MAGIC[] = "LSSTBLOG";
+const int BinaryFormatter::VERSION;
+const std::size_t BinaryFormatter::MAX_PREAMBLES;
+
+BinaryFormatter::BinaryFormatter() 
+    : LogFormatter(), _started(false), _frame(), _names(), _preambleIds(), 
+      _preambles()
+{ }
+
+/*
+ * create a formatter like another; the copy starts a new stream
+ */
+BinaryFormatter::BinaryFormatter(BinaryFormatter const& that) 
+    : LogFormatter(that), _started(false), _frame(), _names(), 
+      _preambleIds(), _preambles()
+{ }
+
+BinaryFormatter::~BinaryFormatter() {}
+
+/*
+ * prepare to write to a new stream
+ */
+void BinaryFormatter::startStream() {
+    _reset();
+}
+
+/*
+ * forget what has been written so that the next record starts a new stream
+ */
+void BinaryFormatter::_reset() {
+    _started = false;
+    _names.clear();
+    _preambleIds.clear();
+    _preambles.clear();
+}
+
+/*
+ * write out a log record to a stream
+ * @param strm   the output stream to write the record to
+ * @param rec    the record to write
+ */
+void BinaryFormatter::write(std::ostream *strm, LogRecord const& rec) {
+    if (strm == 0) return;
+    FrameWriter out(_frame, _names);
+
+    if (! _started) {
+        _frame.clear();
+        out.putByte(HEADER);
+        _frame.append(MAGIC, 8);
+        out.putVarint(VERSION);
+        writeFrame(*strm, _frame);
+        _started = true;
+    }
+
+    CoreProps core(rec);
+    int flags = 0;
+    long long timestamp = 0;
+    if (rec.isCompact()) {
+        if (rec.hasTimestamp()) {
+            flags |= HAS_TIMESTAMP;
+            timestamp = rec.getTimestamp();
+        }
+        if (rec.hasDate()) flags |= HAS_DATE;
+        if (rec.hasLogName()) flags |= HAS_LOG;
+    }
+    else {
+        dafBase::DateTime ts;
+        if (LogRecord::tryGet(rec.data(), LSST_LP_TIMESTAMP, ts)) {
+            flags |= HAS_TIMESTAMP;
+            timestamp = ts.nsecs();
+        }
+        if (rec.data().exists(LSST_LP_DATE)) flags |= HAS_DATE;
+        if (rec.data().exists(LSST_LP_LOG)) flags |= HAS_LOG;
+    }
+
+    _frame.clear();
+    out.putByte(RECORD);
+    out.putByte(flags);
+    out.putSigned(core.level);
+    if (flags & HAS_TIMESTAMP) 
+        out.putFixed(static_cast<unsigned long long>(timestamp), 8);
+    if (flags & HAS_LOG) 
+        out.putName(*core.log);
+
+    // refer to the preamble, writing its properties if it is new
+    bool preambleWritten = false;
+    PreamblePtr const *preamble = 
+        (rec.isCompact() && rec.getPreamble()) ? &rec.getPreamble() : 0;
+    if (preamble) {
+        auto pi = _preambleIds.find(preamble->get());
+        if (pi != _preambleIds.end()) {
+            out.putVarint((pi->second << 1) + 2);
+            preambleWritten = true;
+        }
+        else if (_preambles.size() < MAX_PREAMBLES) {
+            unsigned long long id = _preambles.size();
+            _preambles.push_back(*preamble);
+            _preambleIds[preamble->get()] = id;
+            out.putVarint((id << 1) + 3);
+
+            // the count of values precedes them
+            std::size_t start = _frame.size();
+            out.count = 0;
+            std::vector<string> names = (*preamble)->paramNames(false);
+            for (auto const& name : names) {
+                if (! isSlotName(name)) 
+                    PropertyVisitor::visitValues(**preamble, name, out);
+            }
+            string values = _frame.substr(start);
+            _frame.resize(start);
+            out.putVarint(out.count);
+            _frame.append(values);
+            preambleWritten = true;
+        }
+    }
+    if (! preambleWritten) out.putVarint(0);
+
+    out.putVarint(core.commentsEnd - core.commentsBegin);
+    for (string const *vi = core.commentsBegin; vi != core.commentsEnd; ++vi)
+        out.putString(*vi);
+
+    // the remaining properties run to the end of the frame
+    rec.visitProperties(out, ! preambleWritten);
+
+    writeFrame(*strm, _frame);
+}
+
 //@endcond
 }}} // end lsst::pex::logging
-
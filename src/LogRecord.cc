@@ -25,19 +25,18 @@
  * @author Ray Plante
  */
 #include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Timestamp.h"
 #include "lsst/pex/exceptions.h"
 #include "lsst/daf/base/DateTime.h"
 
 #include <memory>
 #include <stdexcept>
-#include <time.h>
 
 namespace lsst {
 namespace pex {
 namespace logging {
 
 //@cond
-using boost::format;
 using std::string;
 using lsst::daf::base::DateTime;
 using lsst::daf::base::PropertySet;
@@ -52,7 +51,9 @@ namespace pexExcept = lsst::pex::exceptions;
  */
 LogRecord::LogRecord(int threshold, int importance, bool showAll)
     : _send(threshold <= importance), _showAll(showAll), _vol(importance), 
-      _data(new PropertySet())
+      _hasLogName(false), _hasTimestamp(false), _hasDate(false), 
+      _timestamp(0), _logName(), _preamble(), _comments(), _extras(), 
+      _cache(), _data()
 { 
     _init();
 }
@@ -72,76 +73,312 @@ LogRecord::LogRecord(int threshold, int importance, bool showAll)
 LogRecord::LogRecord(int threshold, int importance, const PropertySet& preamble,
                      bool showAll) 
     : _send(threshold <= importance), _showAll(showAll), _vol(importance),
-      _data()
+      _hasLogName(false), _hasTimestamp(false), _hasDate(false), 
+      _timestamp(0), _logName(), _preamble(), _comments(), _extras(), 
+      _cache(), _data()
 {
     if (_send) {
-        _data = preamble.deepCopy();
+        _preamble = preamble.deepCopy();
+
+        // a LOG in the preamble serves as the log name
+        if (_preamble->exists(LSST_LP_LOG)) {
+            try {
+                _logName = _preamble->get<string>(LSST_LP_LOG);
+                _hasLogName = true;
+            } catch (pexExcept::TypeError const &) {
+                // let the formatters deal with it
+                _expand();
+            }
+        }
     }
-    else {
-        _data = std::shared_ptr<PropertySet>(new PropertySet());
+    _init();
+}
+
+/*
+ * Create a log record to be sent to a given log, sharing the log's 
+ * preamble.  
+ */
+LogRecord::LogRecord(int threshold, int importance, 
+                     const std::shared_ptr<const PropertySet>& preamble,
+                     const string& logName, bool showAll) 
+    : _send(threshold <= importance), _showAll(showAll), _vol(importance),
+      _hasLogName(false), _hasTimestamp(false), _hasDate(false), 
+      _timestamp(0), _logName(), _preamble(), _comments(), _extras(), 
+      _cache(), _data()
+{
+    if (_send) {
+        _preamble = preamble;
+        _logName = logName;
+        _hasLogName = true;
     }
     _init();
 }
 
+/*
+ * create a copy of a record
+ */
+LogRecord::LogRecord(const LogRecord& that) 
+    : _send(that._send), _showAll(that._showAll), _vol(that._vol), 
+      _hasLogName(that._hasLogName), _hasTimestamp(that._hasTimestamp), 
+      _hasDate(that._hasDate), _timestamp(that._timestamp), 
+      _logName(that._logName), _preamble(that._preamble), 
+      _comments(that._comments), _extras(that._extras), _cache(), _data()
+{ 
+    if (that._data) _data = that._data->deepCopy();
+}   
+
+/*
+ * copy another record into this one.
+ */
+LogRecord& LogRecord::operator=(const LogRecord& that) {
+    if (this == &that) return *this;
+    _send = that._send; 
+    _showAll = that._showAll; 
+    _vol = that._vol; 
+    _hasLogName = that._hasLogName;
+    _hasTimestamp = that._hasTimestamp;
+    _hasDate = that._hasDate;
+    _timestamp = that._timestamp;
+    _logName = that._logName;
+    _preamble = that._preamble;
+    _comments = that._comments;
+    _extras = that._extras;
+    _cache.reset();
+    _data = that._data;
+    return *this;
+}
+
 /*
  * delete this log record
  */
 LogRecord::~LogRecord() { }
 
 long long LogRecord::utcnow() {
-    struct timeval tv;      
-    struct timezone tz;     
-    gettimeofday(&tv,&tz);
-    // _tv.tv_sec = seconds since the epoch
-    // _tv.tv_usec = microseconds since tv.tv_sec
+    return Timestamp::now();
+}
 
-    long long nsec = static_cast<long long>(tv.tv_sec) * 1000000000L;
-    nsec += tv.tv_usec * 1000L;
-    return nsec;
+string LogRecord::formatDate(long long nsecs) {
+    return Timestamp::format(nsecs);
 }
 
 void LogRecord::setTimestamp() {
-    _data->set(LSST_LP_TIMESTAMP, DateTime(utcnow(), DateTime::UTC));
+    if (_data) {
+        _data->set(LSST_LP_TIMESTAMP, DateTime(utcnow(), DateTime::UTC));
+    }
+    else {
+        _timestamp = utcnow();
+        _hasTimestamp = true;
+        _cache.reset();
+    }
+}
+
+void LogRecord::setTimestamp(long long nsecs) {
+    if (_data) {
+        _data->set(LSST_LP_TIMESTAMP, DateTime(nsecs, DateTime::UTC));
+        if (_data->exists(LSST_LP_DATE)) 
+            _data->set(LSST_LP_DATE, formatDate(nsecs));
+    }
+    else {
+        _timestamp = nsecs;
+        _hasTimestamp = true;
+        _cache.reset();
+    }
 }
 
 void LogRecord::setDate() {
     if (! _send) return;
+    if (! _data) {
+        if (! _hasTimestamp) setTimestamp();
+        _hasDate = true;
+        _cache.reset();
+        return;
+    }
     if (! data().exists(LSST_LP_TIMESTAMP)) setTimestamp();
 
-    char datestr[40];
-    struct timeval tv = _data->get<DateTime>(LSST_LP_TIMESTAMP).timeval(DateTime::UTC);
+    DateTime ts = _data->get<DateTime>(LSST_LP_TIMESTAMP);
+    data().add(LSST_LP_DATE, formatDate(ts.nsecs(DateTime::UTC)));
+}
 
-    struct tm timeinfo;
-    time_t secs = (time_t) tv.tv_sec;
-    gmtime_r(&secs, &timeinfo);
+bool LogRecord::tryGetLevel(int& value) const {
+    if (! _data) {
+        value = _vol;
+        return true;
+    }
+    return tryGet(*_data, LSST_LP_LEVEL, value);
+}
+
+bool LogRecord::tryGetLogName(string& value) const {
+    if (! _data) {
+        if (_hasLogName) {
+            value = _logName;
+            return true;
+        }
+        return _preamble && tryGet(*_preamble, LSST_LP_LOG, value);
+    }
+    return tryGet(*_data, LSST_LP_LOG, value);
+}
+
+bool LogRecord::tryGetLabel(string& value) const {
+    if (! _data) 
+        return _preamble && tryGet(*_preamble, LSST_LP_LABEL, value);
+    return tryGet(*_data, LSST_LP_LABEL, value);
+}
+
+bool LogRecord::tryGetDate(string& value) const {
+    if (! _data) {
+        if (! _hasDate) return false;
+        value = formatDate(_timestamp);
+        return true;
+    }
+    return tryGet(*_data, LSST_LP_DATE, value);
+}
 
-    if ( 0 == strftime(datestr,39,"%Y-%m-%dT%H:%M:%S.", &timeinfo) ) {
-        throw LSST_EXCEPT(pexExcept::RuntimeError, 
-                          "Failed to format time successfully");
+bool LogRecord::tryGetComments(std::vector<string>& value) const {
+    if (! _data) {
+        if (_comments.empty()) return false;
+        value.assign(_comments.begin(), _comments.end());
+        return true;
     }
-    
-    string fulldate(str(format("%s%d") % string(datestr) % tv.tv_usec));
-    data().add(LSST_LP_DATE, fulldate);
+    if (! _data->exists(LSST_LP_COMMENT) || 
+        _data->typeOf(LSST_LP_COMMENT) != typeid(string)) 
+        return false;
+    value = _data->getArray<string>(LSST_LP_COMMENT);
+    return true;
+}
+
+void LogRecord::visitProperties(PropertyVisitor& visitor, 
+                                bool withPreamble) const 
+{
+    if (_data) {
+        std::vector<string> names = _data->paramNames(false);
+        for (auto const& name : names) {
+            if (! _isSlotName(name)) 
+                PropertyVisitor::visitValues(*_data, name, visitor);
+        }
+        return;
+    }
+    if (_preamble && withPreamble) {
+        std::vector<string> names = _preamble->paramNames(false);
+        for (auto const& name : names) {
+            if (! _isSlotName(name)) 
+                PropertyVisitor::visitValues(*_preamble, name, visitor);
+        }
+    }
+    for (auto const& extra : _extras) 
+        (*extra.visit)(extra.name, extra.value, extra.adder, visitor);
 }
 
 size_t LogRecord::countParamValues() const {
+    const PropertySet& props = data();
     size_t sum = 0;
-    std::vector<std::string> names = _data->names(false);
+    std::vector<std::string> names = props.names(false);
     std::vector<std::string>::iterator it;
     for(it = names.begin(); it != names.end(); ++it) {
-        sum += _data->valueCount(*it);
+        sum += props.valueCount(*it);
     }
     return sum;
 }
 
 void LogRecord::addProperties(const PropertySet& props) {
+    if (! _send) return;
     PropertySet::Ptr temp(props.deepCopy());
     if (temp->exists("LEVEL")) temp->remove("LEVEL");
     if (temp->exists("LABEL")) temp->remove("LABEL");
     if (temp->exists("LOG")) temp->remove("LOG");
     if (temp->exists("TIMESTAMP")) temp->remove("TIMESTAMP");
     if (temp->exists("DATE")) temp->remove("DATE");
-    data().combine(temp);
+    if (_data || temp->exists(LSST_LP_COMMENT)) {
+        data().combine(temp);
+    }
+    else {
+        Extra extra;
+        extra.value = temp;
+        extra.adder = &LogRecord::_combineSet;
+        extra.visit = &LogRecord::_visitSet;
+        _extras.push_back(extra);
+        _cache.reset();
+    }
+}
+
+void LogRecord::_combineSet(PropertySet& set, const string&, 
+                            const boost::any& value) 
+{
+    set.combine(boost::any_cast<const PropertySet::Ptr&>(value));
+}
+
+void LogRecord::_visitSet(const string&, const boost::any& value, Adder, 
+                          PropertyVisitor& visitor) 
+{
+    PropertyVisitor::visitAll(*boost::any_cast<const PropertySet::Ptr&>(value),
+                              visitor);
+}
+
+/*
+ * visit a value of a type that PropertyVisitor does not support directly
+ * by way of a PropertySet, which knows how to fall back on a printer
+ */
+void LogRecord::_visitOther(const string& name, const boost::any& value, 
+                            Adder adder, PropertyVisitor& visitor) 
+{
+    PropertySet tmp;
+    (*adder)(tmp, name, value);
+    PropertyVisitor::visitValues(tmp, name, visitor);
+}
+
+/*
+ * return true if the given name is one whose value a compact record keeps
+ * in one of its fixed slots
+ */
+bool LogRecord::_isSlotName(const string& name) {
+    return (name == LSST_LP_COMMENT || name == LSST_LP_LOG || 
+            name == LSST_LP_LEVEL || name == LSST_LP_TIMESTAMP || 
+            name == LSST_LP_DATE);
+}
+
+/*
+ * return true if the given name is one that a compact record keeps in 
+ * one of its fixed slots (or must be able to find in its preamble)
+ */
+bool LogRecord::_isCoreName(const string& name) {
+    return (name == LSST_LP_COMMENT || name == LSST_LP_LOG || 
+            name == LSST_LP_LEVEL || name == LSST_LP_LABEL || 
+            name == LSST_LP_TIMESTAMP || name == LSST_LP_DATE);
+}
+
+/*
+ * build a PropertySet from the parts of a compact record
+ */
+PropertySet::Ptr LogRecord::_assemble() const {
+    PropertySet::Ptr out;
+    if (_preamble) 
+        out = _preamble->deepCopy();
+    else 
+        out.reset(new PropertySet());
+    if (! _send) return out;
+
+    if (_hasLogName) 
+        out->set(LSST_LP_LOG, _logName);
+    out->set(LSST_LP_LEVEL, _vol);
+    if (_hasTimestamp) 
+        out->set(LSST_LP_TIMESTAMP, DateTime(_timestamp, DateTime::UTC));
+    if (_hasDate) 
+        out->add(LSST_LP_DATE, formatDate(_timestamp));
+    for (auto const& comment : _comments) 
+        out->add(LSST_LP_COMMENT, comment);
+    for (auto const& extra : _extras) 
+        (*extra.adder)(*out, extra.name, extra.value);
+
+    return out;
+}
+
+/*
+ * convert this record from its compact form to one held in a PropertySet
+ */
+void LogRecord::_expand() {
+    _data = (_cache) ? _cache : _assemble();
+    _cache.reset();
+    _comments.clear();
+    _extras.clear();
 }
 
 //@endcond
@@ -0,0 +1,383 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file MmapFileDestination.cc
+ */
+#include "lsst/pex/logging/MmapFileDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/exceptions.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+namespace fs = boost::filesystem;
+namespace pexExcept = lsst::pex::exceptions;
+
+const std::size_t MmapFileDestination::DEFAULT_CHUNK_SIZE = 16*1024*1024;
+
+namespace {
+
+    // the most chunks a file may be mapped in (256 GiB at the default
+    // chunk size)
+    const std::size_t MAX_CHUNKS = 16384;
+
+    // the size of the blocks read while looking for the end of a log
+    const std::size_t SCAN_BLOCK = 64*1024;
+
+    // a buffer grown beyond this is released rather than kept
+    const std::size_t MAX_KEPT = 64*1024;
+
+    // the string each thread renders records into
+    struct Scratch {
+        Scratch() : text(), busy(false) { text.reserve(1024); }
+
+        std::string text;
+        bool busy;
+    };
+
+    thread_local Scratch scratch;
+
+    void fail(const std::string& what, const fs::path& path) {
+        throw LSST_EXCEPT(pexExcept::IoError,
+                          what + " " + path.string() + ": " +
+                          std::strerror(errno));
+    }
+
+    int openLog(const fs::path& path, int flags) {
+        int fd = ::open(path.string().c_str(), flags, 0644);
+        if (fd < 0) fail("Unable to open log file", path);
+        return fd;
+    }
+
+    /*
+     * trim the NUL bytes left at the end of a log by a process that did
+     * not unmap it, along with any incomplete last line.  A log that does
+     * not end in a NUL byte was closed properly and is left as it is.
+     * @return the length of the log that remains
+     */
+    off_t trimTail(int fd, const fs::path& path) {
+        struct stat st;
+        if (::fstat(fd, &st) != 0) fail("Unable to examine log file", path);
+        if (st.st_size == 0) return 0;
+
+        char last = '\0';
+        ssize_t got;
+        do {
+            got = ::pread(fd, &last, 1, st.st_size - 1);
+        } while (got < 0 && errno == EINTR);
+        if (got < 0) fail("Unable to read log file", path);
+        if (got == 1 && last != '\0') return st.st_size;
+
+        std::vector<char> block(SCAN_BLOCK);
+        bool inText = false;    // true once the last non-NUL byte is found
+        off_t length = 0;
+        off_t end = st.st_size;
+        while (end > 0 && length == 0) {
+            off_t start = (end > static_cast<off_t>(SCAN_BLOCK))
+                          ? end - static_cast<off_t>(SCAN_BLOCK) : 0;
+            std::size_t n = static_cast<std::size_t>(end - start);
+            ssize_t got = ::pread(fd, &block[0], n, start);
+            if (got < 0) {
+                if (errno == EINTR) continue;
+                fail("Unable to read log file", path);
+            }
+            if (static_cast<std::size_t>(got) < n) {
+                // the file shrank beneath us; start again from its end
+                end = start + got;
+                continue;
+            }
+
+            for(std::size_t i=n; i > 0 && length == 0; --i) {
+                char c = block[i-1];
+                if (! inText) inText = (c != '\0');
+                if (inText && c == '\n') length = start + i;
+            }
+            end = start;
+        }
+
+        if (length < st.st_size && ::ftruncate(fd, length) != 0)
+            fail("Unable to truncate log file", path);
+        return length;
+    }
+}
+
+/*
+ * the file behind a MmapFileDestination and the chunks of it that have
+ * been mapped into memory
+ */
+class MmapFileDestination::Mapping {
+public:
+    Mapping(int fd, const fs::path& path, std::size_t chunkSize)
+        : _fd(fd), _path(path), _chunkSize(chunkSize),
+          _chunks(new std::atomic<char*>[MAX_CHUNKS]), _mutex()
+    {
+        for(std::size_t i=0; i < MAX_CHUNKS; ++i) _chunks[i] = 0;
+    }
+
+    ~Mapping() {
+        _unmap();
+        ::close(_fd);
+    }
+
+    /*
+     * make sure that the chunks holding a range of bytes are mapped.  A
+     * pex::exceptions::IoError is thrown if one cannot be.
+     */
+    void prepare(unsigned long long offset, std::size_t len) {
+        std::size_t last = (offset + len - 1) / _chunkSize;
+        for(std::size_t i = offset / _chunkSize; i <= last; ++i) _chunk(i);
+    }
+
+    /*
+     * copy bytes into the file at a given offset, in chunks already
+     * mapped by prepare()
+     */
+    void copy(unsigned long long offset, const char *data, std::size_t len) {
+        while (len > 0) {
+            std::size_t index = offset / _chunkSize;
+            std::size_t within = offset % _chunkSize;
+            std::size_t n = std::min(len, _chunkSize - within);
+            std::memcpy(_chunk(index) + within, data, n);
+            offset += n;
+            data += n;
+            len -= n;
+        }
+    }
+
+    /*
+     * schedule the mapped chunks holding the first length bytes to be
+     * written back
+     */
+    void sync(unsigned long long length) {
+        std::size_t last = static_cast<std::size_t>(
+            std::min<unsigned long long>(length / _chunkSize, MAX_CHUNKS-1));
+        for(std::size_t i=0; i <= last; ++i) {
+            char *chunk = _chunks[i].load(std::memory_order_acquire);
+            if (chunk != 0) ::msync(chunk, _chunkSize, MS_ASYNC);
+        }
+    }
+
+    /*
+     * unmap the file and cut it back to the given length
+     */
+    void close(unsigned long long length) {
+        _unmap();
+        if (::ftruncate(_fd, static_cast<off_t>(length)) != 0)
+            fail("Unable to truncate log file", _path);
+    }
+
+private:
+    char *_chunk(std::size_t index) {
+        if (index >= MAX_CHUNKS)
+            throw LSST_EXCEPT(pexExcept::IoError,
+                              "Log file " + _path.string() +
+                              " has outgrown its chunk size");
+        char *chunk = _chunks[index].load(std::memory_order_acquire);
+        return (chunk != 0) ? chunk : _map(index);
+    }
+
+    // allocate the disk space for a chunk and map it, unless another
+    // thread already has.  The space is allocated for real (by writing
+    // zeros where fallocate(2) is unsupported) so that a full file system
+    // is reported here rather than by a SIGBUS when the page is touched.
+    char *_map(std::size_t index) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        char *chunk = _chunks[index].load(std::memory_order_relaxed);
+        if (chunk != 0) return chunk;
+
+        off_t start = static_cast<off_t>(index) * _chunkSize;
+        int rc = ::posix_fallocate(_fd, start,
+                                   static_cast<off_t>(_chunkSize));
+        if (rc != 0) {
+            errno = rc;
+            fail("Unable to extend log file", _path);
+        }
+
+        void *addr = ::mmap(0, _chunkSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, _fd, start);
+        if (addr == MAP_FAILED) fail("Unable to map log file", _path);
+        chunk = static_cast<char*>(addr);
+        _chunks[index].store(chunk, std::memory_order_release);
+        return chunk;
+    }
+
+    void _unmap() {
+        for(std::size_t i=0; i < MAX_CHUNKS; ++i) {
+            char *chunk = _chunks[i].exchange(0);
+            if (chunk != 0) ::munmap(chunk, _chunkSize);
+        }
+    }
+
+    int _fd;
+    fs::path _path;
+    std::size_t _chunkSize;
+    std::unique_ptr<std::atomic<char*>[]> _chunks;
+    std::mutex _mutex;      // held while mapping a chunk
+};
+
+MmapFileDestination::MmapFileDestination(
+    const fs::path& filepath, const std::shared_ptr<LogFormatter>& formatter,
+    int threshold, bool truncate, std::size_t chunkSize)
+    : LogDestination(0, formatter, threshold), _path(filepath),
+      _chunkSize(chunkSize), _end(0), _failures(0), _mapping()
+{
+    // chunks are mapped at offsets that must be page-aligned
+    std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    _chunkSize = std::max<std::size_t>((_chunkSize + page - 1) / page, 1)
+                 * page;
+
+    int fd = openLog(filepath, O_RDWR | O_CREAT | (truncate ? O_TRUNC : 0));
+    try {
+        _end = static_cast<unsigned long long>(trimTail(fd, filepath));
+        _mapping.reset(new Mapping(fd, filepath, _chunkSize));
+    }
+    catch (...) {
+        ::close(fd);
+        throw;
+    }
+}
+MmapFileDestination::MmapFileDestination(
+    const std::string& filepath,
+    const std::shared_ptr<LogFormatter>& formatter,
+    int threshold, bool truncate, std::size_t chunkSize)
+    : MmapFileDestination(fs::path(filepath), formatter, threshold, truncate,
+                          chunkSize)
+{ }
+MmapFileDestination::MmapFileDestination(
+    const char *filepath, const std::shared_ptr<LogFormatter>& formatter,
+    int threshold, bool truncate, std::size_t chunkSize)
+    : MmapFileDestination(fs::path(filepath), formatter, threshold, truncate,
+                          chunkSize)
+{ }
+
+MmapFileDestination::~MmapFileDestination() {
+    try {
+        _mapping->close(_end.load());
+    }
+    catch (...) { }
+}
+
+/*
+ * render a record and copy it into the file
+ */
+bool MmapFileDestination::write(const LogRecord& rec) {
+    if (_frmtr.get() == 0 || rec.getImportance() < _threshold)
+        return false;
+
+    Scratch& s = scratch;
+    if (s.busy) {
+        // a formatter is itself logging; render this one separately
+        std::string text;
+        _render(rec, text);
+        return _append(text);
+    }
+
+    s.busy = true;
+    s.text.clear();
+    try {
+        _render(rec, s.text);
+    }
+    catch (...) {
+        s.busy = false;
+        throw;
+    }
+    bool written = _append(s.text);
+    s.busy = false;
+    if (s.text.capacity() > MAX_KEPT) std::string().swap(s.text);
+    return written;
+}
+
+/*
+ * copy a record into the file, using the text already rendered by an
+ * equivalent formatter if there is one
+ */
+bool MmapFileDestination::write(RenderedRecord& rec) {
+    const LogRecord& record = rec.getRecord();
+    if (_frmtr.get() == 0 || record.getImportance() < _threshold)
+        return false;
+
+    return _append(rec.render(*_frmtr));
+}
+
+void MmapFileDestination::flush() {
+    _mapping->sync(_end.load());
+}
+
+/*
+ * claim the bytes for a record at the end of the log and copy it in.
+ * The bytes are only claimed once the chunks holding them are mapped, so
+ * that a failure to extend the file leaves no gap in it.
+ * @return  false if the file could not be extended
+ */
+bool MmapFileDestination::_append(const std::string& text) {
+    if (text.empty()) return true;
+    unsigned long long offset = _end.load();
+    try {
+        do {
+            _mapping->prepare(offset, text.size());
+        } while (! _end.compare_exchange_weak(offset, offset + text.size()));
+    }
+    catch (pexExcept::IoError&) {
+        ++_failures;
+        return false;
+    }
+    _mapping->copy(offset, text.data(), text.size());
+    return true;
+}
+
+/*
+ * trim a log file left behind by a process that did not delete its
+ * MmapFileDestination back to the end of its last complete line
+ */
+unsigned long long MmapFileDestination::recover(const fs::path& filepath) {
+    int fd = openLog(filepath, O_RDWR);
+    struct stat st;
+    off_t length = 0;
+    try {
+        if (::fstat(fd, &st) != 0)
+            fail("Unable to examine log file", filepath);
+        length = trimTail(fd, filepath);
+    }
+    catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+    return static_cast<unsigned long long>(st.st_size - length);
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
@@ -0,0 +1,185 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file NumberFormat.cc
+ */
+#include "lsst/pex/logging/NumberFormat.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <clocale>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+
+namespace {
+
+    // render an unsigned integer into the end of a character array,
+    // returning a pointer to the first digit
+    char *renderDigits(unsigned long long val, char *end) {
+        char *p = end;
+        do {
+            *--p = char('0' + val % 10);
+            val /= 10;
+        } while (val != 0);
+        return p;
+    }
+
+    char *copyDigits(const char *start, const char *end, char *out) {
+        std::memcpy(out, start, end - start);
+        return out + (end - start);
+    }
+
+    /*
+     * copy a number rendered by printf into out, replacing the locale's
+     * decimal point with '.'
+     */
+    char *copyRendered(const char *buf, int len, char *out) {
+        const char *point = std::localeconv()->decimal_point;
+        if (point[0] == '.' && point[1] == '\0') 
+            return copyDigits(buf, buf + len, out);
+
+        std::size_t plen = std::strlen(point);
+        const char *found = (plen > 0) ? std::strstr(buf, point) : 0;
+        if (found == 0) return copyDigits(buf, buf + len, out);
+        out = copyDigits(buf, found, out);
+        *out++ = '.';
+        return copyDigits(found + plen, buf + len, out);
+    }
+
+    double readBack(const char *buf, double) { return std::strtod(buf, 0); }
+    float readBack(const char *buf, float) { return std::strtof(buf, 0); }
+
+    /*
+     * render a floating-point value with the fewest significant digits,
+     * starting from minDigits, that read back as the same value.  
+     * Values are read back in the same (current) locale in which 
+     * printf rendered them.
+     */
+    template <class T>
+    char *renderShortest(T val, int minDigits, int maxDigits, char *out) {
+        char buf[NumberFormat::MAX_LENGTH];
+        int len = 0;
+        for (int digits = minDigits; digits <= maxDigits; ++digits) {
+            len = std::snprintf(buf, sizeof(buf), "%.*g", digits, 
+                                static_cast<double>(val));
+            if (digits == maxDigits) break;
+            if (readBack(buf, val) == val) break;
+        }
+        return copyRendered(buf, len, out);
+    }
+
+    /*
+     * render a value of the form r / 10^k, for an integer r of at most 
+     * maxDigits digits (15 for doubles, 6 for floats), that lies in
+     * [1e-4, 10^maxDigits), without printf:  r is found from the fewest
+     * decimal places for which r / 10^k, computed exactly rounded from 
+     * exact operands, is the value itself--just as reading the decimal
+     * number back would compute it.  As no two decimal numbers of so few 
+     * digits read back as the same value, this is the number that 
+     * renderShortest() would find.  Returns 0 if the value is not of this
+     * form.
+     */
+    template <class T>
+    char *renderDecimal(T val, int maxDigits, char *out) {
+        static const T powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+                                    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 
+                                    1e15 };
+        T mag = std::fabs(val);
+        if (! (mag >= T(1e-4) && mag < powers[maxDigits])) return 0;
+
+        for (int k = 1; k <= maxDigits; ++k) {
+            T r = std::floor(mag * powers[k] + T(0.5));
+            if (r >= powers[maxDigits]) return 0;
+            if (r / powers[k] != mag) continue;
+
+            unsigned long long digits = static_cast<unsigned long long>(r);
+            unsigned long long scale = 
+                static_cast<unsigned long long>(powers[k]);
+            if (val < 0) *out++ = '-';
+            char buf[NumberFormat::MAX_LENGTH];
+            char *end = buf + sizeof(buf);
+            out = copyDigits(renderDigits(digits / scale, end), end, out);
+            *out++ = '.';
+            char *start = renderDigits(digits % scale, end);
+            while (end - start < k) *--start = '0';
+            return copyDigits(start, end, out);
+        }
+        return 0;
+    }
+}
+
+const std::size_t NumberFormat::MAX_LENGTH;
+
+char *NumberFormat::format(long long val, char *out) {
+    char digits[MAX_LENGTH];
+    char *end = digits + sizeof(digits);
+    char *start;
+    if (val < 0) {
+        start = renderDigits(0ULL - static_cast<unsigned long long>(val), end);
+        *--start = '-';
+    }
+    else {
+        start = renderDigits(static_cast<unsigned long long>(val), end);
+    }
+    return copyDigits(start, end, out);
+}
+
+char *NumberFormat::format(unsigned long long val, char *out) {
+    char digits[MAX_LENGTH];
+    char *end = digits + sizeof(digits);
+    return copyDigits(renderDigits(val, end), end, out);
+}
+
+/*
+ * whole numbers of fewer digits than %g would write in exponential form
+ * are written directly as integers, and short decimal fractions directly
+ * as such; other values are rendered with 15, 16, or 17 significant 
+ * digits, whichever is the fewest that round-trip.  (Any shorter 
+ * representation that round-trips is what 15 digits yields once %g drops
+ * its trailing zeros.)
+ */
+char *NumberFormat::format(double val, char *out) {
+    if (val == std::floor(val) && std::fabs(val) < 1e15 && 
+        ! (val == 0 && std::signbit(val)))
+        return format(static_cast<long long>(val), out);
+    char *end = renderDecimal(val, 15, out);
+    return (end != 0) ? end : renderShortest(val, 15, 17, out);
+}
+
+char *NumberFormat::format(float val, char *out) {
+    if (val == std::floor(val) && std::fabs(val) < 1e6f && 
+        ! (val == 0 && std::signbit(val)))
+        return format(static_cast<long long>(val), out);
+    char *end = renderDecimal(val, 6, out);
+    return (end != 0) ? end : renderShortest(val, 6, 9, out);
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
@@ -25,6 +25,7 @@
  * @author Ray Plante
  */
 #include "lsst/pex/logging/PropertyPrinter.h"
+#include "lsst/pex/logging/PropertyVisitor.h"
 #include "lsst/daf/base/DateTime.h"
 #include <boost/any.hpp>
 
@@ -67,7 +68,7 @@ PrinterList::~PrinterList() { }
 DateTimePrinterIter::~DateTimePrinterIter() { }
 
 std::ostream& DateTimePrinterIter::write(std::ostream *strm) const {
-    (*strm) << _it->nsecs();
+    NumberFormat::write(*strm, _it->nsecs());
     return *strm;
 }
 
@@ -116,7 +117,59 @@ PrinterList* makeBoolPrinter(const PropertySet& prop,
     return new BoolPrinterList(prop, name);
 }
 
-#define PF_ADD(T)  add(typeid(T), &lsst::pex::logging::makePrinter<T>)
+namespace {
+
+    // collects the rendered values of a property
+    class StringCollector : public PropertyVisitor {
+    public:
+        explicit StringCollector(vector<std::string>& values) 
+            : _values(values) { }
+        virtual void visit(const std::string&, const PropertyValue& value, 
+                           std::size_t) 
+        {
+            std::ostringstream strm;
+            value.write(strm);
+            _values.push_back(strm.str());
+        }
+    private:
+        vector<std::string>& _values;
+    };
+
+    // a list of values already rendered into strings
+    class VisitedPrinterList : public PrinterList {
+    public:
+        VisitedPrinterList(const PropertySet& prop, const std::string& name)
+            : _list()
+        {
+            StringCollector collector(_list);
+            PropertyVisitor::visitValues(prop, name, collector);
+        }
+
+        virtual iterator begin() const {
+            return iterator(std::make_shared<Iter>(_list.begin(), 
+                                                   _list.begin(), 
+                                                   _list.end()));
+        }
+        virtual iterator last() const {
+            return iterator(std::make_shared<Iter>(_list.end()-1, 
+                                                   _list.begin(), 
+                                                   _list.end()));
+        }
+        virtual size_t valueCount() const { return _list.size(); }
+
+    private:
+        typedef TmplPrinterIter<std::string> Iter;
+        vector<std::string> _list;
+    };
+}
+
+PrinterList* makeVisitedPrinter(const PropertySet& prop, 
+                                const std::string& name) 
+{
+    return new VisitedPrinterList(prop, name);
+}
+
+#define PF_ADD(T)  add(typeid(T), &makeVisitedPrinter)
 
 void PrinterFactory::_loadDefaults() {
     PF_ADD(short);
@@ -129,8 +182,8 @@ void PrinterFactory::_loadDefaults() {
     PF_ADD(signed char);
     PF_ADD(unsigned char);
     PF_ADD(std::string);
-    add(typeid(bool), makeBoolPrinter);
-    add(typeid(DateTime), makeDateTimePrinter);
+    PF_ADD(bool);
+    PF_ADD(DateTime);
 }
 
 PrinterFactory PropertyPrinter::defaultPrinterFactory(true);
@@ -140,10 +193,12 @@ PropertyPrinter::PropertyPrinter(const PropertySet& prop,
                                  const PrinterFactory& fact) 
     : _list(fact.makePrinter(prop, name)) 
 {
+    if (_list.get() == 0 && PropertyVisitor::isSupported(prop.typeOf(name)))
+        _list.reset(makeVisitedPrinter(prop, name));
     if (_list.get() == 0) {
         PropertySet tmp;
         tmp.set(name, "<unprintable>");
-        _list = std::shared_ptr<PrinterList>(fact.makePrinter(tmp, name));
+        _list.reset(makeVisitedPrinter(tmp, name));
     }
 }
  
@@ -0,0 +1,165 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file PropertyVisitor.cc
+ */
+#include "lsst/pex/logging/PropertyVisitor.h"
+#include "lsst/pex/logging/PropertyPrinter.h"
+#include "lsst/daf/base/DateTime.h"
+
+#include <memory>
+#include <mutex>
+#include <typeindex>
+#include <unordered_map>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+using lsst::daf::base::PropertySet;
+using lsst::daf::base::DateTime;
+
+namespace {
+
+    struct Handler {
+        void (*walk)(const PropertySet&, const std::string&, 
+                     PropertyVisitor&, PropertyValue::Writer);
+        PropertyValue::Writer write;
+    };
+
+    typedef std::unordered_map<std::type_index, Handler> HandlerTable;
+
+    // the table of supported types; PropertyVisitor::_loadDefaults() is
+    // called once to fill in the defaults before it is first used
+    HandlerTable& table() {
+        static HandlerTable handlers;
+        return handlers;
+    }
+
+    std::once_flag defaultsLoaded;
+
+    void insert(const std::type_info& type, 
+                void (*walk)(const PropertySet&, const std::string&, 
+                             PropertyVisitor&, PropertyValue::Writer),
+                PropertyValue::Writer write) 
+    {
+        Handler handler = { walk, write };
+        table()[std::type_index(type)] = handler;
+    }
+
+    void writeBool(std::ostream& strm, const void *value) {
+        strm << ((*static_cast<const bool*>(value)) ? "true" : "false");
+    }
+
+    void writeDateTime(std::ostream& strm, const void *value) {
+        NumberFormat::write(strm, static_cast<const DateTime*>(value)->nsecs());
+    }
+
+    const std::string unprintable("<unprintable>");
+}
+
+PropertyVisitor::~PropertyVisitor() { }
+
+#define PV_ADD(T, W)  insert(typeid(T), &_walk<T>, W)
+
+void PropertyVisitor::_loadDefaults() {
+    PV_ADD(short, &writeValue<short>);
+    PV_ADD(int, &writeValue<int>);
+    PV_ADD(long, &writeValue<long>);
+    PV_ADD(long long, &writeValue<long long>);
+    PV_ADD(float, &writeValue<float>);
+    PV_ADD(double, &writeValue<double>);
+    PV_ADD(char, &writeValue<char>);
+    PV_ADD(signed char, &writeValue<signed char>);
+    PV_ADD(unsigned char, &writeValue<unsigned char>);
+    PV_ADD(std::string, &writeValue<std::string>);
+    PV_ADD(bool, &writeBool);
+    PV_ADD(DateTime, &writeDateTime);
+}
+
+#undef PV_ADD
+
+void PropertyVisitor::_addType(const std::type_info& type, Walker walker,
+                               PropertyValue::Writer writer)
+{
+    std::call_once(defaultsLoaded, &PropertyVisitor::_loadDefaults);
+    insert(type, walker, writer);
+}
+
+bool PropertyVisitor::isSupported(const std::type_info& type) {
+    std::call_once(defaultsLoaded, &PropertyVisitor::_loadDefaults);
+    HandlerTable& handlers = table();
+    return handlers.find(std::type_index(type)) != handlers.end();
+}
+
+PropertyValue::Writer PropertyVisitor::getWriter(const std::type_info& type) {
+    std::call_once(defaultsLoaded, &PropertyVisitor::_loadDefaults);
+    HandlerTable& handlers = table();
+    HandlerTable::const_iterator hi = handlers.find(std::type_index(type));
+    return (hi == handlers.end()) ? 0 : hi->second.write;
+}
+
+void PropertyVisitor::visitValues(const PropertySet& props, 
+                                  const std::string& name, 
+                                  PropertyVisitor& visitor)
+{
+    std::call_once(defaultsLoaded, &PropertyVisitor::_loadDefaults);
+    HandlerTable& handlers = table();
+    HandlerTable::const_iterator hi = 
+        handlers.find(std::type_index(props.typeOf(name)));
+    if (hi == handlers.end()) {
+        // a type may have been added to PropertyPrinter alone
+        std::unique_ptr<PrinterList> 
+            printers(PropertyPrinter::defaultPrinterFactory.makePrinter(props,
+                                                                        name));
+        if (printers.get() == 0) {
+            visitor.visit(name, PropertyValue(typeid(std::string), 
+                                              &unprintable,
+                                              &writeValue<std::string>), 0);
+            return;
+        }
+        std::size_t index = 0;
+        for (PrinterList::iterator pi = printers->begin(); pi.notAtEnd(); ++pi)
+        {
+            const std::string value = *pi;
+            visitor.visit(name, PropertyValue(typeid(std::string), &value,
+                                              &writeValue<std::string>), 
+                          index++);
+        }
+        return;
+    }
+    (*hi->second.walk)(props, name, visitor, hi->second.write);
+}
+
+void PropertyVisitor::visitAll(const PropertySet& props, 
+                               PropertyVisitor& visitor, bool topLevelOnly)
+{
+    std::vector<std::string> names = props.paramNames(topLevelOnly);
+    for (auto const& name : names) 
+        visitValues(props, name, visitor);
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
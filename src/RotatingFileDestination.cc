@@ -0,0 +1,335 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file RotatingFileDestination.cc
+ */
+#include "lsst/pex/logging/RotatingFileDestination.h"
+#include "lsst/pex/logging/Timestamp.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+namespace fs = boost::filesystem;
+
+namespace {
+
+    // the name of an old file
+    fs::path generation(const fs::path& path, unsigned int gen,
+                        bool compressed)
+    {
+        std::ostringstream name;
+        name << path.string() << '.' << gen;
+        if (compressed) name << ".gz";
+        return fs::path(name.str());
+    }
+
+    // make room for a new ".1" file by shifting the old ones along and
+    // removing the oldest
+    void shiftGenerations(const fs::path& path, unsigned int keep,
+                          bool compressed)
+    {
+        boost::system::error_code ec;
+        fs::remove(generation(path, keep, compressed), ec);
+        for(unsigned int gen = keep-1; gen > 0; --gen) {
+            fs::path from = generation(path, gen, compressed);
+            if (fs::exists(from, ec))
+                fs::rename(from, generation(path, gen+1, compressed), ec);
+        }
+    }
+
+    // gzip one file into another
+    bool compressFile(const fs::path& from, const fs::path& to) {
+        std::ifstream in(from.string().c_str(), std::ios::binary);
+        if (! in) return false;
+        gzFile out = gzopen(to.string().c_str(), "wb6");
+        if (out == 0) return false;
+
+        std::vector<char> buf(64*1024);
+        bool ok = true;
+        while (ok && in) {
+            in.read(&buf[0], buf.size());
+            int n = static_cast<int>(in.gcount());
+            if (n > 0 && gzwrite(out, &buf[0], n) != n) ok = false;
+        }
+        if (gzclose(out) != Z_OK) ok = false;
+        return ok && ! in.bad();
+    }
+}
+
+/*
+ * the stream buffer behind a RotatingFileDestination.  LogDestination
+ * hands each record to its stream in a single write, so the buffer can
+ * decide before each write whether to start a new file.
+ */
+class RotatingFileDestination::RotatingBuffer : public std::streambuf {
+public:
+    RotatingBuffer(const fs::path& path, const RotationPolicy& policy)
+        : path(path), policy(policy), _file(), _size(0), _nextRotation(0),
+          _staged(0), _held(), _mutex(), _ready(), _done(), _jobs(),
+          _stopping(false), _thread()
+    {
+        _open(std::ios::app);
+    }
+
+    ~RotatingBuffer() {
+        _file.close();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _ready.notify_one();
+        if (_thread.joinable()) _thread.join();
+    }
+
+    unsigned long long getSize() const { return _size; }
+
+    void rotate() {
+        _file.close();
+        unsigned int keep = policy.getKeep();
+        boost::system::error_code ec;
+        if (keep == 0) {
+            fs::remove(path, ec);
+        }
+        else if (policy.isCompressed()) {
+            // hold the file under a new name until it is compressed
+            fs::path staged;
+            do {
+                std::ostringstream name;
+                name << path.string() << ".rotated-" << ++_staged;
+                staged = name.str();
+            } while (fs::exists(staged, ec));
+            fs::rename(path, staged, ec);
+            if (! ec) _queue(staged);
+        }
+        else {
+            shiftGenerations(path, keep, false);
+            fs::rename(path, generation(path, 1, false), ec);
+        }
+
+        // a file that could not be moved aside is kept rather than emptied
+        _open(ec ? std::ios::app : std::ios::trunc);
+    }
+
+    void reopen() {
+        _file.close();
+        _open(std::ios::app);
+    }
+
+    // true if a record of n bytes should go to a new file
+    bool isDue(std::size_t n) const {
+        if (policy.getBytes() > 0 && _size > 0 &&
+            _size + n > policy.getBytes())
+          return true;
+        return (policy.getSeconds() > 0 && Timestamp::now() >= _nextRotation);
+    }
+
+    void waitForCompression() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (! _jobs.empty()) _done.wait(lock);
+    }
+
+    const fs::path path;
+    const RotationPolicy policy;
+
+protected:
+    virtual std::streamsize xsputn(const char *s, std::streamsize n) {
+        std::streamsize put = _file.sputn(s, n);
+        _size += put;
+        return put;
+    }
+
+    virtual int_type overflow(int_type c) {
+        if (traits_type::eq_int_type(c, traits_type::eof()))
+            return traits_type::not_eof(c);
+        char ch = traits_type::to_char_type(c);
+        return (xsputn(&ch, 1) == 1) ? c : traits_type::eof();
+    }
+
+    virtual int sync() { return _file.pubsync(); }
+
+private:
+    void _open(std::ios::openmode mode) {
+        _file.open(path.string().c_str(), std::ios::out | mode);
+        boost::system::error_code ec;
+        _size = fs::file_size(path, ec);
+        if (ec) _size = 0;
+        if (policy.getSeconds() > 0) {
+            long long interval = policy.getSeconds() * 1000000000LL;
+            _nextRotation = (Timestamp::now() / interval + 1) * interval;
+        }
+    }
+
+    void _queue(const fs::path& staged) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _jobs.push_back(staged);
+        if (! _thread.joinable())
+            _thread = std::thread(&RotatingBuffer::_run, this);
+        _ready.notify_one();
+    }
+
+    // compress a staged file and make it the ".1.gz" file, shifting the
+    // others along only once that has worked
+    bool _compress(const fs::path& staged) {
+        fs::path partial(staged.string() + ".gz.tmp");
+        boost::system::error_code ec;
+        if (! compressFile(staged, partial)) {
+            fs::remove(partial, ec);
+            return false;
+        }
+        shiftGenerations(path, policy.getKeep(), true);
+        fs::rename(partial, generation(path, 1, true), ec);
+        fs::remove(staged, ec);
+        return true;
+    }
+
+    // the body of the compression thread.  A file that cannot be 
+    // compressed is kept under its staged name and tried again, ahead of
+    // the files staged after it, when the next one is queued.
+    void _run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            while (_jobs.empty() && ! _stopping) _ready.wait(lock);
+            if (_jobs.empty()) break;
+            _held.push_back(_jobs.front());
+            lock.unlock();
+
+            while (! _held.empty() && _compress(_held.front())) 
+                _held.pop_front();
+
+            lock.lock();
+            _jobs.pop_front();
+            _done.notify_all();
+        }
+    }
+
+    std::filebuf _file;
+    unsigned long long _size;
+    long long _nextRotation;        // when to rotate, in UTC nanosecs
+    unsigned long _staged;          // files held for compression so far
+    std::deque<fs::path> _held;     // staged files not yet compressed,
+                                    //   oldest first; used by the thread
+
+    std::mutex _mutex;
+    std::condition_variable _ready;
+    std::condition_variable _done;
+    std::deque<fs::path> _jobs;     // files waiting to be compressed
+    bool _stopping;
+    std::thread _thread;
+};
+
+const unsigned int RotationPolicy::DEFAULT_KEEP;
+
+RotatingFileDestination::RotatingFileDestination(
+    const fs::path& filepath, const std::shared_ptr<LogFormatter>& formatter,
+    const RotationPolicy& policy, int threshold)
+    : LogDestination(0, formatter, threshold),
+      _buffer(new RotatingBuffer(filepath, policy))
+{
+    _strm = new std::ostream(_buffer.get());
+}
+RotatingFileDestination::RotatingFileDestination(
+    const std::string& filepath,
+    const std::shared_ptr<LogFormatter>& formatter,
+    const RotationPolicy& policy, int threshold)
+    : RotatingFileDestination(fs::path(filepath), formatter, policy,
+                              threshold)
+{ }
+RotatingFileDestination::RotatingFileDestination(
+    const char *filepath, const std::shared_ptr<LogFormatter>& formatter,
+    const RotationPolicy& policy, int threshold)
+    : RotatingFileDestination(fs::path(filepath), formatter, policy,
+                              threshold)
+{ }
+
+RotatingFileDestination::~RotatingFileDestination() {
+    try {
+        _strm->flush();
+    }
+    catch (...) { }
+    delete _strm;
+    _strm = 0;
+}
+
+const fs::path& RotatingFileDestination::getPath() const {
+    return _buffer->path;
+}
+
+const RotationPolicy& RotatingFileDestination::getRotationPolicy() const {
+    return _buffer->policy;
+}
+
+unsigned long long RotatingFileDestination::getSize() const {
+    return _buffer->getSize();
+}
+
+void RotatingFileDestination::rotate() {
+    flush();
+    _buffer->rotate();
+    if (_frmtr.get() != 0) _frmtr->startStream();
+}
+
+void RotatingFileDestination::reopen() {
+    flush();
+    _buffer->reopen();
+    if (_frmtr.get() != 0) _frmtr->startStream();
+}
+
+/*
+ * write a rendered record, first starting a new file if the policy calls
+ * for it.  The record was rendered for the old file, so it is rendered
+ * again for the new one.
+ */
+void RotatingFileDestination::_put(const LogRecord& rec,
+                                   const std::string& text)
+{
+    if (! _buffer->isDue(text.size())) {
+        LogDestination::_put(rec, text);
+        return;
+    }
+
+    rotate();
+    std::string fresh;
+    _render(rec, fresh);
+    LogDestination::_put(rec, fresh);
+}
+
+void RotatingFileDestination::waitForCompression() {
+    _buffer->waitForCompression();
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
@@ -60,7 +60,9 @@ ScreenLog::ScreenLog(const PropertySet& preamble, bool verbose, int threshold)
     : Log(threshold), _screen(0), _screenFrmtr(0)
 {
     configure(verbose);
+    _unsharePreamble();
     _preamble->combine(preamble.deepCopy());
+    if (_preamble->exists(LSST_LP_LOG)) _preamble->remove(LSST_LP_LOG);
 }
 
 /*
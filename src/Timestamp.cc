@@ -0,0 +1,130 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @file Timestamp.cc
+ */
+#include "lsst/pex/logging/Timestamp.h"
+
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <time.h>
+
+namespace lsst {
+namespace pex {
+namespace logging {
+
+//@cond
+
+namespace {
+
+    std::atomic<int> clockInUse(Timestamp::PRECISE);
+
+    // the length of "YYYY-MM-DDTHH:MM:SS."
+    const std::size_t PREFIX_LENGTH = 20;
+
+    // the prefix of the last second formatted by a thread
+    struct PrefixCache {
+        PrefixCache() : secs(LLONG_MIN) { }
+        long long secs;
+        char prefix[PREFIX_LENGTH];
+    };
+
+    thread_local PrefixCache prefixCache;
+
+    // write a zero-padded number of a given width, returning a pointer
+    // just past it
+    char *writeDigits(long val, int width, char *out) {
+        for(int i=width-1; i >= 0; --i) {
+            out[i] = char('0' + val % 10);
+            val /= 10;
+        }
+        return out + width;
+    }
+
+    void makePrefix(long long secs, char *out) {
+        time_t t = static_cast<time_t>(secs);
+        struct tm tm;
+        gmtime_r(&t, &tm);
+
+        // years outside 0-9999 are not representable in this format
+        long year = tm.tm_year + 1900L;
+        if (year < 0) year = 0;
+        out = writeDigits(year % 10000, 4, out);
+        *out++ = '-';
+        out = writeDigits(tm.tm_mon + 1, 2, out);
+        *out++ = '-';
+        out = writeDigits(tm.tm_mday, 2, out);
+        *out++ = 'T';
+        out = writeDigits(tm.tm_hour, 2, out);
+        *out++ = ':';
+        out = writeDigits(tm.tm_min, 2, out);
+        *out++ = ':';
+        out = writeDigits(tm.tm_sec, 2, out);
+        *out++ = '.';
+    }
+}
+
+const std::size_t Timestamp::LENGTH;
+
+long long Timestamp::now() {
+    struct timespec ts;
+#ifdef CLOCK_REALTIME_COARSE
+    if (clockInUse.load(std::memory_order_relaxed) == COARSE)
+        clock_gettime(CLOCK_REALTIME_COARSE, &ts);
+    else
+#endif
+        clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+void Timestamp::setClock(Clock clock) {
+    clockInUse.store(clock, std::memory_order_relaxed);
+}
+
+Timestamp::Clock Timestamp::getClock() {
+    return static_cast<Clock>(clockInUse.load(std::memory_order_relaxed));
+}
+
+char *Timestamp::format(long long nsecs, char *out) {
+    // split into seconds and microseconds, rounding toward the past
+    long long secs = nsecs / 1000000000LL;
+    long long frac = nsecs % 1000000000LL;
+    if (frac < 0) {
+        frac += 1000000000LL;
+        --secs;
+    }
+
+    PrefixCache& cache = prefixCache;
+    if (cache.secs != secs) {
+        makePrefix(secs, cache.prefix);
+        cache.secs = secs;
+    }
+    std::memcpy(out, cache.prefix, PREFIX_LENGTH);
+    return writeDigits(static_cast<long>(frac / 1000), 6,
+                       out + PREFIX_LENGTH);
+}
+
+//@endcond
+
+}}} // end lsst::pex::logging
@@ -29,6 +29,7 @@
 
 #include "lsst/pex/logging/threshold/Memory.h"
 #include <boost/tokenizer.hpp>
+#include <algorithm>
 #include <ostream>
 
 using namespace std;
@@ -168,22 +169,272 @@ void Family::printDescThresholds(std::ostream& out,
 
 /* ******************************************************************* */
 
+std::atomic<unsigned int> Memory::_generation(1);
+
 Memory::Memory(const std::string& delims) 
-    : _tree(), _sep(delims.c_str())
-{ }
+    : _root("", 0, 0, static_cast<size_t>(14695981039346656037ULL)), 
+      _nodes(), _indexes(), _index(0), _remembered(0), _mutex()
+{ 
+    for(int i=0; i < 256; ++i) _isDelim[i] = false;
+    for(string::const_iterator it=delims.begin(); it != delims.end(); ++it)
+        _isDelim[static_cast<unsigned char>(*it)] = true;
+
+    _publish(new Index(16));
+}
+
+Memory::Index::Index(size_t size) 
+    : mask(size-1), count(0), slots(new std::atomic<const Node*>[size])
+{
+    for(size_t i=0; i < size; ++i) 
+        slots[i].store(0, std::memory_order_relaxed);
+}
+
+/*
+ * make a new hash table the one used by lookups.  The mutex must be held
+ * (except during construction).
+ */
+void Memory::_publish(Index *index) {
+    _indexes.push_back(unique_ptr<Index>(index));
+    _index.store(index, std::memory_order_release);
+}
+
+/*
+ * compute the hash table key for a field of a name given its parent.
+ * This is an FNV-1a hash seeded with the parent's hash.
+ */
+size_t Memory::_hash(const Node *parent, const char *field, size_t length) {
+    const size_t prime = static_cast<size_t>(1099511628211ULL);
+    size_t h = parent->hash;
+    for(size_t i=0; i < length; ++i) {
+        h ^= static_cast<unsigned char>(field[i]);
+        h *= prime;
+    }
+    h ^= length;
+    h *= prime;
+    return h;
+}
+
+/*
+ * advance pos past the next field in a name.  field is set to the start 
+ * of that field.  False is returned if there are no more fields.  
+ */
+bool Memory::_nextField(const char*& pos, const char *end, 
+                        const char*& field) const 
+{
+    while (pos != end && _isDelim[static_cast<unsigned char>(*pos)]) ++pos;
+    if (pos == end) return false;
+    field = pos;
+    while (pos != end && ! _isDelim[static_cast<unsigned char>(*pos)]) ++pos;
+    return true;
+}
+
+/*
+ * return the node for the named child of a given parent or null if it 
+ * does not exist.
+ */
+const Memory::Node *Memory::_findChild(const Index& index, const Node *parent,
+                                       size_t hash, const char *field, 
+                                       size_t length) 
+{
+    size_t i = hash & index.mask;
+    const Node *node;
+    while ((node = index.slots[i].load(std::memory_order_acquire)) != 0) {
+        if (node->hash == hash && node->parent == parent && 
+            node->field.length() == length && 
+            node->field.compare(0, length, field, length) == 0)
+        {
+            return node;
+        }
+        i = (i+1) & index.mask;
+    }
+    return 0;
+}
+
+/*
+ * add a node to the hash table, replacing the table with a larger one 
+ * as necessary to keep it no more than half full.  The mutex must be held.
+ */
+void Memory::_insert(const Node *node) {
+    const Index *current = _index.load(std::memory_order_relaxed);
+    if (2*(current->count+1) > current->mask+1) {
+        Index *bigger = new Index(2*(current->mask+1));
+        for(size_t j=0; j <= current->mask; ++j) {
+            const Node *old = current->slots[j].load(std::memory_order_relaxed);
+            if (old == 0) continue;
+            size_t i = old->hash & bigger->mask;
+            while (bigger->slots[i].load(std::memory_order_relaxed) != 0) 
+                i = (i+1) & bigger->mask;
+            bigger->slots[i].store(old, std::memory_order_relaxed);
+        }
+        bigger->count = current->count;
+        _publish(bigger);
+    }
+
+    Index *index = _indexes.back().get();
+    size_t i = node->hash & index->mask;
+    while (index->slots[i].load(std::memory_order_relaxed) != 0) 
+        i = (i+1) & index->mask;
+    index->slots[i].store(node, std::memory_order_release);
+    ++index->count;
+}
+
+/*
+ * return the node for a given name.  If it does not exist, it (and its 
+ * missing ancestors) will be created if create is true; otherwise, null
+ * is returned.  When create is true, forgotten nodes along the way are 
+ * remembered again.  The root is returned for a name with no fields.  
+ * The mutex must be held.
+ */
+Memory::Node *Memory::_findNode(const string& name, bool create) {
+    const char *pos = name.data(), *end = pos + name.length(), *field = 0;
+    Node *node = &_root;
+    while (_nextField(pos, end, field)) {
+        size_t length = pos - field;
+        size_t hash = _hash(node, field, length);
+        const Index& index = *_index.load(std::memory_order_relaxed);
+        Node *child = 
+            const_cast<Node*>(_findChild(index, node, hash, field, length));
+        if (child == 0) {
+            if (! create) return 0;
+            _nodes.emplace_back(field, length, node, hash);
+            child = &_nodes.back();
+            _insert(child);
+            ++_remembered;
+        }
+        else if (create && ! child->remembered) {
+            child->remembered = true;
+            ++_remembered;
+        }
+        node = child;
+    }
+    return node;
+}
+
+/*
+ * return the threshold value associated with a given name.  This is 
+ * the threshold of the nearest ancestor (or the name itself) that 
+ * has not been set to INHERIT.
+ */
+int Memory::getThresholdFor(const char *name, size_t length) const {
+    const Index& index = *_index.load(std::memory_order_acquire);
+    int out = _root.thresh.load(std::memory_order_relaxed);
+    const char *pos = name, *end = name + length, *field = 0;
+    const Node *node = &_root;
+    while (_nextField(pos, end, field)) {
+        size_t flen = pos - field;
+        node = _findChild(index, node, _hash(node, field, flen), field, flen);
+        if (node == 0) break;
+        int thresh = node->thresh.load(std::memory_order_relaxed);
+        if (thresh != INHERIT) out = thresh;
+    }
+    return out;
+}
+
+/*
+ * set the threshold value associated with a given name
+ */
+void Memory::setThresholdFor(const string& name, int threshold) {
+    lock_guard<mutex> lock(_mutex);
+    _findNode(name, true)->thresh.store(threshold, std::memory_order_relaxed);
+    _advanceGeneration();
+}
+
+/*
+ * reset the threshold value associated with a given name so that it 
+ * inherits from its nearest ancestor.
+ */
+void Memory::resetThresholdFor(const string& name) {
+    lock_guard<mutex> lock(_mutex);
+    Node *node = _findNode(name, false);
+    if (node != 0) node->thresh.store(INHERIT, std::memory_order_relaxed);
+    _advanceGeneration();
+}
+
+/*
+ * set the default threshold value associated with the root
+ */
+void Memory::setRootThreshold(int threshold) { 
+    lock_guard<mutex> lock(_mutex);
+    _root.thresh.store(threshold, std::memory_order_relaxed);
+    _advanceGeneration();
+}
+
+/*
+ * reset the memory.  The nodes stay in the table, inheriting, so that 
+ * lookups in other threads may keep visiting them and names set again 
+ * reuse them.
+ */
+void Memory::forgetAllNames() { 
+    lock_guard<mutex> lock(_mutex);
+    deque<Node>::iterator it;
+    for(it = _nodes.begin(); it != _nodes.end(); ++it) {
+        it->thresh.store(INHERIT, std::memory_order_relaxed);
+        it->remembered = false;
+    }
+    _remembered = 0;
+    _advanceGeneration();
+}
+
+size_t Memory::countNames() const {
+    lock_guard<mutex> lock(_mutex);
+    return _remembered;
+}
 
 /**
  * print the thresholds stored in this Memory that are not set to INHERIT.
  */
 void Memory::printThresholds(std::ostream& out) {
+    lock_guard<mutex> lock(_mutex);
     out << "(root)              ";
-    int top = _tree.getThreshold();
+    int top = getRootThreshold();
     if (top < 10 && top >= 0) out << ' ';
     out << top << endl;
 
-    _tree.printDescThresholds(out, " ");
+    const Index& index = *_index.load(std::memory_order_relaxed);
+    multimap<const Node*, const Node*> tree;
+    for(size_t i=0; i <= index.mask; ++i) {
+        const Node *node = index.slots[i].load(std::memory_order_relaxed);
+        if (node != 0 && node->remembered) 
+            tree.insert(make_pair(node->parent, node));
+    }
+    _printChildren(out, tree, &_root, " ");
 }
 
+namespace {
+    template <class NodeT>
+    bool fieldLess(const NodeT *a, const NodeT *b) { 
+        return a->field < b->field; 
+    }
+}
 
+void Memory::_printChildren(std::ostream& out, 
+                            const multimap<const Node*, const Node*>& tree,
+                            const Node *parent, const string& prefix) const
+{
+    typedef multimap<const Node*, const Node*>::const_iterator Iter;
+    pair<Iter, Iter> range = tree.equal_range(parent);
+    vector<const Node*> children;
+    for(Iter it=range.first; it != range.second; ++it) 
+        children.push_back(it->second);
+    sort(children.begin(), children.end(), &fieldLess<Node>);
+
+    int i;
+    vector<const Node*>::const_iterator it;
+    for(it = children.begin(); it != children.end(); ++it) {
+        const Node *child = *it;
+        int thresh = child->thresh.load(std::memory_order_relaxed);
+        out << prefix << child->field;
+        if (thresh != INHERIT) {
+            for(i = prefix.length()+child->field.length(); i < 20; ++i)
+                out << ' ';
+            if (thresh >= 0 && thresh < 10) 
+                out << ' ';
+            out << thresh;
+        }
+        out << endl;
+
+        _printChildren(out, tree, child, prefix+' ');
+    }
+}
 
 }}}}  // end lsst::pex::logging::threshold
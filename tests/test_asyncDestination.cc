@@ -0,0 +1,277 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @brief  This will test writing to a destination through an
+ * AsyncDestination.
+ */
+
+#include "lsst/pex/logging/AsyncDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using lsst::pex::logging::AsyncDestination;
+using lsst::pex::logging::AsyncWriter;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using namespace std;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a formatter that prints only the comment
+class CommentFormatter : public LogFormatter {
+public:
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        (*strm) << rec.getComments().front() << '\n';
+    }
+};
+
+/*
+ * a formatter that prints only the comment and that can be told to
+ * hold up the thread writing with it.
+ */
+class GateFormatter : public LogFormatter {
+public:
+    GateFormatter() : _open(true), _waiting(false) { }
+
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        unique_lock<mutex> lock(_mutex);
+        _waiting = true;
+        _changed.notify_all();
+        while (! _open) _changed.wait(lock);
+        _waiting = false;
+        (*strm) << rec.getComments().front() << '\n';
+    }
+
+    void close() { lock_guard<mutex> lock(_mutex);  _open = false; }
+    void open() {
+        lock_guard<mutex> lock(_mutex);
+        _open = true;
+        _changed.notify_all();
+    }
+    void waitForWriter() {
+        unique_lock<mutex> lock(_mutex);
+        while (! _waiting) _changed.wait(lock);
+    }
+
+private:
+    mutex _mutex;
+    condition_variable _changed;
+    bool _open, _waiting;
+};
+
+/*
+ * create a Log writing through an AsyncDestination to a gated stream
+ */
+shared_ptr<AsyncDestination> gatedLog(Log& log, ostream& out,
+                                      const shared_ptr<GateFormatter>& gate,
+                                      size_t capacity,
+                                      AsyncWriter::OverflowPolicy policy)
+{
+    shared_ptr<LogDestination> slow(new LogDestination(&out, gate));
+    shared_ptr<AsyncDestination> dest(
+        new AsyncDestination(slow, capacity, policy));
+    log.addDestination(dest);
+    return dest;
+}
+
+int main() {
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    shared_ptr<GateFormatter> gate(new GateFormatter());
+
+    // a stalled destination does not hold up the others
+    {
+        ostringstream slowOut, fastOut;
+        Log log(Log::DEBUG, "async");
+        shared_ptr<AsyncDestination> dest =
+            gatedLog(log, slowOut, gate, 16, AsyncWriter::BLOCK);
+        log.addDestination(fastOut, Log::DEBUG, fmtr);
+        Assert(dest->getCapacity() == 16, "wrong capacity");
+        Assert(dest->getBypassImportance() == Log::WARN,
+               "wrong default bypass importance");
+
+        gate->close();
+        log.info("a");
+        gate->waitForWriter();
+        log.info("b");
+        log.info("c");
+        Assert(fastOut.str() == "a\nb\nc\n",
+               "fast destination held up: " + fastOut.str());
+        Assert(dest->getQueueLength() == 2, "wrong queue length");
+        gate->open();
+        log.flush();
+        Assert(slowOut.str() == "a\nb\nc\n",
+               "wrong slow output: " + slowOut.str());
+        Assert(dest->getQueueLength() == 0, "records left queued");
+        Assert(dest->getOverflowCount() == 0 && dest->getDropCount() == 0,
+               "unexpected overflow");
+    }
+
+    // important records are written at once by the sending thread
+    {
+        ostringstream out;
+        shared_ptr<LogDestination> plain(new LogDestination(&out, fmtr));
+        AsyncDestination dest(plain);
+        LogRecord warning(Log::DEBUG, Log::WARN);
+        warning.addComment("warning");
+        Assert(dest.write(warning), "failed to write a warning");
+        Assert(out.str() == "warning\n",
+               "warning was not written at once: " + out.str());
+        Assert(dest.getBypassCount() == 1, "wrong bypass count");
+
+        // ...unless bypassing is turned off
+        ostringstream queued;
+        shared_ptr<LogDestination> other(new LogDestination(&queued, fmtr));
+        AsyncDestination strict(other, 16, AsyncWriter::BLOCK,
+                                AsyncDestination::NO_BYPASS);
+        Assert(strict.write(warning), "failed to queue a warning");
+        strict.flush();
+        Assert(queued.str() == "warning\n",
+               "wrong output: " + queued.str());
+        Assert(strict.getBypassCount() == 0, "warning bypassed the queue");
+    }
+
+    // records below the wrapped destination's threshold are not queued
+    {
+        ostringstream out;
+        shared_ptr<LogDestination> plain(
+            new LogDestination(&out, fmtr, Log::INFO));
+        AsyncDestination dest(plain);
+        Assert(dest.getThreshold() == Log::INFO, "wrong threshold");
+        LogRecord debug(Log::DEBUG, Log::DEBUG);
+        debug.addComment("debug");
+        Assert(! dest.write(debug), "below-threshold record accepted");
+        dest.flush();
+        Assert(out.str() == "", "unexpected output: " + out.str());
+    }
+
+    // DROP_NEWEST discards when the queue is full
+    {
+        ostringstream out;
+        Log log(Log::DEBUG, "drop");
+        shared_ptr<AsyncDestination> dest =
+            gatedLog(log, out, gate, 2, AsyncWriter::DROP_NEWEST);
+        gate->close();
+        log.info("first");
+        gate->waitForWriter();
+        for(int i=0; i < 5; ++i) {
+            ostringstream msg;
+            msg << "i" << i;
+            log.info(msg.str());
+        }
+        Assert(dest->getDropCount() == 3, "wrong drop count");
+        Assert(dest->getOverflowCount() == 3, "wrong overflow count");
+        gate->open();
+        log.flush();
+        Assert(out.str() == "first\ni0\ni1\n", "wrong output: " + out.str());
+    }
+
+    // DROP_DEBUG_FIRST makes room by discarding debugging records
+    {
+        ostringstream out;
+        Log log(Log::DEBUG, "debugFirst");
+        shared_ptr<AsyncDestination> dest =
+            gatedLog(log, out, gate, 2, AsyncWriter::DROP_DEBUG_FIRST);
+        gate->close();
+        log.info("first");
+        gate->waitForWriter();
+        log.log(Log::DEBUG, "d0");
+        log.info("i0");
+        log.info("i1");             // displaces d0
+        log.log(Log::DEBUG, "d1");  // has no room
+        Assert(dest->getDropCount() == 2, "wrong drop count");
+        Assert(dest->getOverflowCount() == 2, "wrong overflow count");
+        gate->open();
+        log.flush();
+        Assert(out.str() == "first\ni0\ni1\n", "wrong output: " + out.str());
+    }
+
+    // BLOCK makes the sender wait for room
+    {
+        ostringstream out;
+        Log log(Log::DEBUG, "block");
+        shared_ptr<AsyncDestination> dest =
+            gatedLog(log, out, gate, 1, AsyncWriter::BLOCK);
+        gate->close();
+        log.info("first");
+        gate->waitForWriter();
+        log.info("a");
+        thread sender([&log]() { log.info("b"); });
+        while (dest->getOverflowCount() == 0)
+            this_thread::sleep_for(chrono::milliseconds(1));
+        gate->open();
+        sender.join();
+        log.flush();
+        Assert(out.str() == "first\na\nb\n", "wrong output: " + out.str());
+        Assert(dest->getDropCount() == 0, "records were dropped");
+    }
+
+    // many threads may write at once
+    {
+        ostringstream out;
+        Log log(Log::DEBUG, "threads");
+        shared_ptr<AsyncDestination> dest =
+            gatedLog(log, out, gate, 16, AsyncWriter::BLOCK);
+        vector<thread> senders;
+        for(int t=0; t < 4; ++t) {
+            senders.push_back(thread([&log]() {
+                for(int i=0; i < 250; ++i) log.info("x");
+            }));
+        }
+        for(auto& t : senders) t.join();
+        log.flush();
+        Assert(out.str().size() == 1000*2, "lost records");
+    }
+
+    // an asynchronous Log waits for the destination when flushed
+    {
+        ostringstream out;
+        Log log(Log::DEBUG, "asyncLog");
+        gatedLog(log, out, gate, 16, AsyncWriter::BLOCK);
+        log.enableAsync();
+        for(int i=0; i < 100; ++i) log.info("x");
+        log.flush();
+        Assert(out.str().size() == 100*2, "Log::flush() did not wait");
+    }
+
+    return 0;
+}
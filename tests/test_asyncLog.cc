@@ -0,0 +1,288 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+ 
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/AsyncWriter.h"
+#include <iostream>
+#include <sstream>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::AsyncWriter;
+using std::shared_ptr;
+using namespace std;
+
+void assure(bool mustBeTrue, const string& failureMsg) {
+    if (! mustBeTrue)
+        throw runtime_error(failureMsg);
+}
+
+/*
+ * a formatter that prints only the comment and that can be told to 
+ * hold up the writer thread.
+ */
+class GateFormatter : public LogFormatter {
+public:
+    GateFormatter() : _open(true), _waiting(false) { }
+
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        unique_lock<mutex> lock(_mutex);
+        _waiting = true;
+        _changed.notify_all();
+        while (! _open) _changed.wait(lock);
+        _waiting = false;
+        (*strm) << rec.getProperties().get<string>("COMMENT") << '\n';
+    }
+
+    void close() { lock_guard<mutex> lock(_mutex);  _open = false; }
+    void open() { 
+        lock_guard<mutex> lock(_mutex);  
+        _open = true; 
+        _changed.notify_all();
+    }
+    void waitForWriter() {
+        unique_lock<mutex> lock(_mutex);
+        while (! _waiting) _changed.wait(lock);
+    }
+
+private:
+    mutex _mutex;
+    condition_variable _changed;
+    bool _open, _waiting;
+};
+
+/*
+ * a destination that switches a log back to synchronous mode, destroying
+ * its writer, when it is given a record
+ */
+class DisablingDestination : public LogDestination {
+public:
+    DisablingDestination(ostream *strm, shared_ptr<LogFormatter> fmtr)
+        : LogDestination(strm, fmtr), log(0), disabled()
+    { }
+
+    virtual bool write(const LogRecord& rec) {
+        bool out = LogDestination::write(rec);
+        if (log->isAsync()) {
+            log->disableAsync();
+            disabled.set_value();
+        }
+        return out;
+    }
+
+    Log *log;
+    promise<void> disabled;
+};
+
+int main() {
+    ostringstream out;
+    shared_ptr<GateFormatter> gate(new GateFormatter());
+    shared_ptr<LogDestination> dest(new LogDestination(&out, gate));
+
+    // records are written in order and flush() waits for them
+    Log log(Log::DEBUG, "async");
+    log.addDestination(dest);
+    assure(! log.isAsync(), "log should start out synchronous");
+    log.enableAsync(16);
+    assure(log.isAsync(), "failed to enable async mode");
+    for(int i=0; i < 100; ++i) {
+        ostringstream msg;
+        msg << "msg" << i;
+        log.info(msg.str());
+    }
+    log.flush();
+    {
+        istringstream in(out.str());
+        string line;
+        int i = 0;
+        while (getline(in, line)) {
+            ostringstream msg;
+            msg << "msg" << i++;
+            assure(line == msg.str(), "out of order record: " + line);
+        }
+        assure(i == 100, "not all records were written");
+    }
+
+    // children inherit the writer; below-threshold records are not queued
+    Log child(log, "child");
+    assure(child.isAsync(), "child did not inherit async mode");
+    assure(child.getAsyncWriter() == log.getAsyncWriter(), 
+           "child does not share parent's writer");
+    out.str("");
+    child.setThreshold(Log::WARN);
+    child.info("quiet");
+    child.warn("loud");
+    child.flush();
+    assure(out.str() == "loud\n", "unexpected child output: " + out.str());
+
+    // many threads may send at once
+    out.str("");
+    {
+        vector<thread> senders;
+        for(int t=0; t < 4; ++t) {
+            senders.push_back(thread([&log]() { 
+                for(int i=0; i < 250; ++i) log.info("x"); 
+            }));
+        }
+        for(auto& t : senders) t.join();
+    }
+    log.flush();
+    assure(out.str().size() == 1000*2, "lost records from multiple threads");
+
+    // records from different threads are merged in time order
+    out.str("");
+    gate->close();
+    log.info("first");
+    gate->waitForWriter();
+    {
+        vector<thread> senders;
+        for(int t=0; t < 2; ++t) {
+            senders.push_back(thread([&log, t]() { 
+                for(int i=t; i < 6; i += 2) {
+                    LogRecord rec(log.getThreshold(), Log::INFO);
+                    ostringstream msg;
+                    msg << "t" << i;
+                    rec.addComment(msg.str());
+                    rec.setTimestamp(1000000000LL*(i+1));
+                    log.send(rec);
+                }
+            }));
+        }
+        for(auto& t : senders) t.join();
+    }
+    gate->open();
+    log.flush();
+    assure(out.str() == "first\nt0\nt1\nt2\nt3\nt4\nt5\n", 
+           "records not merged in time order: " + out.str());
+
+    // the rings of threads that have exited are drained and given up
+    out.str("");
+    for(int t=0; t < 50; ++t) {
+        thread([&log]() { 
+            for(int i=0; i < 10; ++i) log.info("x"); 
+        }).join();
+    }
+    log.flush();
+    assure(out.str().size() == 500*2, "lost records from exited threads");
+    assure(log.getAsyncWriter()->getQueueLength() == 0, 
+           "records left queued");
+
+    // a child process writes its own records with a new writer thread
+    out.str("");
+    log.info("before fork");
+    log.flush();                 // the writer thread holds no locks
+    pid_t pid = fork();
+    if (pid == 0) {
+        out.str("");
+        log.info("child");
+        log.flush();
+        _exit(out.str() == "child\n" ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    assure(WIFEXITED(status) && WEXITSTATUS(status) == 0, 
+           "async logging failed in a child process");
+    log.flush();
+    assure(out.str() == "before fork\n", 
+           "unexpected output around fork: " + out.str());
+
+    // DROP_NEWEST discards when the queue is full
+    out.str("");
+    log.enableAsync(4, AsyncWriter::DROP_NEWEST);
+    gate->close();
+    log.info("first");
+    gate->waitForWriter();        // "first" is now being written
+    for(int i=0; i < 10; ++i) log.info("more");
+    assure(log.getAsyncWriter()->getQueueLength() == 4, "queue overfilled");
+    assure(log.getAsyncWriter()->getDropCount() == 6, 
+           "wrong DROP_NEWEST drop count");
+    gate->open();
+    log.flush();
+    assure(out.str() == "first\nmore\nmore\nmore\nmore\n", 
+           "unexpected DROP_NEWEST output: " + out.str());
+
+    // DROP_DEBUG_FIRST sacrifices debug messages
+    out.str("");
+    log.enableAsync(3, AsyncWriter::DROP_DEBUG_FIRST);
+    gate->close();
+    log.info("first");
+    gate->waitForWriter();
+    log.logdebug("d1");
+    log.logdebug("d2");
+    log.info("i1");
+    log.info("i2");              // evicts d1
+    log.logdebug("d3");             // evicts d2
+    log.info("i3");              // evicts d3
+    log.logdebug("d4");             // dropped
+    assure(log.getAsyncWriter()->getDropCount() == 4, 
+           "wrong DROP_DEBUG_FIRST drop count");
+    gate->open();
+    log.flush();
+    assure(out.str() == "first\ni1\ni2\ni3\n", 
+           "unexpected DROP_DEBUG_FIRST output: " + out.str());
+
+    // going back to synchronous mode writes anything still queued
+    out.str("");
+    gate->close();
+    log.info("queued");
+    gate->waitForWriter();
+    log.info("queued too");
+    gate->open();
+    log.disableAsync();
+    assure(! log.isAsync(), "failed to disable async mode");
+    assure(out.str() == "queued\nqueued too\n", 
+           "disableAsync lost records: " + out.str());
+    log.info("direct");
+    assure(out.str() == "queued\nqueued too\ndirect\n", 
+           "synchronous write failed");
+
+    // a destination may destroy the writer that is writing to it
+    out.str("");
+    {
+        Log selfish(Log::DEBUG, "selfish");
+        shared_ptr<DisablingDestination> 
+            disabling(new DisablingDestination(&out, gate));
+        disabling->log = &selfish;
+        selfish.addDestination(disabling);
+        selfish.enableAsync();
+        selfish.info("last");
+        disabling->disabled.get_future().wait();
+        assure(! selfish.isAsync(), "failed to disable from the writer");
+        selfish.info("after");
+    }
+    assure(out.str() == "last\nafter\n", 
+           "unexpected output after the writer destroyed itself: " + 
+           out.str());
+
+    return 0;
+}
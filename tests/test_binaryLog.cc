@@ -0,0 +1,210 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @brief  This will test writing records with the BinaryFormatter and 
+ * reading them back with the BinaryLogReader.
+ */
+
+#include "lsst/pex/logging/BinaryLogReader.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/daf/base/DateTime.h"
+#include "lsst/pex/exceptions.h"
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using lsst::pex::logging::BinaryFormatter;
+using lsst::pex::logging::BinaryLogReader;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::PrependedFormatter;
+using lsst::daf::base::PropertySet;
+using lsst::daf::base::DateTime;
+using namespace std;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+string render(const LogRecord& rec) {
+    PrependedFormatter fmtr(true);
+    ostringstream out;
+    fmtr.write(&out, rec);
+    return out.str();
+}
+
+shared_ptr<const PropertySet> makePreamble(const string& label) {
+    PropertySet::Ptr preamble(new PropertySet());
+    preamble->set("HOST", string("lsst-dev"));
+    preamble->set("PID", 4242);
+    preamble->set("LABEL", label);
+    return preamble;
+}
+
+// compact records come back as they went in, property types and all
+void testRoundTrip() {
+    shared_ptr<const PropertySet> preamble = makePreamble("visit 12");
+    BinaryFormatter fmtr;
+    ostringstream out;
+    vector<string> expected;
+    vector<size_t> sizes;
+
+    for (int i = 0; i < 3; ++i) {
+        LogRecord rec(-10, -3 + i, preamble, "pipe.isr");
+        rec.addComment("read amp");
+        if (i == 1) rec.addComment("a second\tline \"quoted\"");
+        rec.addProperty("amp", i);
+        rec.addProperty("gain", 1.25 + i);
+        rec.addProperty("noise", 3.5f);
+        rec.addProperty("ccd", string("R22_S11"));
+        rec.addProperty("ok", i != 2);
+        rec.addProperty("nbytes", 12345678901LL * (i - 1));
+        rec.addProperty("mask", 0xffffffffffffffffULL);
+        rec.addProperty("grade", 'A');
+        rec.addProperty("taken", DateTime(1234567890123456789LL, 
+                                          DateTime::UTC));
+        size_t before = out.str().size();
+        fmtr.write(&out, rec);
+        sizes.push_back(out.str().size() - before);
+        expected.push_back(render(rec));
+    }
+    Assert(sizes[2] < sizes[0] / 2, 
+           "names and preamble were not interned");
+
+    istringstream in(out.str());
+    BinaryLogReader reader(in);
+    for (size_t i = 0; i < expected.size(); ++i) {
+        shared_ptr<LogRecord> rec = reader.next();
+        Assert(rec.get() != 0, "too few records");
+        string got = render(*rec);
+        cout << got;
+        Assert(got == expected[i], "mismatched record:\n" + got + 
+               "expected:\n" + expected[i]);
+        Assert(rec->isCompact() && rec->getPreamble(), 
+               "decoded record does not share a preamble");
+        Assert(rec->data().typeOf("noise") == typeid(float) && 
+               rec->data().typeOf("nbytes") == typeid(long long) && 
+               rec->data().typeOf("taken") == typeid(DateTime), 
+               "property types were not kept");
+    }
+    Assert(reader.next().get() == 0, "too many records");
+    Assert(reader.getRecordCount() == 3, "wrong record count");
+}
+
+// records that are no longer compact, or have no log name, and streams
+// that were appended to
+void testOddRecords() {
+    ostringstream out;
+    {
+        BinaryFormatter fmtr;
+        LogRecord expanded(0, 7);
+        expanded.addProperty("LOG", string("pipe.expanded"));
+        expanded.addProperty("LABEL", string("labelled"));
+        expanded.addComment("one");
+        expanded.addProperty("count", 2);
+        expanded.addProperty("count", 3);
+        fmtr.write(&out, expanded);
+
+        LogRecord nameless(0, 1);
+        nameless.addComment("two");
+        fmtr.write(&out, nameless);
+    }
+    {
+        // a second formatter appending to the same stream
+        BinaryFormatter fmtr;
+        LogRecord rec(0, 4, makePreamble("again"), "pipe.appended");
+        rec.addComment("three");
+        fmtr.write(&out, rec);
+    }
+
+    istringstream in(out.str());
+    BinaryLogReader reader(in);
+    shared_ptr<LogRecord> rec = reader.next();
+    string name;
+    Assert(rec && rec->tryGetLogName(name) && name == "pipe.expanded", 
+           "lost the log name of an expanded record");
+    Assert(rec->getImportance() == 7, "lost the level");
+    Assert(rec->data().get<string>("LABEL") == "labelled", "lost LABEL");
+    vector<int> counts = rec->data().getArray<int>("count");
+    Assert(counts.size() == 2 && counts[0] == 2 && counts[1] == 3, 
+           "lost an array property");
+
+    rec = reader.next();
+    Assert(rec && ! rec->data().exists("LOG"), "invented a log name");
+    Assert(rec->data().get<string>("COMMENT") == "two", "lost a comment");
+
+    rec = reader.next();
+    Assert(rec && rec->tryGetLogName(name) && name == "pipe.appended", 
+           "did not read an appended stream");
+    Assert(rec->data().get<string>("LABEL") == "again", 
+           "lost the preamble of an appended stream");
+    Assert(! reader.next(), "too many records");
+}
+
+void testCorruption() {
+    istringstream text("2016-03-01T18:04:05.012345: pipe: hello\n");
+    BinaryLogReader textReader(text);
+    bool caught = false;
+    try {
+        textReader.next();
+    } catch (lsst::pex::exceptions::IoError const&) {
+        caught = true;
+    }
+    Assert(caught, "text was not rejected");
+
+    BinaryFormatter fmtr;
+    ostringstream out;
+    LogRecord rec(0, 5, makePreamble("x"), "pipe");
+    rec.addComment("cut short");
+    fmtr.write(&out, rec);
+    string data = out.str();
+    for (size_t len = 12; len < data.size(); len += 3) {
+        istringstream in(data.substr(0, len));
+        BinaryLogReader reader(in);
+        caught = false;
+        try {
+            reader.next();
+        } catch (lsst::pex::exceptions::IoError const&) {
+            caught = true;
+        }
+        Assert(caught, "a truncated record was not detected");
+    }
+
+    istringstream empty("");
+    BinaryLogReader emptyReader(empty);
+    Assert(! emptyReader.next(), "records found in an empty stream");
+}
+
+int main() {
+    testRoundTrip();
+    testOddRecords();
+    testCorruption();
+    return 0;
+}
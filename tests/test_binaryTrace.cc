@@ -0,0 +1,183 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/**
+ * @brief  This will test recording trace messages with LSST_BINARY_TRACE
+ * and formatting them later.
+ */
+
+#include "lsst/pex/logging/BinaryTrace.h"
+#include "lsst/pex/logging/BinaryLogReader.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include <iostream>
+#include <list>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using lsst::pex::logging::BinaryTrace;
+using lsst::pex::logging::BinaryLogReader;
+using lsst::pex::logging::BriefFormatter;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::Trace;
+using lsst::daf::base::PropertySet;
+using namespace std;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+int evaluated = 0;
+int countEvaluation() { return ++evaluated; }
+
+struct Point { int x, y; };
+ostream& operator<<(ostream& strm, const Point& p) {
+    return strm << '(' << p.x << ',' << p.y << ')';
+}
+
+// messages are formatted into the default Log when drained
+void testFormatting(ostringstream& out) {
+    string name("changed later");
+    Point p = { 3, 4 };
+    LSST_BINARY_TRACE("btrace.fmt", 2, "ints {} {} {}, unsigned {}", 
+                      -5, 123456789012LL, (short) 7, 42u);
+    LSST_BINARY_TRACE("btrace.fmt", 2, "float {:.3f} char {} bool {}", 
+                      2.5, 'x', true);
+    LSST_BINARY_TRACE("btrace.fmt", 2, "string {} and {}; other {}", 
+                      name, "literal", p);
+    LSST_BINARY_TRACE("btrace.fmt", 2, "no arguments");
+    name = "oops";
+
+    // not enabled: arguments are not evaluated
+    LSST_BINARY_TRACE("btrace.fmt", 5, "hidden {}", countEvaluation());
+    Assert(evaluated == 0, "arguments evaluated for a disabled message");
+    Assert(out.str().empty(), "message formatted before flush");
+
+    BinaryTrace::flush();
+    string text = out.str();
+    cout << text;
+    Assert(text == "btrace.fmt DEBUG: ints -5 123456789012 7, unsigned 42\n"
+                   "btrace.fmt DEBUG: float 2.500 char x bool true\n"
+                   "btrace.fmt DEBUG: string changed later and literal; "
+                   "other (3,4)\n"
+                   "btrace.fmt DEBUG: no arguments\n", 
+           "wrong messages:\n" + text);
+}
+
+// messages from several threads come out complete and in time order
+void testThreads(ostringstream& out) {
+    out.str("");
+    const int nthreads = 4, nmsgs = 2000;
+    vector<thread> threads;
+    for (int t = 0; t < nthreads; ++t) {
+        threads.push_back(thread([t]() {
+            for (int i = 0; i < nmsgs; ++i) 
+                LSST_BINARY_TRACE("btrace.threads", 1, "thread {} msg {}", 
+                                  t, i);
+        }));
+    }
+    BinaryTrace::start(1);
+    for (auto& th : threads) th.join();
+    BinaryTrace::stop();
+    Assert(! BinaryTrace::isRunning(), "background thread still running");
+
+    istringstream lines(out.str());
+    string line;
+    vector<int> next(nthreads, 0);
+    int count = 0;
+    while (getline(lines, line)) {
+        int t, i;
+        Assert(sscanf(line.c_str(), "btrace.threads DEBUG: thread %d msg %d",
+                      &t, &i) == 2, "garbled message: " + line);
+        Assert(i == next[t]++, "message out of order: " + line);
+        ++count;
+    }
+    Assert(count == nthreads * nmsgs, "messages lost");
+}
+
+// messages written in binary form are formatted offline
+void testOutput() {
+    shared_ptr<ostringstream> strm(new ostringstream());
+    BinaryTrace::setOutput(strm);
+    for (int i = 0; i < 3; ++i) 
+        LSST_BINARY_TRACE("btrace.out", 3, "offline {} of {}", i, 3.5);
+    BinaryTrace::flush();
+    BinaryTrace::setOutput(shared_ptr<ostream>());
+
+    istringstream in(strm->str());
+    BinaryLogReader reader(in);
+    for (int i = 0; i < 3; ++i) {
+        shared_ptr<LogRecord> rec = reader.next();
+        Assert(rec.get() != 0, "too few messages");
+        ostringstream msg;
+        msg << "offline " << i << " of 3.5";
+        Assert(rec->getComments().size() == 1 && 
+               rec->getComments()[0] == msg.str(), 
+               "wrong message: " + rec->getComments()[0]);
+        Assert(rec->getLogName() == "btrace.out" && 
+               rec->getImportance() == -3, "wrong log name or level");
+    }
+    Assert(! reader.next(), "too many messages");
+}
+
+// a full buffer drops messages rather than waiting
+void testDrops() {
+    size_t size = BinaryTrace::getBufferSize();
+    BinaryTrace::setBufferSize(1024);
+    unsigned long long drops = BinaryTrace::getDropCount();
+    thread th([]() {
+        for (int i = 0; i < 1000; ++i) 
+            LSST_BINARY_TRACE("btrace.drops", 1, "filler {}", i);
+    });
+    th.join();
+    Assert(BinaryTrace::getDropCount() > drops, "no messages were dropped");
+    BinaryTrace::setBufferSize(size);
+    BinaryTrace::flush();
+}
+
+int main() {
+    // send messages only to a string
+    ostringstream out;
+    list<shared_ptr<LogDestination> > destinations;
+    destinations.push_back(shared_ptr<LogDestination>(
+        new LogDestination(&out, shared_ptr<LogFormatter>(new BriefFormatter()),
+                           Log::DEBUG-10)));
+    Log::createDefaultLog(destinations, PropertySet());
+    Trace::setVerbosity("btrace", 3);
+
+    testFormatting(out);
+    testThreads(out);
+    testOutput();
+    testDrops();
+    return 0;
+}
@@ -0,0 +1,187 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @brief  This will test writing compressed log files with the
+ * CompressedFileDestination.
+ */
+
+#include "lsst/pex/logging/CompressedFileDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/exceptions.h"
+#include <boost/filesystem/operations.hpp>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <zlib.h>
+
+using lsst::pex::logging::CompressedFileDestination;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a formatter that prints only the comment
+class CommentFormatter : public LogFormatter {
+public:
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        (*strm) << rec.getComments().front() << '\n';
+    }
+};
+
+string message(int i) {
+    ostringstream msg;
+    msg << "processed exposure " << i << " of visit " << i/10;
+    return msg.str();
+}
+
+void send(CompressedFileDestination& dest, int i, int importance) {
+    LogRecord rec(0, importance);
+    rec.addComment(message(i));
+    dest.write(rec);
+}
+
+// the text of records first through last
+string expected(int first, int last) {
+    string text;
+    for(int i=first; i <= last; ++i) text += message(i) + '\n';
+    return text;
+}
+
+// read as much of a gzip file as has been written
+string readGzip(const fs::path& path) {
+    gzFile in = gzopen(path.string().c_str(), "rb");
+    Assert(in != 0, "can't open " + path.string());
+    string contents;
+    char buf[4096];
+    int n;
+    while ((n = gzread(in, buf, sizeof(buf))) > 0) contents.append(buf, n);
+    gzclose(in);
+    return contents;
+}
+
+void testGzip(const fs::path& dir) {
+    const int defaultLevel = CompressedFileDestination::DEFAULT_LEVEL;
+    const size_t blockSize = CompressedFileDestination::DEFAULT_BLOCK_SIZE;
+    fs::path path = dir / "out.log.gz";
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    {
+        // small blocks, so that many are handed off
+        CompressedFileDestination dest(path, fmtr, 
+                                       CompressedFileDestination::GZIP, 
+                                       defaultLevel, 1000);
+        for(int i=0; i < 500; ++i) send(dest, i, Log::INFO);
+
+        // a warning is handed off for flushing at once, without waiting
+        // for it to be compressed; flush() waits until it can be read
+        send(dest, 500, Log::WARN);
+        dest.flush();
+        Assert(dest.getPendingBytes() == 0, "records still pending");
+        Assert(readGzip(path) == expected(0, 500), 
+               "flushed records are not readable");
+        Assert(dest.getBytesIn() == expected(0, 500).size(), 
+               "wrong count of bytes in");
+        Assert(dest.getBytesOut() == fs::file_size(path), 
+               "wrong count of bytes out");
+        Assert(dest.getBytesOut() < dest.getBytesIn()/4, 
+               "poor compression");
+
+        for(int i=501; i < 1000; ++i) send(dest, i, Log::INFO);
+    }
+    Assert(readGzip(path) == expected(0, 999), "unexpected contents");
+
+    // appended records follow in a new gzip member
+    {
+        CompressedFileDestination dest(path, fmtr);
+        for(int i=1000; i < 1010; ++i) send(dest, i, Log::INFO);
+    }
+    Assert(readGzip(path) == expected(0, 1009), 
+           "unexpected contents after appending");
+
+    // unless asked to start over
+    {
+        CompressedFileDestination dest(path, fmtr, 
+                                       CompressedFileDestination::GZIP, 9,
+                                       blockSize, 0, true);
+        send(dest, 0, Log::INFO);
+    }
+    Assert(readGzip(path) == expected(0, 0), 
+           "unexpected contents after truncating");
+}
+
+void testCodecs(const fs::path& dir) {
+    Assert(CompressedFileDestination::isSupported(
+               CompressedFileDestination::GZIP), "gzip not supported");
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    if (! CompressedFileDestination::isSupported(
+              CompressedFileDestination::ZSTD)) 
+    {
+        try {
+            CompressedFileDestination dest(dir / "out.log.zst", fmtr,
+                                           CompressedFileDestination::ZSTD);
+            Assert(false, "unsupported codec accepted");
+        }
+        catch (lsst::pex::exceptions::InvalidParameterError&) { }
+        return;
+    }
+
+    fs::path path = dir / "out.log.zst";
+    {
+        CompressedFileDestination dest(path, fmtr, 
+                                       CompressedFileDestination::ZSTD);
+        for(int i=0; i < 100; ++i) send(dest, i, Log::INFO);
+        dest.flush();
+        Assert(dest.getBytesOut() > 0 && 
+               dest.getBytesOut() < dest.getBytesIn(), 
+               "zstd output not written");
+    }
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / 
+                   fs::unique_path("compressed-%%%%-%%%%");
+    fs::create_directories(dir);
+    try {
+        testGzip(dir);
+        testCodecs(dir);
+    }
+    catch (...) {
+        fs::remove_all(dir);
+        throw;
+    }
+    fs::remove_all(dir);
+    return 0;
+}
@@ -6,17 +6,46 @@ class UtilsBinaryTester(lsst.utils.tests.ExecutablesTestCase):
     pass
 
 # Do not run the executables that have their output compared in python
-EXECUTABLES = ("test_blockTimingLog",
+EXECUTABLES = ("test_asyncDestination",
+               "test_asyncLog",
+               "test_binaryLog",
+               "test_binaryTrace",
+               "test_blockTimingLog",
+               "test_compressedFile",
                "test_defLog",
+               "test_fdDestination",
                "test_fileDest",
+               "test_flightRecorder",
+               "test_jsonString",
                "test_log",
                "test_logFormatter",
                "test_logRecord",
+               "test_mmapFile",
                "test_noTrace",
                "test_propertyPrinter",
+               "test_rotatingFile",
+               "test_sharedRendering",
                "test_thresholdMemory",
                "test_trace",
-               "test_timeSyscalls")
+               "test_timeAsync",
+               "test_timeAsyncDestination",
+               "test_timeBatch",
+               "test_timeBinary",
+               "test_timeBinaryTrace",
+               "test_timeCompressed",
+               "test_timeFanOut",
+               "test_timeFlightRecorder",
+               "test_timeFlush",
+               "test_timeFormat",
+               "test_timeFormatters",
+               "test_timeJson",
+               "test_timeMmapFile",
+               "test_timeNumbers",
+               "test_timePattern",
+               "test_timePropertyVisitor",
+               "test_timeSyscalls",
+               "test_timeThresholds",
+               "test_timeTimestamps")
 UtilsBinaryTester.create_executable_tests(__file__, EXECUTABLES)
 
 if __name__ == "__main__":
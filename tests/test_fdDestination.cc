@@ -0,0 +1,174 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @brief  This will test writing records one at a time and in batches
+ * with the FdDestination.
+ */
+
+#include "lsst/pex/logging/FdDestination.h"
+#include "lsst/pex/logging/AsyncDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/exceptions.h"
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using lsst::pex::logging::AsyncDestination;
+using lsst::pex::logging::FdDestination;
+using lsst::pex::logging::FlushPolicy;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a formatter that prints only the comment
+class CommentFormatter : public LogFormatter {
+public:
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        (*strm) << rec.getComments().front() << '\n';
+    }
+};
+
+string readFile(const fs::path& path) {
+    ifstream in(path.string().c_str());
+    ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+string message(int i) {
+    ostringstream msg;
+    msg << "record " << i;
+    return msg.str();
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+
+    // records written one at a time are flushed by the FlushPolicy
+    fs::path single = dir / "single.log";
+    {
+        FdDestination dest(single, fmtr);
+        LogRecord rec(Log::DEBUG, Log::INFO);
+        rec.addComment("one");
+        Assert(dest.write(rec), "failed to write a record");
+        Assert(readFile(single) == "one\n",
+               "record not flushed: " + readFile(single));
+        Assert(dest.getSyscallCount() == 1, "wrong number of syscalls");
+    }
+    {
+        // reopening appends
+        FdDestination dest(single.string(), fmtr);
+        LogRecord rec(Log::DEBUG, Log::INFO);
+        rec.addComment("two");
+        dest.write(rec);
+    }
+    Assert(readFile(single) == "one\ntwo\n",
+           "file not appended to: " + readFile(single));
+
+    // a batch is written with one writev() per IOV_MAX records, after any
+    // records still buffered
+    fs::path batched = dir / "batch.log";
+    {
+        const int n = 3000;
+        vector<shared_ptr<LogRecord> > recs;
+        vector<const LogRecord*> ptrs;
+        ostringstream expected;
+        expected << "buffered\n";
+        for(int i=0; i < n; ++i) {
+            int importance = (i % 10 == 9) ? Log::DEBUG : Log::INFO;
+            recs.push_back(shared_ptr<LogRecord>(
+                new LogRecord(Log::DEBUG, importance)));
+            recs.back()->addComment(message(i));
+            ptrs.push_back(recs.back().get());
+            if (importance >= Log::INFO) expected << message(i) << '\n';
+        }
+
+        FdDestination dest(batched.c_str(), fmtr, Log::INFO, true);
+        dest.setFlushPolicy(FlushPolicy::everyBytes(4096));
+        LogRecord first(Log::DEBUG, Log::INFO);
+        first.addComment("buffered");
+        dest.write(first);
+        Assert(dest.getSyscallCount() == 0, "record not buffered");
+
+        size_t written = dest.writeBatch(&ptrs[0], ptrs.size());
+        Assert(written == 2700, "wrong number of records written");
+        Assert(dest.getSyscallCount() <= 1 + (2700 + 1023)/1024,
+               "too many syscalls for a batch");
+        Assert(readFile(batched) == expected.str(),
+               "batch written incorrectly");
+    }
+
+    // an AsyncDestination hands its backlog over in batches
+    fs::path async = dir / "async.log";
+    {
+        const int n = 5000;
+        shared_ptr<LogDestination> fd(new FdDestination(async, fmtr));
+        {
+            Log log(Log::DEBUG, "async");
+            log.addDestination(
+                shared_ptr<LogDestination>(new AsyncDestination(fd)));
+            for(int i=0; i < n; ++i) log.info(message(i));
+        }
+        istringstream in(readFile(async));
+        string line;
+        int i = 0;
+        while (getline(in, line)) {
+            Assert(line == message(i++), "out of order record: " + line);
+        }
+        Assert(i == n, "not all records were written");
+    }
+
+    // a file that cannot be opened is reported
+    bool thrown = false;
+    try {
+        FdDestination dest(dir / "missing" / "x.log", fmtr);
+    }
+    catch (lsst::pex::exceptions::IoError&) {
+        thrown = true;
+    }
+    Assert(thrown, "unopenable file not reported");
+
+    fs::remove_all(dir);
+    return 0;
+}
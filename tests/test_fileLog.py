@@ -19,6 +19,7 @@
 # the GNU General Public License along with this program.  If not,
 # see <http://www.lsstcorp.org/LegalNotices/>.
 
+import json
 import os
 import unittest
 
@@ -82,6 +83,41 @@ class TestCase(unittest.TestCase):
         finally:
             fd.close()
 
+    def testJson(self):
+        self.logger.addDestination(self.file, format="json")
+        self.logger.log(Log.INFO, 'a "quoted"\tmessage')
+        self.logger.setThreshold(Log.DEBUG)
+        self.logger.log(Log.DEBUG, "debugging")
+
+        fd = open(self.file)
+        try:
+            records = [json.loads(l) for l in fd.readlines()]
+            self.assertEqual(len(records), 2)
+            self.assertEqual(records[0]["COMMENT"], ['a "quoted"\tmessage'])
+            self.assertEqual(records[0]["LOG"], "test")
+            self.assertEqual(records[0]["LEVEL"], Log.INFO)
+            self.assertEqual(records[1]["COMMENT"], ["debugging"])
+            self.assertEqual(records[1]["LEVEL"], Log.DEBUG)
+        finally:
+            fd.close()
+
+    def testBinary(self):
+        self.logger.addDestination(self.file, format="binary")
+        self.logger.log(Log.INFO, "in binary")
+
+        fd = open(self.file, "rb")
+        try:
+            data = fd.read()
+            self.assertEqual(data[1:10], b"HLSSTBLOG")
+            self.assertGreater(data.find(b"in binary"), 0)
+            self.assertEqual(data.find(b"INFO"), -1)
+        finally:
+            fd.close()
+
+    def testBadFormat(self):
+        with self.assertRaises(ValueError):
+            self.logger.addDestination(self.file, format="xml")
+
 
 class TestMemory(lsst.utils.tests.MemoryTestCase):
     pass
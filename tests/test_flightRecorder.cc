@@ -0,0 +1,209 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @brief  This will test the limits of the FlightRecorderDestination's
+ * buffer and the dumps made explicitly, on a fatal message and on a
+ * crash.
+ */
+
+#include "lsst/pex/logging/FlightRecorderDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+#include <boost/filesystem/operations.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using lsst::pex::logging::FlightRecorderDestination;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a formatter that prints only the comment
+class CommentFormatter : public LogFormatter {
+public:
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        (*strm) << rec.getComments().front() << '\n';
+    }
+};
+
+string readFile(const fs::path& path) {
+    ifstream in(path.string().c_str());
+    ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+string message(int i) {
+    ostringstream msg;
+    msg << "record " << i;
+    return msg.str();
+}
+
+void writeMany(LogDestination& dest, int from, int to,
+               int importance=Log::DEBUG)
+{
+    for(int i=from; i < to; ++i) {
+        LogRecord rec(Log::DEBUG, importance);
+        rec.addComment(message(i));
+        dest.write(rec);
+    }
+}
+
+/*
+ * write some records to an armed recorder in a child process that then
+ * raises a signal, and return how the child ended
+ */
+int crash(const fs::path& dumppath, shared_ptr<LogFormatter> fmtr, int sig) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        struct rlimit nocore = { 0, 0 };
+        setrlimit(RLIMIT_CORE, &nocore);
+        FlightRecorderDestination recorder(dumppath, fmtr, 2);
+        recorder.armSignals();
+        writeMany(recorder, 0, 3);
+        raise(sig);
+        _exit(0);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return status;
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+
+    // only the most recent records are kept, up to the record limit
+    fs::path counted = dir / "counted.dump";
+    {
+        FlightRecorderDestination recorder(counted, fmtr, 3);
+        writeMany(recorder, 0, 5);
+        LogRecord trace(Log::DEBUG, Log::DEBUG-1);
+        trace.addComment("trace");
+        Assert(! recorder.write(trace), "record below threshold kept");
+        Assert(recorder.getRecordCount() == 3, "wrong number of records");
+        Assert(recorder.getByteCount() == 27, "wrong number of bytes");
+        Assert(! fs::exists(counted), "dump file created early");
+
+        Assert(recorder.dump(), "dump failed");
+        Assert(recorder.getRecordCount() == 0 && recorder.getByteCount() == 0,
+               "buffer not emptied by dump");
+        writeMany(recorder, 5, 6);
+        Assert(recorder.dump("again"), "second dump failed");
+        Assert(recorder.getDumpCount() == 2, "wrong number of dumps");
+    }
+    Assert(readFile(counted) ==
+           "### flight recorder dump: dump requested\n"
+           "record 2\nrecord 3\nrecord 4\n"
+           "### flight recorder dump: again\n"
+           "record 5\n",
+           "wrong records dumped: " + readFile(counted));
+
+    // or up to the byte limit, as the buffer wraps around
+    fs::path sized = dir / "sized.dump";
+    {
+        FlightRecorderDestination recorder(sized, fmtr, 100, 25);
+        writeMany(recorder, 0, 97);
+        Assert(recorder.getRecordCount() == 2, "byte limit not kept");
+        recorder.dump();
+    }
+    Assert(readFile(sized) ==
+           "### flight recorder dump: dump requested\n"
+           "record 95\nrecord 96\n",
+           "wrong records dumped: " + readFile(sized));
+
+    // a fatal message dumps the context that led up to it
+    fs::path fatal = dir / "fatal.dump";
+    {
+        Log log(Log::DEBUG, "flight");
+        shared_ptr<FlightRecorderDestination>
+            recorder(new FlightRecorderDestination(fatal, fmtr));
+        log.addDestination(recorder);
+        log.logdebug("context");
+        log.info("more context");
+        Assert(! fs::exists(fatal), "dumped before a fatal message");
+        log.fatal("disaster");
+        Assert(recorder->getDumpCount() == 1, "fatal message not dumped");
+    }
+    ostringstream fatalDump;
+    fatalDump << "### flight recorder dump: record of importance "
+              << Log::FATAL << "\ncontext\nmore context\ndisaster\n";
+    Assert(readFile(fatal) == fatalDump.str(),
+           "wrong records dumped: " + readFile(fatal));
+
+    // a crash dumps the buffer from the signal handler, and the signal
+    // still ends the process
+    fs::path aborted = dir / "aborted.dump";
+    int status = crash(aborted, fmtr, SIGABRT);
+    Assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT,
+           "process did not abort");
+    Assert(readFile(aborted) ==
+           "### flight recorder dump: caught SIGABRT\nrecord 1\nrecord 2\n",
+           "wrong records dumped: " + readFile(aborted));
+
+    fs::path segv = dir / "segv.dump";
+    status = crash(segv, fmtr, SIGSEGV);
+    Assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGSEGV,
+           "process did not die of SIGSEGV");
+    Assert(readFile(segv) ==
+           "### flight recorder dump: caught SIGSEGV\nrecord 1\nrecord 2\n",
+           "wrong records dumped: " + readFile(segv));
+
+    // deleting an armed recorder restores the handlers
+    {
+        FlightRecorderDestination recorder(dir / "unused.dump", fmtr);
+        recorder.armSignals();
+        Assert(recorder.isArmed(), "recorder not armed");
+    }
+    struct sigaction current;
+    sigaction(SIGSEGV, 0, &current);
+    Assert(current.sa_handler == SIG_DFL, "SIGSEGV handler not restored");
+    sigaction(SIGABRT, 0, &current);
+    Assert(current.sa_handler == SIG_DFL, "SIGABRT handler not restored");
+
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,209 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+ 
+/**
+ * @brief  This will test JSON string escaping and the JsonLinesFormatter.
+ */
+
+#include "lsst/pex/logging/JsonString.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using lsst::pex::logging::JsonString;
+using lsst::pex::logging::JsonLinesFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::daf::base::PropertySet;
+using namespace std;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+string quote(const string& text) {
+    string out;
+    JsonString::append(out, text.data(), text.size());
+    return out;
+}
+
+// every scanner must find the same first special character as the
+// byte-at-a-time one, wherever it falls
+void testScanners() {
+    const char specials[] = { '"', '\\', '\n', '\0', '\x1f', '\x01' };
+    const char ordinary[] = { 'a', ' ', '~', '\x7f', '\x80', '\xe9', '\xff',
+                              '!', '#', '[', ']', '\x20' };
+    srand(12345);
+    for (int trial = 0; trial < 2000; ++trial) {
+        string text(rand() % 100, 'x');
+        for (size_t i = 0; i < text.size(); ++i) 
+            text[i] = ordinary[rand() % sizeof(ordinary)];
+        if (trial % 4 != 0 && ! text.empty()) 
+            text[rand() % text.size()] = specials[rand() % sizeof(specials)];
+
+        JsonString::setScanner(JsonString::BYTES);
+        size_t expected = JsonString::scan(text.data(), text.size());
+        for (int s = JsonString::WORDS; s <= JsonString::AVX2; ++s) {
+            JsonString::Scanner used = 
+                JsonString::setScanner(static_cast<JsonString::Scanner>(s));
+            if (used != s) continue;
+            for (size_t start = 0; start < 3 && start <= text.size(); ++start) 
+            {
+                JsonString::setScanner(JsonString::BYTES);
+                size_t want = JsonString::scan(text.data() + start, 
+                                               text.size() - start);
+                JsonString::setScanner(used);
+                size_t got = JsonString::scan(text.data() + start, 
+                                              text.size() - start);
+                ostringstream msg;
+                msg << "scanner " << s << " found " << got << " not " << want
+                    << " at offset " << start;
+                Assert(got == want, msg.str());
+            }
+        }
+        Assert(expected <= text.size(), "scan past the end");
+    }
+    JsonString::setScanner(JsonString::bestScanner());
+}
+
+void testEscaping() {
+    Assert(quote("") == "\"\"", "wrong empty string");
+    Assert(quote("plain text") == "\"plain text\"", "wrong plain string");
+    Assert(quote("say \"hi\"\\now") == "\"say \\\"hi\\\"\\\\now\"", 
+           "wrong quotes: " + quote("say \"hi\"\\now"));
+    Assert(quote("a\tb\nc\rd\be\ff") == "\"a\\tb\\nc\\rd\\be\\ff\"", 
+           "wrong whitespace escapes: " + quote("a\tb\nc\rd\be\ff"));
+    Assert(quote(string("nul\0\x1f", 5)) == "\"nul\\u0000\\u001f\"", 
+           "wrong control escapes: " + quote(string("nul\0\x1f", 5)));
+    Assert(quote("caf\xc3\xa9") == "\"caf\xc3\xa9\"", "UTF-8 was altered");
+
+    string longer(100, 'z');
+    longer[70] = '"';
+    Assert(quote(longer) == "\"" + longer.substr(0, 70) + "\\\"" 
+                            + longer.substr(71) + "\"", 
+           "wrong escaping in long string");
+
+    ostringstream strm;
+    JsonString::write(strm, "x\"y");
+    Assert(strm.str() == "\"x\\\"y\"", "wrong stream output: " + strm.str());
+}
+
+void testFormatter() {
+    JsonLinesFormatter fmtr;
+    std::shared_ptr<PropertySet> preamble(new PropertySet());
+    preamble->set("HOST", string("host\"1"));
+
+    LogRecord rec(0, 5, preamble, "pipe.isr");
+    rec.addComment("first");
+    rec.addComment("second\tline");
+    rec.addProperty("visit", 85471);
+    rec.addProperty("ratio", 0.1);
+    rec.addProperty("good", true);
+    rec.addProperty("amps", 1);
+    rec.addProperty("amps", 2);
+
+    ostringstream out;
+    fmtr.write(&out, rec);
+    string line = out.str();
+    cout << line;
+    Assert(line.find("{\"DATE\":\"") == 0, "missing DATE: " + line);
+    Assert(line.find(",\"LEVEL\":5,\"LOG\":\"pipe.isr\","
+                     "\"COMMENT\":[\"first\",\"second\\tline\"]") 
+           != string::npos, "wrong standard members: " + line);
+    Assert(line.find(",\"HOST\":\"host\\\"1\"") != string::npos, 
+           "wrong HOST: " + line);
+    Assert(line.find(",\"visit\":85471") != string::npos, 
+           "wrong visit: " + line);
+    Assert(line.find(",\"ratio\":0.1") != string::npos, 
+           "wrong ratio: " + line);
+    Assert(line.find(",\"good\":true") != string::npos, 
+           "wrong good: " + line);
+    Assert(line.find(",\"amps\":[1,2]") != string::npos, 
+           "wrong array: " + line);
+    Assert(line[line.size()-2] == '}' && line[line.size()-1] == '\n', 
+           "record not ended: " + line);
+
+    // the expanded form of a record is written the same way, but for
+    // the order of the remaining members
+    LogRecord expanded(rec);
+    expanded.data();
+    ostringstream eout;
+    fmtr.write(&eout, expanded);
+    line = eout.str();
+    cout << line;
+    Assert(line.find("{\"DATE\":\"") == 0, "missing DATE: " + line);
+    Assert(line.find(",\"LEVEL\":5,\"LOG\":\"pipe.isr\","
+                     "\"COMMENT\":[\"first\",\"second\\tline\"]") 
+           != string::npos, "wrong standard members: " + line);
+    Assert(line.find(",\"amps\":[1,2]") != string::npos, 
+           "wrong array: " + line);
+
+    // both forms give the same TIMESTAMP
+    string compactLine = out.str();
+    size_t ts = compactLine.find(",\"TIMESTAMP\":");
+    Assert(ts != string::npos, "missing TIMESTAMP: " + compactLine);
+    string stamp = compactLine.substr(ts, compactLine.find(',', ts+1) - ts);
+    Assert(line.find(stamp) != string::npos, 
+           "TIMESTAMPs differ: " + stamp + " vs " + line);
+
+    // values of a property that are not kept together are still gathered
+    // into one array
+    LogRecord scattered(0, 5, preamble, "pipe.isr");
+    scattered.addProperty("visit", 1);
+    scattered.addProperty("HOST", string("host2"));
+    ostringstream scout;
+    fmtr.write(&scout, scattered);
+    Assert(scout.str().find(",\"HOST\":[\"host\\\"1\",\"host2\"]") 
+           != string::npos, "scattered values not gathered: " + scout.str());
+
+    // a single comment is still written as an array
+    LogRecord single(0, 5);
+    single.addComment("done");
+    ostringstream oneout;
+    fmtr.write(&oneout, single);
+    Assert(oneout.str().find(",\"COMMENT\":[\"done\"]") != string::npos, 
+           "single comment not an array: " + oneout.str());
+
+    LogRecord special(0, 5);
+    special.addProperty("LOG", string("x"));
+    special.addProperty("inf", 1.0/0.0);
+    ostringstream sout;
+    fmtr.write(&sout, special);
+    Assert(sout.str().find(",\"inf\":null") != string::npos, 
+           "wrong infinity: " + sout.str());
+}
+
+int main() {
+    testScanners();
+    testEscaping();
+    testFormatter();
+    return 0;
+}
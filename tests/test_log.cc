@@ -24,6 +24,7 @@
 #include "lsst/pex/logging/ScreenLog.h"
 #include <iostream>
 #include <memory>
+#include <sstream>
 
 using lsst::pex::logging::Log;
 using lsst::pex::logging::ScreenLog;
@@ -117,6 +118,66 @@ int main() {
     // test flushing on delete
     Rec(tgclog, Log::FATAL) << "never mind";
 
-
-    
+    // test that children see, but do not alter, their parent's preamble
+    Log shlog(tgclog, "share");
+    assure(shlog.getPreamble().get<string>("RUNID") == "testRun",
+           "child did not inherit preamble");
+    assure(shlog.getPreamble().get<string>("LOG") == "test.grand.child.share",
+           "wrong LOG in child's preamble");
+    assure(tgclog.getPreamble().get<string>("LOG") == "test.grand.child",
+           "child changed parent's LOG");
+    shlog.addLabel("shared");
+    shlog.setPreambleProperty("RUNID", string("otherRun"));
+    assure(shlog.getPreamble().get<string>("LABEL") == "shared",
+           "label not added to child's preamble");
+    assure(shlog.getPreamble().get<string>("RUNID") == "otherRun",
+           "child's preamble not updated");
+    assure(! tgclog.getPreamble().exists("LABEL"), 
+           "child's label leaked into parent's preamble");
+    assure(tgclog.getPreamble().get<string>("RUNID") == "testRun",
+           "child's update leaked into parent's preamble");
+    Log shcopy(shlog);
+    shlog.addPreambleProperty("RUNID", string("thirdRun"));
+    assure(shcopy.getPreamble().valueCount("RUNID") == 1, 
+           "update leaked into copy's preamble");
+
+    // test "{}"-style formatting
+    {
+        lsst::pex::logging::FormatBuffer buf;
+        buf.format("{} of {} at {:.2f}: {}{{}}", 3, 10u, 0.25, string("done"));
+        assure(buf.str() == "3 of 10 at 0.25: done{}", 
+               "wrong {}-formatting: " + buf.str());
+        buf.clear();
+        buf.format("[{:>5}|{:<4}|{:04x}|{}|{}]", "ab", 'c', 255, true, -7L);
+        assure(buf.str() == "[   ab|c   |00ff|true|-7]", 
+               "wrong {}-formatting with specs: " + buf.str());
+        buf.clear();
+        buf.format("{} and {}", 1);
+        assure(buf.str() == "1 and {}", "missing argument not left as is");
+
+        // no truncation, however long the message
+        string longval(10000, 'x');
+        buf.clear();
+        buf.printf("%s|%d", longval.c_str(), 5);
+        assure(buf.size() == 10002, "long printf-style message truncated");
+        buf.printf("+%s", "tail");
+        assure(buf.size() == 10007 && buf.str().substr(10000) == "|5+tail",
+               "printf-style message not appended: " + buf.str().substr(9990));
+    }
+    {
+        ostringstream out;
+        Log flog(Log::INFO, "fmt");
+        flog.addDestination(out, Log::DEBUG);
+        flog.infofmt("{} apples", 5);
+        flog.debugfmt("{} pears", 6);      // below threshold
+        assure(out.str().find("5 apples") != string::npos, 
+               "infofmt message not recorded");
+        assure(out.str().find("pears") == string::npos, 
+               "debugfmt message recorded below threshold");
+
+        string longval(300, 'y');
+        flog.infof("%s", longval.c_str());
+        assure(out.str().find(longval) != string::npos, 
+               "long infof message truncated");
+    }
 }
@@ -35,6 +35,7 @@ using lsst::pex::logging::LogFormatter;
 using lsst::pex::logging::BriefFormatter;
 using lsst::pex::logging::NetLoggerFormatter;
 using lsst::pex::logging::PrependedFormatter;
+using lsst::pex::logging::PatternFormatter;
 using lsst::daf::base::PropertySet;
 using namespace std;
 
@@ -161,6 +162,76 @@ int main() {
            "Prepended formatting miswrote log message");
     cout << "-------------" << endl;
 
+    PatternFormatter pattern("%d %L %n: %m%p{visit, ccd,missing}");
+    cap.reset(new ostringstream());
+    LogRecord lr6(1, 5);
+    lr6.setDate();
+    lr6.addComment("first");
+    lr6.addComment("second");
+    lr6.addProperty("LOG", string("pipe.isr"));
+    lr6.addProperty("visit", 85471);
+    lr6.addProperty("ccd", 12);
+    pattern.write(cap.get(), lr6);
+    msg = cap->str();
+    cout << msg;
+    regex patline("^\\d{4}\\-\\d{2}\\-\\d{2}T\\d{2}:\\d{2}:\\d{2}\\.\\d{6} "
+                  "INFO pipe.isr: first visit=85471 ccd=12\n"
+                  "\\d{4}\\-\\d{2}\\-\\d{2}T\\d{2}:\\d{2}:\\d{2}\\.\\d{6} "
+                  "INFO pipe.isr: second visit=85471 ccd=12\n$");
+    Assert(regex_search(msg, patline), "Pattern formatting failed: " + msg);
+
+    PatternFormatter others("[%l|%b|%v{ccd}|%v{nope}] 100%% %q %v %n");
+    cap.reset(new ostringstream());
+    lr5.addProperty("ccd", 3);
+    lr5.addProperty("ccd", 4);
+    others.write(cap.get(), lr5);
+    msg = cap->str();
+    cout << msg;
+    Assert(msg == "[5|{'patch': 0}|3,4|] 100% %q %v tester5\n", 
+           "Pattern directives miswritten: " + msg);
+
+    // a pattern without %m writes one line per record
+    PatternFormatter nomsg("%n");
+    cap.reset(new ostringstream());
+    nomsg.write(cap.get(), lr6);
+    Assert(cap->str() == "pipe.isr\n", "Message-less pattern failed");
+
+    // the compact and expanded forms of a record are written the same way
+    LogRecord lr7(lr6);
+    lr7.data();
+    cap.reset(new ostringstream());
+    pattern.write(cap.get(), lr7);
+    Assert(regex_search(cap->str(), patline), 
+           "Pattern formatting of expanded record failed: " + cap->str());
+
+    // the properties of a compact record are found in its preamble and 
+    // its extra properties without assembling it
+    shared_ptr<PropertySet> shared(new PropertySet());
+    shared->set("ccd", 1);
+    shared->set("RUNID", string("run7"));
+    LogRecord lr8(1, 5, shared, "pipe.isr", true);
+    lr8.addComment("done");
+    lr8.addProperty("ccd", 2);
+    lr8.addProperty("visit", 85471);
+    PatternFormatter named("%v{ccd}|%v{LEVEL}|%v{COMMENT}|%v{TIMESTAMP}"
+                           "%p{RUNID,visit,LOG}");
+    cap.reset(new ostringstream());
+    named.write(cap.get(), lr8);
+    Assert(lr8.isCompact(), "compact record assembled by %v or %p");
+    string compactText = cap->str();
+    LogRecord lr9(lr8);
+    lr9.data();
+    cap.reset(new ostringstream());
+    named.write(cap.get(), lr9);
+    Assert(compactText == cap->str(), 
+           "compact and expanded records' properties differ: " + 
+           compactText + " vs. " + cap->str());
+    Assert(compactText.find("1,2|5|done|") == 0 && 
+           compactText.find(" RUNID=run7 visit=85471 LOG=pipe.isr\n") 
+               != string::npos,
+           "compact record's properties miswritten: " + compactText);
+    cout << "-------------" << endl;
+
     delete notsobrief;
     delete brief;
     delete nl;
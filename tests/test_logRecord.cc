@@ -126,4 +126,94 @@ int main() {
     cout << "  dpint: " << lr3.data().get<int>("dpint") << endl;
     cout << "  dpfloat: " << lr3.data().get<float>("dpfloat") << endl;
     cout << "  dplong: " << lr3.data().get<long>("dplong") << endl;
+
+    // a record made from a shared preamble stays compact until its 
+    // PropertySet is requested for update
+    std::shared_ptr<const PropertySet> shared(preamble.deepCopy());
+    LogRecord lr4(1, 5, shared, "tester");
+    assure(lr4.isCompact(), "new record is not compact");
+    assure(lr4.getPreamble() == shared, "preamble was not shared");
+    assure(lr4.hasLogName() && lr4.getLogName() == "tester", 
+           "wrong log name");
+    assure(lr4.hasDate(), "new record has no date");
+    lr4.addComment(simple);
+    lr4.addComment("another comment");
+    lr4.addProperty("dpstr", "hello");
+    lr4.addProperty("dpint2", 3);
+    assure(lr4.getComments().size() == 2, "wrong number of compact comments");
+
+    const LogRecord& clr4 = lr4;
+    assure(clr4.countParamNames() == 10, "wrong assembled property count");
+    assure(lr4.isCompact(), "read-only access expanded the record");
+    assure(clr4.data().get<string>("LOG") == "tester", "wrong assembled LOG");
+    assure(clr4.data().get<int>("LEVEL") == 5, "wrong assembled LEVEL");
+    assure(clr4.data().get<string>("dpstr") == "hello", "wrong string prop");
+    assure(clr4.data().get<int>("dpint2") == 3, "wrong int prop");
+    assure(clr4.data().getArray<string>("COMMENT").size() == 2,
+           "wrong assembled comment count");
+    assure(clr4.data().get<DateTime>("TIMESTAMP").nsecs(DateTime::UTC) == 
+           lr4.getTimestamp(), "wrong assembled TIMESTAMP");
+    assure(clr4.data().get<string>("DATE") == lr4.getDate(), 
+           "wrong assembled DATE");
+
+    // dates carry zero-padded microseconds, and the prefix remembered for
+    // one second must not leak into the next
+    assure(LogRecord::formatDate(1456848245012345678LL) == 
+           "2016-03-01T16:04:05.012345", "wrong formatted DATE");
+    assure(LogRecord::formatDate(1456848245000001000LL) == 
+           "2016-03-01T16:04:05.000001", "fraction not zero-padded");
+    assure(LogRecord::formatDate(1456848246999999999LL) == 
+           "2016-03-01T16:04:06.999999", "wrong DATE for the next second");
+
+    LogRecord lr5(lr4);
+    assure(lr5.isCompact(), "copy of compact record is not compact");
+    assure(lr5.getPreamble() == shared, "copy did not share preamble");
+    lr5.addComment("only in copy");
+    assure(lr4.getComments().size() == 2, "copy shares comments");
+
+    lr4.data().add("dpint2", 4);
+    assure(! lr4.isCompact(), "updatable access did not expand the record");
+    assure(lr4.countParamValues() == 12, "wrong expanded value count");
+    assure(shared->nameCount() == 3, "expanding altered the shared preamble");
+    lr4.addComment("after expanding");
+    assure(lr4.data().getArray<string>("COMMENT").size() == 3,
+           "comment not added after expanding");
+
+    // setting a core property expands the record
+    LogRecord lr6(1, 5, shared, "tester");
+    lr6.addProperty("LOG", string("other"));
+    assure(! lr6.isCompact(), "core property did not expand the record");
+
+    LogRecord lr7(10, 5, shared, "tester");
+    lr7.addComment(simple);
+    assure(lr7.countParamNames() == 0, "quiet compact record has data");
+
+    // exception-free access to the standard properties
+    LogRecord lr8(1, 5, shared, "tester");
+    lr8.setDate();
+    lr8.addComment("try me");
+    int level = 0;
+    string sval("unset");
+    std::vector<string> trycomments;
+    assure(lr8.tryGetLevel(level) && level == 5, "tryGetLevel failed");
+    assure(lr8.tryGetLogName(sval) && sval == "tester", 
+           "tryGetLogName failed");
+    assure(! lr8.tryGetLabel(sval) && sval == "tester", 
+           "tryGetLabel found a missing label");
+    assure(lr8.tryGetDate(sval) && sval == lr8.getDate(), 
+           "tryGetDate failed");
+    assure(lr8.tryGetComments(trycomments) && trycomments.size() == 1, 
+           "tryGetComments failed");
+    assure(lr8.isCompact(), "try-get access expanded the record");
+
+    lr8.data().set("LABEL", 7);
+    assure(! lr8.tryGetLabel(sval), "tryGetLabel accepted a mis-typed label");
+    lr8.data().set("LABEL", string("special"));
+    assure(lr8.tryGetLabel(sval) && sval == "special", 
+           "tryGetLabel failed on an expanded record");
+    assure(lr8.tryGetLevel(level) && level == 5, 
+           "tryGetLevel failed on an expanded record");
+    double dval = 0.0;
+    assure(! lr8.tryGet("LABEL", dval), "tryGet accepted the wrong type");
+    assure(! lr8.tryGet("NOSUCH", sval), "tryGet found a missing property");
 }
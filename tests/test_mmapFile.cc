@@ -0,0 +1,275 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @brief  This will test appending to, truncating and recovering a log
+ * written with the MmapFileDestination, including from several threads.
+ */
+
+#include "lsst/pex/logging/MmapFileDestination.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/exceptions.h"
+#include <boost/filesystem/operations.hpp>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <signal.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::MmapFileDestination;
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a formatter that prints only the comment
+class CommentFormatter : public LogFormatter {
+public:
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        (*strm) << rec.getComments().front() << '\n';
+    }
+};
+
+string readFile(const fs::path& path) {
+    ifstream in(path.string().c_str(), ios::binary);
+    ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+string message(int thread, int i) {
+    ostringstream msg;
+    msg << "thread " << thread << " record " << i;
+    return msg.str();
+}
+
+void writeMany(MmapFileDestination *dest, int thread, int n) {
+    for(int i=0; i < n; ++i) {
+        LogRecord rec(Log::DEBUG, Log::INFO);
+        rec.addComment(message(thread, i));
+        dest->write(rec);
+    }
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    size_t page = sysconf(_SC_PAGESIZE);
+
+    // the file is cut back to the records written when the destination
+    // is deleted, and reopening it appends
+    fs::path simple = dir / "simple.log";
+    {
+        MmapFileDestination dest(simple, fmtr, Log::INFO);
+        Assert(dest.getChunkSize() == MmapFileDestination::DEFAULT_CHUNK_SIZE,
+               "wrong default chunk size");
+        LogRecord rec(Log::DEBUG, Log::INFO);
+        rec.addComment("one");
+        Assert(dest.write(rec), "failed to write a record");
+        LogRecord quiet(Log::DEBUG, Log::DEBUG);
+        quiet.addComment("quiet");
+        Assert(! dest.write(quiet), "record below threshold written");
+        Assert(dest.getSize() == 4, "wrong size");
+        Assert(fs::file_size(simple) >= dest.getChunkSize(),
+               "file not extended by a chunk");
+        dest.flush();
+    }
+    Assert(readFile(simple) == "one\n",
+           "file not truncated: " + readFile(simple));
+    {
+        MmapFileDestination dest(simple.string(), fmtr);
+        Assert(dest.getSize() == 4, "existing records not counted");
+        LogRecord rec(Log::DEBUG, Log::INFO);
+        rec.addComment("two");
+        dest.write(rec);
+    }
+    Assert(readFile(simple) == "one\ntwo\n",
+           "file not appended to: " + readFile(simple));
+    {
+        MmapFileDestination dest(simple.c_str(), fmtr, Log::INFO, true);
+        Assert(dest.getSize() == 0, "file not truncated on opening");
+    }
+    Assert(fs::file_size(simple) == 0, "truncated file not empty");
+
+    // the chunk size is rounded up to whole pages, and records may
+    // straddle chunks
+    fs::path chunked = dir / "chunked.log";
+    {
+        ostringstream expected;
+        {
+            MmapFileDestination dest(chunked, fmtr, Log::INFO, false, 100);
+            Assert(dest.getChunkSize() == page,
+                   "chunk size not rounded to a page");
+            writeMany(&dest, 0, 2000);
+        }
+        for(int i=0; i < 2000; ++i) expected << message(0, i) << '\n';
+        Assert(readFile(chunked) == expected.str(),
+               "records straddling chunks written incorrectly");
+    }
+
+    // threads appending at once each get their own space, and each
+    // thread's records stay in order
+    fs::path threaded = dir / "threaded.log";
+    {
+        const int nthreads = 4, n = 5000;
+        {
+            MmapFileDestination dest(threaded, fmtr, Log::INFO, false,
+                                     4*page);
+            vector<thread> threads;
+            for(int t=0; t < nthreads; ++t)
+                threads.push_back(thread(writeMany, &dest, t, n));
+            for(int t=0; t < nthreads; ++t) threads[t].join();
+        }
+
+        istringstream in(readFile(threaded));
+        vector<int> next(nthreads, 0);
+        string line;
+        int count = 0;
+        while (getline(in, line)) {
+            int t = line[7] - '0';
+            Assert(t >= 0 && t < nthreads, "garbled record: " + line);
+            Assert(line == message(t, next[t]++),
+                   "garbled or out of order record: " + line);
+            ++count;
+        }
+        Assert(count == nthreads*n, "records lost");
+    }
+
+    // a log left behind by a crash is trimmed to its last complete line
+    fs::path crashed = dir / "crashed.log";
+    {
+        string left("one\ntwo\nthr");
+        left.append(3*page, '\0');
+        ofstream out(crashed.string().c_str(), ios::binary);
+        out.write(left.data(), left.size());
+    }
+    Assert(MmapFileDestination::recover(crashed) == 3*page + 3,
+           "wrong number of bytes recovered");
+    Assert(readFile(crashed) == "one\ntwo\n",
+           "crashed log not recovered: " + readFile(crashed));
+    {
+        ofstream out(crashed.string().c_str(), ios::binary | ios::app);
+        out << string(page, '\0');
+    }
+    {
+        // opening a crashed log recovers it before appending
+        MmapFileDestination dest(crashed, fmtr);
+        Assert(dest.getSize() == 8, "crashed log not recovered on opening");
+        LogRecord rec(Log::DEBUG, Log::INFO);
+        rec.addComment("three");
+        dest.write(rec);
+    }
+    Assert(readFile(crashed) == "one\ntwo\nthree\n",
+           "recovered log appended to incorrectly: " + readFile(crashed));
+    Assert(MmapFileDestination::recover(crashed) == 0,
+           "a cleanly closed log was trimmed");
+
+    // a file without NUL padding is not trimmed, even if its last line
+    // is unfinished or it has no lines at all
+    fs::path unfinished = dir / "unfinished.log";
+    {
+        ofstream out(unfinished.string().c_str(), ios::binary);
+        out << "one\ntwo";
+    }
+    Assert(MmapFileDestination::recover(unfinished) == 0,
+           "an unpadded log was trimmed");
+    {
+        MmapFileDestination dest(unfinished, fmtr);
+        Assert(dest.getSize() == 7, "an unpadded log was trimmed on opening");
+    }
+    Assert(readFile(unfinished) == "one\ntwo",
+           "unpadded log changed: " + readFile(unfinished));
+    fs::path noLines = dir / "nolines.log";
+    {
+        ofstream out(noLines.string().c_str(), ios::binary);
+        out << "no newline";
+    }
+    Assert(MmapFileDestination::recover(noLines) == 0 && 
+           fs::file_size(noLines) == 10, "a log without lines was trimmed");
+
+    // a record that the file cannot be extended to hold is dropped,
+    // leaving no gap, rather than the failure being thrown
+    fs::path limited = dir / "limited.log";
+    {
+        struct rlimit saved, small;
+        getrlimit(RLIMIT_FSIZE, &saved);
+        small = saved;
+        small.rlim_cur = 2*page;
+        signal(SIGXFSZ, SIG_IGN);
+        setrlimit(RLIMIT_FSIZE, &small);
+
+        ostringstream expected;
+        int failed = 0;
+        {
+            MmapFileDestination dest(limited, fmtr, Log::INFO, false, page);
+            for(int i=0; i < 500; ++i) {
+                LogRecord rec(Log::DEBUG, Log::INFO);
+                rec.addComment(message(0, i));
+                if (dest.write(rec))
+                    expected << message(0, i) << '\n';
+                else
+                    ++failed;
+            }
+            Assert(failed > 0, "writing past the file size limit succeeded");
+            Assert(dest.getFailureCount() == static_cast<unsigned>(failed),
+                   "wrong number of failures");
+            Assert(dest.getSize() == expected.str().size(),
+                   "failed records were given space");
+        }
+        setrlimit(RLIMIT_FSIZE, &saved);
+        signal(SIGXFSZ, SIG_DFL);
+        Assert(readFile(limited) == expected.str(),
+               "records lost or gaps left by failed writes");
+    }
+
+    // a file that cannot be opened is reported
+    bool thrown = false;
+    try {
+        MmapFileDestination dest(dir / "missing" / "x.log", fmtr);
+    }
+    catch (lsst::pex::exceptions::IoError&) {
+        thrown = true;
+    }
+    Assert(thrown, "unopenable file not reported");
+
+    fs::remove_all(dir);
+    return 0;
+}
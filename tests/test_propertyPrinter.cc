@@ -21,11 +21,20 @@
  */
  
 #include "lsst/pex/logging/PropertyPrinter.h"
+#include "lsst/pex/logging/PropertyVisitor.h"
+#include "lsst/pex/logging/NumberFormat.h"
+#include <clocale>
+#include <climits>
+#include <cstdlib>
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <stdexcept>
 
 using lsst::pex::logging::PropertyPrinter;
+using lsst::pex::logging::PropertyVisitor;
+using lsst::pex::logging::PropertyValue;
+using lsst::pex::logging::NumberFormat;
 using lsst::daf::base::PropertySet;
 using namespace std;
 
@@ -34,6 +43,63 @@ void assure(bool mustBeTrue, const string& failureMsg) {
         throw runtime_error(failureMsg);
 }
 
+template <class T>
+string render(T val) {
+    string out;
+    NumberFormat::append(val, out);
+    return out;
+}
+
+// check that numbers are rendered exactly and in the fewest digits
+void testNumbers() {
+    assure(render(0) == "0", "wrong zero: " + render(0));
+    assure(render(-42L) == "-42", "wrong negative: " + render(-42L));
+    assure(render(LLONG_MIN) == "-9223372036854775808", 
+           "wrong LLONG_MIN: " + render(LLONG_MIN));
+    assure(render(ULLONG_MAX) == "18446744073709551615", 
+           "wrong ULLONG_MAX: " + render(ULLONG_MAX));
+
+    assure(render(15.0) == "15", "wrong whole double: " + render(15.0));
+    assure(render(0.1) == "0.1", "wrong 0.1: " + render(0.1));
+    assure(render(-2.5e-8) == "-2.5e-08", "wrong small: " + render(-2.5e-8));
+    assure(render(1e20) == "1e+20", "wrong large: " + render(1e20));
+    assure(render(-0.0) == "-0", "wrong negative zero: " + render(-0.0));
+    assure(render(0.1f) == "0.1", "wrong float: " + render(0.1f));
+    assure(render(16777216.0f) == "16777216", 
+           "wrong large float: " + render(16777216.0f));
+
+    double third = 1.0/3.0, sum = 0.1 + 0.2;
+    assure(std::strtod(render(third).c_str(), 0) == third, 
+           "1/3 does not round-trip: " + render(third));
+    assure(render(sum) == "0.30000000000000004", 
+           "0.1+0.2 does not round-trip: " + render(sum));
+    float fthird = 1.0f/3.0f;
+    assure(std::strtof(render(fthird).c_str(), 0) == fthird, 
+           "float 1/3 does not round-trip: " + render(fthird));
+
+    // the decimal point does not follow the locale
+    const char *locales[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", 0 };
+    for (const char **loc = locales; *loc != 0; ++loc) {
+        if (std::setlocale(LC_NUMERIC, *loc) == 0) continue;
+        string val = render(2.5);
+        std::setlocale(LC_NUMERIC, "C");
+        assure(val == "2.5", string("wrong value in ") + *loc + ": " + val);
+        break;
+    }
+}
+
+// records each value visited as "name[index]=value;"
+class Recorder : public PropertyVisitor {
+public:
+    virtual void visit(const string& name, const PropertyValue& value,
+                       std::size_t index) 
+    {
+        out << name << "[" << index << "]=";
+        value.write(out) << ";";
+    }
+    ostringstream out;
+};
+
 int main() {
 
     PropertySet ps;
@@ -52,6 +118,58 @@ int main() {
         }
     }
 
+    // the visitor sees the same values, in place
+    ps.add("count", 5);
+    ps.set("ratio", 0.5);
+    Recorder rec;
+    PropertyVisitor::visitAll(ps, rec);
+    string visited = rec.out.str();
+    assure(visited.find("count[0]=4;count[1]=5;") != string::npos,
+           "wrong multi-valued visit: " + visited);
+    assure(visited.find("done[0]=true;") != string::npos,
+           "wrong bool visit: " + visited);
+    assure(visited.find("name[0]=Ray;") != string::npos,
+           "wrong string visit: " + visited);
+    assure(visited.find("ratio[0]=0.5;") != string::npos,
+           "wrong double visit: " + visited);
+
+    Recorder one;
+    PropertyVisitor::visitValues(ps, "count", one);
+    assure(one.out.str() == "count[0]=4;count[1]=5;", 
+           "wrong visit of one property: " + one.out.str());
+
+    // typed access to a visited value
+    class IntSum : public PropertyVisitor {
+    public:
+        IntSum() : sum(0) { }
+        virtual void visit(const string&, const PropertyValue& value,
+                           std::size_t) 
+        {
+            const int *val = value.get<int>();
+            assure(val != 0, "int value not recognized");
+            assure(value.get<double>() == 0, "int value taken for double");
+            sum += *val;
+        }
+        int sum;
+    } sum;
+    PropertyVisitor::visitValues(ps, "count", sum);
+    assure(sum.sum == 9, "wrong sum of visited values");
+
+    struct Unprintable { int i; };
+    assure(! PropertyVisitor::isSupported(typeid(Unprintable)), 
+           "unexpected support for a type");
+    assure(PropertyVisitor::isSupported(typeid(lsst::daf::base::DateTime)), 
+           "DateTime not supported");
+
+    // PropertyPrinter still prints the same way
+    PropertyPrinter cpp(ps, "count");
+    ostringstream printed;
+    for(PropertyPrinter::iterator i=cpp.begin(); i.notAtEnd(); ++i) 
+        i.write(&printed) << ";";
+    assure(printed.str() == "4;5;", "wrong printed values: " + printed.str());
+
+    testNumbers();
+
     return 0;
 }
     
@@ -0,0 +1,301 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @brief  This will test rotating and compressing log files with the
+ * RotatingFileDestination.
+ */
+
+#include "lsst/pex/logging/RotatingFileDestination.h"
+#include "lsst/pex/logging/BinaryLogReader.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+#include <boost/filesystem/operations.hpp>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+using lsst::pex::logging::BinaryFormatter;
+using lsst::pex::logging::BinaryLogReader;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::RotatingFileDestination;
+using lsst::pex::logging::RotationPolicy;
+using namespace std;
+namespace fs = boost::filesystem;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a formatter that prints only the comment
+class CommentFormatter : public LogFormatter {
+public:
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        (*strm) << rec.getComments().front() << '\n';
+    }
+};
+
+string message(int i) {
+    ostringstream msg;
+    msg << "record number " << setw(3) << setfill('0') << i;
+    return msg.str();
+}
+
+void send(RotatingFileDestination& dest, int i) {
+    LogRecord rec(0, Log::INFO);
+    rec.addComment(message(i));
+    dest.write(rec);
+}
+
+string readFile(const fs::path& path) {
+    ifstream in(path.string().c_str());
+    ostringstream contents;
+    contents << in.rdbuf();
+    return contents.str();
+}
+
+string readGzip(const fs::path& path) {
+    gzFile in = gzopen(path.string().c_str(), "rb");
+    Assert(in != 0, "can't open " + path.string());
+    string contents;
+    char buf[4096];
+    int n;
+    while ((n = gzread(in, buf, sizeof(buf))) > 0) contents.append(buf, n);
+    gzclose(in);
+    return contents;
+}
+
+// the text of records first through last
+string expected(int first, int last) {
+    string text;
+    for(int i=first; i <= last; ++i) text += message(i) + '\n';
+    return text;
+}
+
+// files are rotated before they exceed the size limit and old ones are
+// shifted along, keeping only as many as asked
+void testSize(const fs::path& dir) {
+    fs::path path = dir / "size.log";
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    {
+        RotatingFileDestination dest(path, fmtr, 
+                                     RotationPolicy::bySize(100, 3));
+        for(int i=0; i < 40; ++i) send(dest, i);
+        dest.flush();
+        Assert(dest.getSize() == fs::file_size(path), "wrong size");
+    }
+
+    // each record is 18 bytes with its newline, so 5 fit in 100 bytes
+    string all;
+    for(int gen=3; gen > 0; --gen) {
+        ostringstream name;
+        name << path.string() << '.' << gen;
+        Assert(fs::exists(name.str()), "missing " + name.str());
+        string text = readFile(name.str());
+        Assert(text.size() <= 100, name.str() + " is too large");
+        all += text;
+    }
+    all += readFile(path);
+    Assert(! fs::exists(path.string() + ".4"), "kept too many files");
+    Assert(all == expected(20, 39), "unexpected records:\n" + all);
+}
+
+// old files are gzipped in the background
+void testCompression(const fs::path& dir) {
+    fs::path path = dir / "gz.log";
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    RotatingFileDestination dest(path, fmtr, 
+                                 RotationPolicy::bySize(100, 2, true));
+    for(int i=0; i < 30; ++i) send(dest, i);
+    dest.flush();
+    dest.waitForCompression();
+
+    Assert(readGzip(path.string() + ".2.gz") == expected(15, 19), 
+           "unexpected contents of .2.gz");
+    Assert(readGzip(path.string() + ".1.gz") == expected(20, 24),
+           "unexpected contents of .1.gz");
+    Assert(readFile(path) == expected(25, 29), 
+           "unexpected contents of the current file");
+    Assert(! fs::exists(path.string() + ".3.gz"), "kept too many files");
+    for(fs::directory_iterator di(dir); di != fs::directory_iterator(); ++di)
+        Assert(di->path().string().find(".rotated-") == string::npos &&
+               di->path().extension() != ".tmp", 
+               "left behind " + di->path().string());
+}
+
+// rotate() and reopen() may be called directly
+void testManual(const fs::path& dir) {
+    fs::path path = dir / "manual.log";
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    RotatingFileDestination dest(path, fmtr, RotationPolicy());
+    send(dest, 0);
+    dest.rotate();
+    send(dest, 1);
+
+    // as logrotate would do it
+    fs::rename(path, dir / "moved.log");
+    send(dest, 2);
+    dest.reopen();
+    send(dest, 3);
+    dest.flush();
+
+    Assert(readFile(path.string() + ".1") == expected(0, 0), 
+           "rotate() failed");
+    Assert(readFile(dir / "moved.log") == expected(1, 2), 
+           "wrote to the wrong file before reopen()");
+    Assert(readFile(path) == expected(3, 3), "reopen() failed");
+    Assert(dest.getSize() == expected(3, 3).size(), "wrong size");
+}
+
+// each file written with a BinaryFormatter can be decoded on its own
+void testBinary(const fs::path& dir) {
+    fs::path path = dir / "binary.log";
+    shared_ptr<LogFormatter> fmtr(new BinaryFormatter());
+    {
+        RotatingFileDestination dest(path, fmtr, 
+                                     RotationPolicy::bySize(200, 3));
+        for(int i=0; i < 20; ++i) send(dest, i);
+    }
+
+    int last = 20;
+    for(int gen=0; gen <= 3; ++gen) {
+        ostringstream name;
+        name << path.string();
+        if (gen > 0) name << '.' << gen;
+        Assert(fs::exists(name.str()), "missing " + name.str());
+
+        ifstream in(name.str().c_str(), ios::binary);
+        BinaryLogReader reader(in);
+        vector<string> comments;
+        shared_ptr<LogRecord> rec;
+        while ((rec = reader.next())) 
+            comments.push_back(rec->getComments().front());
+        Assert(! comments.empty(), "no records in " + name.str());
+        for(size_t i=comments.size(); i > 0; --i) {
+            Assert(comments[i-1] == message(--last), 
+                   "unexpected record in " + name.str());
+        }
+    }
+}
+
+// a file that cannot be renamed is appended to rather than emptied
+void testFailedRename(const fs::path& dir) {
+    fs::path path = dir / "stuck.log";
+    fs::create_directories(path.string() + ".1/occupied");
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    {
+        RotatingFileDestination dest(path, fmtr, 
+                                     RotationPolicy::bySize(100, 1));
+        for(int i=0; i < 10; ++i) send(dest, i);
+    }
+    Assert(readFile(path) == expected(0, 9), 
+           "records lost when a rename failed:\n" + readFile(path));
+}
+
+// a file that cannot be compressed is held until it can be, without
+// disturbing the files already compressed
+void testFailedCompression(const fs::path& dir) {
+    fs::path path = dir / "held.log";
+    fs::path blocker(path.string() + ".rotated-2.gz.tmp");
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    RotatingFileDestination dest(path, fmtr, 
+                                 RotationPolicy::bySize(100, 3, true));
+    for(int i=0; i < 5; ++i) send(dest, i);
+    dest.rotate();
+    dest.waitForCompression();
+    Assert(readGzip(path.string() + ".1.gz") == expected(0, 4), 
+           "unexpected contents of .1.gz");
+
+    fs::create_directories(blocker / "occupied");
+    for(int i=5; i < 10; ++i) send(dest, i);
+    dest.rotate();
+    dest.waitForCompression();
+    Assert(readFile(path.string() + ".rotated-2") == expected(5, 9), 
+           "uncompressed file not held");
+    Assert(readGzip(path.string() + ".1.gz") == expected(0, 4) &&
+           ! fs::exists(path.string() + ".2.gz") && 
+           ! fs::exists(path.string() + ".1"), 
+           "generations shifted for a file that was not compressed");
+
+    fs::remove_all(blocker);
+    for(int i=10; i < 15; ++i) send(dest, i);
+    dest.rotate();
+    dest.waitForCompression();
+    Assert(! fs::exists(path.string() + ".rotated-2"), 
+           "held file not compressed later");
+    Assert(readGzip(path.string() + ".3.gz") == expected(0, 4) &&
+           readGzip(path.string() + ".2.gz") == expected(5, 9) &&
+           readGzip(path.string() + ".1.gz") == expected(10, 14),
+           "compressed files out of order");
+}
+
+// files are rotated when the clock passes a multiple of the interval
+void testInterval(const fs::path& dir) {
+    fs::path path = dir / "interval.log";
+    shared_ptr<LogFormatter> fmtr(new CommentFormatter());
+    RotatingFileDestination dest(path, fmtr, RotationPolicy::byInterval(1));
+    send(dest, 0);
+    this_thread::sleep_for(chrono::milliseconds(1100));
+    send(dest, 1);
+    dest.flush();
+    Assert(readFile(path.string() + ".1") == expected(0, 0), 
+           "interval rotation failed");
+    Assert(readFile(path) == expected(1, 1), 
+           "unexpected records after interval rotation");
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / 
+                   fs::unique_path("rotating-%%%%-%%%%");
+    fs::create_directories(dir);
+    try {
+        testSize(dir);
+        testCompression(dir);
+        testManual(dir);
+        testBinary(dir);
+        testFailedRename(dir);
+        testFailedCompression(dir);
+        testInterval(dir);
+    }
+    catch (...) {
+        fs::remove_all(dir);
+        throw;
+    }
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,211 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/**
+ * @brief  This will test that a Log renders a record only once for all of
+ * its destinations with equivalent formatters.
+ */
+
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/LogDestination.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+using lsst::pex::logging::BinaryFormatter;
+using lsst::pex::logging::BriefFormatter;
+using lsst::pex::logging::IndentedFormatter;
+using lsst::pex::logging::JsonLinesFormatter;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::NetLoggerFormatter;
+using lsst::pex::logging::PatternFormatter;
+using lsst::pex::logging::PrependedFormatter;
+using lsst::pex::logging::RenderedRecord;
+using namespace std;
+
+#define Assert(b, m) tattle(b, m, __LINE__)
+
+void tattle(bool mustBeTrue, const string& failureMsg, int line) {
+    if (! mustBeTrue) {
+        ostringstream msg;
+        msg << __FILE__ << ':' << line << ":\n" << failureMsg << ends;
+        throw runtime_error(msg.str());
+    }
+}
+
+// a formatter that counts the records it renders
+class CountingFormatter : public LogFormatter {
+public:
+    CountingFormatter() : count(0) { }
+
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        ++count;
+        (*strm) << rec.getComments().front() << '\n';
+    }
+
+    int count;
+};
+
+// a user's formatters that add state to the library's ones
+class TaggedBriefFormatter : public BriefFormatter {
+public:
+    explicit TaggedBriefFormatter(const string& tag) : tag(tag) { }
+
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        (*strm) << tag << ' ';
+        BriefFormatter::write(strm, rec);
+    }
+
+    string tag;
+};
+
+class TaggedPatternFormatter : public PatternFormatter {
+public:
+    explicit TaggedPatternFormatter(const string& tag) 
+        : PatternFormatter("%m"), tag(tag) 
+    { }
+
+    virtual void write(ostream *strm, LogRecord const& rec) {
+        (*strm) << tag << ' ';
+        PatternFormatter::write(strm, rec);
+    }
+
+    string tag;
+};
+
+shared_ptr<LogDestination> destination(ostream& out,
+                                       const shared_ptr<LogFormatter>& f)
+{
+    return shared_ptr<LogDestination>(new LogDestination(&out, f));
+}
+
+int main() {
+
+    // which formatters are equivalent
+    PrependedFormatter prepended, prepended2, verbose(true);
+    IndentedFormatter indented;
+    Assert(prepended.isEquivalent(prepended2),
+           "PrependedFormatters not equivalent");
+    Assert(! prepended.isEquivalent(verbose),
+           "verbose PrependedFormatter equivalent to a quiet one");
+    Assert(! prepended.isEquivalent(indented) &&
+           ! indented.isEquivalent(prepended),
+           "formatters of different classes equivalent");
+    Assert(! BriefFormatter().isEquivalent(prepended),
+           "a formatter equivalent to one of a subclass");
+    Assert(NetLoggerFormatter().isEquivalent(NetLoggerFormatter()) &&
+           ! NetLoggerFormatter().isEquivalent(NetLoggerFormatter("=")),
+           "wrong NetLoggerFormatter equivalence");
+    Assert(PatternFormatter("%m").isEquivalent(PatternFormatter("%m")) &&
+           ! PatternFormatter("%m").isEquivalent(PatternFormatter("%n")),
+           "wrong PatternFormatter equivalence");
+    Assert(JsonLinesFormatter().isEquivalent(JsonLinesFormatter()),
+           "JsonLinesFormatters not equivalent");
+    TaggedBriefFormatter red("red"), blue("blue");
+    TaggedPatternFormatter redPattern("red"), bluePattern("blue");
+    Assert(! red.isEquivalent(blue) && ! blue.isEquivalent(red) && 
+           ! redPattern.isEquivalent(bluePattern),
+           "subclasses that inherit isEquivalent() equivalent");
+    Assert(red.isEquivalent(red) && redPattern.isEquivalent(redPattern),
+           "a subclass not equivalent to itself");
+    BinaryFormatter binary;
+    Assert(binary.isEquivalent(binary) &&
+           ! binary.isEquivalent(BinaryFormatter()),
+           "BinaryFormatters should only be equivalent to themselves");
+
+    // a RenderedRecord renders once per distinct formatter
+    LogRecord rec(Log::DEBUG, Log::INFO);
+    rec.addComment("shared");
+    {
+        RenderedRecord rendered(rec);
+        const string& text = rendered.render(prepended);
+        Assert(text.find("shared") != string::npos,
+               "wrong rendering: " + text);
+        rendered.render(prepended2);
+        Assert(rendered.getRenderCount() == 1,
+               "equivalent formatter rendered again");
+        rendered.render(indented);
+        Assert(rendered.getRenderCount() == 2,
+               "distinct formatter not rendered");
+    }
+
+    // destinations sharing a formatter get one rendering from a Log
+    {
+        shared_ptr<CountingFormatter> counter(new CountingFormatter());
+        ostringstream out1, out2, out3;
+        Log log(Log::DEBUG, "shared");
+        log.addDestination(destination(out1, counter));
+        log.addDestination(destination(out2, counter));
+        log.addDestination(destination(out3, counter));
+        log.info("hello");
+        Assert(counter->count == 1, "record rendered more than once");
+        Assert(out1.str() == "hello\n" && out2.str() == "hello\n" &&
+               out3.str() == "hello\n", "a destination missed the record");
+
+        // ...but below-threshold destinations get nothing
+        shared_ptr<LogDestination> quiet = destination(out3, counter);
+        quiet->setThreshold(Log::WARN);
+        Log log2(Log::DEBUG, "threshold");
+        log2.addDestination(destination(out1, counter));
+        log2.addDestination(quiet);
+        out3.str("");
+        log2.info("again");
+        Assert(out3.str() == "", "threshold ignored: " + out3.str());
+    }
+
+    // equivalent but distinct formatters produce the same text
+    {
+        ostringstream out1, out2;
+        Log log(Log::DEBUG, "equivalent");
+        shared_ptr<LogFormatter> f1(new PrependedFormatter());
+        shared_ptr<LogFormatter> f2(new PrependedFormatter());
+        log.addDestination(destination(out1, f1));
+        log.addDestination(destination(out2, f2));
+        log.info("same");
+        Assert(! out1.str().empty() && out1.str() == out2.str(),
+               "outputs differ: " + out1.str() + " vs " + out2.str());
+    }
+
+    // the same holds when the Log is asynchronous
+    {
+        shared_ptr<CountingFormatter> counter(new CountingFormatter());
+        ostringstream out1, out2;
+        Log log(Log::DEBUG, "async");
+        log.addDestination(destination(out1, counter));
+        log.addDestination(destination(out2, counter));
+        log.enableAsync();
+        for(int i=0; i < 10; ++i) log.info("x");
+        log.flush();
+        Assert(counter->count == 10, "records rendered more than once");
+        Assert(out1.str() == out2.str() && out1.str().size() == 10*2,
+               "a destination missed records");
+    }
+
+    return 0;
+}
@@ -28,6 +28,9 @@
 #include "lsst/pex/logging/LogRecord.h"
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <vector>
+#include <atomic>
 
 using lsst::pex::logging::threshold::Memory;
 using namespace std;
@@ -70,5 +73,103 @@ int main() {
     Assert(mem.getThresholdFor("valley.of.the") == -11, 
            "wrong new inherited threshold");
 
+    // a cached value is only good until the next threshold change
+    Threshold::CachedThreshold cache;
+    int cached = 0;
+    unsigned int gen = Memory::getGeneration();
+    Assert(! cache.get(gen, cached), "empty cache returned a value");
+    cache.set(gen, mem.getThresholdFor("valley.of.the"));
+    Assert(cache.get(Memory::getGeneration(), cached) && cached == -11, 
+           "cache lost a value with no intervening change");
+    mem.setThresholdFor("valley", 3);
+    Assert(Memory::getGeneration() != gen, "generation did not advance");
+    Assert(! cache.get(Memory::getGeneration(), cached), 
+           "stale cached value not invalidated");
+    gen = Memory::getGeneration();
+    mem.resetThresholdFor("valley.of");
+    Assert(Memory::getGeneration() != gen, 
+           "generation did not advance on reset");
+    Assert(mem.getThresholdFor("valley.of.the") == 3, 
+           "wrong threshold after reset");
+
+    // empty fields are ignored, as with boost::char_separator
+    Assert(mem.getThresholdFor("valley..of.the.") == 3, 
+           "empty fields not ignored");
+    Assert(mem.getThresholdFor(".valley") == 3, 
+           "leading delimiter not ignored");
+    Assert(mem.getThresholdFor("valley.o") == 3, 
+           "partial field matched");
+    Assert(mem.getThresholdFor("valley.of.the.dollsx") == 3, 
+           "partial field matched");
+    Assert(mem.countNames() == 4, "wrong number of remembered names");
+
+    // the printed tree must match the original Family implementation
+    Threshold::Family fam(mem.getRootThreshold());
+    Threshold::Memory mem2;
+    const char *names[] = { "zeta.b", "alpha", "zeta.a.x", "alpha.beta", 
+                            "mid", "zeta" };
+    int threshes[] = { 2, -3, Threshold::INHERIT, 12, 7, 0 };
+    boost::char_separator<char> sep(".");
+    fam.setThreshold(mem2.getRootThreshold());
+    for(int i=0; i < 6; ++i) {
+        string name(names[i]);
+        Threshold::tokenizer fields(name, sep);
+        fam.setThresholdFor(fields.begin(), fields.end(), threshes[i]);
+        mem2.setThresholdFor(name, threshes[i]);
+    }
+    ostringstream famout, memout;
+    famout << "(root)              " << fam.getThreshold() << endl;
+    fam.printDescThresholds(famout, " ");
+    mem2.printThresholds(memout);
+    Assert(famout.str() == memout.str(), 
+           "printThresholds differs from Family:\n" + memout.str());
+
+    mem2.forgetAllNames();
+    Assert(mem2.countNames() == 0, "names not forgotten");
+    Assert(mem2.getThresholdFor("zeta.b") == mem2.getRootThreshold(), 
+           "forgotten name still has a threshold");
+    ostringstream rootonly;
+    rootonly << "(root)              " << mem2.getRootThreshold() << endl;
+    memout.str("");
+    mem2.printThresholds(memout);
+    Assert(memout.str() == rootonly.str(), 
+           "forgotten names printed:\n" + memout.str());
+    mem2.setThresholdFor("zeta.a", 4);
+    Assert(mem2.countNames() == 2, "wrong number of names set again");
+    Assert(mem2.getThresholdFor("zeta.a.x") == 4, 
+           "wrong threshold for a name set again");
+    Assert(mem2.getThresholdFor("zeta.b") == mem2.getRootThreshold(), 
+           "forgotten sibling regained its threshold");
+
+    // lookups may proceed while other threads change the thresholds
+    Threshold::Memory shared;
+    shared.setRootThreshold(1);
+    shared.setThresholdFor("a.b", 2);
+    std::atomic<bool> done(false);
+    std::atomic<int> bad(0);
+    std::vector<std::thread> readers;
+    for(int t=0; t < 3; ++t) {
+        readers.push_back(std::thread([&shared, &done, &bad]() {
+            while (! done.load()) {
+                int th = shared.getThresholdFor("a.b.c.d");
+                if (th != 2 && th != 3) ++bad;
+                if (shared.getThresholdFor("x.y") != 1) ++bad;
+            }
+        }));
+    }
+    for(int i=0; i < 20000; ++i) {
+        ostringstream name;
+        name << "a.b.n" << i;
+        shared.setThresholdFor(name.str(), -i);
+        shared.setThresholdFor("a.b", 2 + i % 2);
+    }
+    shared.setThresholdFor("a.b", 2);
+    shared.forgetAllNames();
+    shared.setThresholdFor("a.b", 2);
+    done = true;
+    for(auto& t : readers) t.join();
+    Assert(bad.load() == 0, "inconsistent threshold seen during updates");
+    Assert(shared.getThresholdFor("a.b.n5") == 2, "wrong threshold after reset");
+
     mem.printThresholds(cout);
 }
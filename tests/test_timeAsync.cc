@@ -0,0 +1,108 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * time how long it takes each of many threads to send debugging records
+ * to a Log in asynchronous mode, and check that every record arrives in
+ * time order.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/LogDestination.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+using std::cout;
+using std::endl;
+using std::shared_ptr;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+/*
+ * a formatter that only counts the records it gets and notes whether
+ * any arrive out of time order
+ */
+class CountingFormatter : public LogFormatter {
+public:
+    CountingFormatter() : count(0), late(0), _last(0) { }
+
+    virtual void write(std::ostream *, LogRecord const& rec) {
+        ++count;
+        if (rec.getTimestamp() < _last) ++late;
+        _last = rec.getTimestamp();
+    }
+
+    long count, late;
+
+private:
+    long long _last;
+};
+
+int main() {
+    const int n = 20000;
+    const int threadCounts[] = { 1, 4, 16, 32 };
+
+    for(std::size_t c=0; c < sizeof(threadCounts)/sizeof(int); ++c) {
+        int nthreads = threadCounts[c];
+        shared_ptr<CountingFormatter> fmtr(new CountingFormatter());
+        Log log(Log::DEBUG, "async");
+        log.addDestination(shared_ptr<LogDestination>(
+            new LogDestination(&cout, fmtr, Log::DEBUG)));
+        log.enableAsync();
+
+        long long t0 = usecs();
+        std::vector<std::thread> senders;
+        for(int t=0; t < nthreads; ++t) {
+            senders.push_back(std::thread([&log]() {
+                for(int i=0; i < n; ++i) log.logdebug("processing");
+            }));
+        }
+        for(auto& t : senders) t.join();
+        long long sent = usecs();
+        log.flush();
+        long long written = usecs();
+
+        cout << nthreads << " threads: " 
+             << 1000.0*(sent - t0)/n << " ns per record to send, "
+             << 1000.0*(written - t0)/(n*nthreads) 
+             << " ns per record to write; " << fmtr->late 
+             << " records out of order" << endl;
+        if (fmtr->count != static_cast<long>(n)*nthreads) 
+            throw std::runtime_error("records were lost");
+    }
+    return 0;
+}
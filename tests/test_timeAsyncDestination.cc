@@ -0,0 +1,104 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * time how long it takes to send records to a Log with a fast and a slow
+ * destination, with the slow one written to directly and through an
+ * AsyncDestination.
+ */
+#include <sys/time.h>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "lsst/pex/logging/AsyncDestination.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+using std::cout;
+using std::endl;
+using std::shared_ptr;
+using lsst::pex::logging::AsyncDestination;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+/*
+ * a formatter that counts the records it gets, taking a while over each
+ * if asked to
+ */
+class CountingFormatter : public LogFormatter {
+public:
+    explicit CountingFormatter(long micros) : count(0), _micros(micros) { }
+
+    virtual void write(std::ostream *, LogRecord const&) {
+        if (_micros > 0)
+            std::this_thread::sleep_for(std::chrono::microseconds(_micros));
+        ++count;
+    }
+
+    long count;
+
+private:
+    long _micros;
+};
+
+int main() {
+    const int n = 2000;
+    std::ostringstream sink;
+
+    for(int wrapped=0; wrapped < 2; ++wrapped) {
+        shared_ptr<CountingFormatter> fast(new CountingFormatter(0));
+        shared_ptr<CountingFormatter> slow(new CountingFormatter(50));
+        shared_ptr<LogDestination> slowDest(new LogDestination(&sink, slow));
+        if (wrapped) slowDest.reset(new AsyncDestination(slowDest, n));
+
+        Log log(Log::DEBUG, "timeAsyncDestination");
+        log.addDestination(slowDest);
+        log.addDestination(shared_ptr<LogDestination>(
+            new LogDestination(&sink, fast)));
+
+        long long t0 = usecs();
+        for(int i=0; i < n; ++i) log.info("processing");
+        long long sent = usecs();
+        log.flush();
+        long long written = usecs();
+
+        cout << (wrapped ? "through an AsyncDestination: " : "directly: ")
+             << 1.0*(sent - t0)/n << " usec per record to send, "
+             << 1.0*(written - t0)/n << " usec per record to write" << endl;
+        if (fast->count != n || slow->count != n)
+            throw std::runtime_error("records were lost");
+    }
+    return 0;
+}
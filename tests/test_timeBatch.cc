@@ -0,0 +1,88 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * time how long it takes an FdDestination to write out a backlog of
+ * records one at a time and as a batch, and count the system calls.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include <boost/filesystem/operations.hpp>
+
+#include "lsst/pex/logging/FdDestination.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+using std::cout;
+using std::endl;
+using std::shared_ptr;
+using lsst::pex::logging::FdDestination;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::PrependedFormatter;
+namespace fs = boost::filesystem;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+int main() {
+    const int n = 100000;
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    shared_ptr<LogFormatter> fmtr(new PrependedFormatter());
+
+    std::vector<shared_ptr<LogRecord> > recs;
+    std::vector<const LogRecord*> ptrs;
+    for(int i=0; i < n; ++i) {
+        recs.push_back(shared_ptr<LogRecord>(
+            new LogRecord(Log::DEBUG, Log::INFO)));
+        recs.back()->addComment("processed exposure 8471 of visit 12");
+        ptrs.push_back(recs.back().get());
+    }
+
+    {
+        FdDestination dest(dir / "single.log", fmtr);
+        long long t0 = usecs();
+        for(int i=0; i < n; ++i) dest.write(*ptrs[i]);
+        long long t = usecs() - t0;
+        cout << "one at a time: " << 1000.0*t/n << " ns per record, "
+             << dest.getSyscallCount() << " system calls" << endl;
+    }
+    {
+        FdDestination dest(dir / "batch.log", fmtr);
+        long long t0 = usecs();
+        dest.writeBatch(&ptrs[0], ptrs.size());
+        long long t = usecs() - t0;
+        cout << "as a batch: " << 1000.0*t/n << " ns per record, "
+             << dest.getSyscallCount() << " system calls" << endl;
+    }
+
+    fs::remove_all(dir);
+    return 0;
+}
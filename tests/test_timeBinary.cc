@@ -0,0 +1,109 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/*
+ * measure the cost and size of typical debug records written with the 
+ * BinaryFormatter compared to the text formatters, and the cost of 
+ * decoding them again with the BinaryLogReader.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "lsst/pex/logging/BinaryLogReader.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/daf/base/PropertySet.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using lsst::daf::base::PropertySet;
+using lsst::pex::logging::BinaryFormatter;
+using lsst::pex::logging::BinaryLogReader;
+using lsst::pex::logging::BriefFormatter;
+using lsst::pex::logging::JsonLinesFormatter;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::NetLoggerFormatter;
+using lsst::pex::logging::PrependedFormatter;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+void timeWrites(const char *what, LogFormatter& fmtr, LogRecord& rec, int n) {
+    std::ostringstream out;
+    fmtr.write(&out, rec);
+    std::size_t first = out.str().size();
+    out.str("");
+    fmtr.write(&out, rec);
+    std::size_t size = out.str().size();
+
+    std::ostream nowhere(0);
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) fmtr.write(&nowhere, rec);
+    cout << what << ": " << 1000.0*(usecs() - t0)/n << " ns per record, "
+         << size << " bytes per record (" << first << " for the first)" 
+         << endl;
+}
+
+int main() {
+    const int n = 200000;
+
+    std::shared_ptr<PropertySet> preamble(new PropertySet());
+    preamble->set("HOST", string("lsst-dev01"));
+    preamble->set("PID", 31337);
+    preamble->set("LABEL", string("visit=85471 ccd=12"));
+    LogRecord rec(-10, -3, preamble, "pipe.isr.overscan");
+    rec.addComment("fit overscan for amplifier");
+    rec.addProperty("amp", 3);
+    rec.addProperty("median", 1523.25);
+    rec.addProperty("stdev", 4.75f);
+    rec.addProperty("ccd", string("R22_S11"));
+
+    BinaryFormatter binary;
+    BriefFormatter brief(true);
+    PrependedFormatter prepended(true);
+    JsonLinesFormatter json;
+    NetLoggerFormatter netlogger;
+    timeWrites("BinaryFormatter", binary, rec, n);
+    timeWrites("BriefFormatter (verbose)", brief, rec, n);
+    timeWrites("PrependedFormatter (verbose)", prepended, rec, n);
+    timeWrites("JsonLinesFormatter", json, rec, n);
+    timeWrites("NetLoggerFormatter", netlogger, rec, n);
+
+    std::ostringstream out;
+    BinaryFormatter writer;
+    for(int i=0; i < n/4; ++i) writer.write(&out, rec);
+    std::istringstream in(out.str());
+    BinaryLogReader reader(in);
+    long long t0 = usecs();
+    while (reader.next()) { }
+    cout << "BinaryLogReader: " << 1000.0*(usecs() - t0)/reader.getRecordCount()
+         << " ns per record" << endl;
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+/*
+ * measure the cost of sending trace messages with LSST_BINARY_TRACE, 
+ * which records them to be formatted later, compared to LSST_TRACE, 
+ * which formats and writes them at once, and the cost of draining them.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "lsst/pex/logging/BinaryTrace.h"
+#include "lsst/pex/logging/LogFormatter.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using lsst::daf::base::PropertySet;
+using lsst::pex::logging::BinaryTrace;
+using lsst::pex::logging::BriefFormatter;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::Trace;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+int main() {
+    const int n = 100000, rounds = 10;
+    std::ostream nowhere(0);
+    std::list<std::shared_ptr<LogDestination> > destinations;
+    destinations.push_back(std::shared_ptr<LogDestination>(
+        new LogDestination(&nowhere, 
+                           std::shared_ptr<LogFormatter>(new BriefFormatter()),
+                           Log::DEBUG-10)));
+    Log::createDefaultLog(destinations, PropertySet());
+    Trace::setVerbosity("timing", 5);
+    string ccd("R22_S11");
+
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) 
+        LSST_TRACE("timing.text", 3, "row %d of %s: %.3f", i, ccd.c_str(), 
+                   i*0.5);
+    cout << "LSST_TRACE: " << 1000.0*(usecs() - t0)/n << " ns per message" 
+         << endl;
+
+    long long sent = 0, drained = 0;
+    for(int r=0; r < rounds; ++r) {
+        t0 = usecs();
+        for(int i=0; i < n; ++i) 
+            LSST_BINARY_TRACE("timing.binary", 3, "row {} of {}: {:.3f}", i, 
+                              ccd, i*0.5);
+        long long t1 = usecs();
+        BinaryTrace::flush();
+        sent += t1 - t0;
+        drained += usecs() - t1;
+    }
+    cout << "LSST_BINARY_TRACE: " << 1000.0*sent/(rounds*n) 
+         << " ns per message, " << 1000.0*drained/(rounds*n) 
+         << " ns per message to format and write later (" 
+         << BinaryTrace::getDropCount() << " dropped)" << endl;
+
+    std::shared_ptr<std::ostream> 
+        binary(new std::ostream(0));
+    BinaryTrace::setOutput(binary);
+    sent = drained = 0;
+    for(int r=0; r < rounds; ++r) {
+        t0 = usecs();
+        for(int i=0; i < n; ++i) 
+            LSST_BINARY_TRACE("timing.binary", 3, "row {} of {}: {:.3f}", i, 
+                              ccd, i*0.5);
+        long long t1 = usecs();
+        BinaryTrace::flush();
+        sent += t1 - t0;
+        drained += usecs() - t1;
+    }
+    BinaryTrace::setOutput(std::shared_ptr<std::ostream>());
+    cout << "LSST_BINARY_TRACE to binary output: " << 1000.0*sent/(rounds*n) 
+         << " ns per message, " << 1000.0*drained/(rounds*n) 
+         << " ns per message to write later" << endl;
+
+    t0 = usecs();
+    for(int i=0; i < n; ++i) 
+        LSST_BINARY_TRACE("timing.binary", 8, "row {} of {}", i, ccd);
+    cout << "LSST_BINARY_TRACE not recorded: " << 1000.0*(usecs() - t0)/n 
+         << " ns per message" << endl;
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * compare the time taken to write verbose debugging records, shaped like
+ * those of test_log, to a plain FileDestination and to a
+ * CompressedFileDestination at several levels, and the sizes of the
+ * files that result.
+ */
+#include <sys/time.h>
+#include <boost/filesystem/operations.hpp>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "lsst/pex/logging/CompressedFileDestination.h"
+#include "lsst/pex/logging/FileDestination.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::shared_ptr;
+using lsst::pex::logging::CompressedFileDestination;
+using lsst::pex::logging::FileDestination;
+using lsst::pex::logging::FlushPolicy;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::PrependedFormatter;
+using lsst::daf::base::PropertySet;
+namespace fs = boost::filesystem;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+const int n = 100000;
+
+// write the records and return the time taken in usecs
+long long writeAll(LogDestination& dest, shared_ptr<PropertySet> preamble) {
+    const char *what[] = { "gloves", "hat", "shoes", "scarf" };
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) {
+        LogRecord rec(Log::DEBUG, Log::DEBUG, preamble, "test.grand.child", 
+                      true);
+        string msg("I have debug ");
+        msg += what[i % 4];
+        msg += " just like those";
+        rec.addComment(msg);
+        rec.addProperty("number", i);
+        rec.addProperty("STATUS", string((i % 3) ? "now" : "later"));
+        rec.addProperty("NODE", i % 64);
+        dest.write(rec);
+    }
+    dest.flush();
+    return usecs() - t0;
+}
+
+void report(const char *what, long long usecs, unsigned long long bytes,
+            unsigned long long plain) 
+{
+    cout << what << ": " << 1000.0*usecs/n << " ns per record, "
+         << 1.0*plain/usecs << " MB/s of text, " << bytes << " bytes ("
+         << 100.0*bytes/plain << "%)" << endl;
+}
+
+int main() {
+    fs::path dir = fs::temp_directory_path() / 
+                   fs::unique_path("timeCompressed-%%%%-%%%%");
+    fs::create_directories(dir);
+    shared_ptr<LogFormatter> fmtr(new PrependedFormatter(true));
+    shared_ptr<PropertySet> preamble(new PropertySet());
+    preamble->set("RUNID", string("testRun"));
+    preamble->set("LABEL", string("shared"));
+
+    unsigned long long plain = 0;
+    {
+        fs::path path = dir / "plain.log";
+        long long t;
+        {
+            FileDestination dest(path, fmtr, Log::DEBUG);
+            dest.setFlushPolicy(FlushPolicy::everyBytes(256*1024));
+            t = writeAll(dest, preamble);
+        }
+        plain = fs::file_size(path);
+        report("FileDestination", t, plain, plain);
+    }
+
+    const int defaultLevel = CompressedFileDestination::DEFAULT_LEVEL;
+    const std::size_t blockSize = CompressedFileDestination::DEFAULT_BLOCK_SIZE;
+    const int levels[] = { 1, defaultLevel, 9 };
+    const char *names[] = { "gzip level 1", "gzip default level", 
+                            "gzip level 9" };
+    for(int l=0; l < 3; ++l) {
+        fs::path path = dir / "compressed.log.gz";
+        long long t;
+        {
+            CompressedFileDestination dest(path, fmtr, 
+                                           CompressedFileDestination::GZIP,
+                                           levels[l], blockSize, 
+                                           Log::DEBUG, true);
+            t = writeAll(dest, preamble);
+        }
+        report(names[l], t, fs::file_size(path), plain);
+    }
+
+    if (CompressedFileDestination::isSupported(
+            CompressedFileDestination::ZSTD)) 
+    {
+        fs::path path = dir / "compressed.log.zst";
+        long long t;
+        {
+            CompressedFileDestination dest(path, fmtr, 
+                                           CompressedFileDestination::ZSTD,
+                                           defaultLevel, blockSize, 
+                                           Log::DEBUG, true);
+            t = writeAll(dest, preamble);
+        }
+        report("zstd default level", t, fs::file_size(path), plain);
+    }
+
+    fs::remove_all(dir);
+    return 0;
+}
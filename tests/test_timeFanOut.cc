@@ -0,0 +1,102 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * time how long it takes to send a record to a Log with 1, 2 and 4
+ * destinations using equivalent PrependedFormatters, with the record
+ * rendered once and shared, and with each destination rendering it
+ * separately.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <streambuf>
+
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/LogDestination.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+using std::cout;
+using std::endl;
+using std::shared_ptr;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::PrependedFormatter;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+// a stream buffer that discards everything
+class NullBuffer : public std::streambuf {
+protected:
+    virtual int_type overflow(int_type c) { return traits_type::not_eof(c); }
+    virtual std::streamsize xsputn(const char *, std::streamsize n) {
+        return n;
+    }
+};
+
+int main() {
+    const int n = 200000;
+    const int counts[] = { 1, 2, 4 };
+    NullBuffer nullBuffer;
+    std::ostream null(&nullBuffer);
+
+    for(std::size_t c=0; c < sizeof(counts)/sizeof(int); ++c) {
+        Log log(Log::DEBUG, "timeFanOut");
+        std::list<shared_ptr<LogDestination> > dests;
+        for(int d=0; d < counts[c]; ++d) {
+            shared_ptr<LogFormatter> fmtr(new PrependedFormatter());
+            dests.push_back(shared_ptr<LogDestination>(
+                new LogDestination(&null, fmtr)));
+            log.addDestination(dests.back());
+        }
+
+        LogRecord rec(Log::DEBUG, Log::INFO, log.getPreamble(), false);
+        rec.addComment("processed exposure 8471 of visit 12");
+        rec.addProperty("ccd", 12);
+
+        long long t0 = usecs();
+        for(int i=0; i < n; ++i) log.send(rec);
+        long long shared = usecs() - t0;
+
+        t0 = usecs();
+        for(int i=0; i < n; ++i) {
+            std::list<shared_ptr<LogDestination> >::iterator di;
+            for(di = dests.begin(); di != dests.end(); ++di)
+                (*di)->write(rec);
+        }
+        long long separate = usecs() - t0;
+
+        cout << counts[c] << " destinations: "
+             << 1000.0*shared/n << " ns per record rendered once, "
+             << 1000.0*separate/n << " ns per record rendered separately"
+             << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * time how much keeping debug messages in a FlightRecorderDestination
+ * adds to a log that otherwise reports only at INFO.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <memory>
+#include <boost/filesystem/operations.hpp>
+
+#include "lsst/pex/logging/FlightRecorderDestination.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+using std::cout;
+using std::endl;
+using std::shared_ptr;
+using lsst::pex::logging::FlightRecorderDestination;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::PrependedFormatter;
+namespace fs = boost::filesystem;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+int main() {
+    const int n = 1000000;
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    shared_ptr<LogFormatter> fmtr(new PrependedFormatter());
+    shared_ptr<FlightRecorderDestination>
+        recorder(new FlightRecorderDestination(dir / "flight.dump", fmtr));
+
+    {
+        Log log(Log::INFO, "timing");
+        long long t0 = usecs();
+        for(int i=0; i < n; ++i) log.logdebug("processed exposure 8471");
+        long long t = usecs() - t0;
+        cout << "debug message dropped: " << 1000.0*t/n << " ns" << endl;
+    }
+    {
+        Log log(Log::DEBUG, "timing");
+        log.addDestination(recorder);
+        long long t0 = usecs();
+        for(int i=0; i < n; ++i) log.logdebug("processed exposure 8471");
+        long long t = usecs() - t0;
+        cout << "debug message recorded: " << 1000.0*t/n << " ns" << endl;
+    }
+    {
+        LogRecord rec(Log::DEBUG, Log::DEBUG);
+        rec.addComment("processed exposure 8471");
+        long long t0 = usecs();
+        for(int i=0; i < n; ++i) recorder->write(rec);
+        long long t = usecs() - t0;
+        cout << "record written to the recorder: " << 1000.0*t/n << " ns"
+             << endl;
+    }
+
+    fs::remove_all(dir);
+    return 0;
+}
@@ -0,0 +1,144 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * count the write(2) system calls (and the time) needed to write verbose
+ * records to a file when every line is flushed, as the formatters once 
+ * did with std::endl, and when a LogDestination writes whole records 
+ * under several flush policies.  The system calls are counted by 
+ * interposing on write(), much as strace -c would.
+ */
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "lsst/pex/logging/LogDestination.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/logging/Log.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::shared_ptr;
+using lsst::pex::logging::FlushPolicy;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::BriefFormatter;
+
+static long writeCalls = 0;
+
+extern "C" ssize_t write(int fd, const void *buf, size_t count) {
+    ++writeCalls;
+    return syscall(SYS_write, fd, buf, count);
+}
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+void report(const char *what, long long t0, long calls0, int n) {
+    cout << what << ": " << 1.0*(writeCalls - calls0)/n 
+         << " write() calls and " << 1000.0*(usecs() - t0)/n 
+         << " ns per record" << endl;
+}
+
+int main() {
+    const int n = 20000;
+    const char *path = "/dev/null";
+
+    // a verbose record with 20 properties
+    LogRecord rec(0, Log::INFO);
+    rec.addComment("processed a visit");
+    for(int i=0; i < 20; ++i) {
+        std::ostringstream name;
+        name << "prop" << i;
+        rec.addProperty(name.str(), i);
+    }
+    shared_ptr<LogFormatter> fmtr(new BriefFormatter(true));
+
+    long long t0;
+    long calls0;
+
+    // every line written and flushed separately, as with std::endl
+    {
+        std::ofstream out(path);
+        t0 = usecs();
+        calls0 = writeCalls;
+        for(int i=0; i < n; ++i) {
+            std::ostringstream lines;
+            fmtr->write(&lines, rec);
+            std::istringstream in(lines.str());
+            string line;
+            while (std::getline(in, line)) out << line << std::endl;
+        }
+        report("flush after every line", t0, calls0, n);
+    }
+
+    const struct {
+        const char *what;
+        FlushPolicy policy;
+    } cases[] = {
+        { "LogDestination, flush every record", FlushPolicy::everyRecord() },
+        { "LogDestination, flush every 64 kB", 
+          FlushPolicy::everyBytes(64*1024) },
+        { "LogDestination, flush every 100 ms", 
+          FlushPolicy::everyMillis(100) }
+    };
+    for(size_t c=0; c < sizeof(cases)/sizeof(cases[0]); ++c) {
+        std::ofstream out(path);
+        LogDestination dest(&out, fmtr);
+        dest.setFlushPolicy(cases[c].policy);
+
+        t0 = usecs();
+        calls0 = writeCalls;
+        for(int i=0; i < n; ++i) dest.write(rec);
+        dest.flush();
+        report(cases[c].what, t0, calls0, n);
+    }
+
+    // important records still go out at once
+    {
+        std::ofstream out(path);
+        LogDestination dest(&out, fmtr);
+        dest.setFlushPolicy(FlushPolicy::everyBytes(1 << 20));
+        LogRecord warning(0, Log::WARN);
+        warning.addComment("watch out");
+        dest.write(rec);
+        if (dest.getPendingBytes() == 0) 
+            throw std::runtime_error("INFO record was flushed early");
+        dest.write(warning);
+        if (dest.getPendingBytes() != 0) 
+            throw std::runtime_error("WARN record was not flushed");
+    }
+    return 0;
+}
@@ -0,0 +1,167 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * compare the cost of formatting log messages with printf-style format 
+ * strings (Log::format(), Log::infof()) against "{}"-style ones 
+ * (Log::infofmt()), both for the formatting alone and for whole messages
+ * sent to a destination that discards its output.
+ */
+#include <sys/time.h>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#include "lsst/pex/logging/Log.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using lsst::pex::logging::FormatBuffer;
+using lsst::pex::logging::Log;
+
+// count the allocations made while formatting
+static long allocations = 0;
+
+void *operator new(std::size_t size) {
+    ++allocations;
+    void *out = std::malloc(size ? size : 1);
+    if (out == 0) throw std::bad_alloc();
+    return out;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+// the way messages were formatted before FormatBuffer:  measure the 
+// message, then format it again into a variable-length stack array
+int formatTwice(const char *fmt, ...) {
+    va_list ap, aq;
+    va_start(ap, fmt);
+    va_copy(aq, ap);
+    const int len = vsnprintf(NULL, 0, fmt, ap) + 1;
+    va_end(ap);
+    char msg[len];
+    vsnprintf(msg, len, fmt, aq);
+    va_end(aq);
+    return msg[0];
+}
+
+void report(const char *what, long long t0, long allocs0, int n) {
+    cout << what << ": " << 1000.0*(usecs() - t0)/n << " ns per call, " 
+         << 1.0*(allocations - allocs0)/n << " allocations per call" << endl;
+}
+
+int main() {
+    const int n = 500000;
+    const char *name = "calexp";
+    int id = 1234567;
+    double ra = 150.118765, dec = 2.205833;
+
+    long long t0;
+    long allocs0;
+    int sum = 0;
+
+    // formatting alone
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < n; ++i) 
+        sum += formatTwice("%s %d: ra=%g dec=%g visit=%d", 
+                           name, id, ra, dec, i);
+    report("vsnprintf() twice into a stack array", t0, allocs0, n);
+
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < n; ++i) {
+        FormatBuffer buf;
+        buf.printf("%s %d: ra=%g dec=%g visit=%d", name, id, ra, dec, i);
+        sum += buf.size();
+    }
+    report("FormatBuffer::printf()", t0, allocs0, n);
+
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < n; ++i) {
+        FormatBuffer buf;
+        buf.format("{} {}: ra={} dec={} visit={}", name, id, ra, dec, i);
+        sum += buf.size();
+    }
+    report("FormatBuffer::format()", t0, allocs0, n);
+
+    {
+        FormatBuffer a, b;
+        a.printf("%s %d: ra=%g dec=%g visit=%d", name, id, ra, dec, 7);
+        b.format("{} {}: ra={} dec={} visit={}", name, id, ra, dec, 7);
+        if (a.str() != b.str()) 
+            throw std::runtime_error("printf() and format() disagree: " + 
+                                     a.str() + " vs. " + b.str());
+    }
+
+    // whole messages, written to a stream that discards them
+    std::ostream nowhere(0);
+    Log log(Log::INFO, "time");
+    log.addDestination(nowhere, Log::DEBUG);
+
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < n; ++i) 
+        log.format(Log::INFO, "%s %d: ra=%g dec=%g visit=%d", 
+                   name, id, ra, dec, i);
+    report("Log::format()", t0, allocs0, n);
+
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < n; ++i) 
+        log.infof("%s %d: ra=%g dec=%g visit=%d", name, id, ra, dec, i);
+    report("Log::infof()", t0, allocs0, n);
+
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < n; ++i) 
+        log.infofmt("{} {}: ra={} dec={} visit={}", name, id, ra, dec, i);
+    report("Log::infofmt()", t0, allocs0, n);
+
+    // messages below the threshold
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < n; ++i) 
+        log.debugf("%s %d: ra=%g dec=%g visit=%d", name, id, ra, dec, i);
+    report("Log::debugf() (not recorded)", t0, allocs0, n);
+
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < n; ++i) 
+        log.debugfmt("{} {}: ra={} dec={} visit={}", name, id, ra, dec, i);
+    report("Log::debugfmt() (not recorded)", t0, allocs0, n);
+
+    return (sum == 0) ? 1 : 0;
+}
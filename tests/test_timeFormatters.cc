@@ -0,0 +1,106 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * measure the cost of writing records with and without a LABEL through
+ * the PrependedFormatter, for both compact and expanded records, and 
+ * compare the exception-free lookup of a missing LABEL with catching the 
+ * NotFoundError thrown by PropertySet::get().
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/pex/exceptions.h"
+#include "lsst/daf/base/PropertySet.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using lsst::daf::base::PropertySet;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::PrependedFormatter;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+void timeWrites(const char *what, LogRecord& rec, int n) {
+    PrependedFormatter fmtr;
+    std::ostream nowhere(0);
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) fmtr.write(&nowhere, rec);
+    cout << what << ": " << 1000.0*(usecs() - t0)/n << " ns per record" 
+         << endl;
+}
+
+int main() {
+    const int n = 200000;
+
+    std::shared_ptr<PropertySet> plain(new PropertySet());
+    plain->set("RUNID", string("run1"));
+    std::shared_ptr<PropertySet> labeled(plain->deepCopy());
+    labeled->set("LABEL", string("stage3"));
+
+    LogRecord compact(0, 5, plain, "pipe.stage");
+    compact.setDate();
+    compact.addComment("a message without a label");
+    timeWrites("compact record without label", compact, n);
+
+    LogRecord compactLabeled(0, 5, labeled, "pipe.stage");
+    compactLabeled.setDate();
+    compactLabeled.addComment("a message with a label");
+    timeWrites("compact record with label", compactLabeled, n);
+
+    LogRecord expanded(compact);
+    expanded.data();      // expand
+    timeWrites("expanded record without label", expanded, n);
+
+    LogRecord expandedLabeled(compactLabeled);
+    expandedLabeled.data();
+    timeWrites("expanded record with label", expandedLabeled, n);
+
+    // the cost of a missing LABEL alone
+    const PropertySet& props = expanded.getProperties();
+    string label;
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) {
+        try {
+            label = props.get<string>("LABEL");
+        } catch (lsst::pex::exceptions::NotFoundError const &) { }
+    }
+    cout << "missing LABEL via get() and catch: " 
+         << 1000.0*(usecs() - t0)/n << " ns per lookup" << endl;
+
+    t0 = usecs();
+    for(int i=0; i < n; ++i) LogRecord::tryGet(props, "LABEL", label);
+    cout << "missing LABEL via tryGet(): " 
+         << 1000.0*(usecs() - t0)/n << " ns per lookup" << endl;
+
+    return 0;
+}
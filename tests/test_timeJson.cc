@@ -0,0 +1,116 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * measure the cost of escaping typical messages as JSON strings with each
+ * of JsonString's scanners, and of writing whole records with the 
+ * JsonLinesFormatter compared to the NetLoggerFormatter.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "lsst/pex/logging/JsonString.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/daf/base/PropertySet.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using lsst::daf::base::PropertySet;
+using lsst::pex::logging::JsonString;
+using lsst::pex::logging::JsonLinesFormatter;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::NetLoggerFormatter;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+const char *scannerNames[] = { "bytes", "words", "SSE2", "AVX2" };
+
+void timeEscaping(const char *what, const string& text, int n) {
+    string out;
+    out.reserve(2 * text.size() + 16);
+    for (int s = JsonString::BYTES; s <= JsonString::AVX2; ++s) {
+        JsonString::Scanner scanner = static_cast<JsonString::Scanner>(s);
+        if (JsonString::setScanner(scanner) != scanner) continue;
+        long long t0 = usecs();
+        for(int i=0; i < n; ++i) {
+            out.clear();
+            JsonString::append(out, text.data(), text.size());
+        }
+        long long dt = usecs() - t0;
+        cout << what << " (" << text.size() << " chars), " 
+             << scannerNames[s] << ": " << 1000.0*dt/n << " ns per string, "
+             << (dt > 0 ? double(text.size())*n/dt/1000.0 : 0.0) 
+             << " GB/s" << endl;
+    }
+    JsonString::setScanner(JsonString::bestScanner());
+}
+
+void timeWrites(const char *what, LogFormatter& fmtr, LogRecord& rec, int n) {
+    std::ostream nowhere(0);
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) fmtr.write(&nowhere, rec);
+    cout << what << ": " << 1000.0*(usecs() - t0)/n << " ns per record" 
+         << endl;
+}
+
+int main() {
+    const int n = 200000;
+
+    cout << "best scanner: " << scannerNames[JsonString::bestScanner()] 
+         << endl;
+
+    string comment("finished processing visit 85471 ccd 12 in 3.2 seconds "
+                   "with 4 amplifiers");
+    timeEscaping("typical message", comment, n);
+
+    string longer;
+    while (longer.size() < 1000) longer += comment + "; ";
+    timeEscaping("long message", longer, n/4);
+
+    string quoted("path=\"/data/raw/85471\"\tstatus=\"ok\"\n");
+    timeEscaping("message with escapes", quoted, n);
+
+    std::shared_ptr<PropertySet> preamble(new PropertySet());
+    preamble->set("HOST", string("lsst-dev01"));
+    preamble->set("PID", 31337);
+    LogRecord rec(0, 5, preamble, "pipe.isr");
+    rec.addComment(comment);
+    rec.addProperty("visit", 85471);
+    rec.addProperty("exptime", 15.5);
+    rec.data();       // expand
+
+    JsonLinesFormatter json;
+    NetLoggerFormatter netlogger;
+    timeWrites("JsonLinesFormatter", json, rec, n);
+    timeWrites("NetLoggerFormatter", netlogger, rec, n);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * time how long it takes to write records to a FileDestination and to a
+ * MmapFileDestination, from one thread and from several at once.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+#include <boost/filesystem/operations.hpp>
+
+#include "lsst/pex/logging/FileDestination.h"
+#include "lsst/pex/logging/MmapFileDestination.h"
+#include "lsst/pex/logging/Log.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+using std::cout;
+using std::endl;
+using std::shared_ptr;
+using lsst::pex::logging::FileDestination;
+using lsst::pex::logging::FlushPolicy;
+using lsst::pex::logging::Log;
+using lsst::pex::logging::LogDestination;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::MmapFileDestination;
+using lsst::pex::logging::PrependedFormatter;
+namespace fs = boost::filesystem;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+void writeMany(LogDestination *dest, const LogRecord *rec, int n) {
+    for(int i=0; i < n; ++i) dest->write(*rec);
+}
+
+int main() {
+    const int n = 200000, nthreads = 4;
+    fs::path dir = fs::temp_directory_path() / fs::unique_path();
+    fs::create_directories(dir);
+    shared_ptr<LogFormatter> fmtr(new PrependedFormatter());
+    LogRecord rec(Log::DEBUG, Log::INFO);
+    rec.addComment("processed exposure 8471 of visit 12");
+
+    {
+        FileDestination dest(dir / "file.log", fmtr);
+        dest.setFlushPolicy(FlushPolicy::everyBytes(64*1024));
+        long long t0 = usecs();
+        writeMany(&dest, &rec, n);
+        dest.flush();
+        long long t = usecs() - t0;
+        cout << "FileDestination: " << 1000.0*t/n << " ns per record"
+             << endl;
+    }
+    {
+        MmapFileDestination dest(dir / "mmap.log", fmtr);
+        long long t0 = usecs();
+        writeMany(&dest, &rec, n);
+        long long t = usecs() - t0;
+        cout << "MmapFileDestination: " << 1000.0*t/n << " ns per record"
+             << endl;
+    }
+    {
+        MmapFileDestination dest(dir / "threads.log", fmtr);
+        std::vector<std::thread> threads;
+        long long t0 = usecs();
+        for(int i=0; i < nthreads; ++i)
+            threads.push_back(std::thread(writeMany, &dest, &rec, n));
+        for(int i=0; i < nthreads; ++i) threads[i].join();
+        long long t = usecs() - t0;
+        cout << "MmapFileDestination, " << nthreads << " threads: "
+             << 1000.0*t/(n*nthreads) << " ns per record" << endl;
+    }
+
+    fs::remove_all(dir);
+    return 0;
+}
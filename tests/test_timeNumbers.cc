@@ -0,0 +1,86 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * compare the cost of writing numbers to a stream with operator<< against
+ * NumberFormat, which writes the shortest exact form without consulting
+ * the stream's locale.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "lsst/pex/logging/NumberFormat.h"
+
+using std::cout;
+using std::endl;
+using lsst::pex::logging::NumberFormat;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+template <class T>
+void timeBoth(const char *what, const T *vals, int nvals, int n) {
+    std::ostringstream strm;
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) {
+        strm.seekp(0);
+        strm << vals[i % nvals];
+    }
+    cout << what << " via operator<<: " << 1000.0*(usecs() - t0)/n 
+         << " ns per value" << endl;
+
+    t0 = usecs();
+    for(int i=0; i < n; ++i) {
+        strm.seekp(0);
+        NumberFormat::write(strm, vals[i % nvals]);
+    }
+    cout << what << " via NumberFormat: " << 1000.0*(usecs() - t0)/n 
+         << " ns per value" << endl;
+}
+
+int main() {
+    const int n = 500000;
+
+    const long long ints[] = { 0, 7, -42, 85471, 1456848245012345678LL };
+    timeBoth("integers", ints, 5, n);
+
+    const double whole[] = { 0.0, 15.0, 1024.0, -3.0, 85471.0 };
+    timeBoth("whole doubles", whole, 5, n);
+
+    const double decimals[] = { 0.1, -1.5, 15.25, 1024.125, 0.001 };
+    timeBoth("short decimal doubles", decimals, 5, n);
+
+    // these need 16 or 17 digits, or exponents, to be exact
+    const double reals[] = { 1.0/3.0, 2.5e-8, 6.02214076e23, 0.1+0.2, 
+                             3.141592653589793 };
+    timeBoth("full-precision doubles", reals, 5, n);
+
+    const float floats[] = { 0.1f, 1.0f/3.0f, 2.5e-8f, 15.5f, -1.5f };
+    timeBoth("floats", floats, 5, n);
+
+    return 0;
+}
@@ -0,0 +1,94 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * compare the cost of writing records with a PatternFormatter against the
+ * PrependedFormatter, both for the equivalent layout and for one that
+ * adds named properties, with compact and expanded records.
+ */
+#include <sys/time.h>
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/daf/base/PropertySet.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using lsst::daf::base::PropertySet;
+using lsst::pex::logging::LogFormatter;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::PatternFormatter;
+using lsst::pex::logging::PrependedFormatter;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+void timeWrites(const char *what, LogFormatter& fmtr, LogRecord& rec, int n) {
+    std::ostream nowhere(0);
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) fmtr.write(&nowhere, rec);
+    cout << what << ": " << 1000.0*(usecs() - t0)/n << " ns per record" 
+         << endl;
+}
+
+int main() {
+    const int n = 200000;
+
+    std::shared_ptr<PropertySet> preamble(new PropertySet());
+    preamble->set("LABEL", string("stage3"));
+
+    LogRecord compact(0, 5, preamble, "pipe.isr");
+    compact.setDate();
+    compact.addComment("finished the instrument signature removal");
+    compact.addProperty("visit", 85471);
+    compact.addProperty("ccd", 12);
+
+    LogRecord expanded(compact);
+    expanded.data();      // expand
+
+    PrependedFormatter prepended;
+    PatternFormatter same("%d: %b: %n: %m");
+    PatternFormatter props("%d %L %n: %m%p{visit,ccd}");
+
+    timeWrites("PrependedFormatter, compact record", prepended, compact, n);
+    timeWrites("equivalent pattern, compact record", same, compact, n);
+    timeWrites("pattern with properties, compact record", props, compact, n);
+    timeWrites("PrependedFormatter, expanded record", prepended, expanded, n);
+    timeWrites("equivalent pattern, expanded record", same, expanded, n);
+    timeWrites("pattern with properties, expanded record", props, expanded, n);
+
+    // the one-time cost of compiling a pattern
+    long long t0 = usecs();
+    for(int i=0; i < n/10; ++i) 
+        PatternFormatter fmtr("%d %L %n: %m%p{visit,ccd}");
+    cout << "compiling a pattern: " << 10000.0*(usecs() - t0)/n 
+         << " ns" << endl;
+
+    return 0;
+}
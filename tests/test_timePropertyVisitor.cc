@@ -0,0 +1,144 @@
+/*
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ *
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the LSST License Statement and
+ * the GNU General Public License along with this program.  If not,
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * compare the cost of printing every property of a PropertySet with
+ * PropertyPrinter iterators against PropertyVisitor, counting the
+ * allocations each makes, and time a verbose formatter using the latter.
+ */
+#include <sys/time.h>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "lsst/pex/logging/PropertyPrinter.h"
+#include "lsst/pex/logging/PropertyVisitor.h"
+#include "lsst/pex/logging/LogFormatter.h"
+#include "lsst/pex/logging/LogRecord.h"
+#include "lsst/daf/base/PropertySet.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using lsst::daf::base::PropertySet;
+using lsst::pex::logging::PropertyPrinter;
+using lsst::pex::logging::PropertyVisitor;
+using lsst::pex::logging::PropertyValue;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::BriefFormatter;
+
+// count the allocations made while printing
+static long allocations = 0;
+
+void *operator new(std::size_t size) {
+    ++allocations;
+    void *out = std::malloc(size ? size : 1);
+    if (out == 0) throw std::bad_alloc();
+    return out;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+class Printer : public PropertyVisitor {
+public:
+    explicit Printer(std::ostream& strm) : _strm(strm) { }
+    virtual void visit(const string& name, const PropertyValue& value,
+                       std::size_t) 
+    {
+        _strm << "  " << name << ": ";
+        value.write(_strm) << '\n';
+    }
+private:
+    std::ostream& _strm;
+};
+
+void report(const char *what, long long t0, long allocs, int n) {
+    cout << what << ": " << 1000.0*(usecs() - t0)/n << " ns and " 
+         << double(allocations - allocs)/n << " allocations per set" << endl;
+}
+
+int main() {
+    const int n = 100000;
+
+    PropertySet ps;
+    ps.set("RUNID", string("run1"));
+    ps.set("visit", 85471);
+    ps.set("ccd", 12);
+    ps.set("exptime", 15.0);
+    ps.set("good", true);
+    ps.add("amps", 1);
+    ps.add("amps", 2);
+    ps.add("amps", 3);
+    std::vector<string> names = ps.paramNames(false);
+
+    std::ostream nowhere(0);
+
+    long allocs = allocations;
+    long long t0 = usecs();
+    for(int i=0; i < n; ++i) {
+        for (auto const& name : names) {
+            PropertyPrinter pp(ps, name);
+            for (PropertyPrinter::iterator pi=pp.begin(); pi.notAtEnd(); ++pi){
+                nowhere << "  " << name << ": ";
+                pi.write(&nowhere) << '\n';
+            }
+        }
+    }
+    report("PropertyPrinter", t0, allocs, n);
+
+    Printer printer(nowhere);
+    allocs = allocations;
+    t0 = usecs();
+    for(int i=0; i < n; ++i) {
+        for (auto const& name : names) 
+            PropertyVisitor::visitValues(ps, name, printer);
+    }
+    report("PropertyVisitor", t0, allocs, n);
+
+    // a whole verbose record
+    std::shared_ptr<PropertySet> preamble(new PropertySet());
+    LogRecord rec(0, 5, preamble, "pipe.stage");
+    rec.addComment("a verbose message");
+    rec.addProperty("visit", 85471);
+    rec.addProperty("exptime", 15.0);
+    rec.addProperty("good", true);
+    rec.data();      // expand
+    BriefFormatter fmtr(true);
+    allocs = allocations;
+    t0 = usecs();
+    for(int i=0; i < n; ++i) fmtr.write(&nowhere, rec);
+    cout << "verbose BriefFormatter: " << 1000.0*(usecs() - t0)/n 
+         << " ns and " << double(allocations - allocs)/n 
+         << " allocations per record" << endl;
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008, 2009, 2010 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * compare the cost of looking up thresholds in threshold::Memory against
+ * the original tree of threshold::Family nodes with a large number of 
+ * registered names.
+ */
+#include <sys/time.h>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "lsst/pex/logging/threshold/Memory.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using std::vector;
+namespace Threshold = lsst::pex::logging::threshold;
+
+// count the allocations made while looking up thresholds
+static long allocations = 0;
+
+void *operator new(std::size_t size) {
+    ++allocations;
+    void *out = std::malloc(size ? size : 1);
+    if (out == 0) throw std::bad_alloc();
+    return out;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+int main() {
+    const int nnames = 20000;
+    const int nlookups = 1000000;
+
+    // names like "pipe3.task17.stage5"; every tenth one has a threshold 
+    // while the rest inherit
+    vector<string> names;
+    for(int i=0; i < nnames; ++i) {
+        std::ostringstream name;
+        name << "pipe" << i % 20 << ".task" << i % 1000 << ".stage" << i;
+        names.push_back(name.str());
+    }
+
+    // lookups are done on descendants of the registered names
+    vector<string> queries;
+    for(int i=0; i < nnames; ++i) queries.push_back(names[i] + ".step.detail");
+
+    boost::char_separator<char> sep(".");
+    Threshold::Family family(0);
+    Threshold::Memory memory;
+    memory.setRootThreshold(0);
+    for(int i=0; i < nnames; ++i) {
+        int thresh = (i % 10 == 0) ? -i : Threshold::INHERIT;
+        Threshold::tokenizer fields(names[i], sep);
+        family.setThresholdFor(fields.begin(), fields.end(), thresh);
+        memory.setThresholdFor(names[i], thresh);
+    }
+    cout << "Registered " << memory.countNames() << " names" << endl;
+
+    long long t0, t;
+    long allocs0;
+    int sum = 0;
+
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < nlookups; ++i) {
+        const string& name = queries[i % nnames];
+        Threshold::tokenizer fields(name, sep);
+        sum += family.getThresholdFor(fields.begin(), fields.end());
+    }
+    t = usecs();
+    cout << "Family::getThresholdFor(): " << 1000.0*(t - t0)/nlookups 
+         << " ns per call, " << 1.0*(allocations - allocs0)/nlookups 
+         << " allocations per call" << endl;
+    int famsum = sum;
+
+    sum = 0;
+    t0 = usecs();
+    allocs0 = allocations;
+    for(int i=0; i < nlookups; ++i) {
+        sum += memory.getThresholdFor(queries[i % nnames]);
+    }
+    t = usecs();
+    cout << "Memory::getThresholdFor(): " << 1000.0*(t - t0)/nlookups 
+         << " ns per call, " << 1.0*(allocations - allocs0)/nlookups 
+         << " allocations per call" << endl;
+
+    if (sum != famsum) 
+        throw std::runtime_error("Memory and Family thresholds disagree");
+    if (allocations != allocs0) 
+        throw std::runtime_error("Memory::getThresholdFor() allocated memory");
+    return 0;
+}
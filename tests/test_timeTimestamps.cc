@@ -0,0 +1,112 @@
+/* 
+ * LSST Data Management System
+ * Copyright 2008-2016 LSST Corporation.
+ * 
+ * This product includes software developed by the
+ * LSST Project (http://www.lsst.org/).
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the LSST License Statement and 
+ * the GNU General Public License along with this program.  If not, 
+ * see <http://www.lsstcorp.org/LegalNotices/>.
+ */
+
+/*
+ * compare the cost of stamping a record with the time and formatting its
+ * DATE the way LogRecord once did (gettimeofday(), gmtime_r(), strftime()
+ * and boost::format for every record) against Timestamp, with both the
+ * precise and the coarse clock.
+ */
+#include <sys/time.h>
+#include <time.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <boost/format.hpp>
+
+#include "lsst/pex/logging/Timestamp.h"
+#include "lsst/pex/logging/LogRecord.h"
+
+using std::cout;
+using std::endl;
+using std::string;
+using lsst::pex::logging::LogRecord;
+using lsst::pex::logging::Timestamp;
+
+long long usecs() {
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+long long oldNow() {
+    struct timeval tv;      
+    gettimeofday(&tv, NULL);
+    return static_cast<long long>(tv.tv_sec) * 1000000000LL + 
+           tv.tv_usec * 1000LL;
+}
+
+string oldFormat(long long nsecs) {
+    char datestr[40];
+    time_t secs = static_cast<time_t>(nsecs / 1000000000LL);
+    long usec = static_cast<long>((nsecs % 1000000000LL) / 1000);
+    struct tm timeinfo;
+    gmtime_r(&secs, &timeinfo);
+    strftime(datestr, 39, "%Y-%m-%dT%H:%M:%S.", &timeinfo);
+    return str(boost::format("%s%d") % string(datestr) % usec);
+}
+
+int main() {
+    const int n = 1000000;
+    long long t0;
+    size_t sum = 0;
+
+    t0 = usecs();
+    for(int i=0; i < n; ++i) sum += oldFormat(oldNow()).size();
+    cout << "gettimeofday() + strftime() + boost::format: " 
+         << 1000.0*(usecs() - t0)/n << " ns per record" << endl;
+
+    t0 = usecs();
+    for(int i=0; i < n; ++i) sum += Timestamp::now() & 1;
+    cout << "Timestamp::now() (precise): " 
+         << 1000.0*(usecs() - t0)/n << " ns per call" << endl;
+
+    char buf[Timestamp::LENGTH];
+    t0 = usecs();
+    for(int i=0; i < n; ++i) 
+        sum += Timestamp::format(Timestamp::now(), buf) - buf;
+    cout << "Timestamp::now() + format() (precise): " 
+         << 1000.0*(usecs() - t0)/n << " ns per record" << endl;
+
+    Timestamp::setClock(Timestamp::COARSE);
+    t0 = usecs();
+    for(int i=0; i < n; ++i) 
+        sum += Timestamp::format(Timestamp::now(), buf) - buf;
+    cout << "Timestamp::now() + format() (coarse): " 
+         << 1000.0*(usecs() - t0)/n << " ns per record" << endl;
+    Timestamp::setClock(Timestamp::PRECISE);
+
+    // the full DATE string, as a record assembles it
+    t0 = usecs();
+    for(int i=0; i < n; ++i) 
+        sum += LogRecord::formatDate(LogRecord::utcnow()).size();
+    cout << "LogRecord::formatDate(LogRecord::utcnow()): " 
+         << 1000.0*(usecs() - t0)/n << " ns per record" << endl;
+
+    // make sure the two agree where the old one was right
+    long long when = 1456848245512345000LL;
+    if (oldFormat(when) != LogRecord::formatDate(when))
+        throw std::runtime_error("old and new dates disagree: " + 
+                                 oldFormat(when) + " vs. " + 
+                                 LogRecord::formatDate(when));
+    return (sum == 0) ? 1 : 0;
+}
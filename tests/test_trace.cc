@@ -39,6 +39,9 @@ void assure(bool mustBeTrue, const string& failureMsg) {
         throw runtime_error(failureMsg);
 }
 
+int evaluated = 0;
+int countEvaluation() { return ++evaluated; }
+
 int main(int argc, char* argv[]) {
     long long t0, t1;
     int verb = LSST_MAX_TRACE;
@@ -100,4 +103,33 @@ int main(int argc, char* argv[]) {
     for(int i=0; i < 110; i++) msg[i] = '0' + (i % 10);
     msg[110] = '\0';
     lg::TTrace<3>("myapp", "Long message: %s", msg);
+
+    // LSST_TRACE does not evaluate its arguments if it will not print
+    Trace::setVerbosity("myapp.macro", 2);
+    for (int k=0; k < 2; k++) 
+        LSST_TRACE("myapp.macro", 3, "not printed: %d", countEvaluation());
+    assure(evaluated == 0, "LSST_TRACE evaluated arguments when disabled");
+
+    t0 = LogRecord::utcnow();
+    for (int k=0; k < 1000000; k++) 
+        LSST_TRACE("myapp.macro", 3, "not printed: %d", countEvaluation());
+    t1 = LogRecord::utcnow();
+    cout << "LSST_TRACE message not printed in " << (t1-t0)/1000000.0 
+         << " nsec" << endl;
+
+    // a change in verbosity is noticed by an existing site
+    for (int k=0; k < 2; k++) {
+        LSST_TRACE("myapp.macro", 3, "printed at verbosity 3: %d", 
+                   countEvaluation());
+        Trace::setVerbosity("myapp.macro", 5);
+    }
+    assure(evaluated == (LSST_NO_TRACE ? 0 : 1), 
+           "LSST_TRACE did not see new verbosity");
+
+    // a message more verbose than LSST_MAX_TRACE is compiled out
+    LSST_TRACE("myapp.macro", 4, "never printed: %d", countEvaluation());
+    assure(evaluated == (LSST_NO_TRACE ? 0 : 1), 
+           "LSST_TRACE ignored LSST_MAX_TRACE");
+    LSST_TRACE("myapp.macro", 2, string("a plain message"));
+    LSST_TRACE("myapp.macro", 2, boost::format("a %s message") % "formatted");
 }